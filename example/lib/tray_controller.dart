@@ -10,6 +10,8 @@ import 'package:tray_manager_winui/tray_manager_winui.dart';
 class TrayController extends ChangeNotifier implements TrayListener {
   TrayController() {
     trayManager.addListener(this);
+    // Checkbox and radio items are already toggled when onClick runs.
+    TrayManagerWinUI.instance.nativeToggles = true;
     _listenToWinUIEvents();
     _buildMenu();
     _applyMenuAndStyle();
@@ -84,19 +86,13 @@ class TrayController extends ChangeNotifier implements TrayListener {
           label: 'Dark Mode',
           checked: false,
           winuiIcon: const WinUIIcon.glyph(0xE793),
-          onClick: (item) {
-            item.checked = !(item.checked == true);
-            _applyMenuAndStyle();
-          },
+          onClick: (item) => _showSnack('${item.label}: ${item.checked}'),
         ),
         WinUIMenuItem.checkbox(
           label: 'Notifications',
           checked: true,
           winuiIcon: const WinUIIcon.glyph(0xEA8F),
-          onClick: (item) {
-            item.checked = !(item.checked == true);
-            _applyMenuAndStyle();
-          },
+          onClick: (item) => _showSnack('${item.label}: ${item.checked}'),
         ),
         MenuItem.separator(),
         WinUIMenuItem.submenu(
@@ -180,10 +176,6 @@ class TrayController extends ChangeNotifier implements TrayListener {
   }
 
   void _onRadioClick(MenuItem clicked) {
-    for (final item in [_radioSmall, _radioMedium, _radioLarge]) {
-      item.checked = (item == clicked);
-    }
-    _applyMenuAndStyle();
     if (kDebugMode) print('Radio selected: ${clicked.label}');
   }
 
@@ -404,10 +396,7 @@ class TrayController extends ChangeNotifier implements TrayListener {
         winuiIcon: icon,
         disabled: disabled,
         acceleratorText: accelerator,
-        onClick: (item) {
-          item.checked = !(item.checked == true);
-          _applyMenuAndStyle();
-        },
+        onClick: (item) => _showSnack('$label: ${item.checked}'),
       );
     }
 
@@ -546,10 +535,7 @@ class TrayController extends ChangeNotifier implements TrayListener {
       items.add(WinUIMenuItem.checkbox(
         label: toggleLabels[i],
         checked: rng.nextBool(),
-        onClick: (item) {
-          item.checked = !(item.checked == true);
-          _applyMenuAndStyle();
-        },
+        onClick: (item) => _showSnack('$label: ${item.checked}'),
       ));
     }
 
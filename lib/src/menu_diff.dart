@@ -0,0 +1,154 @@
+/// Item fields that the native side can update in place via
+/// `updateMenuItems`. Any other difference needs a full `setContextMenu`.
+const Set<String> patchableMenuItemFields = {
+  'label',
+  'checked',
+  'disabled',
+  'toolTip',
+  'icon',
+  'iconFontFamily',
+  'acceleratorText',
+};
+
+/// Computes the `updateMenuItems` patches that turn [oldMenu] into [newMenu].
+///
+/// Both arguments are in `Menu.toJson()` form. Each patch is a map
+/// `{'id': int, 'field': String, 'value': Object?}`; a `null` value clears the
+/// field on the native side.
+///
+/// Returns `null` if the menus differ in anything that cannot be patched
+/// (item count or order, ids, types, radio groups, submenu structure), and an
+/// empty list if they are equal.
+List<Map<String, Object?>>? diffMenuJson(
+  Map<String, dynamic> oldMenu,
+  Map<String, dynamic> newMenu,
+) {
+  final patches = <Map<String, Object?>>[];
+  if (!_diffItems(oldMenu['items'], newMenu['items'], patches)) return null;
+  return patches;
+}
+
+/// Sets `checked` of the item [id] in [menuJson] (`Menu.toJson()` form) to
+/// [checked], keeping a sent menu in step with a toggle the native side made.
+///
+/// [path] is the item's index among its siblings at each level, as sent with
+/// `onMenuItemClick`; without it, or if it does not lead to [id], the menu is
+/// searched. Returns false if there is no such item.
+bool setMenuJsonChecked(
+  Map<String, dynamic> menuJson,
+  int id,
+  bool checked, {
+  List<int>? path,
+}) {
+  Map? item = path == null ? null : _itemAt(menuJson, path);
+  if (item == null || item['id'] != id) item = _findItem(menuJson['items'], id);
+  if (item == null) return false;
+  item['checked'] = checked;
+  return true;
+}
+
+/// Runs the sends of one menu one at a time, in call order, so that each
+/// diffs against the menu JSON the previous send left on the native side.
+///
+/// Without it, a send that starts while another is still awaiting the
+/// native side diffs against the JSON from before that one: a toggle
+/// quickly reverted yields no patches, and the toggle then stays shown.
+class MenuSendQueue {
+  Future<void> _tail = Future<void>.value();
+
+  Future<void> run(Future<void> Function() send) {
+    final Future<void> result = _tail.then((_) => send());
+    // A failed send does not hold up the ones queued behind it.
+    _tail = result.then((_) {}, onError: (Object _) {});
+    return result;
+  }
+}
+
+Map? _itemAt(Map menuJson, List<int> path) {
+  Map? menu = menuJson;
+  Map? item;
+  for (final int position in path) {
+    final Object? items = menu?['items'];
+    if (items is! List || position < 0 || position >= items.length) {
+      return null;
+    }
+    final Object? entry = items[position];
+    if (entry is! Map) return null;
+    item = entry;
+    final Object? submenu = entry['submenu'];
+    menu = submenu is Map ? submenu : null;
+  }
+  return item;
+}
+
+Map? _findItem(Object? items, int id) {
+  if (items is! List) return null;
+  for (final Object? item in items) {
+    if (item is! Map) continue;
+    if (item['id'] == id) return item;
+    final Object? submenu = item['submenu'];
+    if (submenu is Map) {
+      final Map? found = _findItem(submenu['items'], id);
+      if (found != null) return found;
+    }
+  }
+  return null;
+}
+
+/// Deep equality for JSON-like values (maps, lists and scalars).
+bool jsonEquals(Object? a, Object? b) {
+  if (identical(a, b)) return true;
+  if (a is Map && b is Map) {
+    if (a.length != b.length) return false;
+    for (final key in a.keys) {
+      if (!b.containsKey(key) || !jsonEquals(a[key], b[key])) return false;
+    }
+    return true;
+  }
+  if (a is List && b is List) {
+    if (a.length != b.length) return false;
+    for (var i = 0; i < a.length; i++) {
+      if (!jsonEquals(a[i], b[i])) return false;
+    }
+    return true;
+  }
+  return a == b;
+}
+
+bool _diffItems(
+  Object? oldItems,
+  Object? newItems,
+  List<Map<String, Object?>> patches,
+) {
+  if (oldItems == null && newItems == null) return true;
+  if (oldItems is! List || newItems is! List) return false;
+  if (oldItems.length != newItems.length) return false;
+  for (var i = 0; i < oldItems.length; i++) {
+    final oldItem = oldItems[i];
+    final newItem = newItems[i];
+    if (oldItem is! Map || newItem is! Map) return false;
+    if (!_diffItem(oldItem, newItem, patches)) return false;
+  }
+  return true;
+}
+
+bool _diffItem(Map oldItem, Map newItem, List<Map<String, Object?>> patches) {
+  final id = newItem['id'];
+  if (id is! int || oldItem['id'] != id) return false;
+  for (final key in {...oldItem.keys, ...newItem.keys}) {
+    final oldValue = oldItem[key];
+    final newValue = newItem[key];
+    if (key == 'submenu') {
+      if (oldValue == null && newValue == null) continue;
+      if (oldValue is! Map || newValue is! Map) return false;
+      if (!_diffItems(oldValue['items'], newValue['items'], patches)) {
+        return false;
+      }
+      continue;
+    }
+    if (jsonEquals(oldValue, newValue)) continue;
+    if (!patchableMenuItemFields.contains(key)) return false;
+    patches.add({'id': id, 'field': key, 'value': newValue});
+  }
+  return true;
+}
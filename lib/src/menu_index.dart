@@ -0,0 +1,74 @@
+import 'package:menu_base/menu_base.dart';
+
+/// The items of one version of a menu by id, for resolving
+/// `onMenuItemClick` events without walking the tree
+/// ([Menu.getMenuItemById]).
+///
+/// [generation] is sent to the native side with the menu and comes back with
+/// every click on it, so a click on a flyout that still shows an older
+/// version is dropped instead of being matched to whatever item now has its
+/// id. Build a new index whenever the menu is sent again.
+class MenuItemIndex {
+  MenuItemIndex(this.menu, this.generation) {
+    _addItems(menu);
+  }
+
+  final Menu menu;
+
+  /// Stamp of this version, 32 bits (see [nextMenuGeneration]).
+  final int generation;
+
+  final Map<int, MenuItem> _items = {};
+
+  /// Ids used by more than one item; clicks on them are resolved by path.
+  final Set<int> _duplicateIds = {};
+
+  void _addItems(Menu menu) {
+    for (final MenuItem item in menu.items ?? const <MenuItem>[]) {
+      final int? id = item.id;
+      if (id != null &&
+          !identical(_items.putIfAbsent(id, () => item), item)) {
+        _duplicateIds.add(id);
+      }
+      final Menu? submenu = item.submenu;
+      if (submenu != null) _addItems(submenu);
+    }
+  }
+
+  /// Number of distinct ids.
+  int get length => _items.length;
+
+  /// Returns the clicked item, or `null` if the click was on another
+  /// [generation] or names no item of this menu.
+  ///
+  /// [path] is the item's index among its siblings at each level, root
+  /// first; it is only needed to tell items with the same id apart. Without
+  /// [generation] (an unstamped event), the id alone decides.
+  MenuItem? resolve(int id, {int? generation, List<int>? path}) {
+    if (generation != null && generation != this.generation) return null;
+    if (path != null && _duplicateIds.contains(id)) {
+      final MenuItem? item = _itemAt(path);
+      if (item != null && item.id == id) return item;
+    }
+    return _items[id];
+  }
+
+  MenuItem? _itemAt(List<int> path) {
+    Menu? level = menu;
+    MenuItem? item;
+    for (final int position in path) {
+      final List<MenuItem>? items = level?.items;
+      if (items == null || position < 0 || position >= items.length) {
+        return null;
+      }
+      item = items[position];
+      level = item.submenu;
+    }
+    return item;
+  }
+}
+
+/// Returns the generation after [generation]: 32 bits, never 0 (the native
+/// side's "unstamped").
+int nextMenuGeneration(int generation) =>
+    generation >= 0xFFFFFFFF ? 1 : generation + 1;
@@ -0,0 +1,232 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+/// Name of the BinaryMessenger channel that takes [packMenu] buffers.
+const String packedMenuChannelName = 'tray_manager_winui/packed_menu';
+
+/// Layout constants of the packed format; keep in sync with
+/// windows/packed_menu.h.
+const int packedMenuMagic = 0x50574D54; // "TMWP"
+const int packedMenuVersion = 1;
+const int _headerSize = 40;
+const int _stringRefSize = 8;
+const int _nodeSize = 40;
+const int _styleSize = 16;
+const int _insetsSize = 32;
+
+const int _nodeDisabled = 1;
+const int _nodeChecked = 2;
+const int _nodeVirtualized = 4;
+
+const int _styleBool = 1;
+const int _styleInt = 2;
+const int _styleDouble = 3;
+const int _styleString = 4;
+const int _styleInsets = 5;
+
+/// MenuItemType on the native side.
+const Map<String, int> _itemTypes = {
+  'normal': 0,
+  'separator': 1,
+  'submenu': 2,
+  'checkbox': 3,
+  'radio': 4,
+  'split': 5,
+};
+
+const List<String> _nodeStringFields = [
+  'label',
+  'icon',
+  'iconFontFamily',
+  'acceleratorText',
+  'toolTip',
+  'radioGroup',
+];
+
+const List<String> _insetSides = ['left', 'top', 'right', 'bottom'];
+
+/// Encodes a `setContextMenu` call (`Menu.toJson()` and
+/// `WinUIContextMenuStyle.toJson()`) into the packed binary format that the
+/// native side reads in place, without building an EncodableValue tree.
+///
+/// Items are laid out as the native menu compiler lays them out: each sibling
+/// block is followed by the blocks of its submenus, depth first. Style values
+/// other than bools, ints, doubles, strings and padding maps are dropped.
+///
+/// [generation] is echoed back with every click on the menu (32 bits).
+Uint8List packMenu(
+  Map<String, dynamic> menuJson, [
+  Map<String, dynamic>? styleJson,
+  int generation = 0,
+]) {
+  final strings = _StringTable();
+  final nodes = <_Node>[];
+  final rootCount = _packList(menuJson['items'], nodes, strings);
+
+  final styles = <_StyleEntry>[];
+  final insets = <double>[];
+  styleJson?.forEach((key, value) {
+    final _StyleEntry entry;
+    if (value is bool) {
+      entry = _StyleEntry(_styleBool, value ? 1 : 0);
+    } else if (value is int) {
+      entry = _StyleEntry(_styleInt, value);
+    } else if (value is double) {
+      entry = _StyleEntry(_styleDouble, value);
+    } else if (value is String) {
+      entry = _StyleEntry(_styleString, strings.intern(value));
+    } else if (value is Map) {
+      entry = _StyleEntry(_styleInsets, insets.length ~/ 4);
+      for (final side in _insetSides) {
+        final Object? inset = value[side];
+        insets.add(inset is num ? inset.toDouble() : 0);
+      }
+    } else {
+      return;
+    }
+    entry.key = strings.intern(key);
+    styles.add(entry);
+  });
+
+  final stringData = BytesBuilder(copy: false);
+  for (final bytes in strings.bytes) {
+    stringData.add(bytes);
+  }
+  final int stringCount = strings.bytes.length;
+  final int total = _headerSize +
+      stringCount * _stringRefSize +
+      nodes.length * _nodeSize +
+      styles.length * _styleSize +
+      insets.length ~/ 4 * _insetsSize +
+      stringData.length;
+
+  final buffer = Uint8List(total);
+  final data = ByteData.sublistView(buffer);
+  data
+    ..setUint32(0, packedMenuMagic, Endian.little)
+    ..setUint16(4, packedMenuVersion, Endian.little)
+    ..setUint16(6, _headerSize, Endian.little)
+    ..setUint32(8, total, Endian.little)
+    ..setUint32(12, stringCount, Endian.little)
+    ..setUint32(16, stringData.length, Endian.little)
+    ..setUint32(20, nodes.length, Endian.little)
+    ..setUint32(24, rootCount, Endian.little)
+    ..setUint32(28, styles.length, Endian.little)
+    ..setUint32(32, insets.length ~/ 4, Endian.little)
+    ..setUint32(36, generation & 0xFFFFFFFF, Endian.little);
+
+  var offset = _headerSize;
+  var dataOffset = 0;
+  for (final bytes in strings.bytes) {
+    data
+      ..setUint32(offset, dataOffset, Endian.little)
+      ..setUint32(offset + 4, bytes.length, Endian.little);
+    dataOffset += bytes.length;
+    offset += _stringRefSize;
+  }
+  for (final node in nodes) {
+    data
+      ..setUint8(offset, node.type)
+      ..setUint8(offset + 1, node.flags)
+      ..setInt32(offset + 4, node.id, Endian.little);
+    for (var i = 0; i < node.strings.length; i++) {
+      data.setUint32(offset + 8 + i * 4, node.strings[i], Endian.little);
+    }
+    data
+      ..setUint32(offset + 32, node.firstChild, Endian.little)
+      ..setUint32(offset + 36, node.childCount, Endian.little);
+    offset += _nodeSize;
+  }
+  for (final entry in styles) {
+    data
+      ..setUint32(offset, entry.key, Endian.little)
+      ..setUint8(offset + 4, entry.kind);
+    final Object value = entry.value;
+    if (value is double) {
+      data.setFloat64(offset + 8, value, Endian.little);
+    } else {
+      data.setInt64(offset + 8, value as int, Endian.little);
+    }
+    offset += _styleSize;
+  }
+  for (final inset in insets) {
+    data.setFloat64(offset, inset, Endian.little);
+    offset += 8;
+  }
+  buffer.setAll(offset, stringData.takeBytes());
+  return buffer;
+}
+
+/// Appends one sibling block, then the blocks of its submenus. Returns the
+/// number of nodes in the block.
+int _packList(Object? items, List<_Node> nodes, _StringTable strings) {
+  if (items is! List) return 0;
+  final first = nodes.length;
+  final children = <Object?>[];
+  for (final item in items) {
+    if (item is! Map) continue;
+    final int type = _itemTypes[item['type']] ?? 0;
+    final Object? id = item['id'];
+    nodes.add(_Node(
+      type: type,
+      flags: (item['disabled'] == true ? _nodeDisabled : 0) |
+          (item['checked'] == true ? _nodeChecked : 0) |
+          (item['virtualized'] == true ? _nodeVirtualized : 0),
+      id: id is int ? id : 0,
+      strings: [
+        for (final field in _nodeStringFields) strings.internValue(item[field]),
+      ],
+    ));
+    final Object? submenu = item['submenu'];
+    final bool hasChildren = type == _itemTypes['submenu'] ||
+        type == _itemTypes['split'];
+    children.add(hasChildren && submenu is Map ? submenu['items'] : null);
+  }
+  for (var i = 0; i < children.length; i++) {
+    final Object? childItems = children[i];
+    if (childItems == null) continue;
+    final node = nodes[first + i];
+    node.firstChild = nodes.length;
+    node.childCount = _packList(childItems, nodes, strings);
+  }
+  return children.length;
+}
+
+class _Node {
+  _Node({
+    required this.type,
+    required this.flags,
+    required this.id,
+    required this.strings,
+  });
+
+  final int type;
+  final int flags;
+  final int id;
+  final List<int> strings;
+  int firstChild = 0;
+  int childCount = 0;
+}
+
+class _StyleEntry {
+  _StyleEntry(this.kind, this.value);
+
+  final int kind;
+  final Object value;
+  int key = 0;
+}
+
+/// UTF-8 string table; id 0 is the empty string.
+class _StringTable {
+  final List<Uint8List> bytes = [Uint8List(0)];
+  final Map<String, int> _ids = {'': 0};
+
+  int intern(String value) {
+    return _ids.putIfAbsent(value, () {
+      bytes.add(utf8.encode(value));
+      return bytes.length - 1;
+    });
+  }
+
+  int internValue(Object? value) => value is String ? intern(value) : 0;
+}
@@ -5,8 +5,12 @@ import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 import 'package:menu_base/menu_base.dart';
 
+import 'menu_diff.dart';
+import 'menu_index.dart';
+import 'packed_menu.dart';
 import 'winui_context_menu_style.dart';
 import 'winui_flyout_placement.dart';
+import 'winui_live_item.dart';
 
 const _methodChannelName = 'tray_manager_winui';
 const _methodOnMenuItemClick = 'onMenuItemClick';
@@ -32,6 +36,55 @@ class TrayManagerWinUI {
 
   Menu? _menu;
   WinUIContextMenuStyle? _style;
+
+  /// Index of the [setContextMenu] menu, stamped with the generation last
+  /// sent to the native side.
+  MenuItemIndex? _menuIndex;
+
+  /// Last generation handed out; shared by all menus so that a click on one
+  /// never resolves against another.
+  int _generation = 0;
+
+  /// Menus registered with [registerMenu], kept to register them again when
+  /// the native side evicted them.
+  final Map<String, _NamedMenu> _namedMenus = {};
+
+  /// Handle of the menu last passed to [showContextMenu]; `null` for the
+  /// [setContextMenu] menu. Clicks are resolved against this menu.
+  String? _activeHandle;
+
+  /// Whether [setContextMenu] sends full menus in the packed binary format
+  /// (see [packMenu]) instead of through the method channel codec. Large
+  /// menus decode much faster on the native side; if the native side rejects
+  /// the buffer, the method channel is used instead.
+  bool usePackedMenuFormat = false;
+
+  /// Whether checkbox and radio items keep the state a click gives them.
+  ///
+  /// A click flips the item in the open menu (and unchecks the radio item it
+  /// replaces) either way. With [nativeToggles], that is the new state:
+  /// [MenuItem.checked] already holds it when `onClick` runs, and nothing is
+  /// sent. Without it (the default, as before native toggling), `onClick`
+  /// sees the previous state and decides: a handler that flips `checked`
+  /// (and calls [setContextMenu]) keeps the click without a resend, and a
+  /// click whose handler changes nothing is reverted.
+  ///
+  /// Handlers written for the default flip `checked` back when this is set;
+  /// in debug mode, that prints a warning.
+  bool nativeToggles = false;
+
+  /// Sends of the [setContextMenu] menu, one at a time.
+  final MenuSendQueue _menuSends = MenuSendQueue();
+
+  /// Menu and style JSON as last accepted by the native side.
+  Map<String, dynamic>? _sentMenuJson;
+  Map<String, dynamic>? _sentStyleJson;
+
+  /// Live item updates for the next `updateLiveItems` message, and the
+  /// pending send of it.
+  final LiveItemBatch _liveItems = LiveItemBatch();
+  Future<bool>? _liveItemsSend;
+
   final StreamController<MenuItem> _menuItemClickController =
       StreamController<MenuItem>.broadcast();
   final StreamController<void> _menuOpeningController =
@@ -59,17 +112,147 @@ class TrayManagerWinUI {
   ///
   /// Optionally pass [style] to customize the appearance of the WinUI context
   /// menu (background, text color, font, corner radius, etc.).
-  Future<void> setContextMenu(Menu menu, {WinUIContextMenuStyle? style}) async {
+  ///
+  /// Calling this again after changing item labels, `checked`, `disabled`,
+  /// tooltips, icons or accelerator text only sends those fields to the native
+  /// side (see [diffMenuJson]). Structural changes and style changes resend the
+  /// whole menu.
+  ///
+  /// Overlapping calls are sent one after another, each diffed against what
+  /// the previous one sent.
+  Future<void> setContextMenu(Menu menu, {WinUIContextMenuStyle? style}) {
     _menu = menu;
     _style = style;
     if (!Platform.isWindows) {
-      return;
+      return Future<void>.value();
+    }
+    final Map<String, dynamic> menuJson = menu.toJson();
+    final Map<String, dynamic>? styleJson = style?.toJson();
+    return _menuSends.run(() => _sendContextMenu(menu, menuJson, styleJson));
+  }
+
+  Future<void> _sendContextMenu(
+    Menu menu,
+    Map<String, dynamic> menuJson,
+    Map<String, dynamic>? styleJson,
+  ) async {
+    final Map<String, dynamic>? sentMenuJson = _sentMenuJson;
+    final MenuItemIndex? sentIndex = _menuIndex;
+    if (sentMenuJson != null &&
+        sentIndex != null &&
+        jsonEquals(styleJson, _sentStyleJson)) {
+      final patches = diffMenuJson(sentMenuJson, menuJson);
+      if (patches != null) {
+        // Same ids and structure: clicks on the shown version still name
+        // the same items, so the generation stays.
+        if (!identical(menu, sentIndex.menu)) {
+          _menuIndex = MenuItemIndex(menu, sentIndex.generation);
+        }
+        if (patches.isEmpty) return;
+        final Object? applied = await _channel.invokeMethod(
+          'updateMenuItems',
+          {'patches': patches},
+        );
+        if (applied == true) {
+          _sentMenuJson = menuJson;
+          return;
+        }
+      }
+    }
+
+    final int generation = _nextGeneration();
+    _menuIndex = MenuItemIndex(menu, generation);
+    if (!usePackedMenuFormat ||
+        !await _sendPackedMenu(menuJson, styleJson, generation)) {
+      final Map<String, dynamic> arguments = {
+        'menu': menuJson,
+        if (styleJson != null) 'style': styleJson,
+        'generation': generation,
+      };
+      await _channel.invokeMethod('setContextMenu', arguments);
+    }
+    _sentMenuJson = menuJson;
+    _sentStyleJson = styleJson;
+  }
+
+  int _nextGeneration() => _generation = nextMenuGeneration(_generation);
+
+  Future<bool> _sendPackedMenu(
+    Map<String, dynamic> menuJson,
+    Map<String, dynamic>? styleJson,
+    int generation,
+  ) async {
+    final Uint8List packed = packMenu(menuJson, styleJson, generation);
+    final BinaryMessenger messenger =
+        ServicesBinding.instance.defaultBinaryMessenger;
+    final ByteData? reply = await messenger.send(
+      packedMenuChannelName,
+      ByteData.sublistView(packed),
+    );
+    return reply != null && reply.lengthInBytes == 1 && reply.getUint8(0) == 1;
+  }
+
+  /// Registers [menu] under [handle], so that `showContextMenu(handle:)`
+  /// shows it without sending it again. Use it for apps with several context
+  /// menus (tray, per-document, per-row): each is compiled once and keeps its
+  /// own [style]. Registering a handle again replaces its menu.
+  ///
+  /// Registered menus are bounded by [setMenuMemoryBudget]; the least
+  /// recently shown ones are dropped natively first and registered again
+  /// transparently when shown. The [setContextMenu] menu is separate and not
+  /// counted. [setContextMenu]'s incremental updates do not apply here:
+  /// changing a registered menu re-registers it.
+  Future<void> registerMenu(
+    String handle,
+    Menu menu, {
+    WinUIContextMenuStyle? style,
+  }) async {
+    final named = _NamedMenu(MenuItemIndex(menu, _nextGeneration()), style);
+    _namedMenus[handle] = named;
+    if (!Platform.isWindows) return;
+    await _sendRegisterMenu(handle, named);
+  }
+
+  /// Removes the menu registered under [handle], natively and here.
+  Future<void> disposeMenu(String handle) async {
+    _namedMenus.remove(handle);
+    if (_activeHandle == handle) _activeHandle = null;
+    if (!Platform.isWindows) return;
+    await _channel.invokeMethod('disposeMenu', {'handle': handle});
+  }
+
+  /// Sets how many bytes the native side may hold for registered menus
+  /// (8 MiB by default), dropping the least recently shown ones to meet it.
+  Future<void> setMenuMemoryBudget(int bytes) async {
+    if (!Platform.isWindows) return;
+    await _channel.invokeMethod('setMenuMemoryBudget', {'bytes': bytes});
+  }
+
+  Future<void> _sendRegisterMenu(String handle, _NamedMenu named) async {
+    final Map<String, dynamic>? styleJson = named.style?.toJson();
+    await _channel.invokeMethod('registerMenu', {
+      'handle': handle,
+      'menu': named.menu.toJson(),
+      if (styleJson != null) 'style': styleJson,
+      'generation': named.index.generation,
+    });
+  }
+
+  /// Invokes [method] for the menu under [handle], registering it again and
+  /// retrying once if the native side evicted it.
+  Future<Object?> _invokeForMenu(
+    String method,
+    String? handle,
+    Map<String, dynamic>? arguments,
+  ) async {
+    try {
+      return await _channel.invokeMethod(method, arguments);
+    } on PlatformException catch (e) {
+      final _NamedMenu? named = handle == null ? null : _namedMenus[handle];
+      if (e.code != 'menu_not_registered' || named == null) rethrow;
+      await _sendRegisterMenu(handle!, named);
+      return _channel.invokeMethod(method, arguments);
     }
-    final Map<String, dynamic> arguments = {
-      'menu': menu.toJson(),
-      if (style != null) 'style': style.toJson(),
-    };
-    await _channel.invokeMethod('setContextMenu', arguments);
   }
 
   /// Shows the WinUI context menu.
@@ -84,21 +267,38 @@ class TrayManagerWinUI {
   /// Use [exclusionRect] to specify a screen area the menu should avoid
   /// (e.g. the taskbar). Coordinates are in physical pixels.
   ///
+  /// Pass [handle] to show a menu registered with [registerMenu] instead of
+  /// the [setContextMenu] menu.
+  ///
   /// Call this from [TrayListener.onTrayIconRightMouseDown] instead of
   /// [trayManager.popUpContextMenu].
   ///
+  /// The returned future completes once the menu has opened, or as soon as
+  /// the show fails. The first show after startup also waits for WinUI
+  /// initialization, unless [setContextMenu] already finished it; the
+  /// platform thread is never blocked meanwhile.
+  ///
+  /// The latest call wins: calls made while an earlier one has not opened
+  /// yet are merged into it (the latest position, placement and
+  /// [exclusionRect] are used) and complete with its outcome; a call made
+  /// while the menu is open reopens it at the new position.
+  ///
   /// On non-Windows platforms, this does nothing.
-  /// Returns `true` if the menu was shown, `false` if WinUI is not available (stub).
+  /// Returns `true` if the menu was shown, `false` if WinUI is not available
+  /// (stub) or the show failed.
   Future<bool> showContextMenu({
     double? x,
     double? y,
     WinUIFlyoutPlacement? placement,
     Rect? exclusionRect,
+    String? handle,
   }) async {
     if (!Platform.isWindows) {
       return false;
     }
+    _activeHandle = handle;
     final Map<String, dynamic> arguments = {};
+    if (handle != null) arguments['handle'] = handle;
     if (x != null) arguments['x'] = x;
     if (y != null) arguments['y'] = y;
     if (placement != null) arguments['placement'] = placement.name;
@@ -110,8 +310,9 @@ class TrayManagerWinUI {
         'height': exclusionRect.height,
       };
     }
-    final Object? result = await _channel.invokeMethod(
+    final Object? result = await _invokeForMenu(
       'showContextMenu',
+      handle,
       arguments.isEmpty ? null : arguments,
     );
     final bool shown = result == true;
@@ -125,6 +326,102 @@ class TrayManagerWinUI {
     return shown;
   }
 
+  /// Builds the hidden menu for the current [setContextMenu] (or the menu
+  /// registered under [handle]) in the background (host window, XAML island,
+  /// styles and every item), so that the next [showContextMenu] only
+  /// positions it and opens it.
+  ///
+  /// Call it when a show is likely, e.g. on tray icon hover or right after
+  /// [setContextMenu]. Changing the menu afterwards makes the prepared menu
+  /// stale; the next show then builds what changed, as without preparing.
+  ///
+  /// Returns `false` if no menu is set or WinUI is not available.
+  Future<bool> prepareContextMenu({String? handle}) async {
+    if (!Platform.isWindows) return false;
+    final Object? result = await _invokeForMenu(
+      'prepareContextMenu',
+      handle,
+      handle == null ? null : {'handle': handle},
+    );
+    return result == true;
+  }
+
+  /// Updates the label, icon or disabled state of items in the open context
+  /// menu in place, without sending the menu again; for progress and status
+  /// items that change many times a second.
+  ///
+  /// Updates from the same microtask go out as one message, merged per item
+  /// and field (the latest value wins). The native side merges them further
+  /// and applies them at most once per display frame, so the platform thread
+  /// never falls behind. Items built later (unopened submenus, other pages)
+  /// show the live values when built; see [WinUILiveItemUpdate] for how long
+  /// they last.
+  ///
+  /// Returns `false` if WinUI is not available, or not initialized yet (no
+  /// menu has been set, prepared or shown), in which case the updates are
+  /// dropped, or if the native side rejected one of them.
+  Future<bool> updateLiveItems(Iterable<WinUILiveItemUpdate> updates) {
+    if (!Platform.isWindows) return Future.value(false);
+    updates.forEach(_liveItems.add);
+    return _liveItemsSend ??= Future.microtask(_sendLiveItems);
+  }
+
+  /// Calls [updateLiveItems] for every update on [updates]; cancel the
+  /// subscription to stop.
+  StreamSubscription<WinUILiveItemUpdate> bindLiveItems(
+    Stream<WinUILiveItemUpdate> updates,
+  ) {
+    return updates.listen((update) => unawaited(updateLiveItems([update])));
+  }
+
+  Future<bool> _sendLiveItems() async {
+    _liveItemsSend = null;
+    if (_liveItems.isEmpty) return true;
+    final Object? result = await _channel.invokeMethod(
+      'updateLiveItems',
+      {'items': _liveItems.take()},
+    );
+    return result == true;
+  }
+
+  /// Turns recording of native show-pipeline spans (WinUI initialization,
+  /// host window and XAML island creation, style parsing, item building,
+  /// ShowAt, Opened) on or off. Off by default.
+  Future<void> setTracingEnabled(bool enabled) async {
+    if (!Platform.isWindows) return;
+    await _channel.invokeMethod('setTracingEnabled', {'enabled': enabled});
+  }
+
+  /// Returns the spans recorded since tracing was enabled (or since the last
+  /// [getTrace] with [clear]) as Chrome `trace_event` JSON, for
+  /// `chrome://tracing` or Perfetto. The native side keeps the most recent
+  /// 4096 spans.
+  Future<String> getTrace({bool clear = false}) async {
+    if (!Platform.isWindows) return '{"traceEvents":[]}';
+    final String? trace = await _channel.invokeMethod<String>(
+      'getTrace',
+      {'clear': clear},
+    );
+    return trace ?? '{"traceEvents":[]}';
+  }
+
+  /// Records a native toggle in the menu JSON last sent for the
+  /// [setContextMenu] menu, so that the next diff starts from what the
+  /// native side shows. Without the item, the next [setContextMenu] sends the
+  /// whole menu.
+  void _syncSentChecked(
+    String? handle,
+    int id,
+    bool checked,
+    List<int>? path,
+  ) {
+    final Map<String, dynamic>? sent = _sentMenuJson;
+    if (handle != null || sent == null) return;
+    if (!setMenuJsonChecked(sent, id, checked, path: path)) {
+      _sentMenuJson = null;
+    }
+  }
+
   Future<dynamic> _methodCallHandler(MethodCall call) async {
     switch (call.method) {
       case _methodOnMenuItemClick:
@@ -132,16 +429,63 @@ class TrayManagerWinUI {
         if (args is! Map) return;
         final id = args['id'];
         if (id is! int) return;
+        final generation = args['generation'];
+        final List<int>? path = _intList(args['path']);
 
-        final MenuItem? menuItem = _menu?.getMenuItemById(id);
+        // A click from a menu version that has been replaced since (or from
+        // another menu) resolves to null and is dropped.
+        final String? handle = _activeHandle;
+        final _NamedMenu? named = handle == null ? null : _namedMenus[handle];
+        final MenuItemIndex? index = handle == null ? _menuIndex : named?.index;
+        final MenuItem? menuItem = index?.resolve(
+          id,
+          generation: generation is int ? generation : null,
+          path: path,
+        );
         if (menuItem != null) {
-          final bool? oldChecked = menuItem.checked;
+          // Checkbox and radio clicks were applied natively (the item
+          // toggled, and the radio item it replaces unchecked). The sent
+          // JSON follows what is shown; the items only with nativeToggles,
+          // otherwise onClick sees the previous state as it always did.
+          final checked = args['checked'];
+          final bool? shownChecked =
+              checked is bool ? checked : menuItem.checked;
+          MenuItem? unchecked;
+          if (checked is bool) {
+            if (nativeToggles) menuItem.checked = checked;
+            _syncSentChecked(handle, id, checked, path);
+            final uncheckedId = args['uncheckedId'];
+            if (uncheckedId is int) {
+              final List<int>? uncheckedPath = _intList(args['uncheckedPath']);
+              unchecked = index!.resolve(uncheckedId, path: uncheckedPath);
+              if (nativeToggles) unchecked?.checked = false;
+              _syncSentChecked(handle, uncheckedId, false, uncheckedPath);
+            }
+          }
+
           menuItem.onClick?.call(menuItem);
           _menuItemClickController.add(menuItem);
 
-          final bool? newChecked = menuItem.checked;
-          if (oldChecked != newChecked) {
-            await setContextMenu(_menu!, style: _style);
+          if (kDebugMode &&
+              nativeToggles &&
+              checked is bool &&
+              menuItem.checked != checked) {
+            debugPrint(
+              'tray_manager_winui: onClick of "${menuItem.label}" set '
+              'checked back to ${menuItem.checked}. With nativeToggles the '
+              'item is already toggled when onClick runs; do not flip it.',
+            );
+          }
+
+          // Resend only if what the native side shows is not what the items
+          // say: onClick changed it, or (without nativeToggles) did not
+          // accept the click.
+          if (menuItem.checked != shownChecked || unchecked?.checked == true) {
+            if (named != null) {
+              await registerMenu(handle!, named.menu, style: named.style);
+            } else {
+              await setContextMenu(_menu!, style: _style);
+            }
           }
         }
       case _methodOnMenuOpening:
@@ -153,3 +497,16 @@ class TrayManagerWinUI {
     }
   }
 }
+
+List<int>? _intList(Object? value) =>
+    value is List ? value.whereType<int>().toList() : null;
+
+class _NamedMenu {
+  _NamedMenu(this.index, this.style);
+
+  /// The menu with its generation; a new registration gets a new one.
+  final MenuItemIndex index;
+  final WinUIContextMenuStyle? style;
+
+  Menu get menu => index.menu;
+}
@@ -39,6 +39,11 @@ class WinUIContextMenuStyle {
     this.keyboardAcceleratorColor,
     this.compactItemLayout = true,
     this.maxHeight,
+    this.virtualizationThreshold,
+    this.virtualizationPageSize,
+    this.virtualizationMaxItems,
+    this.virtualizationMoreLabel,
+    this.virtualizationPreviousLabel,
     this.enableOpenCloseAnimations,
     this.dismissOnPointerMoveAway = false,
     this.backdropType,
@@ -53,7 +58,13 @@ class WinUIContextMenuStyle {
             'shadowElevation must be non-negative'),
         assert(minWidth == null || minWidth > 0, 'minWidth must be positive'),
         assert(maxHeight == null || maxHeight > 0,
-            'maxHeight must be positive');
+            'maxHeight must be positive'),
+        assert(virtualizationThreshold == null || virtualizationThreshold >= 0,
+            'virtualizationThreshold must be non-negative'),
+        assert(virtualizationPageSize == null || virtualizationPageSize > 0,
+            'virtualizationPageSize must be positive'),
+        assert(virtualizationMaxItems == null || virtualizationMaxItems > 0,
+            'virtualizationMaxItems must be positive');
 
   /// Background color of the menu popup.
   final Color? backgroundColor;
@@ -139,6 +150,29 @@ class WinUIContextMenuStyle {
   /// Shows a scrollbar when content exceeds this height.
   final double? maxHeight;
 
+  /// Item lists (the menu itself or a submenu) with more entries than this
+  /// are paged: only a page of items is created, with a "More…" item that
+  /// loads the next page when clicked, hovered or reached by keyboard.
+  /// Null uses the native default (256); 0 pages only submenus marked
+  /// [WinUIMenuItem.virtualized].
+  final int? virtualizationThreshold;
+
+  /// Entries loaded per page of a paged list. Null fits a page to
+  /// [maxHeight] (or about a screen of items) plus a small margin.
+  final int? virtualizationPageSize;
+
+  /// Most items of one paged list that exist at once. Paging past it
+  /// removes items at the other end, which come back through a
+  /// "Previous…"/"More…" item. Null uses the native default (256).
+  final int? virtualizationMaxItems;
+
+  /// Label of the item that loads the next page. Defaults to "More…".
+  final String? virtualizationMoreLabel;
+
+  /// Label of the item that loads the previous page. Defaults to
+  /// "Previous…".
+  final String? virtualizationPreviousLabel;
+
   /// Controls open/close animations. Null uses WinUI default (enabled).
   /// Set to false to disable animations.
   final bool? enableOpenCloseAnimations;
@@ -239,6 +273,21 @@ class WinUIContextMenuStyle {
     if (maxHeight != null) {
       map['maxHeight'] = maxHeight;
     }
+    if (virtualizationThreshold != null) {
+      map['virtualizationThreshold'] = virtualizationThreshold;
+    }
+    if (virtualizationPageSize != null) {
+      map['virtualizationPageSize'] = virtualizationPageSize;
+    }
+    if (virtualizationMaxItems != null) {
+      map['virtualizationMaxItems'] = virtualizationMaxItems;
+    }
+    if (virtualizationMoreLabel != null) {
+      map['virtualizationMoreLabel'] = virtualizationMoreLabel;
+    }
+    if (virtualizationPreviousLabel != null) {
+      map['virtualizationPreviousLabel'] = virtualizationPreviousLabel;
+    }
     if (enableOpenCloseAnimations != null) {
       map['enableOpenCloseAnimations'] = enableOpenCloseAnimations;
     }
@@ -0,0 +1,75 @@
+import 'winui_icon.dart';
+
+/// New values for the items with [id] in the open WinUI context menu, for
+/// [TrayManagerWinUI.updateLiveItems]. Fields left `null` keep what the item
+/// shows.
+///
+/// Live values change only what the flyout shows, not the [MenuItem]: they
+/// last until the menu is sent again with changes (or another menu is
+/// shown), which restores the menu's own values.
+class WinUILiveItemUpdate {
+  const WinUILiveItemUpdate(
+    this.id, {
+    this.label,
+    this.icon,
+    this.disabled,
+  });
+
+  /// [MenuItem.id] of the items to update.
+  final int id;
+
+  final String? label;
+
+  /// Shown only on items laid out with icons (see
+  /// [WinUIContextMenuStyle.compactItemLayout]); the font of the menu's icon
+  /// is kept.
+  final WinUIIcon? icon;
+
+  final bool? disabled;
+
+  /// This update with the fields [newer] sets replaced by its values.
+  WinUILiveItemUpdate mergedWith(WinUILiveItemUpdate newer) {
+    assert(newer.id == id);
+    return WinUILiveItemUpdate(
+      id,
+      label: newer.label ?? label,
+      icon: newer.icon ?? icon,
+      disabled: newer.disabled ?? disabled,
+    );
+  }
+
+  Map<String, dynamic> toJson() => {
+        'id': id,
+        if (label != null) 'label': label,
+        if (icon != null) 'icon': icon!.toIconString(),
+        if (disabled != null) 'disabled': disabled,
+      };
+}
+
+/// Live item updates waiting to be sent, merged per item and field so that
+/// a burst of updates costs one message with the latest value of each.
+class LiveItemBatch {
+  final Map<int, WinUILiveItemUpdate> _updates = {};
+
+  bool get isEmpty => _updates.isEmpty;
+
+  /// Number of distinct items waiting.
+  int get length => _updates.length;
+
+  void add(WinUILiveItemUpdate update) {
+    final WinUILiveItemUpdate? pending = _updates[update.id];
+    _updates[update.id] =
+        pending == null ? update : pending.mergedWith(update);
+  }
+
+  /// The `updateLiveItems` entries, in the order items were first added;
+  /// empties the batch.
+  List<Map<String, dynamic>> take() {
+    final entries = [
+      for (final WinUILiveItemUpdate update in _updates.values)
+        update.toJson(),
+    ];
+    _updates.clear();
+    return entries;
+  }
+}
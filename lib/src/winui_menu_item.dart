@@ -4,8 +4,9 @@ import 'winui_icon.dart';
 
 /// Extended [MenuItem] with WinUI 3-specific features.
 ///
-/// Adds support for [winuiIcon], [acceleratorText], and [radioGroup]
-/// properties that are serialized into the JSON sent to the native side.
+/// Adds support for [winuiIcon], [acceleratorText], [radioGroup] and
+/// [virtualized] properties that are serialized into the JSON sent to the
+/// native side.
 ///
 /// Use standard [MenuItem] constructors for basic items. Use [WinUIMenuItem]
 /// when you need WinUI-specific features like icons or keyboard shortcut text.
@@ -19,11 +20,16 @@ class WinUIMenuItem extends MenuItem {
     super.toolTip,
     this.winuiIcon,
     this.acceleratorText,
-  }) : radioGroup = null;
+  })  : radioGroup = null,
+        virtualized = false;
 
   /// Creates a checkbox menu item with optional WinUI extras.
   ///
-  /// Renders as a [ToggleMenuFlyoutItem] on the native side.
+  /// Renders as a [ToggleMenuFlyoutItem] on the native side. A click flips
+  /// the item natively. With `TrayManagerWinUI.nativeToggles`, [checked]
+  /// already holds the new state when [onClick] runs and there is no need to
+  /// call [setContextMenu] again; without it, [onClick] flips [checked] as
+  /// before, or the click is reverted.
   WinUIMenuItem.checkbox({
     super.key,
     super.label,
@@ -34,9 +40,13 @@ class WinUIMenuItem extends MenuItem {
     this.winuiIcon,
     this.acceleratorText,
   })  : radioGroup = null,
+        virtualized = false,
         super.checkbox();
 
   /// Creates a submenu item with optional WinUI extras.
+  ///
+  /// Set [virtualized] for submenus that can grow long (recent files,
+  /// devices) to load their items a page at a time.
   WinUIMenuItem.submenu({
     super.key,
     super.label,
@@ -44,6 +54,7 @@ class WinUIMenuItem extends MenuItem {
     super.disabled,
     super.toolTip,
     this.winuiIcon,
+    this.virtualized = false,
   })  : radioGroup = null,
         acceleratorText = null,
         super.submenu();
@@ -62,16 +73,23 @@ class WinUIMenuItem extends MenuItem {
     super.toolTip,
     this.winuiIcon,
     this.acceleratorText,
+    this.virtualized = false,
   })  : radioGroup = null,
         super(type: 'split');
 
   /// Creates a radio menu item that belongs to a mutual-exclusion group.
   ///
-  /// Items with the same [radioGroup] name form a radio group — selecting one
-  /// automatically deselects the others on the native side. Update the
-  /// [checked] state in [onClick] and call [setContextMenu] again to sync.
+  /// Items with the same [radioGroup] name form a radio group, across
+  /// submenus; radio items without a group form one per submenu. Selecting
+  /// one deselects the others on the native side, in the open flyout. With
+  /// `TrayManagerWinUI.nativeToggles`, [checked] is already updated on both
+  /// items when [onClick] runs; without it, [onClick] updates them as
+  /// before, or the selection is reverted. Changing [checked] in [onClick]
+  /// always works and is sent again.
   ///
-  /// Renders as a [RadioMenuFlyoutItem] with [GroupName] on the native side.
+  /// Renders as a [ToggleMenuFlyoutItem] on the native side, with the group
+  /// kept exclusive natively ([RadioMenuFlyoutItem] does not work in XAML
+  /// islands).
   WinUIMenuItem.radio({
     super.key,
     super.label,
@@ -82,7 +100,8 @@ class WinUIMenuItem extends MenuItem {
     super.toolTip,
     this.winuiIcon,
     this.acceleratorText,
-  }) : super(type: 'radio', checked: checked);
+  })  : virtualized = false,
+        super(type: 'radio', checked: checked);
 
   /// WinUI icon displayed to the left of the label.
   ///
@@ -105,6 +124,14 @@ class WinUIMenuItem extends MenuItem {
   /// form a radio group where only one can be checked at a time.
   final String? radioGroup;
 
+  /// Whether the submenu is paged whatever its length.
+  ///
+  /// Only set on [WinUIMenuItem.submenu] and [WinUIMenuItem.split]. Paged
+  /// submenus create a page of items and a "More…" item that loads the next
+  /// one; see `WinUIContextMenuStyle.virtualizationThreshold` for paging
+  /// long lists automatically.
+  final bool virtualized;
+
   @override
   Map<String, dynamic> toJson() {
     final json = super.toJson();
@@ -123,6 +150,9 @@ class WinUIMenuItem extends MenuItem {
     if (radioGroup != null) {
       json['radioGroup'] = radioGroup;
     }
+    if (virtualized) {
+      json['virtualized'] = true;
+    }
     return json;
   }
 }
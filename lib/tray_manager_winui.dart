@@ -2,4 +2,5 @@ export 'src/tray_manager_winui.dart';
 export 'src/winui_context_menu_style.dart';
 export 'src/winui_flyout_placement.dart';
 export 'src/winui_icon.dart';
+export 'src/winui_live_item.dart' show WinUILiveItemUpdate;
 export 'src/winui_menu_item.dart';
@@ -0,0 +1,176 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:menu_base/menu_base.dart';
+import 'package:tray_manager_winui/src/menu_diff.dart';
+import 'package:tray_manager_winui/tray_manager_winui.dart';
+
+void main() {
+  late MenuItem open;
+  late MenuItem wrap;
+  late MenuItem nested;
+  late Menu menu;
+
+  setUp(() {
+    open = WinUIMenuItem(label: 'Open', acceleratorText: 'Ctrl+O');
+    wrap = WinUIMenuItem.checkbox(label: 'Wrap', checked: false);
+    nested = MenuItem(label: 'Nested', toolTip: 'tip');
+    menu = Menu(items: [
+      open,
+      MenuItem.separator(),
+      wrap,
+      MenuItem.submenu(label: 'More', submenu: Menu(items: [nested])),
+    ]);
+  });
+
+  group('diffMenuJson', () {
+    test('returns no patches for an unchanged menu', () {
+      expect(diffMenuJson(menu.toJson(), menu.toJson()), isEmpty);
+    });
+
+    test('patches a checkbox toggle', () {
+      final before = menu.toJson();
+      wrap.checked = true;
+      expect(diffMenuJson(before, menu.toJson()), [
+        {'id': wrap.id, 'field': 'checked', 'value': true},
+      ]);
+    });
+
+    test('patches fields of submenu items', () {
+      final before = menu.toJson();
+      nested.label = 'Renamed';
+      nested.disabled = true;
+      final patches = diffMenuJson(before, menu.toJson());
+      expect(patches, hasLength(2));
+      expect(
+        patches,
+        contains({'id': nested.id, 'field': 'label', 'value': 'Renamed'}),
+      );
+      expect(
+        patches,
+        contains({'id': nested.id, 'field': 'disabled', 'value': true}),
+      );
+    });
+
+    test('sends null for removed fields', () {
+      final before = menu.toJson();
+      nested.toolTip = null;
+      expect(diffMenuJson(before, menu.toJson()), [
+        {'id': nested.id, 'field': 'toolTip', 'value': null},
+      ]);
+    });
+
+    test('requires a full resend for structural changes', () {
+      final before = menu.toJson();
+      menu.items!.add(MenuItem(label: 'Exit'));
+      expect(diffMenuJson(before, menu.toJson()), isNull);
+    });
+
+    test('requires a full resend for reordered items', () {
+      final before = menu.toJson();
+      menu.items!.insert(0, menu.items!.removeAt(2));
+      expect(diffMenuJson(before, menu.toJson()), isNull);
+    });
+
+    test('requires a full resend for non-patchable fields', () {
+      final before = menu.toJson();
+      final after = menu.toJson();
+      (after['items'] as List)[0]['type'] = 'checkbox';
+      expect(diffMenuJson(before, after), isNull);
+
+      final radioBefore =
+          Menu(items: [WinUIMenuItem.radio(label: 'A', radioGroup: 'g1')]);
+      final json = radioBefore.toJson();
+      final changed = radioBefore.toJson();
+      (changed['items'] as List)[0]['radioGroup'] = 'g2';
+      expect(diffMenuJson(json, changed), isNull);
+    });
+
+    test('requires a full resend when a submenu appears', () {
+      final before = menu.toJson();
+      final after = menu.toJson();
+      (after['items'] as List)[0]['submenu'] = {'items': <Object?>[]};
+      expect(diffMenuJson(before, after), isNull);
+    });
+  });
+
+  group('setMenuJsonChecked', () {
+    test('follows the click path', () {
+      final json = menu.toJson();
+      expect(setMenuJsonChecked(json, wrap.id, true, path: [2]), isTrue);
+      wrap.checked = true;
+      expect(diffMenuJson(json, menu.toJson()), isEmpty);
+    });
+
+    test('searches when the path is missing or stale', () {
+      final inner = WinUIMenuItem.checkbox(label: 'Inner', checked: false);
+      menu.items![3].submenu!.items!.add(inner);
+      final json = menu.toJson();
+      expect(setMenuJsonChecked(json, inner.id, true), isTrue);
+      expect(setMenuJsonChecked(json, wrap.id, true, path: [0]), isTrue);
+      inner.checked = true;
+      wrap.checked = true;
+      expect(diffMenuJson(json, menu.toJson()), isEmpty);
+    });
+
+    test('reports unknown ids', () {
+      final json = menu.toJson();
+      expect(setMenuJsonChecked(json, -1, true, path: [9, 9]), isFalse);
+      expect(diffMenuJson(menu.toJson(), json), isEmpty);
+    });
+  });
+
+  group('MenuSendQueue', () {
+    test('keeps a quickly reverted toggle in sync', () async {
+      // What setContextMenu does: diff against the JSON the native side
+      // last accepted, then send the patches, which takes a while.
+      Map<String, dynamic> sent = menu.toJson();
+      bool? nativeChecked = wrap.checked;
+      final queue = MenuSendQueue();
+      Future<void> setContextMenu() {
+        final json = menu.toJson();
+        return queue.run(() async {
+          final patches = diffMenuJson(sent, json)!;
+          if (patches.isEmpty) return;
+          await Future<void>.delayed(const Duration(milliseconds: 10));
+          nativeChecked = patches.single['value'] as bool;
+          sent = json;
+        });
+      }
+
+      wrap.checked = true;
+      final toggle = setContextMenu();
+      wrap.checked = false;
+      final revert = setContextMenu();
+      await Future.wait([toggle, revert]);
+      expect(nativeChecked, isFalse);
+      expect(diffMenuJson(sent, menu.toJson()), isEmpty);
+    });
+
+    test('runs later sends after a failed one', () async {
+      final queue = MenuSendQueue();
+      final failed = queue.run(() async => throw StateError('no channel'));
+      var ran = false;
+      final next = queue.run(() async => ran = true);
+      await expectLater(failed, throwsStateError);
+      await next;
+      expect(ran, isTrue);
+    });
+  });
+
+  group('jsonEquals', () {
+    test('compares nested maps and lists by value', () {
+      expect(
+        jsonEquals({
+          'padding': {'left': 1.0, 'top': 2.0},
+          'list': [1, 2],
+        }, {
+          'list': [1, 2],
+          'padding': {'top': 2.0, 'left': 1.0},
+        }),
+        isTrue,
+      );
+      expect(jsonEquals({'a': 1}, {'a': 2}), isFalse);
+      expect(jsonEquals({'a': null}, <String, Object?>{}), isFalse);
+      expect(jsonEquals(null, null), isTrue);
+    });
+  });
+}
@@ -0,0 +1,70 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:menu_base/menu_base.dart';
+import 'package:tray_manager_winui/src/menu_index.dart';
+
+void main() {
+  late MenuItem open;
+  late MenuItem nested;
+  late Menu menu;
+
+  setUp(() {
+    open = MenuItem(label: 'Open');
+    nested = MenuItem(label: 'Nested');
+    menu = Menu(items: [
+      open,
+      MenuItem.separator(),
+      MenuItem.submenu(label: 'More', submenu: Menu(items: [nested])),
+    ]);
+  });
+
+  group('MenuItemIndex', () {
+    test('finds items at any depth', () {
+      final index = MenuItemIndex(menu, 3);
+      expect(index.length, 4);
+      expect(index.resolve(open.id, generation: 3), same(open));
+      expect(index.resolve(nested.id, generation: 3, path: [2, 0]),
+          same(nested));
+      expect(index.resolve(-1, generation: 3), isNull);
+    });
+
+    test('drops clicks on other generations', () {
+      final index = MenuItemIndex(menu, 3);
+      expect(index.resolve(open.id, generation: 2), isNull);
+      expect(index.resolve(open.id, generation: 4), isNull);
+      // Unstamped events are resolved by id.
+      expect(index.resolve(open.id), same(open));
+    });
+
+    test('matches the tree walk on a large menu', () {
+      final items = [
+        for (var i = 0; i < 100; i++)
+          MenuItem.submenu(
+            label: 'Group $i',
+            submenu: Menu(items: [
+              for (var j = 0; j < 100; j++) MenuItem(label: 'Item $i.$j'),
+            ]),
+          ),
+      ];
+      final large = Menu(items: items);
+      final index = MenuItemIndex(large, 1);
+      expect(index.length, 100 * 101);
+      for (final group in items) {
+        for (final item in group.submenu!.items!) {
+          expect(index.resolve(item.id, generation: 1),
+              same(large.getMenuItemById(item.id)));
+        }
+      }
+    });
+
+    test('ignores paths that do not lead to the id', () {
+      final index = MenuItemIndex(menu, 1);
+      expect(index.resolve(open.id, generation: 1, path: [9, 9]), same(open));
+    });
+  });
+
+  test('nextMenuGeneration wraps to 1 after 32 bits', () {
+    expect(nextMenuGeneration(0), 1);
+    expect(nextMenuGeneration(41), 42);
+    expect(nextMenuGeneration(0xFFFFFFFF), 1);
+  });
+}
@@ -0,0 +1,150 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:flutter/painting.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:menu_base/menu_base.dart';
+import 'package:tray_manager_winui/src/packed_menu.dart';
+import 'package:tray_manager_winui/tray_manager_winui.dart';
+
+/// Reads back the parts of a packed buffer the tests look at.
+class _Packed {
+  _Packed(Uint8List bytes)
+      : data = ByteData.sublistView(bytes),
+        length = bytes.length;
+
+  final ByteData data;
+  final int length;
+
+  int u32(int offset) => data.getUint32(offset, Endian.little);
+
+  int get stringCount => u32(12);
+  int get nodeCount => u32(20);
+  int get rootCount => u32(24);
+  int get styleCount => u32(28);
+  int get insetCount => u32(32);
+
+  int get _nodes => 40 + stringCount * 8;
+  int get _styles => _nodes + nodeCount * 40;
+  int get _insets => _styles + styleCount * 16;
+  int get _stringData => _insets + insetCount * 32;
+
+  String str(int id) {
+    final offset = u32(40 + id * 8);
+    final size = u32(40 + id * 8 + 4);
+    return utf8.decode(Uint8List.sublistView(
+        data, _stringData + offset, _stringData + offset + size));
+  }
+
+  int type(int node) => data.getUint8(_nodes + node * 40);
+  int flags(int node) => data.getUint8(_nodes + node * 40 + 1);
+  int id(int node) => data.getInt32(_nodes + node * 40 + 4, Endian.little);
+  String label(int node) => str(u32(_nodes + node * 40 + 8));
+  String acceleratorText(int node) => str(u32(_nodes + node * 40 + 20));
+  int firstChild(int node) => u32(_nodes + node * 40 + 32);
+  int childCount(int node) => u32(_nodes + node * 40 + 36);
+
+  Map<String, Object> style() {
+    final result = <String, Object>{};
+    for (var i = 0; i < styleCount; i++) {
+      final record = _styles + i * 16;
+      final key = str(u32(record));
+      switch (data.getUint8(record + 4)) {
+        case 1:
+          result[key] = data.getUint8(record + 8) != 0;
+        case 2:
+          result[key] = data.getInt64(record + 8, Endian.little);
+        case 3:
+          result[key] = data.getFloat64(record + 8, Endian.little);
+        case 4:
+          result[key] = str(u32(record + 8));
+        case 5:
+          final insets = _insets + u32(record + 8) * 32;
+          result[key] = {
+            'left': data.getFloat64(insets, Endian.little),
+            'top': data.getFloat64(insets + 8, Endian.little),
+            'right': data.getFloat64(insets + 16, Endian.little),
+            'bottom': data.getFloat64(insets + 24, Endian.little),
+          };
+      }
+    }
+    return result;
+  }
+}
+
+void main() {
+  test('writes a versioned header whose size matches the buffer', () {
+    final bytes = packMenu(Menu(items: [MenuItem(label: 'Quit')]).toJson());
+    final packed = _Packed(bytes);
+    expect(packed.u32(0), packedMenuMagic);
+    expect(packed.data.getUint16(4, Endian.little), packedMenuVersion);
+    expect(packed.u32(8), bytes.length);
+    expect(packed.nodeCount, 1);
+    expect(packed.rootCount, 1);
+    expect(packed.styleCount, 0);
+    expect(packed.str(0), '');
+  });
+
+  test('stores the menu generation in the header', () {
+    final json = Menu(items: [MenuItem(label: 'Quit')]).toJson();
+    expect(_Packed(packMenu(json)).u32(36), 0);
+    expect(_Packed(packMenu(json, null, 0xC0FFEE)).u32(36), 0xC0FFEE);
+  });
+
+  test('lays out submenus after their sibling block, depth first', () {
+    final open = WinUIMenuItem(label: 'Open', acceleratorText: 'Ctrl+O');
+    final older = MenuItem.submenu(
+      label: 'Older',
+      submenu: Menu(items: [WinUIMenuItem.radio(
+          label: 'b.txt', radioGroup: 'older', checked: true)]),
+    );
+    final menu = Menu(items: [
+      open,
+      MenuItem.submenu(
+        label: 'Recent',
+        submenu: Menu(items: [WinUIMenuItem.checkbox(label: 'a.txt'), older]),
+      ),
+      MenuItem(label: 'Quit', disabled: true),
+    ]);
+
+    final packed = _Packed(packMenu(menu.toJson()));
+    expect(packed.nodeCount, 6);
+    expect(packed.rootCount, 3);
+    expect([for (var i = 0; i < 6; i++) packed.label(i)],
+        ['Open', 'Recent', 'Quit', 'a.txt', 'Older', 'b.txt']);
+    expect([for (var i = 0; i < 6; i++) packed.type(i)], [0, 2, 0, 3, 2, 4]);
+    expect(packed.id(0), open.id);
+    expect(packed.acceleratorText(0), 'Ctrl+O');
+    expect(packed.flags(2), 1); // disabled
+    expect(packed.flags(5), 2); // checked
+    expect([packed.firstChild(1), packed.childCount(1)], [3, 2]);
+    expect([packed.firstChild(4), packed.childCount(4)], [5, 1]);
+    expect(packed.childCount(0), 0);
+  });
+
+  test('interns repeated strings once', () {
+    final menu = Menu(items: [
+      for (var i = 0; i < 10; i++) MenuItem(label: 'Same', toolTip: 'Same'),
+    ]);
+    expect(_Packed(packMenu(menu.toJson())).stringCount, 2);
+  });
+
+  test('encodes style values by kind', () {
+    const style = WinUIContextMenuStyle(
+      textColor: Color(0xFFEEEEEE),
+      fontSize: 13.5,
+      fontFamily: 'Segoe UI',
+      compactItemLayout: true,
+      padding: EdgeInsets.fromLTRB(4, 2, 4, 2),
+    );
+    final packed = _Packed(packMenu(Menu(items: []).toJson(), style.toJson()));
+    final decoded = packed.style();
+    expect(decoded['textColor'], 0xFFEEEEEE);
+    expect(decoded['fontSize'], 13.5);
+    expect(decoded['fontFamily'], 'Segoe UI');
+    expect(decoded['compactItemLayout'], true);
+    expect(decoded['padding'],
+        {'left': 4.0, 'top': 2.0, 'right': 4.0, 'bottom': 2.0});
+    expect(packed.insetCount, 1);
+  });
+}
@@ -67,6 +67,23 @@ void main() {
       expect(json['maxHeight'], 400.0);
     });
 
+    test('virtualization properties serialize correctly', () {
+      const style = WinUIContextMenuStyle(
+        virtualizationThreshold: 0,
+        virtualizationPageSize: 25,
+        virtualizationMaxItems: 100,
+        virtualizationMoreLabel: 'Mehr…',
+        virtualizationPreviousLabel: 'Zurück…',
+      );
+      final json = style.toJson();
+
+      expect(json['virtualizationThreshold'], 0);
+      expect(json['virtualizationPageSize'], 25);
+      expect(json['virtualizationMaxItems'], 100);
+      expect(json['virtualizationMoreLabel'], 'Mehr…');
+      expect(json['virtualizationPreviousLabel'], 'Zurück…');
+    });
+
     test('font properties serialize correctly', () {
       const style = WinUIContextMenuStyle(
         fontFamily: 'Segoe UI',
@@ -222,6 +239,13 @@ void main() {
           throwsA(isA<AssertionError>()),
         );
       });
+
+      test('rejects non-positive virtualizationPageSize', () {
+        expect(
+          () => WinUIContextMenuStyle(virtualizationPageSize: 0),
+          throwsA(isA<AssertionError>()),
+        );
+      });
     });
   });
 
@@ -0,0 +1,46 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:tray_manager_winui/src/winui_icon.dart';
+import 'package:tray_manager_winui/src/winui_live_item.dart';
+
+void main() {
+  group('WinUILiveItemUpdate', () {
+    test('sends only the fields it sets', () {
+      expect(const WinUILiveItemUpdate(3, label: 'Syncing').toJson(), {
+        'id': 3,
+        'label': 'Syncing',
+      });
+      expect(
+        WinUILiveItemUpdate(
+          3,
+          icon: WinUIIcon.symbol(WinUISymbol.add),
+          disabled: true,
+        ).toJson(),
+        {'id': 3, 'icon': '0xE710', 'disabled': true},
+      );
+    });
+
+    test('merges newer fields over older ones', () {
+      final merged = const WinUILiveItemUpdate(3, label: 'a', disabled: true)
+          .mergedWith(const WinUILiveItemUpdate(3, label: 'b'));
+      expect(merged.toJson(), {'id': 3, 'label': 'b', 'disabled': true});
+    });
+  });
+
+  group('LiveItemBatch', () {
+    test('keeps the latest value per item and field', () {
+      final batch = LiveItemBatch();
+      for (var i = 0; i < 1000; i++) {
+        batch.add(WinUILiveItemUpdate(i % 10, label: '$i'));
+      }
+      batch.add(const WinUILiveItemUpdate(0, disabled: false));
+      expect(batch.length, 10);
+
+      final entries = batch.take();
+      expect(entries.length, 10);
+      expect(entries.first, {'id': 0, 'label': '990', 'disabled': false});
+      expect(entries.last, {'id': 9, 'label': '999'});
+      expect(batch.isEmpty, isTrue);
+      expect(batch.take(), isEmpty);
+    });
+  });
+}
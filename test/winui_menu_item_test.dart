@@ -189,6 +189,22 @@ void main() {
       expect(json['type'], 'submenu');
       expect(json['icon'], '0xE8B7');
     });
+
+    test('toJson includes virtualized only when set', () {
+      final plain = WinUIMenuItem.submenu(
+        label: 'Recent',
+        submenu: Menu(items: []),
+      );
+      expect(plain.toJson().containsKey('virtualized'), false);
+
+      final paged = WinUIMenuItem.submenu(
+        label: 'Recent',
+        submenu: Menu(items: []),
+        virtualized: true,
+      );
+      expect(paged.virtualized, true);
+      expect(paged.toJson()['virtualized'], true);
+    });
   });
 
   group('WinUIMenuItem.radio', () {
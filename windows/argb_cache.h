@@ -0,0 +1,89 @@
+#ifndef TRAY_MANAGER_WINUI_ARGB_CACHE_H_
+#define TRAY_MANAGER_WINUI_ARGB_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace tray_manager_winui {
+
+/// Converts a style colour (Dart int, 0xAARRGGBB in int32 or int64) to the
+/// 32-bit ARGB cache key.
+inline uint32_t ToArgbKey(int64_t value) {
+  return static_cast<uint32_t>(value & 0xFFFFFFFF);
+}
+
+/// Least-recently-used cache of per-colour objects (e.g. SolidColorBrush),
+/// keyed by 32-bit ARGB.
+///
+/// Not thread-safe: keep one instance per thread that owns the values. Value
+/// must be copyable and contextually convertible to bool; falsy values
+/// returned by the factory are treated as failures and not cached.
+template <typename Value>
+class ArgbCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 64;
+
+  explicit ArgbCache(size_t capacity = kDefaultCapacity)
+      : capacity_(capacity == 0 ? 1 : capacity) {}
+
+  ArgbCache(const ArgbCache&) = delete;
+  ArgbCache& operator=(const ArgbCache&) = delete;
+
+  /// Returns the cached value for argb, or calls create(argb) on a miss.
+  template <typename Factory>
+  Value GetOrCreate(uint32_t argb, Factory&& create) {
+    auto it = index_.find(argb);
+    if (it != index_.end()) {
+      ++hits_;
+      order_.splice(order_.begin(), order_, it->second);
+      return it->second->second;
+    }
+
+    ++misses_;
+    Value value = create(argb);
+    if (!value) return value;
+
+    if (index_.size() >= capacity_) {
+      index_.erase(order_.back().first);
+      order_.pop_back();
+      ++evictions_;
+    }
+    order_.emplace_front(argb, value);
+    index_.emplace(argb, order_.begin());
+    return value;
+  }
+
+  bool Contains(uint32_t argb) const { return index_.count(argb) != 0; }
+
+  void Clear() {
+    index_.clear();
+    order_.clear();
+  }
+
+  /// Zeroes hits/misses/evictions without dropping cached values.
+  void ResetStats() { hits_ = misses_ = evictions_ = 0; }
+
+  size_t size() const { return index_.size(); }
+  size_t capacity() const { return capacity_; }
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  uint64_t evictions() const { return evictions_; }
+
+ private:
+  using Entry = std::pair<uint32_t, Value>;
+
+  size_t capacity_;
+  // Most recently used first.
+  std::list<Entry> order_;
+  std::unordered_map<uint32_t, typename std::list<Entry>::iterator> index_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_ARGB_CACHE_H_
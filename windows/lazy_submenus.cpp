@@ -0,0 +1,57 @@
+#include "lazy_submenus.h"
+
+namespace tray_manager_winui {
+
+void LazySubmenuTracker::Reset(const CompiledMenu& menu) {
+  const auto& nodes = menu.nodes();
+  // assign() keeps the capacity, so re-shows with a new layout of similar
+  // size do not allocate.
+  states_.assign(nodes.size(), State::kLeaf);
+  parents_.assign(nodes.size(), kNoParent);
+  pending_count_ = 0;
+  built_count_ = 0;
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    const MenuNode& node = nodes[i];
+    if (!node.has_children()) continue;
+    // Only submenu and split entries get children from the compiler.
+    states_[i] = State::kPending;
+    ++pending_count_;
+    for (uint32_t c = node.first_child; c < node.first_child + node.child_count;
+         ++c) {
+      parents_[c] = i;
+    }
+  }
+}
+
+void LazySubmenuTracker::Clear() {
+  states_.clear();
+  parents_.clear();
+  pending_count_ = 0;
+  built_count_ = 0;
+}
+
+bool LazySubmenuTracker::IsMaterialized(uint32_t index) const {
+  if (index >= parents_.size()) return false;
+  const uint32_t parent = parents_[index];
+  // A built submenu is itself materialized: it could only be opened (and
+  // built) while its item existed.
+  return parent == kNoParent || states_[parent] == State::kBuilt;
+}
+
+bool LazySubmenuTracker::MarkBuilt(uint32_t index) {
+  if (!IsPending(index)) return false;
+  states_[index] = State::kBuilt;
+  --pending_count_;
+  ++built_count_;
+  return true;
+}
+
+bool LazySubmenuTracker::MarkUnbuilt(uint32_t index) {
+  if (index >= states_.size() || states_[index] != State::kBuilt) return false;
+  states_[index] = State::kPending;
+  --built_count_;
+  ++pending_count_;
+  return true;
+}
+
+}  // namespace tray_manager_winui
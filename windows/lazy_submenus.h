@@ -0,0 +1,66 @@
+#ifndef TRAY_MANAGER_WINUI_LAZY_SUBMENUS_H_
+#define TRAY_MANAGER_WINUI_LAZY_SUBMENUS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+
+/// Tracks which submenus of the current flyout have their children built.
+///
+/// Submenu children are created the first time the submenu is about to open
+/// rather than with the root items, so a show costs the same however large
+/// the nested menus are. One instance covers one set of built items: Reset
+/// when the items are rebuilt, Clear when the flyout goes away.
+class LazySubmenuTracker {
+ public:
+  /// parent() of root items.
+  static constexpr uint32_t kNoParent = 0xFFFFFFFF;
+
+  /// Marks every submenu (and split entry) with children in menu as not built.
+  void Reset(const CompiledMenu& menu);
+
+  /// Forgets everything; all queries return false.
+  void Clear();
+
+  /// True if index is a submenu whose children have not been built yet.
+  bool IsPending(uint32_t index) const {
+    return index < states_.size() && states_[index] == State::kPending;
+  }
+
+  /// True if the item for index exists: root items always do, other items
+  /// once their parent submenu is built.
+  bool IsMaterialized(uint32_t index) const;
+
+  /// Records that the children of index are being built. Returns false if
+  /// index is not a pending submenu (already built, or not a submenu).
+  bool MarkBuilt(uint32_t index);
+
+  /// Returns built submenu index to pending after its item was removed (a
+  /// paged list dropped it), so it is built again when it comes back.
+  /// Returns false if index is not a built submenu.
+  bool MarkUnbuilt(uint32_t index);
+
+  /// Parent node of index; kNoParent for root items and unknown indices.
+  uint32_t parent(uint32_t index) const {
+    return index < parents_.size() ? parents_[index] : kNoParent;
+  }
+
+  uint32_t pending_count() const { return pending_count_; }
+  uint32_t built_count() const { return built_count_; }
+
+ private:
+  enum class State : uint8_t { kLeaf, kPending, kBuilt };
+
+  std::vector<State> states_;
+  // Parent node of every node; kNoParent for root items.
+  std::vector<uint32_t> parents_;
+  uint32_t pending_count_ = 0;
+  uint32_t built_count_ = 0;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_LAZY_SUBMENUS_H_
@@ -0,0 +1,228 @@
+#include "live_items.h"
+
+#include <utility>
+
+namespace tray_manager_winui {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+// Fibonacci hashing, so that consecutive ids spread over the table.
+size_t IdHome(int32_t id, size_t mask) {
+  const uint32_t hash = static_cast<uint32_t>(id) * 0x9E3779B9u;
+  return static_cast<size_t>(hash) & mask;
+}
+
+// Reads key of map into out if present; false if it has another type.
+template <typename T>
+bool ReadOptional(const flutter::EncodableMap& map, const char* key,
+                  std::optional<T>* out) {
+  auto it = map.find(flutter::EncodableValue(key));
+  if (it == map.end()) return true;
+  const auto* value = std::get_if<T>(&it->second);
+  if (!value) return false;
+  *out = *value;
+  return true;
+}
+
+// Replaces the pending string of field with value and frees the one it
+// replaced, if the consumer had not taken it yet.
+void Store(std::atomic<std::string*>& field, std::string value) {
+  delete field.exchange(new std::string(std::move(value)),
+                        std::memory_order_acq_rel);
+}
+
+bool Take(std::atomic<std::string*>& field, std::optional<std::string>& out) {
+  std::unique_ptr<std::string> value(
+      field.exchange(nullptr, std::memory_order_acq_rel));
+  if (!value) {
+    out.reset();
+    return false;
+  }
+  out = std::move(*value);
+  return true;
+}
+
+}  // namespace
+
+bool ParseLiveItemUpdate(const flutter::EncodableValue& entry,
+                         LiveItemUpdate* out) {
+  const auto* map = std::get_if<flutter::EncodableMap>(&entry);
+  if (!map) return false;
+  auto id_it = map->find(flutter::EncodableValue("id"));
+  if (id_it == map->end()) return false;
+  const auto* id = std::get_if<int32_t>(&id_it->second);
+  if (!id) return false;
+  LiveItemUpdate update;
+  update.id = *id;
+  if (!ReadOptional(*map, "label", &update.label) ||
+      !ReadOptional(*map, "icon", &update.icon) ||
+      !ReadOptional(*map, "disabled", &update.disabled)) {
+    return false;
+  }
+  *out = std::move(update);
+  return true;
+}
+
+LiveItemCoalescer::LiveItemCoalescer(size_t capacity) {
+  const size_t size = RoundUpToPowerOfTwo(capacity);
+  slots_ = std::make_unique<Slot[]>(size);
+  mask_ = size - 1;
+}
+
+LiveItemCoalescer::~LiveItemCoalescer() {
+  for (size_t i = 0; i <= mask_; ++i) {
+    delete slots_[i].label.load(std::memory_order_relaxed);
+    delete slots_[i].icon.load(std::memory_order_relaxed);
+  }
+}
+
+uint32_t LiveItemCoalescer::PinOwnedSlot(int32_t id, bool stop_at_free) {
+  const uint64_t owner = kOwned | static_cast<uint32_t>(id);
+  const size_t home = IdHome(id, mask_);
+  for (size_t probe = 0; probe <= mask_; ++probe) {
+    const size_t index = (home + probe) & mask_;
+    std::atomic<uint64_t>& state = slots_[index].state;
+    uint64_t current = state.load(std::memory_order_acquire);
+    // Retried while only the pins or queued change; Drain may free it.
+    while ((current & (kOwned | kIdMask)) == owner) {
+      if (state.compare_exchange_weak(current, current + kPin,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        return static_cast<uint32_t>(index);
+      }
+    }
+    if (current == kFree && stop_at_free) return kNoSlot;
+  }
+  return kNoSlot;
+}
+
+uint32_t LiveItemCoalescer::PinSlot(int32_t id) {
+  uint32_t index = PinOwnedSlot(id, true);
+  if (index != kNoSlot) return index;
+  // Only claims free slots, so under the lock a full probe that misses the
+  // id proves it owns none, and the slot claimed below stays its only one.
+  std::lock_guard lock(claim_mutex_);
+  index = PinOwnedSlot(id, false);
+  if (index != kNoSlot) return index;
+  const size_t home = IdHome(id, mask_);
+  for (size_t probe = 0; probe <= mask_; ++probe) {
+    const size_t i = (home + probe) & mask_;
+    uint64_t current = kFree;
+    if (slots_[i].state.compare_exchange_strong(
+            current, kOwned | static_cast<uint32_t>(id) | kPin,
+            std::memory_order_acq_rel)) {
+      return static_cast<uint32_t>(i);
+    }
+  }
+  return kNoSlot;
+}
+
+LiveItemPush LiveItemCoalescer::Push(LiveItemUpdate update) {
+  const uint32_t index = PinSlot(update.id);
+  if (index == kNoSlot) {
+    overflow_count_.fetch_add(1, std::memory_order_relaxed);
+    return LiveItemPush::kOverflow;
+  }
+  Slot& slot = slots_[index];
+  if (update.label) Store(slot.label, std::move(*update.label));
+  if (update.icon) Store(slot.icon, std::move(*update.icon));
+  if (update.disabled) {
+    slot.disabled.store(static_cast<uint8_t>(1 + *update.disabled),
+                        std::memory_order_release);
+  }
+  // The values above are published by setting queued: Drain clears it
+  // before it reads them, so it either sees them or the slot is queued
+  // again.
+  if (!(slot.state.fetch_or(kQueued, std::memory_order_acq_rel) & kQueued)) {
+    uint32_t head = dirty_.load(std::memory_order_relaxed);
+    do {
+      slot.next.store(head, std::memory_order_relaxed);
+    } while (!dirty_.compare_exchange_weak(head, index,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_relaxed));
+  }
+  slot.state.fetch_sub(kPin, std::memory_order_release);
+  return wake_pending_.exchange(true, std::memory_order_acq_rel)
+             ? LiveItemPush::kQueued
+             : LiveItemPush::kQueuedWake;
+}
+
+bool LiveItemCoalescer::TakeSlot(Slot& slot, LiveItemUpdate& update) {
+  // Queued until now, so the slot still has the owner it was queued for.
+  const uint64_t state =
+      slot.state.fetch_and(~kQueued, std::memory_order_acq_rel);
+  update.id = static_cast<int32_t>(static_cast<uint32_t>(state & kIdMask));
+  bool any = Take(slot.label, update.label);
+  any |= Take(slot.icon, update.icon);
+  const uint8_t disabled =
+      slot.disabled.exchange(kNoValue, std::memory_order_acq_rel);
+  if (disabled == kNoValue) {
+    update.disabled.reset();
+  } else {
+    update.disabled = disabled != 1;
+    any = true;
+  }
+  // Fails if a producer holds the slot or queued it again since; it is
+  // taken and freed by a later drain then.
+  uint64_t idle = state & (kOwned | kIdMask);
+  slot.state.compare_exchange_strong(idle, kFree, std::memory_order_acq_rel);
+  return any;
+}
+
+bool SubmitLiveItems(const flutter::EncodableList& entries,
+                     LiveItemCoalescer& coalescer, XamlThreadGate& gate,
+                     std::function<void()> flush) {
+  bool ok = true;
+  bool wake = false;
+  for (const auto& entry : entries) {
+    LiveItemUpdate update;
+    if (!ParseLiveItemUpdate(entry, &update)) {
+      ok = false;
+      continue;
+    }
+    switch (coalescer.Push(std::move(update))) {
+      case LiveItemPush::kQueuedWake:
+        wake = true;
+        break;
+      case LiveItemPush::kOverflow:
+        ok = false;
+        break;
+      case LiveItemPush::kQueued:
+        break;
+    }
+  }
+  if (gate.state() != XamlThreadState::kReady) {
+    // Nothing else drains before WinUI is up, so this thread is the only
+    // consumer.
+    coalescer.Drain([](const LiveItemUpdate&) {});
+    return false;
+  }
+  if (!wake) return ok;
+  gate.Run(std::move(flush), [&coalescer]() {
+    // The updates stay queued; the next one schedules a flush again.
+    coalescer.CancelWake();
+  });
+  return ok;
+}
+
+std::chrono::microseconds LiveItemFlushPacer::Delay(
+    Clock::time_point now) const {
+  if (!last_flush_) return std::chrono::microseconds(0);
+  const auto next = *last_flush_ + frame_interval_;
+  if (now >= next) return std::chrono::microseconds(0);
+  // Rounded up, so that a flush after the delay is never early.
+  return std::chrono::ceil<std::chrono::microseconds>(next - now);
+}
+
+void LiveItemFlushPacer::set_refresh_rate(uint32_t hz) {
+  if (hz == 0) return;
+  frame_interval_ = std::chrono::microseconds((1000000 + hz - 1) / hz);
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,208 @@
+#ifndef TRAY_MANAGER_WINUI_LIVE_ITEMS_H_
+#define TRAY_MANAGER_WINUI_LIVE_ITEMS_H_
+
+#include <flutter/encodable_value.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "xaml_thread_gate.h"
+
+namespace tray_manager_winui {
+
+/// New values for the items with one id in the open flyout
+/// (updateLiveItems). Fields left unset keep what the item shows.
+struct LiveItemUpdate {
+  int32_t id = 0;
+  /// UTF-8.
+  std::optional<std::string> label;
+  /// Glyph code point as MenuItem icons send it ("0xE713").
+  std::optional<std::string> icon;
+  std::optional<bool> disabled;
+
+  bool empty() const { return !label && !icon && !disabled; }
+};
+
+/// Parses one {"id": int, "label": string, "icon": string, "disabled": bool}
+/// entry of updateLiveItems; every key but id is optional. Returns false for
+/// entries that are not such maps or carry a value of the wrong type.
+bool ParseLiveItemUpdate(const flutter::EncodableValue& entry,
+                         LiveItemUpdate* out);
+
+/// Outcome of LiveItemCoalescer::Push.
+enum class LiveItemPush : uint8_t {
+  /// Merged; a flush is already pending.
+  kQueued,
+  /// Merged as the first update since the consumer last started draining;
+  /// the caller must schedule a flush.
+  kQueuedWake,
+  /// Every slot holds another id's pending values; the update was counted in
+  /// overflow_count().
+  kOverflow,
+};
+
+/// Coalesces live item updates between producers on any thread and one
+/// consumer that flushes them to the flyout, so that a burst of updates
+/// costs one flush.
+///
+/// Each id with pending values owns a slot with one atomic value per field:
+/// a newer update replaces the pending value of each field it sets (latest
+/// wins per item and field) and keeps the others. The first update of an
+/// idle slot adds it to a lock-free list of dirty slots, which Drain takes
+/// in one exchange. String values cost one allocation each.
+///
+/// Drain frees the slots it empties, so capacity bounds the ids with
+/// pending updates, not the ids seen over the coalescer's lifetime (menus
+/// are rebuilt with new ids). Updates to an id that holds a slot never wait;
+/// claiming a slot for an id takes a mutex that only producers share, so
+/// that an id never holds two slots. The consumer never waits.
+class LiveItemCoalescer {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024;
+
+  /// capacity is rounded up to a power of two (at least 2).
+  explicit LiveItemCoalescer(size_t capacity = kDefaultCapacity);
+  ~LiveItemCoalescer();
+
+  LiveItemCoalescer(const LiveItemCoalescer&) = delete;
+  LiveItemCoalescer& operator=(const LiveItemCoalescer&) = delete;
+
+  /// Thread-safe and lock-free. Empty updates are queued as well (they wake
+  /// the consumer without changing anything).
+  LiveItemPush Push(LiveItemUpdate update);
+
+  /// Consumer only. Takes the pending wake-up, then calls fn(const
+  /// LiveItemUpdate&) once for every id updated since the last drain, with
+  /// the latest value of each field. Updates pushed while draining are
+  /// either drained too or trigger a new wake-up. Returns the number of
+  /// updates passed to fn.
+  template <typename Fn>
+  size_t Drain(Fn&& fn);
+
+  /// For the producer that got kQueuedWake but could not schedule the
+  /// flush: clears it so that the next Push wakes the consumer instead.
+  void CancelWake() { wake_pending_.store(false, std::memory_order_release); }
+
+  /// Updates dropped because every slot held another id's pending values.
+  uint64_t overflow_count() const {
+    return overflow_count_.load(std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr uint32_t kNoSlot = 0xFFFFFFFF;
+  // Slot::disabled when no value is pending.
+  static constexpr uint8_t kNoValue = 0;
+
+  // Slot::state: the owning id in the low 32 bits, then the flags below and
+  // the number of producers writing to the slot. Owner, queued and pins
+  // share one word so that Drain frees a slot only if no producer holds or
+  // queued it since.
+  static constexpr uint64_t kFree = 0;
+  static constexpr uint64_t kIdMask = 0xFFFFFFFF;
+  static constexpr uint64_t kOwned = uint64_t{1} << 32;
+  // On the dirty list (or taken off it and not yet cleared by Drain).
+  static constexpr uint64_t kQueued = uint64_t{1} << 33;
+  static constexpr uint64_t kPin = uint64_t{1} << 40;
+
+  struct Slot {
+    std::atomic<uint64_t> state{kFree};
+    std::atomic<std::string*> label{nullptr};
+    std::atomic<std::string*> icon{nullptr};
+    /// kNoValue, or 1 + the pending disabled value.
+    std::atomic<uint8_t> disabled{kNoValue};
+    /// Next dirty slot; written by the producer that queues this one.
+    std::atomic<uint32_t> next{kNoSlot};
+  };
+
+  // Pins the slot of id, claiming a free one if it has none; kNoSlot if
+  // every slot is held by other ids.
+  uint32_t PinSlot(int32_t id);
+  // Pins the slot id owns, probing from its home slot. With stop_at_free,
+  // gives up at the first free slot, past which the id rarely is.
+  uint32_t PinOwnedSlot(int32_t id, bool stop_at_free);
+  // Moves the pending values of slot into update and frees the slot unless
+  // a producer holds it; false if there were no values.
+  bool TakeSlot(Slot& slot, LiveItemUpdate& update);
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  // Head of the dirty list. Producers and the consumer write different
+  // cache lines.
+  alignas(64) std::atomic<uint32_t> dirty_{kNoSlot};
+  alignas(64) std::atomic<bool> wake_pending_{false};
+  std::atomic<uint64_t> overflow_count_{0};
+  // Serializes claims of free slots.
+  std::mutex claim_mutex_;
+};
+
+template <typename Fn>
+size_t LiveItemCoalescer::Drain(Fn&& fn) {
+  // Taking the flag before the list: a producer that queues after the
+  // exchange below sees it cleared and wakes the consumer again.
+  wake_pending_.exchange(false, std::memory_order_acq_rel);
+  uint32_t index = dirty_.exchange(kNoSlot, std::memory_order_acq_rel);
+  size_t drained = 0;
+  LiveItemUpdate update;
+  while (index != kNoSlot) {
+    Slot& slot = slots_[index];
+    // Before clearing queued, after which a producer may queue it again.
+    index = slot.next.load(std::memory_order_relaxed);
+    if (TakeSlot(slot, update)) {
+      fn(static_cast<const LiveItemUpdate&>(update));
+      ++drained;
+    }
+  }
+  return drained;
+}
+
+/// Handles one updateLiveItems call: pushes entries into coalescer and, for
+/// the first update of a burst, has gate run flush on the XAML thread (flush
+/// drains coalescer there). Until gate is ready no flyout exists to show the
+/// updates, so they are drained and dropped on this thread. Returns false if
+/// an entry was malformed or overflowed, or the updates were dropped.
+bool SubmitLiveItems(const flutter::EncodableList& entries,
+                     LiveItemCoalescer& coalescer, XamlThreadGate& gate,
+                     std::function<void()> flush);
+
+/// Spaces the flushes of a LiveItemCoalescer at least one display frame
+/// apart. Consumer thread only.
+class LiveItemFlushPacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// 60 Hz.
+  static constexpr std::chrono::microseconds kDefaultFrameInterval{16667};
+
+  explicit LiveItemFlushPacer(
+      std::chrono::microseconds frame_interval = kDefaultFrameInterval)
+      : frame_interval_(frame_interval) {}
+
+  /// How long a flush woken at now waits: zero if the last flush was at
+  /// least a frame ago, the rest of that frame otherwise.
+  std::chrono::microseconds Delay(Clock::time_point now) const;
+
+  void OnFlushed(Clock::time_point now) { last_flush_ = now; }
+
+  /// For a display refresh rate in Hz; rates of 0 (unknown) keep the
+  /// current interval.
+  void set_refresh_rate(uint32_t hz);
+
+  std::chrono::microseconds frame_interval() const { return frame_interval_; }
+
+ private:
+  std::chrono::microseconds frame_interval_;
+  std::optional<Clock::time_point> last_flush_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_LIVE_ITEMS_H_
@@ -0,0 +1,110 @@
+#include "menu_event_queue.h"
+
+#include <utility>
+
+namespace tray_manager_winui {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+void AddPath(flutter::EncodableMap& args, const char* key,
+             const MenuPath& path) {
+  if (path.length == 0) return;
+  flutter::EncodableList positions;
+  positions.reserve(path.length);
+  for (uint8_t i = 0; i < path.length; ++i) {
+    positions.emplace_back(static_cast<int64_t>(path.positions[i]));
+  }
+  args[flutter::EncodableValue(key)] =
+      flutter::EncodableValue(std::move(positions));
+}
+
+}  // namespace
+
+const char* MenuEventMethod(MenuEventType type) {
+  switch (type) {
+    case MenuEventType::kItemClick:
+      return "onMenuItemClick";
+    case MenuEventType::kOpening:
+      return "onMenuOpening";
+    case MenuEventType::kClosing:
+      return "onMenuClosing";
+    case MenuEventType::kClosed:
+      return "onMenuClosed";
+  }
+  return "";
+}
+
+std::unique_ptr<flutter::EncodableValue> MenuEventArguments(
+    const MenuEvent& event) {
+  if (event.type != MenuEventType::kItemClick) return nullptr;
+  flutter::EncodableMap args;
+  args[flutter::EncodableValue("id")] = flutter::EncodableValue(event.id);
+  // int64 so that generations above INT32_MAX stay positive in Dart.
+  args[flutter::EncodableValue("generation")] =
+      flutter::EncodableValue(static_cast<int64_t>(event.generation));
+  AddPath(args, "path", event.path);
+  if (event.checked) {
+    args[flutter::EncodableValue("checked")] =
+        flutter::EncodableValue(*event.checked);
+  }
+  if (event.unchecked_id) {
+    args[flutter::EncodableValue("uncheckedId")] =
+        flutter::EncodableValue(*event.unchecked_id);
+    AddPath(args, "uncheckedPath", event.unchecked_path);
+  }
+  return std::make_unique<flutter::EncodableValue>(std::move(args));
+}
+
+MenuEventQueue::MenuEventQueue(size_t capacity) {
+  const size_t size = RoundUpToPowerOfTwo(capacity);
+  slots_ = std::make_unique<Slot[]>(size);
+  mask_ = size - 1;
+  for (size_t i = 0; i < size; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+MenuEventPush MenuEventQueue::Push(const MenuEvent& event) {
+  size_t position = tail_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &slots_[position & mask_];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto lag = static_cast<intptr_t>(sequence - position);
+    if (lag == 0) {
+      if (tail_.compare_exchange_weak(position, position + 1,
+                                      std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (lag < 0) {
+      // The slot still holds the event from one lap ago: full.
+      overflow_count_.fetch_add(1, std::memory_order_relaxed);
+      return MenuEventPush::kOverflow;
+    } else {
+      position = tail_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->event = event;
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return wake_pending_.exchange(true, std::memory_order_acq_rel)
+             ? MenuEventPush::kQueued
+             : MenuEventPush::kQueuedWake;
+}
+
+bool MenuEventQueue::TryPop(MenuEvent& event) {
+  Slot& slot = slots_[head_ & mask_];
+  if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) return false;
+  event = slot.event;
+  // Free for the producer one lap ahead.
+  slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+  ++head_;
+  return true;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,138 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_EVENT_QUEUE_H_
+#define TRAY_MANAGER_WINUI_MENU_EVENT_QUEUE_H_
+
+#include <flutter/encodable_value.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+
+/// Menu events forwarded from the XAML thread to Dart.
+enum class MenuEventType : uint8_t {
+  kItemClick,
+  kOpening,
+  kClosing,
+  kClosed,
+};
+
+/// One queued event. For kItemClick, the fields after type are those of the
+/// MenuClick; they are 0 or empty otherwise. Fixed-size, so the queue's
+/// slots need no allocation.
+struct MenuEvent {
+  MenuEventType type = MenuEventType::kOpening;
+  int32_t id = 0;
+  uint32_t generation = 0;
+  MenuPath path;
+  std::optional<bool> checked;
+  std::optional<int32_t> unchecked_id;
+  MenuPath unchecked_path;
+};
+
+/// The kItemClick event for click.
+inline MenuEvent MakeClickEvent(const MenuClick& click) {
+  return {MenuEventType::kItemClick, click.id, click.generation, click.path,
+          click.checked, click.unchecked_id, click.unchecked_path};
+}
+
+/// Dart method the event is delivered as ("onMenuItemClick", ...).
+const char* MenuEventMethod(MenuEventType type);
+
+/// Arguments for MenuEventMethod, null for all but kItemClick:
+/// {"id": id, "generation": generation, "path": [positions]}, plus
+/// "checked": bool for toggles and "uncheckedId": id and "uncheckedPath":
+/// [positions] for the radio item a click unchecked. Empty paths are
+/// omitted.
+std::unique_ptr<flutter::EncodableValue> MenuEventArguments(
+    const MenuEvent& event);
+
+/// Outcome of MenuEventQueue::Push.
+enum class MenuEventPush : uint8_t {
+  /// Queued; a wake-up for the consumer is already pending.
+  kQueued,
+  /// Queued as the first event since the consumer last started draining;
+  /// the caller must wake it (post the platform-thread message).
+  kQueuedWake,
+  /// The queue was full; the event was counted in overflow_count().
+  kOverflow,
+};
+
+/// Bounded lock-free multi-producer, single-consumer queue of preallocated
+/// event slots (a ring with a sequence number per slot). Producers on any
+/// thread Push; one consumer thread drains everything on each wake-up, so a
+/// burst of events costs one platform-thread message instead of one each.
+class MenuEventQueue {
+ public:
+  static constexpr size_t kDefaultCapacity = 256;
+
+  /// capacity is rounded up to a power of two (at least 2).
+  explicit MenuEventQueue(size_t capacity = kDefaultCapacity);
+
+  MenuEventQueue(const MenuEventQueue&) = delete;
+  MenuEventQueue& operator=(const MenuEventQueue&) = delete;
+
+  /// Thread-safe, wait-free unless other producers are racing for the same
+  /// slot.
+  MenuEventPush Push(const MenuEvent& event);
+
+  /// Consumer only. Takes the pending wake-up, then calls fn(const
+  /// MenuEvent&) for every event published so far, oldest first. Events
+  /// pushed while draining are either drained too or trigger a new wake-up.
+  /// Returns the number of events drained.
+  template <typename Fn>
+  size_t Drain(Fn&& fn);
+
+  /// For the producer that got kQueuedWake but could not deliver the
+  /// wake-up: clears it so that the next Push wakes the consumer instead.
+  /// The queued events stay queued until then.
+  void CancelWake() { wake_pending_.store(false, std::memory_order_release); }
+
+  /// Events dropped because the queue was full, since construction.
+  uint64_t overflow_count() const {
+    return overflow_count_.load(std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    /// position when free for the producer claiming position, position + 1
+    /// once published.
+    std::atomic<size_t> sequence;
+    MenuEvent event;
+  };
+
+  // Returns false if the slot at head_ is not published yet.
+  bool TryPop(MenuEvent& event);
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  // Producers and the consumer write different cache lines.
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) size_t head_ = 0;
+  alignas(64) std::atomic<bool> wake_pending_{false};
+  std::atomic<uint64_t> overflow_count_{0};
+};
+
+template <typename Fn>
+size_t MenuEventQueue::Drain(Fn&& fn) {
+  // Taking the flag before popping: a producer that publishes after the last
+  // pop below sees it cleared and wakes the consumer again.
+  wake_pending_.exchange(false, std::memory_order_acq_rel);
+  size_t drained = 0;
+  MenuEvent event;
+  while (TryPop(event)) {
+    fn(static_cast<const MenuEvent&>(event));
+    ++drained;
+  }
+  return drained;
+}
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_EVENT_QUEUE_H_
@@ -0,0 +1,163 @@
+#include "menu_host_pool.h"
+
+#include <utility>
+
+namespace tray_manager_winui {
+
+bool MenuLayoutMatches(const CompiledMenu& a, const CompiledMenu& b) {
+  if (a.root_count() != b.root_count()) return false;
+  if (a.nodes().size() != b.nodes().size()) return false;
+  for (size_t i = 0; i < a.nodes().size(); ++i) {
+    const MenuNode& x = a.nodes()[i];
+    const MenuNode& y = b.nodes()[i];
+    if (x.type != y.type || x.id != y.id || x.virtualized != y.virtualized ||
+        x.first_child != y.first_child || x.child_count != y.child_count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MenuNodeContentEquals(const CompiledMenu& a, const CompiledMenu& b,
+                           uint32_t index) {
+  const MenuNode& x = a.node(index);
+  const MenuNode& y = b.node(index);
+  return x.disabled == y.disabled && x.checked == y.checked &&
+         a.str(x.label) == b.str(y.label) && a.str(x.icon) == b.str(y.icon) &&
+         a.str(x.icon_font_family) == b.str(y.icon_font_family) &&
+         a.str(x.accelerator_text) == b.str(y.accelerator_text) &&
+         a.str(x.tool_tip) == b.str(y.tool_tip) &&
+         a.str(x.radio_group) == b.str(y.radio_group);
+}
+
+bool MenuHostPool::Show(MenuSnapshotPtr snapshot,
+                        const MenuShowRequest& request) {
+  if (state_ != MenuHostState::kCold && !backend_.IsHostAlive()) {
+    // The host window went away (or a previous show never reported Closed
+    // because of it); start over.
+    Recover();
+  }
+  if (state_ == MenuHostState::kShowing) return false;
+  ++stats_.shows;
+
+  if (!Build(std::move(snapshot))) return false;
+
+  state_ = MenuHostState::kShowing;
+  if (!backend_.Show(request)) {
+    Recover();
+    return false;
+  }
+  return true;
+}
+
+bool MenuHostPool::Prepare(MenuSnapshotPtr snapshot) {
+  if (state_ != MenuHostState::kCold && !backend_.IsHostAlive()) Recover();
+  if (state_ == MenuHostState::kShowing) return false;
+  ++stats_.prepares;
+  return Build(std::move(snapshot));
+}
+
+bool MenuHostPool::ShowPrepared(const MenuShowRequest& request) {
+  if (state_ != MenuHostState::kWarm || !has_flyout_ || !built_ ||
+      !backend_.IsHostAlive()) {
+    return false;
+  }
+  ++stats_.shows;
+  ++stats_.prepared_shows;
+  state_ = MenuHostState::kShowing;
+  if (!backend_.Show(request)) {
+    Recover();
+    return false;
+  }
+  return true;
+}
+
+// Creates the host, flyout and items that are missing or out of date.
+// Leaves the pool warm, or cold after a failure.
+bool MenuHostPool::Build(MenuSnapshotPtr snapshot) {
+  if (state_ == MenuHostState::kCold) {
+    if (!backend_.CreateHost()) {
+      Recover();
+      return false;
+    }
+    ++stats_.host_creates;
+    state_ = MenuHostState::kWarm;
+  }
+
+  const uint64_t fingerprint = snapshot->style->fingerprint;
+  if (!has_flyout_ || fingerprint != style_fingerprint_) {
+    if (has_flyout_) {
+      backend_.DestroyFlyout();
+      has_flyout_ = false;
+    }
+    built_.reset();
+    if (!backend_.CreateFlyout(*snapshot->style)) {
+      Recover();
+      return false;
+    }
+    ++stats_.flyout_creates;
+    has_flyout_ = true;
+    style_fingerprint_ = fingerprint;
+  }
+
+  if (!SyncItems(std::move(snapshot))) {
+    Recover();
+    return false;
+  }
+  return true;
+}
+
+bool MenuHostPool::SyncItems(MenuSnapshotPtr snapshot) {
+  // Showing the same snapshot again (or one patched to the same content)
+  // changes nothing.
+  if (built_ == snapshot) return true;
+  const CompiledMenu& menu = snapshot->menu;
+  bool rebuild = !built_ || !MenuLayoutMatches(built_->menu, menu);
+  if (!rebuild) {
+    const CompiledMenu& previous = built_->menu;
+    const auto node_count = static_cast<uint32_t>(menu.nodes().size());
+    for (uint32_t i = 0; i < node_count; ++i) {
+      if (MenuNodeContentEquals(previous, menu, i)) continue;
+      if (!backend_.UpdateItem(previous, menu, i)) {
+        rebuild = true;
+        break;
+      }
+      ++stats_.item_updates;
+    }
+  }
+  if (rebuild) {
+    built_.reset();
+    if (!backend_.BuildItems(menu)) return false;
+    ++stats_.item_builds;
+  } else {
+    // Lazily built submenus and pages read the new snapshot from now on; the
+    // previous one may be released below.
+    backend_.RebindItems(menu);
+  }
+  built_ = std::move(snapshot);
+  return true;
+}
+
+void MenuHostPool::OnClosed() {
+  if (state_ == MenuHostState::kShowing) state_ = MenuHostState::kWarm;
+}
+
+void MenuHostPool::Reset() {
+  if (has_flyout_) backend_.DestroyFlyout();
+  if (state_ != MenuHostState::kCold) backend_.DestroyHost();
+  has_flyout_ = false;
+  built_.reset();
+  state_ = MenuHostState::kCold;
+}
+
+void MenuHostPool::Recover() {
+  ++stats_.recoveries;
+  // DestroyHost must cope with a partially created host.
+  if (has_flyout_) backend_.DestroyFlyout();
+  backend_.DestroyHost();
+  has_flyout_ = false;
+  built_.reset();
+  state_ = MenuHostState::kCold;
+}
+
+}  // namespace tray_manager_winui
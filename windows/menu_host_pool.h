@@ -0,0 +1,156 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_HOST_POOL_H_
+#define TRAY_MANAGER_WINUI_MENU_HOST_POOL_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "menu_model.h"
+#include "menu_placement.h"
+#include "menu_snapshot.h"
+
+namespace tray_manager_winui {
+
+/// Where and how to open the menu for one show.
+struct MenuShowRequest {
+  std::optional<double> x;
+  std::optional<double> y;
+  std::optional<std::string> placement;
+  std::optional<MenuRect> exclusion_rect;
+};
+
+/// Platform side of MenuHostPool: the host window, its XAML island and the
+/// flyout. Implemented with WinUI on Windows and by fakes in tests. Methods
+/// return false on failure (including caught platform exceptions); the pool
+/// then discards everything and starts cold on the next show.
+class MenuHostBackend {
+ public:
+  virtual ~MenuHostBackend() = default;
+
+  /// Creates the hidden host window and its XAML island.
+  virtual bool CreateHost() = 0;
+  virtual void DestroyHost() = 0;
+
+  /// False once the host window was destroyed outside the pool's control.
+  virtual bool IsHostAlive() const = 0;
+
+  /// Creates the flyout and everything derived from the style (presenter
+  /// style, backdrop, event handlers).
+  virtual bool CreateFlyout(const ResolvedStyle& style) = 0;
+  virtual void DestroyFlyout() = 0;
+
+  /// Replaces all flyout items with the items of menu. menu belongs to a
+  /// snapshot the pool holds; it stays valid until the next BuildItems,
+  /// RebindItems or DestroyFlyout.
+  virtual bool BuildItems(const CompiledMenu& menu) = 0;
+
+  /// Refreshes the item built for node index of previous to show node index
+  /// of menu; both menus have the same layout, and previous is the menu the
+  /// items currently show. Returns false if the item cannot be updated in
+  /// place; the pool then rebuilds all items.
+  virtual bool UpdateItem(const CompiledMenu& previous,
+                          const CompiledMenu& menu, uint32_t index) = 0;
+
+  /// After the UpdateItem calls of a show: the items now show menu, which
+  /// replaces the previous one for items built later (lazy submenus, pages).
+  /// Same lifetime as for BuildItems.
+  virtual void RebindItems(const CompiledMenu& menu) = 0;
+
+  /// Moves the host window to the anchor and opens the flyout.
+  virtual bool Show(const MenuShowRequest& request) = 0;
+};
+
+/// Lifecycle of the pooled host.
+enum class MenuHostState : uint8_t {
+  /// Nothing exists; the next show creates the host.
+  kCold,
+  /// Host (and possibly flyout and items) exist and are hidden.
+  kWarm,
+  /// The flyout is open.
+  kShowing,
+};
+
+/// Counters for tests and debug logging.
+struct MenuHostStats {
+  uint64_t shows = 0;
+  uint64_t host_creates = 0;
+  uint64_t flyout_creates = 0;
+  uint64_t item_builds = 0;
+  uint64_t item_updates = 0;
+  uint64_t recoveries = 0;
+  uint64_t prepares = 0;
+  uint64_t prepared_shows = 0;
+};
+
+/// Keeps one host window, XAML island and flyout alive between shows.
+///
+/// A show creates only what is missing: the host on the first show or after
+/// a failure, the flyout when the style fingerprint changes, and the items
+/// when the menu layout (types, ids, nesting) changes. Otherwise only items
+/// whose content differs from the previous show are updated. Not thread-safe;
+/// all calls happen on the XAML thread.
+class MenuHostPool {
+ public:
+  explicit MenuHostPool(MenuHostBackend& backend) : backend_(backend) {}
+
+  MenuHostPool(const MenuHostPool&) = delete;
+  MenuHostPool& operator=(const MenuHostPool&) = delete;
+
+  /// Prepares and opens the menu. Returns false if a show is already in
+  /// progress or a backend step failed; in the latter case everything is torn
+  /// down so that the next show starts cold. The pool keeps snapshot (not a
+  /// copy) for as long as its items show it.
+  bool Show(MenuSnapshotPtr snapshot, const MenuShowRequest& request);
+
+  /// Creates what the menu needs without opening it, so that a following
+  /// ShowPrepared only positions and opens the flyout. Returns false while
+  /// the menu is showing (nothing is touched) or if a backend step failed
+  /// (everything is torn down, as for Show).
+  bool Prepare(MenuSnapshotPtr snapshot);
+
+  /// Opens the flyout as the last Prepare or Show left it, without comparing
+  /// menus. Returns false without side effects if there is nothing to open
+  /// (cold, showing, or the host died); the caller then falls back to Show.
+  /// A failing backend Show tears everything down.
+  bool ShowPrepared(const MenuShowRequest& request);
+
+  /// The flyout closed; the host stays warm for the next show.
+  void OnClosed();
+
+  /// Tears everything down, e.g. on shutdown.
+  void Reset();
+
+  MenuHostState state() const { return state_; }
+  const MenuHostStats& stats() const { return stats_; }
+
+  /// The snapshot the built items show; null if there are none.
+  const MenuSnapshotPtr& built() const { return built_; }
+
+ private:
+  bool Build(MenuSnapshotPtr snapshot);
+  bool SyncItems(MenuSnapshotPtr snapshot);
+  void Recover();
+
+  MenuHostBackend& backend_;
+  MenuHostState state_ = MenuHostState::kCold;
+  bool has_flyout_ = false;
+  uint64_t style_fingerprint_ = 0;
+  // The snapshot the current items show; its menu is handed to the backend.
+  MenuSnapshotPtr built_;
+  MenuHostStats stats_;
+};
+
+/// True if both menus have the same nodes in the same places (type, id,
+/// nesting, paging), i.e. built items can be updated instead of rebuilt.
+bool MenuLayoutMatches(const CompiledMenu& a, const CompiledMenu& b);
+
+/// True if node index renders identically in both menus (which must have the
+/// same layout).
+bool MenuNodeContentEquals(const CompiledMenu& a, const CompiledMenu& b,
+                           uint32_t index);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_HOST_POOL_H_
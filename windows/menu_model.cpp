@@ -0,0 +1,320 @@
+#include "menu_model.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "menu_toggles.h"
+#include "utf16.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+// Below this, strings appended by updates are not worth a pass over the
+// nodes (see CompiledMenu::CompactStrings).
+constexpr size_t kMinCompactBytes = 4096;
+
+MenuItemType ParseItemType(const std::string& type) {
+  if (type == "separator") return MenuItemType::kSeparator;
+  if (type == "submenu") return MenuItemType::kSubmenu;
+  if (type == "checkbox") return MenuItemType::kCheckbox;
+  if (type == "radio") return MenuItemType::kRadio;
+  if (type == "split") return MenuItemType::kSplit;
+  return MenuItemType::kNormal;
+}
+
+const flutter::EncodableList* FindItems(const flutter::EncodableMap& menu) {
+  auto it = menu.find(flutter::EncodableValue("items"));
+  if (it == menu.end()) return nullptr;
+  return std::get_if<flutter::EncodableList>(&it->second);
+}
+
+}  // namespace
+
+// Walks the EncodableMap tree once. Interned strings are keyed by views into
+// the source map, which outlives the compiler.
+class MenuCompiler {
+ public:
+  explicit MenuCompiler(CompiledMenu& out) : out_(out) {
+    interned_.emplace(std::string_view(), kEmptyString);
+  }
+
+  void CompileRoot(const flutter::EncodableMap& menu_json) {
+    if (const auto* items = FindItems(menu_json)) {
+      out_.nodes_.reserve(items->size());
+      out_.root_count_ = CompileList(*items).second;
+      out_.ConvertStrings();
+    }
+    out_.BuildIndex();
+  }
+
+ private:
+  // Appends one sibling block, then the blocks of its submenus.
+  // Returns {first, count} of the appended block.
+  std::pair<uint32_t, uint32_t> CompileList(const flutter::EncodableList& items) {
+    uint32_t count = 0;
+    for (const auto& item_val : items) {
+      if (std::holds_alternative<flutter::EncodableMap>(item_val)) ++count;
+    }
+    const uint32_t first = static_cast<uint32_t>(out_.nodes_.size());
+    out_.nodes_.resize(first + count);
+
+    // Fill the whole block before recursing so that siblings stay adjacent.
+    std::vector<const flutter::EncodableList*> children(count, nullptr);
+    uint32_t index = first;
+    for (const auto& item_val : items) {
+      const auto* item_map = std::get_if<flutter::EncodableMap>(&item_val);
+      if (!item_map) continue;
+      children[index - first] = FillNode(out_.nodes_[index], *item_map);
+      ++index;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!children[i]) continue;
+      auto range = CompileList(*children[i]);
+      // CompileList may reallocate nodes_, so index again afterwards.
+      out_.nodes_[first + i].first_child = range.first;
+      out_.nodes_[first + i].child_count = range.second;
+    }
+    return {first, count};
+  }
+
+  // Returns the submenu items to compile for submenu/split entries.
+  const flutter::EncodableList* FillNode(MenuNode& node,
+                                         const flutter::EncodableMap& item) {
+    const flutter::EncodableList* submenu_items = nullptr;
+    for (const auto& [key_val, value] : item) {
+      const auto* key = std::get_if<std::string>(&key_val);
+      if (!key) continue;
+      if (*key == "type") {
+        const auto* s = std::get_if<std::string>(&value);
+        if (s) node.type = ParseItemType(*s);
+      } else if (*key == "id") {
+        const auto* i = std::get_if<int32_t>(&value);
+        if (i) node.id = *i;
+      } else if (*key == "disabled") {
+        const auto* b = std::get_if<bool>(&value);
+        if (b) node.disabled = *b;
+      } else if (*key == "checked") {
+        const auto* b = std::get_if<bool>(&value);
+        if (b) node.checked = *b;
+      } else if (*key == "virtualized") {
+        const auto* b = std::get_if<bool>(&value);
+        if (b) node.virtualized = *b;
+      } else if (*key == "label") {
+        node.label = Intern(value);
+      } else if (*key == "icon") {
+        node.icon = Intern(value);
+      } else if (*key == "iconFontFamily") {
+        node.icon_font_family = Intern(value);
+      } else if (*key == "acceleratorText") {
+        node.accelerator_text = Intern(value);
+      } else if (*key == "toolTip") {
+        node.tool_tip = Intern(value);
+      } else if (*key == "radioGroup") {
+        node.radio_group = Intern(value);
+      } else if (*key == "submenu") {
+        const auto* sub_map = std::get_if<flutter::EncodableMap>(&value);
+        if (sub_map) submenu_items = FindItems(*sub_map);
+      }
+    }
+    if (node.type != MenuItemType::kSubmenu && node.type != MenuItemType::kSplit) {
+      return nullptr;
+    }
+    return submenu_items;
+  }
+
+  StringId Intern(const flutter::EncodableValue& value) {
+    const auto* s = std::get_if<std::string>(&value);
+    if (!s || s->empty()) return kEmptyString;
+    std::string_view view(*s);
+    auto it = interned_.find(view);
+    if (it != interned_.end()) return it->second;
+
+    const auto id = static_cast<StringId>(out_.strings_.size());
+    out_.strings_.push_back({static_cast<uint32_t>(out_.string_data_.size()),
+                             static_cast<uint32_t>(view.size())});
+    out_.string_data_.append(view);
+    interned_.emplace(view, id);
+    return id;
+  }
+
+  CompiledMenu& out_;
+  std::unordered_map<std::string_view, StringId> interned_;
+};
+
+CompiledMenu::CompiledMenu() : strings_{{0, 0}}, wide_strings_{{0, 0}} {}
+
+size_t CompiledMenu::memory_bytes() const {
+  return sizeof(*this) + nodes_.capacity() * sizeof(MenuNode) +
+         strings_.capacity() * sizeof(StringRef) + string_data_.capacity() +
+         wide_strings_.capacity() * sizeof(StringRef) +
+         wide_data_.capacity() * sizeof(char16_t) +
+         parents_.capacity() * sizeof(uint32_t) +
+         id_slots_.capacity() * sizeof(IdSlot) +
+         radio_groups_.capacity() * sizeof(uint32_t) +
+         (toggles_ ? toggles_->memory_bytes() : 0);
+}
+
+uint32_t CompiledMenu::FindNode(int32_t id) const {
+  if (id_slots_.empty()) return kNoNode;
+  const size_t mask = id_slots_.size() - 1;
+  for (size_t i = IdHome(id); id_slots_[i].node != kNoNode;
+       i = (i + 1) & mask) {
+    if (id_slots_[i].id == id) return id_slots_[i].node;
+  }
+  return kNoNode;
+}
+
+MenuPath CompiledMenu::PathOf(uint32_t index) const {
+  // Collected leaf first, then reversed.
+  MenuPath path;
+  for (uint32_t node = index; node != kNoNode; node = parents_[node]) {
+    if (path.length == MenuPath::kMaxDepth) return MenuPath();
+    const uint32_t parent = parents_[node];
+    path.positions[path.length++] =
+        parent == kNoNode ? node : node - nodes_[parent].first_child;
+  }
+  std::reverse(path.positions.begin(), path.positions.begin() + path.length);
+  return path;
+}
+
+StringId CompiledMenu::AddString(std::string_view value) {
+  if (value.empty()) return kEmptyString;
+  const auto id = static_cast<StringId>(strings_.size());
+  strings_.push_back({static_cast<uint32_t>(string_data_.size()),
+                      static_cast<uint32_t>(value.size())});
+  string_data_.append(value);
+  appended_bytes_ += value.size();
+  ConvertStrings();
+  return id;
+}
+
+void CompiledMenu::CompactStrings() {
+  if (appended_bytes_ < kMinCompactBytes ||
+      appended_bytes_ < string_data_.size() - appended_bytes_) {
+    return;
+  }
+  std::vector<StringRef> strings{{0, 0}};
+  std::vector<StringRef> wide_strings{{0, 0}};
+  std::string string_data;
+  std::u16string wide_data;
+  // Views into the old buffer, which lives until the swap below.
+  std::unordered_map<std::string_view, StringId> interned;
+  auto keep = [&](StringId& id) {
+    if (id == kEmptyString) return;
+    const MenuText text = this->text(id);
+    auto [it, inserted] =
+        interned.emplace(text.utf8, static_cast<StringId>(strings.size()));
+    if (inserted) {
+      strings.push_back({static_cast<uint32_t>(string_data.size()),
+                         static_cast<uint32_t>(text.utf8.size())});
+      string_data.append(text.utf8);
+      wide_strings.push_back({static_cast<uint32_t>(wide_data.size()),
+                              static_cast<uint32_t>(text.utf16.size())});
+      wide_data.append(text.utf16);
+    }
+    id = it->second;
+  };
+  for (MenuNode& node : nodes_) {
+    keep(node.label);
+    keep(node.icon);
+    keep(node.icon_font_family);
+    keep(node.accelerator_text);
+    keep(node.tool_tip);
+    keep(node.radio_group);
+  }
+  strings_ = std::move(strings);
+  wide_strings_ = std::move(wide_strings);
+  string_data_ = std::move(string_data);
+  wide_data_ = std::move(wide_data);
+  appended_bytes_ = 0;
+}
+
+void CompiledMenu::BuildIndex() {
+  const auto count = static_cast<uint32_t>(nodes_.size());
+  parents_.assign(count, kNoNode);
+  for (uint32_t i = 0; i < count; ++i) {
+    const MenuNode& node = nodes_[i];
+    for (uint32_t c = 0; c < node.child_count; ++c) {
+      parents_[node.first_child + c] = i;
+    }
+  }
+
+  BuildRadioGroups();
+  toggles_ = std::make_shared<MenuToggleState>(*this);
+
+  id_slots_.clear();
+  if (count == 0) return;
+  size_t size = 2;
+  while (size < size_t{count} * 2) size <<= 1;
+  id_slots_.assign(size, IdSlot{0, kNoNode});
+  const size_t mask = size - 1;
+  for (uint32_t i = 0; i < count; ++i) {
+    const int32_t id = nodes_[i].id;
+    size_t slot = IdHome(id);
+    while (id_slots_[slot].node != kNoNode) slot = (slot + 1) & mask;
+    id_slots_[slot] = {id, i};
+  }
+}
+
+void CompiledMenu::BuildRadioGroups() {
+  radio_groups_.clear();
+  radio_group_count_ = 0;
+  const auto count = static_cast<uint32_t>(nodes_.size());
+  uint32_t first_radio = 0;
+  while (first_radio < count &&
+         nodes_[first_radio].type != MenuItemType::kRadio) {
+    ++first_radio;
+  }
+  if (first_radio == count) return;
+
+  // Named groups by content (strings added by updates are not interned);
+  // unnamed ones by parent.
+  std::unordered_map<std::string_view, uint32_t> named;
+  std::unordered_map<uint32_t, uint32_t> unnamed;
+  radio_groups_.assign(count, kNoGroup);
+  for (uint32_t i = first_radio; i < count; ++i) {
+    const MenuNode& node = nodes_[i];
+    if (node.type != MenuItemType::kRadio) continue;
+    uint32_t group;
+    if (node.radio_group == kEmptyString) {
+      group = unnamed.emplace(parents_[i], radio_group_count_).first->second;
+    } else {
+      group = named.emplace(str(node.radio_group), radio_group_count_)
+                  .first->second;
+    }
+    if (group == radio_group_count_) ++radio_group_count_;
+    radio_groups_[i] = group;
+  }
+}
+
+void CompiledMenu::ConvertStrings() {
+  // One allocation for all new strings: UTF-16 never needs more units than
+  // UTF-8 has bytes.
+  size_t capacity = wide_data_.size();
+  for (size_t i = wide_strings_.size(); i < strings_.size(); ++i) {
+    capacity += strings_[i].length;
+  }
+  const size_t start = wide_data_.size();
+  wide_data_.resize(capacity);
+  char16_t* out = wide_data_.data() + start;
+  wide_strings_.reserve(strings_.size());
+  for (size_t i = wide_strings_.size(); i < strings_.size(); ++i) {
+    const size_t written = Utf8ToUtf16(str(static_cast<StringId>(i)), out);
+    wide_strings_.push_back(
+        {static_cast<uint32_t>(out - wide_data_.data()),
+         static_cast<uint32_t>(written)});
+    out += written;
+  }
+  wide_data_.resize(static_cast<size_t>(out - wide_data_.data()));
+}
+
+CompiledMenu CompileMenu(const flutter::EncodableMap& menu_json) {
+  CompiledMenu menu;
+  MenuCompiler(menu).CompileRoot(menu_json);
+  return menu;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,259 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_MODEL_H_
+#define TRAY_MANAGER_WINUI_MENU_MODEL_H_
+
+#include <flutter/encodable_value.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tray_manager_winui {
+
+/// Item kinds of the tray_manager menu JSON ("type" field).
+enum class MenuItemType : uint8_t {
+  kNormal,
+  kSeparator,
+  kSubmenu,
+  kCheckbox,
+  kRadio,
+  kSplit,
+};
+
+class MenuToggleState;
+class PackedMenuView;
+
+/// Index into CompiledMenu's string table. Absent fields map to kEmptyString.
+using StringId = uint32_t;
+constexpr StringId kEmptyString = 0;
+
+/// A menu string in both encodings: UTF-8 for comparisons and logs, UTF-16
+/// for the XAML controls.
+struct MenuText {
+  std::string_view utf8;
+  std::u16string_view utf16;
+
+  bool empty() const { return utf8.empty(); }
+};
+
+/// One menu item with typed fields. Children of a submenu/split item occupy
+/// the contiguous range [first_child, first_child + child_count).
+struct MenuNode {
+  MenuItemType type = MenuItemType::kNormal;
+  bool disabled = false;
+  bool checked = false;
+  /// Submenu children are built a page at a time (see menu_paging.h).
+  bool virtualized = false;
+  int32_t id = 0;
+  StringId label = kEmptyString;
+  StringId icon = kEmptyString;
+  StringId icon_font_family = kEmptyString;
+  StringId accelerator_text = kEmptyString;
+  StringId tool_tip = kEmptyString;
+  StringId radio_group = kEmptyString;
+  uint32_t first_child = 0;
+  uint32_t child_count = 0;
+
+  bool has_children() const { return child_count != 0; }
+};
+
+/// Position of a node in the menu tree: its index among its siblings at each
+/// level, root first.
+struct MenuPath {
+  static constexpr size_t kMaxDepth = 8;
+
+  /// 0 for nodes nested deeper than kMaxDepth.
+  uint8_t length = 0;
+  std::array<uint32_t, kMaxDepth> positions{};
+};
+
+/// A click on an item as reported to Dart (onMenuItemClick).
+struct MenuClick {
+  /// CompiledMenu::generation of the menu the clicked item was built from.
+  uint32_t generation = 0;
+  int32_t id = 0;
+  MenuPath path;
+  /// Checkbox and radio items: the item's checked state after the click
+  /// (see MenuToggleState::Toggle). Unset for other items.
+  std::optional<bool> checked;
+  /// Radio items: the item of the group that the click unchecked.
+  std::optional<int32_t> unchecked_id;
+  MenuPath unchecked_path;
+};
+
+/// Flat form of a setContextMenu menu map, compiled once per set.
+///
+/// Nodes are laid out depth-first by sibling block: the root items come
+/// first, followed by the children of each submenu in order. Strings are
+/// interned into a single UTF-8 buffer so identical labels share storage,
+/// and converted once into a parallel UTF-16 buffer so shows do not convert.
+class CompiledMenu {
+ public:
+  /// FindNode and parent result for no node.
+  static constexpr uint32_t kNoNode = 0xFFFFFFFF;
+  /// radio_group result for items that are not radio items.
+  static constexpr uint32_t kNoGroup = 0xFFFFFFFF;
+
+  CompiledMenu();
+
+  const std::vector<MenuNode>& nodes() const { return nodes_; }
+  const MenuNode& node(uint32_t index) const { return nodes_[index]; }
+
+  /// Root items are always nodes [0, root_count()).
+  uint32_t root_count() const { return root_count_; }
+
+  /// Returns the interned string; empty for kEmptyString.
+  std::string_view str(StringId id) const {
+    const StringRef& ref = strings_[id];
+    return std::string_view(string_data_.data() + ref.offset, ref.length);
+  }
+
+  /// The interned string with its UTF-16 form.
+  MenuText text(StringId id) const {
+    const StringRef& wide = wide_strings_[id];
+    return {str(id), std::u16string_view(wide_data_.data() + wide.offset,
+                                         wide.length)};
+  }
+
+  size_t string_count() const { return strings_.size(); }
+
+  /// Index of the first node (in nodes() order) with the given item id, or
+  /// kNoNode. Expected O(1): ids are hashed into a flat open-addressing table
+  /// built with the menu, which copies along with it.
+  uint32_t FindNode(int32_t id) const;
+
+  /// Calls fn(uint32_t index) for every node with the given item id, in
+  /// nodes() order. menu_base ids are unique, but the JSON does not say so.
+  template <typename Fn>
+  void ForEachNodeWithId(int32_t id, Fn&& fn) const;
+
+  /// The submenu or split item whose children include index; kNoNode for
+  /// root items.
+  uint32_t parent(uint32_t index) const { return parents_[index]; }
+
+  /// Position of index in the tree (see MenuPath).
+  MenuPath PathOf(uint32_t index) const;
+
+  /// The click event for the item at index, without its checked state
+  /// (see MenuWidgetBackend::ClickItem).
+  MenuClick ClickOn(uint32_t index) const {
+    MenuClick click;
+    click.generation = generation_;
+    click.id = nodes_[index].id;
+    click.path = PathOf(index);
+    return click;
+  }
+
+  /// Radio group of node index in [0, radio_group_count()), or kNoGroup if
+  /// it is not a radio item. Radio items with the same radioGroup form one
+  /// group wherever they are in the menu; radio items without one form a
+  /// group with the other such items among their siblings.
+  uint32_t radio_group(uint32_t index) const {
+    return radio_groups_.empty() ? kNoGroup : radio_groups_[index];
+  }
+  uint32_t radio_group_count() const { return radio_group_count_; }
+
+  /// Live checked state of the checkbox and radio items, shared by every
+  /// copy of this menu; the nodes' checked fields only seed it. Compiled
+  /// menus only (not default-constructed ones).
+  MenuToggleState& toggles() const { return *toggles_; }
+
+  /// Stamp of the Dart menu this was compiled from (the "generation" of
+  /// setContextMenu and registerMenu, or of the packed header; 0 if none).
+  /// Clicks carry it so that Dart can drop clicks on a menu it has replaced.
+  uint32_t generation() const { return generation_; }
+  void set_generation(uint32_t generation) { generation_ = generation; }
+
+  /// Heap and object bytes held by this menu (allocated capacity), for
+  /// memory budgets (see menu_registry.h).
+  size_t memory_bytes() const;
+
+  /// Mutable access for in-place updates (see menu_patch.h). Changing
+  /// first_child/child_count breaks the layout invariants, changing id the
+  /// id index, and changing checked does not reach toggles().
+  MenuNode& mutable_node(uint32_t index) { return nodes_[index]; }
+
+  /// Appends a string (and its UTF-16 form) without interning it; returns
+  /// kEmptyString for "".
+  /// Strings replaced by updates stay in the table until CompactStrings.
+  StringId AddString(std::string_view value);
+
+  /// Drops the strings no node refers to any more (and interns the rest)
+  /// once AddString has appended at least as many bytes as the table held
+  /// before, so that a label updated over and over keeps the menu's size
+  /// bounded at O(1) amortized cost per appended byte. Renumbers StringIds:
+  /// only the ones in nodes() stay valid.
+  void CompactStrings();
+
+ private:
+  friend class MenuCompiler;
+  friend CompiledMenu CompileMenu(const PackedMenuView& packed);
+
+  struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  /// An id index entry; node is kNoNode for free slots.
+  struct IdSlot {
+    int32_t id;
+    uint32_t node;
+  };
+
+  /// Converts strings_ [wide_strings_.size(), string_count()) to UTF-16.
+  void ConvertStrings();
+
+  /// Fills parents_, id_slots_ and the radio groups from nodes_ and seeds
+  /// toggles_; the compilers call it last.
+  void BuildIndex();
+  /// Fills radio_groups_; needs parents_.
+  void BuildRadioGroups();
+
+  /// First slot of id's probe sequence; id_slots_ must not be empty.
+  size_t IdHome(int32_t id) const {
+    uint32_t hash = static_cast<uint32_t>(id) * 0x9E3779B1u;
+    return (hash ^ (hash >> 16)) & (id_slots_.size() - 1);
+  }
+
+  std::vector<MenuNode> nodes_;
+  std::vector<StringRef> strings_;
+  std::string string_data_;
+  /// UTF-16 forms, indexed by StringId like strings_.
+  std::vector<StringRef> wide_strings_;
+  std::u16string wide_data_;
+  /// Per node, see parent().
+  std::vector<uint32_t> parents_;
+  /// Linear probing, power-of-two size, at most half full; entries with the
+  /// same id lie along one probe sequence in node order.
+  std::vector<IdSlot> id_slots_;
+  /// Per node, see radio_group(); empty if the menu has no radio items.
+  std::vector<uint32_t> radio_groups_;
+  uint32_t radio_group_count_ = 0;
+  std::shared_ptr<MenuToggleState> toggles_;
+  uint32_t root_count_ = 0;
+  uint32_t generation_ = 0;
+  /// UTF-8 bytes appended by AddString since the table was last built.
+  size_t appended_bytes_ = 0;
+};
+
+template <typename Fn>
+void CompiledMenu::ForEachNodeWithId(int32_t id, Fn&& fn) const {
+  if (id_slots_.empty()) return;
+  const size_t mask = id_slots_.size() - 1;
+  for (size_t i = IdHome(id); id_slots_[i].node != kNoNode;
+       i = (i + 1) & mask) {
+    if (id_slots_[i].id == id) fn(id_slots_[i].node);
+  }
+}
+
+/// Compiles {"items": [...]} (tray_manager menu JSON) into a CompiledMenu.
+/// Entries that are not maps are skipped, as are unknown fields.
+CompiledMenu CompileMenu(const flutter::EncodableMap& menu_json);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_MODEL_H_
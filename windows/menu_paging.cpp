@@ -0,0 +1,92 @@
+#include "menu_paging.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "style_values.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+// Non-negative int style value clamped to uint32_t, or fallback when unset.
+uint32_t StyleCount(const ResolvedStyle& style, StyleKey key, int64_t value,
+                    uint32_t fallback) {
+  if (!style.has(key) || value < 0) return fallback;
+  return static_cast<uint32_t>(std::min<int64_t>(value, UINT32_MAX));
+}
+
+}  // namespace
+
+MenuPagingOptions ResolveMenuPaging(const ResolvedStyle& style) {
+  MenuPagingOptions options;
+  options.threshold =
+      StyleCount(style, StyleKey::kVirtualizationThreshold,
+                 style.virtualization_threshold, options.threshold);
+
+  uint32_t visible_rows = kDefaultVisibleRows;
+  if (style.max_height > 0) {
+    double item_height = style.item_height;
+    if (item_height <= 0) item_height = kDefaultItemHeight;
+    visible_rows = static_cast<uint32_t>(std::min(
+        std::ceil(style.max_height / item_height), double{UINT16_MAX}));
+  }
+  options.page_size = std::max<uint32_t>(
+      1, StyleCount(style, StyleKey::kVirtualizationPageSize,
+                    style.virtualization_page_size,
+                    visible_rows + kPageMargin));
+  options.max_items = std::max(
+      options.page_size,
+      StyleCount(style, StyleKey::kVirtualizationMaxItems,
+                 style.virtualization_max_items, options.max_items));
+
+  if (!style.virtualization_previous_label.empty()) {
+    options.previous_label = style.virtualization_previous_label;
+  }
+  if (!style.virtualization_more_label.empty()) {
+    options.more_label = style.virtualization_more_label;
+  }
+  return options;
+}
+
+bool ShouldPageList(const MenuPagingOptions& options, uint32_t count,
+                    bool virtualized) {
+  // A list that fits in one page would only gain page items.
+  if (count <= options.page_size) return false;
+  return virtualized || (options.threshold != 0 && count > options.threshold);
+}
+
+MenuPageWindow::MenuPageWindow(uint32_t count, uint32_t page_size,
+                               uint32_t max_items)
+    : count_(count),
+      page_size_(std::max<uint32_t>(page_size, 1)),
+      max_items_(std::max(max_items, page_size_)),
+      end_(std::min(count, page_size_)) {}
+
+MenuPageChange MenuPageWindow::Step(MenuPageDirection direction) {
+  MenuPageChange change;
+  if (direction == MenuPageDirection::kNext) {
+    if (!has_more()) return change;
+    change.added_first = end_;
+    change.added_count = std::min(page_size_, count_ - end_);
+    end_ += change.added_count;
+    if (size() > max_items_) {
+      change.removed_first = begin_;
+      change.removed_count = size() - max_items_;
+      begin_ += change.removed_count;
+    }
+  } else {
+    if (!has_previous()) return change;
+    change.added_count = std::min(page_size_, begin_);
+    begin_ -= change.added_count;
+    change.added_first = begin_;
+    if (size() > max_items_) {
+      change.removed_count = size() - max_items_;
+      end_ -= change.removed_count;
+      change.removed_first = end_;
+    }
+  }
+  return change;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,107 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_PAGING_H_
+#define TRAY_MANAGER_WINUI_MENU_PAGING_H_
+
+#include <cstdint>
+#include <string>
+
+#include "style_values.h"
+
+namespace tray_manager_winui {
+
+/// Lists with more entries than this are paged unless the style says
+/// otherwise. Also the default cap on the items of one paged list.
+constexpr uint32_t kDefaultPagingThreshold = 256;
+
+/// Rows assumed visible when the style has no maxHeight (about a screen of
+/// default-height items).
+constexpr uint32_t kDefaultVisibleRows = 32;
+
+/// Extra rows built past the visible ones, so the first scroll or arrow key
+/// does not immediately hit the end of the page.
+constexpr uint32_t kPageMargin = 8;
+
+/// WinUI's default MenuFlyoutItem height, used when itemHeight is not set.
+constexpr double kDefaultItemHeight = 32;
+
+/// The end of a paged list that a page item ("Previous…", "More…") sits at.
+enum class MenuPageDirection : uint8_t {
+  kPrevious,
+  kNext,
+};
+
+/// Paging part of a WinUIContextMenuStyle, resolved once per flyout.
+struct MenuPagingOptions {
+  /// virtualizationThreshold: sibling lists longer than this are paged. 0
+  /// turns automatic paging off; virtualized submenus are still paged.
+  uint32_t threshold = kDefaultPagingThreshold;
+  /// virtualizationPageSize, or the rows that fit in maxHeight plus
+  /// kPageMargin. Entries added per page.
+  uint32_t page_size = kDefaultVisibleRows + kPageMargin;
+  /// virtualizationMaxItems: most items of one paged list that exist at once.
+  /// Never less than page_size.
+  uint32_t max_items = kDefaultPagingThreshold;
+  /// virtualizationPreviousLabel / virtualizationMoreLabel (UTF-8; the
+  /// defaults end in U+2026).
+  std::string previous_label = "Previous\xE2\x80\xA6";
+  std::string more_label = "More\xE2\x80\xA6";
+};
+
+MenuPagingOptions ResolveMenuPaging(const ResolvedStyle& style);
+
+/// True if a list of count entries is built a page at a time. virtualized is
+/// the flag of the submenu the list belongs to (false for the root).
+bool ShouldPageList(const MenuPagingOptions& options, uint32_t count,
+                    bool virtualized);
+
+/// Entries of a paged list whose items a page step removes and adds. Ranges
+/// are entry offsets within the list.
+struct MenuPageChange {
+  uint32_t removed_first = 0;
+  uint32_t removed_count = 0;
+  uint32_t added_first = 0;
+  uint32_t added_count = 0;
+
+  bool empty() const { return removed_count == 0 && added_count == 0; }
+};
+
+/// The entries of a paged list that have items: [begin, end) of count.
+///
+/// Starts at the first page. Each step adds a page at one end and, once more
+/// than max_items entries would exist, removes the entries at the other end,
+/// so the window never holds more than max_items however far the user pages.
+/// Entries outside the window are represented by a "Previous…" item before
+/// it and a "More…" item after it.
+class MenuPageWindow {
+ public:
+  MenuPageWindow() = default;
+  /// page_size is raised to 1 and max_items to page_size.
+  MenuPageWindow(uint32_t count, uint32_t page_size, uint32_t max_items);
+
+  uint32_t begin() const { return begin_; }
+  uint32_t end() const { return end_; }
+  uint32_t count() const { return count_; }
+  uint32_t size() const { return end_ - begin_; }
+  uint32_t page_size() const { return page_size_; }
+  uint32_t max_items() const { return max_items_; }
+
+  bool Contains(uint32_t offset) const {
+    return offset >= begin_ && offset < end_;
+  }
+  bool has_previous() const { return begin_ > 0; }
+  bool has_more() const { return end_ < count_; }
+
+  /// Moves the window a page towards direction. Returns an empty change at
+  /// that end of the list.
+  MenuPageChange Step(MenuPageDirection direction);
+
+ private:
+  uint32_t count_ = 0;
+  uint32_t page_size_ = 1;
+  uint32_t max_items_ = 1;
+  uint32_t begin_ = 0;
+  uint32_t end_ = 0;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_PAGING_H_
@@ -0,0 +1,131 @@
+#include "menu_patch.h"
+
+#include <string>
+
+#include "menu_toggles.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+// A validated patch; value points into the source list.
+struct ParsedPatch {
+  int32_t id;
+  MenuField field;
+  const flutter::EncodableValue* value;
+};
+
+bool IsStringField(MenuField field) {
+  return field != MenuField::kChecked && field != MenuField::kDisabled;
+}
+
+bool ParsePatch(const flutter::EncodableValue& entry, ParsedPatch* out) {
+  const auto* map = std::get_if<flutter::EncodableMap>(&entry);
+  if (!map) return false;
+  auto id_it = map->find(flutter::EncodableValue("id"));
+  auto field_it = map->find(flutter::EncodableValue("field"));
+  if (id_it == map->end() || field_it == map->end()) return false;
+  const auto* id = std::get_if<int32_t>(&id_it->second);
+  const auto* field_name = std::get_if<std::string>(&field_it->second);
+  if (!id || !field_name) return false;
+
+  MenuField field;
+  if (!ParseMenuField(*field_name, &field)) return false;
+
+  static const flutter::EncodableValue kNull;
+  auto value_it = map->find(flutter::EncodableValue("value"));
+  const flutter::EncodableValue* value =
+      value_it == map->end() ? &kNull : &value_it->second;
+  const bool is_null = std::holds_alternative<std::monostate>(*value);
+  if (!is_null) {
+    if (IsStringField(field) && !std::holds_alternative<std::string>(*value)) {
+      return false;
+    }
+    if (!IsStringField(field) && !std::holds_alternative<bool>(*value)) {
+      return false;
+    }
+  }
+  *out = {*id, field, value};
+  return true;
+}
+
+void Apply(CompiledMenu& menu, uint32_t index, MenuField field,
+           const flutter::EncodableValue& value) {
+  MenuNode& node = menu.mutable_node(index);
+  if (!IsStringField(field)) {
+    const auto* b = std::get_if<bool>(&value);
+    const bool set = b && *b;
+    if (field == MenuField::kChecked) {
+      node.checked = set;
+      menu.toggles().Set(menu, index, set);
+    } else {
+      node.disabled = set;
+    }
+    return;
+  }
+  const auto* s = std::get_if<std::string>(&value);
+  StringId* slot = nullptr;
+  switch (field) {
+    case MenuField::kLabel: slot = &node.label; break;
+    case MenuField::kToolTip: slot = &node.tool_tip; break;
+    case MenuField::kIcon: slot = &node.icon; break;
+    case MenuField::kIconFontFamily: slot = &node.icon_font_family; break;
+    case MenuField::kAcceleratorText: slot = &node.accelerator_text; break;
+    default: return;
+  }
+  if (!s || s->empty()) {
+    *slot = kEmptyString;
+  } else if (menu.str(*slot) != *s) {
+    *slot = menu.AddString(*s);
+  }
+}
+
+}  // namespace
+
+bool ParseMenuField(std::string_view key, MenuField* field) {
+  if (key == "label") {
+    *field = MenuField::kLabel;
+  } else if (key == "checked") {
+    *field = MenuField::kChecked;
+  } else if (key == "disabled") {
+    *field = MenuField::kDisabled;
+  } else if (key == "toolTip") {
+    *field = MenuField::kToolTip;
+  } else if (key == "icon") {
+    *field = MenuField::kIcon;
+  } else if (key == "iconFontFamily") {
+    *field = MenuField::kIconFontFamily;
+  } else if (key == "acceleratorText") {
+    *field = MenuField::kAcceleratorText;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+MenuPatchResult ApplyMenuPatches(CompiledMenu& menu,
+                                 const flutter::EncodableList& patches) {
+  MenuPatchResult result;
+  for (const auto& entry : patches) {
+    ParsedPatch patch;
+    if (!ParsePatch(entry, &patch)) {
+      ++result.invalid;
+      continue;
+    }
+    // In list order, so that later patches to the same field win.
+    bool matched = false;
+    menu.ForEachNodeWithId(patch.id, [&](uint32_t index) {
+      Apply(menu, index, patch.field, *patch.value);
+      matched = true;
+    });
+    if (matched) {
+      ++result.applied;
+    } else {
+      ++result.unknown_id;
+    }
+  }
+  menu.CompactStrings();
+  return result;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,59 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_PATCH_H_
+#define TRAY_MANAGER_WINUI_MENU_PATCH_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+
+/// Item fields that updateMenuItems can change without a full resend.
+/// Anything else (type, id, radioGroup, submenu shape) needs setContextMenu.
+enum class MenuField : uint8_t {
+  kLabel,
+  kChecked,
+  kDisabled,
+  kToolTip,
+  kIcon,
+  kIconFontFamily,
+  kAcceleratorText,
+};
+
+/// Maps a MenuItem.toJson() key ("label", "checked", ...) to its field.
+/// Returns false for keys that cannot be patched.
+bool ParseMenuField(std::string_view key, MenuField* field);
+
+/// Outcome of ApplyMenuPatches.
+struct MenuPatchResult {
+  /// Patches written to at least one node.
+  size_t applied = 0;
+  /// Patches whose id is not in the menu.
+  size_t unknown_id = 0;
+  /// Patches that are not {id, field, value} maps, name an unknown field or
+  /// carry a value of the wrong type.
+  size_t invalid = 0;
+
+  bool ok() const { return unknown_id == 0 && invalid == 0; }
+};
+
+/// Applies a list of {"id": int, "field": string, "value": ...} maps in place.
+///
+/// String fields take a string or null (cleared); checked and disabled take a
+/// bool or null (false). checked also sets the menu's toggle state, which is
+/// shared with the menu it was copied from (see CompiledMenu::toggles). Later patches to the same id and field win. Valid
+/// patches are applied even when others in the list are rejected.
+///
+/// Runs in O(patches): nodes are found through the menu's id index (see
+/// CompiledMenu::FindNode). Every node with a patch's id is patched.
+/// Replaced strings are dropped from the menu's tables once they add up
+/// (see CompiledMenu::CompactStrings), so repeated patches keep it bounded.
+MenuPatchResult ApplyMenuPatches(CompiledMenu& menu,
+                                 const flutter::EncodableList& patches);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_PATCH_H_
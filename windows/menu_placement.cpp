@@ -0,0 +1,56 @@
+#include "menu_placement.h"
+
+#include <utility>
+#include <variant>
+
+namespace tray_manager_winui {
+
+namespace {
+
+constexpr std::pair<std::string_view, MenuPlacement> kPlacements[] = {
+    {"top", MenuPlacement::kTop},
+    {"bottom", MenuPlacement::kBottom},
+    {"left", MenuPlacement::kLeft},
+    {"right", MenuPlacement::kRight},
+    {"full", MenuPlacement::kFull},
+    {"auto", MenuPlacement::kAuto},
+    {"topEdgeAlignedLeft", MenuPlacement::kTopEdgeAlignedLeft},
+    {"topEdgeAlignedRight", MenuPlacement::kTopEdgeAlignedRight},
+    {"bottomEdgeAlignedLeft", MenuPlacement::kBottomEdgeAlignedLeft},
+    {"bottomEdgeAlignedRight", MenuPlacement::kBottomEdgeAlignedRight},
+    {"leftEdgeAlignedTop", MenuPlacement::kLeftEdgeAlignedTop},
+    {"leftEdgeAlignedBottom", MenuPlacement::kLeftEdgeAlignedBottom},
+    {"rightEdgeAlignedTop", MenuPlacement::kRightEdgeAlignedTop},
+    {"rightEdgeAlignedBottom", MenuPlacement::kRightEdgeAlignedBottom},
+};
+
+double GetNumber(const flutter::EncodableMap& map, const char* key) {
+  auto it = map.find(flutter::EncodableValue(key));
+  if (it == map.end()) return 0.0;
+  if (const auto* d = std::get_if<double>(&it->second)) return *d;
+  if (const auto* i = std::get_if<int32_t>(&it->second)) return *i;
+  if (const auto* l = std::get_if<int64_t>(&it->second)) {
+    return static_cast<double>(*l);
+  }
+  return 0.0;
+}
+
+}  // namespace
+
+std::optional<MenuPlacement> ParseMenuPlacement(std::string_view name) {
+  for (const auto& [key, placement] : kPlacements) {
+    if (key == name) return placement;
+  }
+  return std::nullopt;
+}
+
+MenuRect ParseMenuRect(const flutter::EncodableMap& rect) {
+  MenuRect parsed;
+  parsed.x = GetNumber(rect, "x");
+  parsed.y = GetNumber(rect, "y");
+  parsed.width = GetNumber(rect, "width");
+  parsed.height = GetNumber(rect, "height");
+  return parsed;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,49 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_PLACEMENT_H_
+#define TRAY_MANAGER_WINUI_MENU_PLACEMENT_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace tray_manager_winui {
+
+/// Flyout placement relative to the anchor. Values match WinUI's
+/// FlyoutPlacementMode, so the WinUI side converts with a cast.
+enum class MenuPlacement : int32_t {
+  kTop = 0,
+  kBottom = 1,
+  kLeft = 2,
+  kRight = 3,
+  kFull = 4,
+  kTopEdgeAlignedLeft = 5,
+  kTopEdgeAlignedRight = 6,
+  kBottomEdgeAlignedLeft = 7,
+  kBottomEdgeAlignedRight = 8,
+  kLeftEdgeAlignedTop = 9,
+  kLeftEdgeAlignedBottom = 10,
+  kRightEdgeAlignedTop = 11,
+  kRightEdgeAlignedBottom = 12,
+  kAuto = 13,
+};
+
+/// Parses a WinUIFlyoutPlacement name from Dart ("top", "auto",
+/// "bottomEdgeAlignedRight", ...). Returns nullopt for unknown names.
+std::optional<MenuPlacement> ParseMenuPlacement(std::string_view name);
+
+/// A screen rectangle in physical pixels, e.g. the area the flyout avoids.
+struct MenuRect {
+  double x = 0;
+  double y = 0;
+  double width = 0;
+  double height = 0;
+};
+
+/// Parses {"x", "y", "width", "height"} (doubles or ints) as sent for
+/// showContextMenu's exclusionRect. Missing or non-numeric fields are 0.
+MenuRect ParseMenuRect(const flutter::EncodableMap& rect);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_PLACEMENT_H_
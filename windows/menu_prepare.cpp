@@ -0,0 +1,99 @@
+#include "menu_prepare.h"
+
+namespace tray_manager_winui {
+
+uint64_t MenuPrepareTracker::OnMenuChanged() {
+  std::lock_guard lock(mutex_);
+  ++version_;
+  // A running prepare notices in StartPrepare or FinishPrepare.
+  if (state_ == MenuPrepareState::kPrepared) {
+    state_ = MenuPrepareState::kStale;
+    ++stats_.stale;
+  }
+  return version_;
+}
+
+uint64_t MenuPrepareTracker::RequestPrepare() {
+  std::lock_guard lock(mutex_);
+  ++stats_.requests;
+  if ((state_ == MenuPrepareState::kPreparing ||
+       state_ == MenuPrepareState::kPrepared) &&
+      prepared_version_ == version_) {
+    ++stats_.duplicates;
+    return 0;
+  }
+  state_ = MenuPrepareState::kPreparing;
+  ticket_ = next_ticket_++;
+  prepared_version_ = version_;
+  return ticket_;
+}
+
+bool MenuPrepareTracker::StartPrepare(uint64_t ticket, uint64_t version) {
+  std::lock_guard lock(mutex_);
+  if (state_ != MenuPrepareState::kPreparing || ticket != ticket_) {
+    ++stats_.skipped;
+    return false;
+  }
+  if (version != version_) {
+    // Building the replaced menu would be wasted; the next request prepares
+    // the current one.
+    state_ = MenuPrepareState::kStale;
+    ++stats_.skipped;
+    ++stats_.stale;
+    return false;
+  }
+  ++stats_.started;
+  return true;
+}
+
+void MenuPrepareTracker::FinishPrepare(uint64_t ticket, bool ok) {
+  std::lock_guard lock(mutex_);
+  if (state_ != MenuPrepareState::kPreparing || ticket != ticket_) return;
+  if (!ok) {
+    state_ = MenuPrepareState::kIdle;
+    ++stats_.failed;
+  } else if (prepared_version_ != version_) {
+    state_ = MenuPrepareState::kStale;
+    ++stats_.stale;
+  } else {
+    state_ = MenuPrepareState::kPrepared;
+    ++stats_.completed;
+  }
+}
+
+MenuPrepareShow MenuPrepareTracker::BeginShow(uint64_t version) {
+  std::lock_guard lock(mutex_);
+  const bool hit = state_ == MenuPrepareState::kPrepared &&
+                   prepared_version_ == version && version == version_;
+  // A running prepare is overtaken: the show builds the menu itself, so the
+  // prepare must not touch the pool afterwards.
+  state_ = MenuPrepareState::kConsumed;
+  if (hit) {
+    ++stats_.hits;
+    return MenuPrepareShow::kUsePrepared;
+  }
+  ++stats_.misses;
+  return MenuPrepareShow::kBuild;
+}
+
+void MenuPrepareTracker::Invalidate() {
+  std::lock_guard lock(mutex_);
+  state_ = MenuPrepareState::kIdle;
+}
+
+uint64_t MenuPrepareTracker::version() const {
+  std::lock_guard lock(mutex_);
+  return version_;
+}
+
+MenuPrepareState MenuPrepareTracker::state() const {
+  std::lock_guard lock(mutex_);
+  return state_;
+}
+
+MenuPrepareStats MenuPrepareTracker::stats() const {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,96 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_PREPARE_H_
+#define TRAY_MANAGER_WINUI_MENU_PREPARE_H_
+
+#include <cstdint>
+#include <mutex>
+
+namespace tray_manager_winui {
+
+/// Where the speculatively built (prepared) flyout stands relative to the
+/// current menu.
+enum class MenuPrepareState : uint8_t {
+  /// Nothing prepared, or the pool was reset.
+  kIdle,
+  /// A prepare was requested and has not finished.
+  kPreparing,
+  /// The hidden flyout holds the current menu; the next show only positions
+  /// and opens it.
+  kPrepared,
+  /// The flyout was prepared for a menu that has since been replaced.
+  kStale,
+  /// A show opened the prepared flyout (or built its own).
+  kConsumed,
+};
+
+/// How a show should use the pool.
+enum class MenuPrepareShow : uint8_t {
+  /// The prepared flyout is current: open it as is.
+  kUsePrepared,
+  /// Build what is missing first (MenuHostPool::Show).
+  kBuild,
+};
+
+/// Counters for tests and debug logging.
+struct MenuPrepareStats {
+  uint64_t requests = 0;
+  uint64_t duplicates = 0;
+  uint64_t started = 0;
+  uint64_t skipped = 0;
+  uint64_t completed = 0;
+  uint64_t failed = 0;
+  uint64_t stale = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+/// State machine for prepareContextMenu, shared by the platform thread, which
+/// changes the menu and requests prepares and shows, and the XAML thread,
+/// which runs them. Each menu the plugin holds has a version; a prepare is
+/// identified by a ticket and builds one version. A prepare counts only if
+/// it is still the latest one when it finishes and its version is still
+/// current; a show that overtakes it, a newer prepare or a reset make it
+/// moot. Thread-safe.
+class MenuPrepareTracker {
+ public:
+  /// Platform thread: the menu (or its style) changed. Returns the new
+  /// version, which shows and prepares of this menu carry.
+  uint64_t OnMenuChanged();
+
+  /// Platform thread: returns the ticket of a new prepare for the current
+  /// version, or 0 if one is already running or done for it.
+  uint64_t RequestPrepare();
+
+  /// XAML thread, before building: false if the prepare is no longer
+  /// wanted (superseded, overtaken by a show, or its menu replaced), in which
+  /// case the caller must not touch the pool.
+  bool StartPrepare(uint64_t ticket, uint64_t version);
+
+  /// XAML thread, after building; ok is false if the pool failed.
+  void FinishPrepare(uint64_t ticket, bool ok);
+
+  /// XAML thread, before a show of version: decides whether the prepared
+  /// flyout can be opened as is, and marks it consumed either way.
+  MenuPrepareShow BeginShow(uint64_t version);
+
+  /// XAML thread: the prepared flyout is gone (pool reset or recovery, or
+  /// ShowPrepared failed); cancels a running prepare.
+  void Invalidate();
+
+  uint64_t version() const;
+  MenuPrepareState state() const;
+  MenuPrepareStats stats() const;
+
+ private:
+  mutable std::mutex mutex_;
+  MenuPrepareState state_ = MenuPrepareState::kIdle;
+  uint64_t version_ = 0;
+  // Ticket and version of the latest prepare.
+  uint64_t ticket_ = 0;
+  uint64_t prepared_version_ = 0;
+  uint64_t next_ticket_ = 1;
+  MenuPrepareStats stats_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_PREPARE_H_
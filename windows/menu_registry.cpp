@@ -0,0 +1,79 @@
+#include "menu_registry.h"
+
+#include <iterator>
+#include <utility>
+
+namespace tray_manager_winui {
+
+size_t EstimateRegisteredMenuBytes(const RegisteredMenu& entry) {
+  return sizeof(RegisteredMenu) + entry.handle.capacity() +
+         EstimateMenuSnapshotBytes(*entry.snapshot);
+}
+
+MenuRegistry::MenuRegistry(size_t budget_bytes) : budget_bytes_(budget_bytes) {}
+
+const RegisteredMenu& MenuRegistry::Register(const std::string& handle,
+                                             MenuSnapshotPtr snapshot) {
+  ++stats_.registrations;
+  auto found = index_.find(handle);
+  if (found != index_.end()) {
+    ++stats_.replacements;
+    Erase(found->second);
+  }
+  entries_.emplace_front();
+  RegisteredMenu& entry = entries_.front();
+  entry.handle = handle;
+  entry.snapshot = std::move(snapshot);
+  entry.version = next_version_++;
+  entry.bytes = EstimateRegisteredMenuBytes(entry);
+  used_bytes_ += entry.bytes;
+  index_.emplace(handle, entries_.begin());
+  EvictToBudget(&entry);
+  return entry;
+}
+
+const RegisteredMenu* MenuRegistry::Use(const std::string& handle) {
+  auto found = index_.find(handle);
+  if (found == index_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  entries_.splice(entries_.begin(), entries_, found->second);
+  return &*found->second;
+}
+
+const RegisteredMenu* MenuRegistry::Find(const std::string& handle) const {
+  auto found = index_.find(handle);
+  return found == index_.end() ? nullptr : &*found->second;
+}
+
+bool MenuRegistry::Dispose(const std::string& handle) {
+  auto found = index_.find(handle);
+  if (found == index_.end()) return false;
+  ++stats_.disposals;
+  Erase(found->second);
+  return true;
+}
+
+void MenuRegistry::set_budget_bytes(size_t budget_bytes) {
+  budget_bytes_ = budget_bytes;
+  EvictToBudget(nullptr);
+}
+
+void MenuRegistry::EvictToBudget(const RegisteredMenu* keep) {
+  while (used_bytes_ > budget_bytes_ && !entries_.empty()) {
+    auto last = std::prev(entries_.end());
+    if (&*last == keep) break;  // Only the new menu is left.
+    ++stats_.evictions;
+    Erase(last);
+  }
+}
+
+void MenuRegistry::Erase(Entries::iterator it) {
+  used_bytes_ -= it->bytes;
+  index_.erase(it->handle);
+  entries_.erase(it);
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,106 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_REGISTRY_H_
+#define TRAY_MANAGER_WINUI_MENU_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "menu_snapshot.h"
+
+namespace tray_manager_winui {
+
+/// A menu registered under a handle: compiled once by registerMenu and shown
+/// any number of times without a setContextMenu round trip.
+struct RegisteredMenu {
+  std::string handle;
+  /// Shared with shows of it; an evicted or replaced menu that is open stays
+  /// alive until its flyout lets go.
+  MenuSnapshotPtr snapshot;
+  /// Changes whenever the handle is registered again.
+  uint64_t version = 0;
+  /// Accounted size (see EstimateRegisteredMenuBytes).
+  size_t bytes = 0;
+};
+
+/// Counters for tests, benchmarks and debug logging.
+struct MenuRegistryStats {
+  uint64_t registrations = 0;
+  /// Registrations that replaced a menu under the same handle.
+  uint64_t replacements = 0;
+  uint64_t disposals = 0;
+  /// Menus dropped to stay within the budget.
+  uint64_t evictions = 0;
+  /// Use calls that found their handle.
+  uint64_t hits = 0;
+  /// Use calls for unknown, disposed or evicted handles.
+  uint64_t misses = 0;
+};
+
+/// Approximate bytes a registered menu holds: its snapshot (see
+/// EstimateMenuSnapshotBytes) and the handle.
+size_t EstimateRegisteredMenuBytes(const RegisteredMenu& entry);
+
+/// Named menus, each with its own compiled model and style, bounded by a
+/// memory budget. When the registered menus exceed the budget, the least
+/// recently shown ones (or registered, if never shown) are evicted; showing
+/// an evicted handle then misses and the caller registers it again. The menu
+/// just registered is never evicted by its own registration, even if it alone
+/// exceeds the budget.
+///
+/// Not thread-safe; the plugin uses it on the platform thread only.
+class MenuRegistry {
+ public:
+  static constexpr size_t kDefaultBudgetBytes = size_t{8} << 20;
+
+  explicit MenuRegistry(size_t budget_bytes = kDefaultBudgetBytes);
+
+  MenuRegistry(const MenuRegistry&) = delete;
+  MenuRegistry& operator=(const MenuRegistry&) = delete;
+
+  /// Adds or replaces the menu under handle and makes it the most recent.
+  /// Returns the stored entry, valid until it is replaced, disposed or
+  /// evicted.
+  const RegisteredMenu& Register(const std::string& handle,
+                                 MenuSnapshotPtr snapshot);
+
+  /// Looks up handle for a show and makes it the most recent. Returns null
+  /// if it is not registered (or was evicted).
+  const RegisteredMenu* Use(const std::string& handle);
+
+  /// Looks up handle without changing the eviction order.
+  const RegisteredMenu* Find(const std::string& handle) const;
+
+  /// Removes handle; false if it was not registered.
+  bool Dispose(const std::string& handle);
+
+  /// Changes the budget, evicting least recently shown menus to meet it.
+  void set_budget_bytes(size_t budget_bytes);
+  size_t budget_bytes() const { return budget_bytes_; }
+
+  /// Accounted bytes of all registered menus.
+  size_t used_bytes() const { return used_bytes_; }
+  size_t size() const { return index_.size(); }
+
+  const MenuRegistryStats& stats() const { return stats_; }
+
+ private:
+  using Entries = std::list<RegisteredMenu>;
+
+  // Evicts from the back (least recent) until within budget, sparing keep.
+  void EvictToBudget(const RegisteredMenu* keep);
+  void Erase(Entries::iterator it);
+
+  size_t budget_bytes_;
+  size_t used_bytes_ = 0;
+  uint64_t next_version_ = 1;
+  // Most recently shown first.
+  Entries entries_;
+  std::unordered_map<std::string, Entries::iterator> index_;
+  MenuRegistryStats stats_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_REGISTRY_H_
@@ -0,0 +1,36 @@
+#include "menu_snapshot.h"
+
+#include <atomic>
+#include <utility>
+
+namespace tray_manager_winui {
+
+size_t EstimateMenuSnapshotBytes(const MenuSnapshot& snapshot) {
+  return sizeof(MenuSnapshot) - sizeof(CompiledMenu) +
+         snapshot.menu.memory_bytes() + snapshot.style->memory_bytes();
+}
+
+std::shared_ptr<MenuSnapshot> MakeMenuSnapshot(
+    CompiledMenu menu, const flutter::EncodableMap& style) {
+  auto snapshot = std::make_shared<MenuSnapshot>();
+  snapshot->menu = std::move(menu);
+  snapshot->style = std::make_shared<const ResolvedStyle>(ResolveStyle(style));
+  return snapshot;
+}
+
+MenuPatchResult PatchMenuSnapshot(std::shared_ptr<MenuSnapshot>& snapshot,
+                                  const flutter::EncodableList& patches) {
+  // Other threads can only drop their references, never add one, so a count
+  // of 1 stays 1. The fence orders their last reads of the menu, released by
+  // the count decrement, before the writes below.
+  if (snapshot.use_count() == 1) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return ApplyMenuPatches(snapshot->menu, patches);
+  }
+  auto patched = std::make_shared<MenuSnapshot>(*snapshot);
+  MenuPatchResult result = ApplyMenuPatches(patched->menu, patches);
+  snapshot = std::move(patched);
+  return result;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,55 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_SNAPSHOT_H_
+#define TRAY_MANAGER_WINUI_MENU_SNAPSHOT_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "menu_model.h"
+#include "menu_patch.h"
+#include "style_values.h"
+
+namespace tray_manager_winui {
+
+/// A compiled menu and its style as one setContextMenu or registerMenu left
+/// them. Immutable once shared: the plugin's current menu, a queued show, the
+/// pooled flyout and an open menu all share one snapshot by pointer, and a
+/// newer setContextMenu replaces the plugin's pointer without touching the
+/// snapshot an open flyout still shows. Only PatchMenuSnapshot changes one,
+/// and only while nothing else holds it. The one live part is the menu's
+/// toggle state (CompiledMenu::toggles), which snapshots patched from this
+/// one share, so that clicks on checkbox and radio items outlive patches.
+struct MenuSnapshot {
+  CompiledMenu menu;
+  /// Never null. Resolved once when the snapshot is made; shared with
+  /// snapshots patched from this one (updateMenuItems), which only change
+  /// the menu.
+  std::shared_ptr<const ResolvedStyle> style;
+};
+
+using MenuSnapshotPtr = std::shared_ptr<const MenuSnapshot>;
+
+/// Makes a snapshot from menu, moved in, and style, resolved. Returned
+/// mutable for the owner that patches it (PatchMenuSnapshot); everyone else
+/// gets a MenuSnapshotPtr.
+std::shared_ptr<MenuSnapshot> MakeMenuSnapshot(
+    CompiledMenu menu, const flutter::EncodableMap& style);
+
+/// updateMenuItems: applies patches to snapshot's menu. In place if snapshot
+/// is the only reference to it; otherwise (a queued show, the pooled flyout
+/// or an open menu holds it) copy-on-write: snapshot is replaced by a patched
+/// copy sharing the style, and the old one stays as it was for its holders.
+/// Call it on the thread that hands out copies of snapshot.
+MenuPatchResult PatchMenuSnapshot(std::shared_ptr<MenuSnapshot>& snapshot,
+                                  const flutter::EncodableList& patches);
+
+/// Approximate bytes snapshot holds: the compiled menu and the resolved
+/// style, counted in full even when the style is shared. For memory budgets
+/// (see menu_registry.h).
+size_t EstimateMenuSnapshotBytes(const MenuSnapshot& snapshot);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_SNAPSHOT_H_
@@ -0,0 +1,70 @@
+#include "menu_toggles.h"
+
+namespace tray_manager_winui {
+
+MenuToggleState::MenuToggleState(const CompiledMenu& menu)
+    : node_count_(menu.nodes().size()),
+      group_count_(menu.radio_group_count()),
+      checked_(new std::atomic<bool>[node_count_]),
+      group_checked_(new std::atomic<uint32_t>[group_count_]) {
+  for (uint32_t group = 0; group < group_count_; ++group) {
+    group_checked_[group].store(CompiledMenu::kNoNode,
+                                std::memory_order_relaxed);
+  }
+  for (uint32_t i = 0; i < node_count_; ++i) {
+    const bool checked = menu.node(i).checked;
+    checked_[i].store(checked, std::memory_order_relaxed);
+    const uint32_t group = menu.radio_group(i);
+    if (checked && group != CompiledMenu::kNoGroup) Select(group, i);
+  }
+}
+
+MenuToggleResult MenuToggleState::Toggle(const CompiledMenu& menu,
+                                         uint32_t index) {
+  MenuToggleResult result;
+  const MenuItemType type = menu.node(index).type;
+  if (type == MenuItemType::kCheckbox) {
+    result.toggled = true;
+    // Clicks all run on the XAML thread.
+    result.checked = !checked(index);
+    checked_[index].store(result.checked, std::memory_order_relaxed);
+  } else if (type == MenuItemType::kRadio) {
+    result.toggled = true;
+    result.checked = true;
+    result.unchecked = Select(menu.radio_group(index), index);
+  }
+  return result;
+}
+
+void MenuToggleState::Set(const CompiledMenu& menu, uint32_t index,
+                          bool checked) {
+  const uint32_t group = menu.radio_group(index);
+  if (group == CompiledMenu::kNoGroup) {
+    checked_[index].store(checked, std::memory_order_relaxed);
+  } else if (checked) {
+    Select(group, index);
+  } else {
+    checked_[index].store(false, std::memory_order_relaxed);
+    uint32_t expected = index;
+    group_checked_[group].compare_exchange_strong(
+        expected, CompiledMenu::kNoNode, std::memory_order_relaxed);
+  }
+}
+
+size_t MenuToggleState::memory_bytes() const {
+  return sizeof(*this) + node_count_ * sizeof(std::atomic<bool>) +
+         group_count_ * sizeof(std::atomic<uint32_t>);
+}
+
+uint32_t MenuToggleState::Select(uint32_t group, uint32_t index) {
+  checked_[index].store(true, std::memory_order_relaxed);
+  const uint32_t previous =
+      group_checked_[group].exchange(index, std::memory_order_relaxed);
+  if (previous == index || previous == CompiledMenu::kNoNode) {
+    return CompiledMenu::kNoNode;
+  }
+  checked_[previous].store(false, std::memory_order_relaxed);
+  return previous;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,78 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_TOGGLES_H_
+#define TRAY_MANAGER_WINUI_MENU_TOGGLES_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+
+/// Outcome of MenuToggleState::Toggle.
+struct MenuToggleResult {
+  /// False if the node is not a checkbox or radio item; nothing changed.
+  bool toggled = false;
+  /// The clicked item's state after the click.
+  bool checked = false;
+  /// The radio item of the same group that the click unchecked, or kNoNode.
+  uint32_t unchecked = CompiledMenu::kNoNode;
+};
+
+/// Checked state of a menu's checkbox and radio items, owned by the native
+/// side so that a click toggles them (and unchecks the rest of a radio
+/// group) without waiting for Dart to send the menu again.
+///
+/// Starts from the compiled `checked` fields; in a radio group with more than
+/// one checked item the last one in node order wins, as if they were checked
+/// one after another. Each group remembers its checked item, so selecting a
+/// radio item is O(1) whatever the group's size.
+///
+/// Every copy of a CompiledMenu shares one state (see CompiledMenu::toggles):
+/// a click on a flyout built from one snapshot is seen by the snapshots
+/// patched from it. Clicks arrive on the XAML thread and updateMenuItems on
+/// the platform thread, so entries are atomics; a click and a patch racing
+/// on the same group are not ordered, and the next change to the group
+/// settles it.
+class MenuToggleState {
+ public:
+  /// The state menu's checked fields describe.
+  explicit MenuToggleState(const CompiledMenu& menu);
+
+  MenuToggleState(const MenuToggleState&) = delete;
+  MenuToggleState& operator=(const MenuToggleState&) = delete;
+
+  bool checked(uint32_t index) const {
+    return checked_[index].load(std::memory_order_relaxed);
+  }
+
+  /// The checked item of radio group group, or CompiledMenu::kNoNode.
+  uint32_t group_checked(uint32_t group) const {
+    return group_checked_[group].load(std::memory_order_relaxed);
+  }
+
+  /// A click on node index of menu (the menu this state belongs to):
+  /// checkboxes flip; a radio item becomes checked and unchecks the group's
+  /// previous one. Clicking the checked radio item leaves it checked.
+  MenuToggleResult Toggle(const CompiledMenu& menu, uint32_t index);
+
+  /// Sets node index as updateMenuItems does. Checking a radio item
+  /// unchecks the rest of its group.
+  void Set(const CompiledMenu& menu, uint32_t index, bool checked);
+
+  size_t memory_bytes() const;
+
+ private:
+  // Checks index and unchecks the group's previous item; returns that item.
+  uint32_t Select(uint32_t group, uint32_t index);
+
+  size_t node_count_;
+  uint32_t group_count_;
+  std::unique_ptr<std::atomic<bool>[]> checked_;
+  std::unique_ptr<std::atomic<uint32_t>[]> group_checked_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_TOGGLES_H_
@@ -0,0 +1,448 @@
+#include "menu_widget_backend.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "menu_toggles.h"
+#include "style_values.h"
+#include "utf16.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+bool HasClick(MenuItemType type) {
+  return type == MenuItemType::kNormal || type == MenuItemType::kCheckbox ||
+         type == MenuItemType::kRadio;
+}
+
+bool HasAcceleratorText(MenuItemType type) {
+  return type == MenuItemType::kNormal || type == MenuItemType::kRadio;
+}
+
+}  // namespace
+
+MenuWidgetKind WidgetKindFor(MenuItemType type) {
+  switch (type) {
+    case MenuItemType::kSeparator:
+      return MenuWidgetKind::kSeparator;
+    case MenuItemType::kSubmenu:
+    case MenuItemType::kSplit:
+      return MenuWidgetKind::kSubItem;
+    case MenuItemType::kCheckbox:
+    case MenuItemType::kRadio:
+      return MenuWidgetKind::kToggle;
+    case MenuItemType::kNormal:
+      break;
+  }
+  return MenuWidgetKind::kItem;
+}
+
+MenuItemStyle ResolveMenuItemStyle(const ResolvedStyle& style) {
+  MenuItemStyle resolved;
+  resolved.compact = style.compact_item_layout;
+  resolved.font_size = style.font_size;
+  resolved.item_height = style.item_height;
+  resolved.text_color = style.text_color;
+  resolved.disabled_text_color = style.disabled_text_color;
+  resolved.icon_color = style.icon_color;
+  resolved.separator_color = style.separator_color;
+  return resolved;
+}
+
+uint16_t ParseIconGlyph(std::string_view icon) {
+  if (icon.size() < 3 || icon[0] != '0' || (icon[1] != 'x' && icon[1] != 'X')) {
+    return 0;
+  }
+  uint32_t code_point = 0;
+  const char* first = icon.data() + 2;
+  const char* last = icon.data() + icon.size();
+  auto [ptr, ec] = std::from_chars(first, last, code_point, 16);
+  // Like stoul, accept trailing garbage after at least one hex digit.
+  if (ec != std::errc() || ptr == first) return 0;
+  if (code_point > 0xFFFF) return 0;
+  return static_cast<uint16_t>(code_point);
+}
+
+bool MenuWidgetBackend::CreateFlyout(const ResolvedStyle& style) {
+  item_style_ = ResolveMenuItemStyle(style);
+  paging_ = ResolveMenuPaging(style);
+  return CreateFlyoutWidget(style);
+}
+
+void MenuWidgetBackend::DestroyFlyout() {
+  menu_ = nullptr;
+  submenus_.Clear();
+  shown_checked_.clear();
+  icon_column_.clear();
+  live_.clear();
+  paged_lists_.clear();
+  DestroyFlyoutWidget();
+}
+
+bool MenuWidgetBackend::BuildItems(const CompiledMenu& menu) {
+  menu_ = &menu;
+  submenus_.Reset(menu);
+  paged_lists_.clear();
+  shown_checked_.assign(menu.nodes().size(), 0);
+  icon_column_.assign(menu.nodes().size(), 0);
+  live_.clear();
+  ClearItems(menu.nodes().size());
+  BuildRange(menu, kRootWidget, 0, menu.root_count());
+  return true;
+}
+
+void MenuWidgetBackend::RebindItems(const CompiledMenu& menu) {
+  menu_ = &menu;
+  if (!live_.empty()) EndLiveValues(menu);
+  // Toggles may have changed since the items were built: clicks in an
+  // earlier show of another snapshot of the menu, or updateMenuItems.
+  const MenuToggleState& toggles = menu.toggles();
+  const auto node_count = static_cast<uint32_t>(menu.nodes().size());
+  for (uint32_t i = 0; i < node_count; ++i) {
+    if (WidgetKindFor(menu.node(i).type) != MenuWidgetKind::kToggle) continue;
+    const bool checked = toggles.checked(i);
+    if (shown_checked_[i] != checked && IsItemBuilt(i)) {
+      ShowChecked(i, checked);
+    }
+  }
+}
+
+bool MenuWidgetBackend::ApplyLiveItem(const LiveItemUpdate& update) {
+  if (!menu_) return false;
+  bool found = false;
+  menu_->ForEachNodeWithId(update.id, [&](uint32_t index) {
+    const MenuNode& node = menu_->node(index);
+    if (node.type == MenuItemType::kSeparator) return;
+    found = true;
+    LiveValues& live = live_[index];
+    const bool built = IsItemBuilt(index);
+    if (update.label) {
+      live.label = *update.label;
+      live.label_utf16 = Utf8ToUtf16(*update.label);
+      if (built) SetText(index, live.text());
+    }
+    const uint16_t glyph = update.icon ? ParseIconGlyph(*update.icon) : 0;
+    if (glyph != 0) {
+      live.glyph = glyph;
+      if (built && icon_column_[index]) {
+        SetIcon(index, glyph, menu_->text(node.icon_font_family),
+                item_style_.icon_color);
+      }
+    }
+    if (update.disabled) {
+      const uint32_t shown = live.disabled ? LiveForegroundFor(*live.disabled)
+                                           : ForegroundFor(node.disabled);
+      live.disabled = *update.disabled;
+      if (built) {
+        SetEnabled(index, !*live.disabled);
+        const uint32_t foreground = LiveForegroundFor(*live.disabled);
+        if (foreground != 0 && foreground != shown) {
+          SetForeground(index, foreground);
+        }
+      }
+    }
+  });
+  return found;
+}
+
+MenuClick MenuWidgetBackend::ClickItem(uint32_t index) {
+  MenuClick click = menu_->ClickOn(index);
+  const MenuToggleResult toggle = menu_->toggles().Toggle(*menu_, index);
+  if (!toggle.toggled) return click;
+  ShowChecked(index, toggle.checked);
+  click.checked = toggle.checked;
+  if (toggle.unchecked != CompiledMenu::kNoNode) {
+    if (IsItemBuilt(toggle.unchecked)) ShowChecked(toggle.unchecked, false);
+    click.unchecked_id = menu_->node(toggle.unchecked).id;
+    click.unchecked_path = menu_->PathOf(toggle.unchecked);
+  }
+  return click;
+}
+
+bool MenuWidgetBackend::MaterializeSubmenu(uint32_t index) {
+  if (!menu_ || !submenus_.MarkBuilt(index)) return false;
+  const MenuNode& node = menu_->node(index);
+  BuildRange(*menu_, index, node.first_child, node.child_count);
+  return true;
+}
+
+bool MenuWidgetBackend::ShowPage(uint32_t parent, MenuPageDirection direction) {
+  const PagedList* list = FindPagedList(parent);
+  if (!menu_ || !list) return false;
+  const uint32_t first = list->first;
+  const MenuPageWindow before = list->window;
+  MenuPageWindow window = before;
+  const MenuPageChange change = window.Step(direction);
+  if (change.empty()) return false;
+
+  // Items move first, positioned against the old page items; building and
+  // releasing items can add and remove paged lists, so list is not used
+  // again.
+  const uint32_t lead = before.has_previous() ? 1 : 0;
+  const uint32_t removed_at = lead + (change.removed_first - before.begin());
+  for (uint32_t i = 0; i < change.removed_count; ++i) {
+    RemoveItem(parent, removed_at);
+    ReleaseSubtree(first + change.removed_first + i);
+  }
+  const uint32_t added_at =
+      direction == MenuPageDirection::kNext
+          ? lead + (before.size() - change.removed_count)
+          : lead;
+  for (uint32_t i = 0; i < change.added_count; ++i) {
+    const uint32_t index = first + change.added_first + i;
+    BuildItem(*menu_, index);
+    InsertItem(parent, added_at + i, index);
+  }
+
+  if (window.has_previous() != before.has_previous()) {
+    if (window.has_previous()) {
+      InsertPageItem(parent, 0, MenuPageDirection::kPrevious,
+                     paging_.previous_label);
+    } else {
+      RemoveItem(parent, 0);
+    }
+  }
+  if (window.has_more() != before.has_more()) {
+    const uint32_t more_at = (window.has_previous() ? 1 : 0) + window.size();
+    if (window.has_more()) {
+      InsertPageItem(parent, more_at, MenuPageDirection::kNext,
+                     paging_.more_label);
+    } else {
+      RemoveItem(parent, more_at);
+    }
+  }
+  FindPagedList(parent)->window = window;
+  return true;
+}
+
+bool MenuWidgetBackend::IsItemBuilt(uint32_t index) const {
+  if (!menu_ || !submenus_.IsMaterialized(index)) return false;
+  const uint32_t parent = submenus_.parent(index);
+  const PagedList* list = FindPagedList(
+      parent == LazySubmenuTracker::kNoParent ? kRootWidget : parent);
+  return !list || list->window.Contains(index - list->first);
+}
+
+const MenuPageWindow* MenuWidgetBackend::page_window(uint32_t parent) const {
+  const PagedList* list = FindPagedList(parent);
+  return list ? &list->window : nullptr;
+}
+
+void MenuWidgetBackend::BuildRange(const CompiledMenu& menu, uint32_t parent,
+                                   uint32_t first, uint32_t count) {
+  const bool virtualized =
+      parent != kRootWidget && menu.node(parent).virtualized;
+  if (!ShouldPageList(paging_, count, virtualized)) {
+    for (uint32_t index = first; index < first + count; ++index) {
+      BuildItem(menu, index);
+      AppendItem(parent, index);
+    }
+    return;
+  }
+
+  const MenuPageWindow window(count, paging_.page_size, paging_.max_items);
+  for (uint32_t offset = window.begin(); offset < window.end(); ++offset) {
+    BuildItem(menu, first + offset);
+    AppendItem(parent, first + offset);
+  }
+  // Paged lists are longer than a page, so the first page has more after it.
+  InsertPageItem(parent, window.size(), MenuPageDirection::kNext,
+                 paging_.more_label);
+  paged_lists_.push_back({parent, first, window});
+}
+
+void MenuWidgetBackend::BuildItem(const CompiledMenu& menu, uint32_t index) {
+  const MenuNode& node = menu.node(index);
+  const MenuWidgetKind kind = WidgetKindFor(node.type);
+  CreateItem(index, kind);
+
+  if (kind == MenuWidgetKind::kSeparator) {
+    if (item_style_.separator_color != 0) {
+      SetSeparatorColor(index, item_style_.separator_color);
+    }
+    return;
+  }
+
+  const LiveValues* live = FindLive(index);
+  SetText(index, live && live->label ? live->text() : menu.text(node.label));
+  const bool live_disabled = live && live->disabled;
+  const bool disabled = live_disabled ? *live->disabled : node.disabled;
+  SetEnabled(index, !disabled);
+  if (kind == MenuWidgetKind::kToggle) {
+    ShowChecked(index, menu.toggles().checked(index));
+  }
+  if (HasClick(node.type)) {
+    SetClickHandler(index, node.id, kind == MenuWidgetKind::kToggle);
+  }
+  if (kind == MenuWidgetKind::kSubItem && node.has_children()) {
+    if (lazy_submenus_) {
+      SetSubmenuOpenHandler(index);
+    } else {
+      submenus_.MarkBuilt(index);
+      BuildRange(menu, index, node.first_child, node.child_count);
+    }
+  }
+
+  // Split entries keep their icon column to tell them apart from submenus.
+  const bool compact = item_style_.compact &&
+                       node.type != MenuItemType::kSplit &&
+                       SetCompactStyle(index, kind);
+  if (!compact) {
+    icon_column_[index] = 1;
+    const uint16_t glyph = live && live->glyph
+                               ? *live->glyph
+                               : ParseIconGlyph(menu.str(node.icon));
+    if (glyph != 0) {
+      SetIcon(index, glyph, menu.text(node.icon_font_family),
+              item_style_.icon_color);
+    }
+  }
+
+  const MenuText accelerator_text = menu.text(node.accelerator_text);
+  if (HasAcceleratorText(node.type) && !accelerator_text.empty()) {
+    SetAcceleratorText(index, accelerator_text);
+  }
+  const MenuText tool_tip = menu.text(node.tool_tip);
+  if (!tool_tip.empty()) SetToolTip(index, tool_tip);
+
+  ApplyItemStyle(index, live_disabled ? LiveForegroundFor(disabled)
+                                      : ForegroundFor(node.disabled));
+}
+
+void MenuWidgetBackend::ReleaseSubtree(uint32_t index) {
+  if (submenus_.MarkUnbuilt(index)) {
+    const MenuNode& node = menu_->node(index);
+    uint32_t begin = 0;
+    uint32_t end = node.child_count;
+    auto it = std::find_if(
+        paged_lists_.begin(), paged_lists_.end(),
+        [index](const PagedList& list) { return list.parent == index; });
+    if (it != paged_lists_.end()) {
+      begin = it->window.begin();
+      end = it->window.end();
+      paged_lists_.erase(it);
+    }
+    for (uint32_t offset = begin; offset < end; ++offset) {
+      ReleaseSubtree(node.first_child + offset);
+    }
+  }
+  ReleaseItem(index);
+}
+
+const MenuWidgetBackend::PagedList* MenuWidgetBackend::FindPagedList(
+    uint32_t parent) const {
+  for (const PagedList& list : paged_lists_) {
+    if (list.parent == parent) return &list;
+  }
+  return nullptr;
+}
+
+MenuWidgetBackend::PagedList* MenuWidgetBackend::FindPagedList(
+    uint32_t parent) {
+  return const_cast<PagedList*>(
+      static_cast<const MenuWidgetBackend*>(this)->FindPagedList(parent));
+}
+
+void MenuWidgetBackend::ShowChecked(uint32_t index, bool checked) {
+  shown_checked_[index] = checked;
+  SetChecked(index, checked);
+}
+
+void MenuWidgetBackend::ApplyItemStyle(uint32_t index, uint32_t foreground) {
+  if (item_style_.font_size > 0) SetFontSize(index, item_style_.font_size);
+  if (item_style_.item_height > 0) SetMinHeight(index, item_style_.item_height);
+  if (foreground != 0) SetForeground(index, foreground);
+}
+
+uint32_t MenuWidgetBackend::ForegroundFor(bool disabled) const {
+  if (disabled && item_style_.disabled_text_color != 0) {
+    return item_style_.disabled_text_color;
+  }
+  return item_style_.text_color;
+}
+
+// Without a textColor to go back to, a live disabled value could not take
+// disabledTextColor off again (foregrounds are never cleared), so items whose
+// enabled state is live keep the theme's colours then.
+uint32_t MenuWidgetBackend::LiveForegroundFor(bool disabled) const {
+  return item_style_.text_color == 0 ? 0 : ForegroundFor(disabled);
+}
+
+const MenuWidgetBackend::LiveValues* MenuWidgetBackend::FindLive(
+    uint32_t index) const {
+  if (live_.empty()) return nullptr;
+  auto it = live_.find(index);
+  return it == live_.end() ? nullptr : &it->second;
+}
+
+void MenuWidgetBackend::EndLiveValues(const CompiledMenu& menu) {
+  for (const auto& [index, live] : live_) {
+    if (!IsItemBuilt(index)) continue;
+    const MenuNode& node = menu.node(index);
+    if (live.label) SetText(index, menu.text(node.label));
+    if (live.glyph && icon_column_[index]) {
+      const uint16_t glyph = ParseIconGlyph(menu.str(node.icon));
+      if (glyph != 0) {
+        SetIcon(index, glyph, menu.text(node.icon_font_family),
+                item_style_.icon_color);
+      } else {
+        ClearIcon(index);
+      }
+    }
+    if (live.disabled) {
+      SetEnabled(index, !node.disabled);
+      // UpdateItem may have set it too, from what it took the item to show.
+      const uint32_t foreground = ForegroundFor(node.disabled);
+      if (foreground != 0) SetForeground(index, foreground);
+    }
+  }
+  live_.clear();
+}
+
+bool MenuWidgetBackend::UpdateItem(const CompiledMenu& previous,
+                                   const CompiledMenu& menu, uint32_t index) {
+  if (!IsItemBuilt(index)) return true;
+  const MenuNode& before = previous.node(index);
+  const MenuNode& node = menu.node(index);
+  // Icons are only set up at build time.
+  if (previous.str(before.icon) != menu.str(node.icon) ||
+      previous.str(before.icon_font_family) !=
+          menu.str(node.icon_font_family)) {
+    return false;
+  }
+  if (before.disabled != node.disabled &&
+      ForegroundFor(node.disabled) == 0 &&
+      ForegroundFor(before.disabled) != 0) {
+    return false;
+  }
+
+  const MenuWidgetKind kind = WidgetKindFor(node.type);
+  if (kind == MenuWidgetKind::kSeparator) return true;
+
+  if (previous.str(before.label) != menu.str(node.label)) {
+    SetText(index, menu.text(node.label));
+  }
+  if (before.disabled != node.disabled) {
+    SetEnabled(index, !node.disabled);
+    const uint32_t foreground = ForegroundFor(node.disabled);
+    if (foreground != ForegroundFor(before.disabled)) {
+      SetForeground(index, foreground);
+    }
+  }
+  if (kind == MenuWidgetKind::kToggle &&
+      shown_checked_[index] != menu.toggles().checked(index)) {
+    ShowChecked(index, menu.toggles().checked(index));
+  }
+  if (HasAcceleratorText(node.type) &&
+      previous.str(before.accelerator_text) !=
+          menu.str(node.accelerator_text)) {
+    SetAcceleratorText(index, menu.text(node.accelerator_text));
+  }
+  if (previous.str(before.tool_tip) != menu.str(node.tool_tip)) {
+    SetToolTip(index, menu.text(node.tool_tip));
+  }
+  return true;
+}
+
+}  // namespace tray_manager_winui
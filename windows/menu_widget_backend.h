@@ -0,0 +1,255 @@
+#ifndef TRAY_MANAGER_WINUI_MENU_WIDGET_BACKEND_H_
+#define TRAY_MANAGER_WINUI_MENU_WIDGET_BACKEND_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "lazy_submenus.h"
+#include "live_items.h"
+#include "menu_host_pool.h"
+#include "menu_model.h"
+#include "menu_paging.h"
+
+namespace tray_manager_winui {
+
+/// Flyout item controls. Radio entries are toggles (RadioMenuFlyoutItem
+/// crashes inside XAML Islands) and split entries are sub items (WinUI has no
+/// SplitMenuFlyoutItem).
+enum class MenuWidgetKind : uint8_t {
+  kItem,
+  kToggle,
+  kSubItem,
+  kSeparator,
+};
+
+/// Widget kind used for a menu item type.
+MenuWidgetKind WidgetKindFor(MenuItemType type);
+
+/// Parent handle of root items in MenuWidgetBackend::AppendItem.
+constexpr uint32_t kRootWidget = 0xFFFFFFFF;
+
+/// Per-item part of a WinUIContextMenuStyle, resolved once per flyout.
+/// Colours are 0xAARRGGBB; 0 means "not set", as do sizes of 0.
+struct MenuItemStyle {
+  /// compactItemLayout (default true).
+  bool compact = true;
+  double font_size = 0;
+  double item_height = 0;
+  uint32_t text_color = 0;
+  uint32_t disabled_text_color = 0;
+  uint32_t icon_color = 0;
+  uint32_t separator_color = 0;
+};
+
+MenuItemStyle ResolveMenuItemStyle(const ResolvedStyle& style);
+
+/// Parses an icon string ("0xE713") into a Segoe Fluent Icons code point.
+/// Returns 0 for invalid input or code points outside the BMP.
+uint16_t ParseIconGlyph(std::string_view icon);
+
+/// Receives the menu events that are forwarded to Dart (onMenuItemClick,
+/// onMenuOpening, onMenuClosing, onMenuClosed).
+class MenuEventSink {
+ public:
+  virtual ~MenuEventSink() = default;
+
+  virtual void OnMenuItemClick(const MenuClick& click) = 0;
+  virtual void OnMenuOpening() = 0;
+  virtual void OnMenuClosing() = 0;
+  virtual void OnMenuClosed() = 0;
+};
+
+/// MenuHostBackend that builds and updates items through per-property widget
+/// calls. Deciding which controls to create and which properties to set is
+/// platform-neutral and lives here; subclasses only map the calls onto
+/// controls (WinUI on Windows, an in-memory tree in RecordingMenuBackend).
+///
+/// Widgets are addressed by their CompiledMenu node index. Submenu children
+/// are built when the submenu is first opened (see LazySubmenuTracker), and
+/// long lists a page at a time (see MenuPageWindow).
+class MenuWidgetBackend : public MenuHostBackend {
+ public:
+  /// Resolves the item style and paging options, then calls
+  /// CreateFlyoutWidget.
+  bool CreateFlyout(const ResolvedStyle& style) override;
+
+  /// Forgets the built items, then calls DestroyFlyoutWidget.
+  void DestroyFlyout() override;
+
+  /// Creates, configures and appends the root items; submenu children are
+  /// left to MaterializeSubmenu.
+  bool BuildItems(const CompiledMenu& menu) override;
+
+  /// Sets only the properties that differ between the two nodes. Refuses
+  /// icon changes, and re-enabling an item whose disabled colour has no
+  /// textColor to revert to (foregrounds are never cleared). Items inside
+  /// submenus that were not built yet, or outside the page window of a
+  /// paged list, need nothing.
+  bool UpdateItem(const CompiledMenu& previous, const CompiledMenu& menu,
+                  uint32_t index) override;
+
+  /// Builds later items (submenus, pages) from menu, and sets the built
+  /// toggles whose checked state differs from menu's toggle state. Live
+  /// values end here: built items that show one get menu's value back.
+  void RebindItems(const CompiledMenu& menu) override;
+
+  /// Shows update on the items with its id, built or built later (submenus,
+  /// pages), until the items are rebuilt or rebound to another menu. For
+  /// labels, icons and enabled state that change while the flyout is open
+  /// (updateLiveItems). Icons only change on items with an icon column (not
+  /// compact), and only to valid glyphs. Returns false if the menu has no
+  /// such item.
+  bool ApplyLiveItem(const LiveItemUpdate& update);
+
+  /// Builds the children of submenu index if they were not built yet in this
+  /// flyout. Called by the submenu open handler; returns false if there was
+  /// nothing to build.
+  bool MaterializeSubmenu(uint32_t index);
+
+  /// Moves the paged list of parent (kRootWidget or a sub item) a page
+  /// towards direction: builds the entries that come into view and removes
+  /// the ones beyond the paging cap. Called by the page items; returns false
+  /// if parent is not paged or there is nothing left in that direction.
+  bool ShowPage(uint32_t parent, MenuPageDirection direction);
+
+  /// The menu the items were built from or last rebound to; null before
+  /// the first BuildItems.
+  const CompiledMenu* menu() const { return menu_; }
+
+  /// Handles a click on the item of node index and returns the click event,
+  /// stamped with the menu the items show now (see RebindItems). Checkbox
+  /// and radio items are toggled in the menu's toggle state, and the built
+  /// items of the change are set in place: the clicked one (toggle controls
+  /// flip themselves, which a checked radio item must undo) and the radio
+  /// item it unchecked. For click handlers.
+  MenuClick ClickItem(uint32_t index);
+
+  /// True if the item for node index currently exists.
+  bool IsItemBuilt(uint32_t index) const;
+
+  /// Page window of the list of parent, or null if it is not paged.
+  const MenuPageWindow* page_window(uint32_t parent) const;
+
+  /// With lazy submenus off, BuildItems builds the whole tree up front.
+  void set_lazy_submenus(bool lazy) { lazy_submenus_ = lazy; }
+
+  const MenuItemStyle& item_style() const { return item_style_; }
+  const MenuPagingOptions& paging() const { return paging_; }
+  const LazySubmenuTracker& submenus() const { return submenus_; }
+
+ protected:
+  /// Creates the flyout for style (see MenuHostBackend::CreateFlyout).
+  virtual bool CreateFlyoutWidget(const ResolvedStyle& style) = 0;
+  virtual void DestroyFlyoutWidget() = 0;
+
+  /// Removes all items; node_count widgets are about to be created.
+  virtual void ClearItems(size_t node_count) = 0;
+  virtual void CreateItem(uint32_t index, MenuWidgetKind kind) = 0;
+  /// Appends index to the flyout (kRootWidget) or to a sub item.
+  virtual void AppendItem(uint32_t parent, uint32_t index) = 0;
+  /// Inserts index into the items of parent at position. Positions count
+  /// every item of parent, page items included.
+  virtual void InsertItem(uint32_t parent, uint32_t position,
+                          uint32_t index) = 0;
+  /// Removes the item (or page item) at position from parent.
+  virtual void RemoveItem(uint32_t parent, uint32_t position) = 0;
+  /// Drops the widget of index after it was removed from its parent,
+  /// including the page items of its own children.
+  virtual void ReleaseItem(uint32_t index) = 0;
+  /// Inserts a page item into parent at position. Clicking it, or reaching it
+  /// by pointer or keyboard, calls ShowPage(parent, direction); it keeps the
+  /// menu open.
+  virtual void InsertPageItem(uint32_t parent, uint32_t position,
+                              MenuPageDirection direction,
+                              std::string_view label) = 0;
+
+  /// Text hooks get both encodings from CompiledMenu::text(), so backends
+  /// need not convert on show.
+  virtual void SetText(uint32_t index, MenuText text) = 0;
+  virtual void SetEnabled(uint32_t index, bool enabled) = 0;
+  virtual void SetChecked(uint32_t index, bool checked) = 0;
+  /// Only called for valid glyphs; icon_color may be 0.
+  virtual void SetIcon(uint32_t index, uint16_t glyph,
+                       MenuText font_family, uint32_t icon_color) = 0;
+  /// Removes the icon SetIcon set; for live icons that end (RebindItems).
+  virtual void ClearIcon(uint32_t index) = 0;
+  virtual void SetAcceleratorText(uint32_t index, MenuText text) = 0;
+  /// An empty tool tip removes it.
+  virtual void SetToolTip(uint32_t index, MenuText text) = 0;
+  /// Applies the compact (no icon column) style. Returns false if there is
+  /// none for kind; the item then gets its icon instead.
+  virtual bool SetCompactStyle(uint32_t index, MenuWidgetKind kind) = 0;
+  virtual void SetFontSize(uint32_t index, double size) = 0;
+  virtual void SetMinHeight(uint32_t index, double height) = 0;
+  virtual void SetForeground(uint32_t index, uint32_t argb) = 0;
+  virtual void SetSeparatorColor(uint32_t index, uint32_t argb) = 0;
+  /// Clicking reports ClickItem(index) to the event sink. keep_open items
+  /// (toggles) cancel the close that the click would cause.
+  virtual void SetClickHandler(uint32_t index, int32_t id, bool keep_open) = 0;
+  /// Calls MaterializeSubmenu(index) before sub item index opens its
+  /// submenu.
+  virtual void SetSubmenuOpenHandler(uint32_t index) = 0;
+
+ private:
+  // What a node shows instead of its menu values (ApplyLiveItem).
+  struct LiveValues {
+    std::optional<std::string> label;
+    std::u16string label_utf16;
+    /// A valid glyph.
+    std::optional<uint16_t> glyph;
+    std::optional<bool> disabled;
+
+    MenuText text() const { return {*label, label_utf16}; }
+  };
+
+  struct PagedList {
+    uint32_t parent;
+    // Node index of the first entry.
+    uint32_t first;
+    MenuPageWindow window;
+  };
+
+  void BuildRange(const CompiledMenu& menu, uint32_t parent, uint32_t first,
+                  uint32_t count);
+  // Creates and configures the item for index; the caller adds it to parent.
+  void BuildItem(const CompiledMenu& menu, uint32_t index);
+  // Releases index and every built item below it.
+  void ReleaseSubtree(uint32_t index);
+  const PagedList* FindPagedList(uint32_t parent) const;
+  PagedList* FindPagedList(uint32_t parent);
+  // SetChecked, remembering what the item shows.
+  void ShowChecked(uint32_t index, bool checked);
+  void ApplyItemStyle(uint32_t index, uint32_t foreground);
+  uint32_t ForegroundFor(bool disabled) const;
+  uint32_t LiveForegroundFor(bool disabled) const;
+  const LiveValues* FindLive(uint32_t index) const;
+  // Gives the built items with live values their values from menu again and
+  // forgets the live values.
+  void EndLiveValues(const CompiledMenu& menu);
+
+  MenuItemStyle item_style_;
+  MenuPagingOptions paging_;
+  bool lazy_submenus_ = true;
+  // The pool's copy of the menu the items were built from.
+  const CompiledMenu* menu_ = nullptr;
+  LazySubmenuTracker submenus_;
+  // Per node: the checked state the built toggle shows.
+  std::vector<uint8_t> shown_checked_;
+  // Per node: the built item has an icon column (it is not compact).
+  std::vector<uint8_t> icon_column_;
+  // By node index; usually a handful.
+  std::unordered_map<uint32_t, LiveValues> live_;
+  // One per paged list of the built items; few, so searched linearly.
+  std::vector<PagedList> paged_lists_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_MENU_WIDGET_BACKEND_H_
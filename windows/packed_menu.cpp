@@ -0,0 +1,258 @@
+#include "packed_menu.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace tray_manager_winui {
+
+namespace {
+
+// Byte-wise little-endian reads: no alignment requirements, any host.
+uint16_t ReadU16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t ReadU32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t ReadU64(const uint8_t* p) {
+  return static_cast<uint64_t>(ReadU32(p)) |
+         (static_cast<uint64_t>(ReadU32(p + 4)) << 32);
+}
+
+double ReadF64(const uint8_t* p) {
+  const uint64_t bits = ReadU64(p);
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+constexpr uint8_t kMaxItemType = static_cast<uint8_t>(MenuItemType::kSplit);
+
+bool CanHaveChildren(MenuItemType type) {
+  return type == MenuItemType::kSubmenu || type == MenuItemType::kSplit;
+}
+
+}  // namespace
+
+PackedMenuError PackedMenuView::Open(const uint8_t* data, size_t size) {
+  *this = PackedMenuView();
+  if (!data || size < kPackedHeaderSize) return PackedMenuError::kTruncated;
+  if (ReadU32(data) != kPackedMenuMagic) return PackedMenuError::kBadMagic;
+  if (ReadU16(data + 4) != kPackedMenuVersion) {
+    return PackedMenuError::kUnsupportedVersion;
+  }
+  const uint32_t string_count = ReadU32(data + 12);
+  const uint32_t string_data_size = ReadU32(data + 16);
+  const uint32_t node_count = ReadU32(data + 20);
+  const uint32_t root_count = ReadU32(data + 24);
+  const uint32_t style_count = ReadU32(data + 28);
+  const uint32_t inset_count = ReadU32(data + 32);
+  // 64-bit sums cannot overflow with 32-bit counts.
+  const uint64_t expected =
+      uint64_t{kPackedHeaderSize} + uint64_t{string_count} * kPackedStringRefSize +
+      uint64_t{node_count} * kPackedNodeSize +
+      uint64_t{style_count} * kPackedStyleSize +
+      uint64_t{inset_count} * kPackedInsetsSize + string_data_size;
+  if (ReadU16(data + 6) != kPackedHeaderSize || ReadU32(data + 8) != size ||
+      expected != size) {
+    return PackedMenuError::kBadSize;
+  }
+  if (root_count > node_count) return PackedMenuError::kBadLayout;
+
+  const uint8_t* string_refs = data + kPackedHeaderSize;
+  const uint8_t* nodes = string_refs + size_t{string_count} * kPackedStringRefSize;
+  const uint8_t* styles = nodes + size_t{node_count} * kPackedNodeSize;
+  const uint8_t* insets = styles + size_t{style_count} * kPackedStyleSize;
+  const uint8_t* string_data = insets + size_t{inset_count} * kPackedInsetsSize;
+
+  if (string_count == 0 || ReadU32(string_refs + 4) != 0) {
+    return PackedMenuError::kBadString;
+  }
+  for (uint32_t i = 0; i < string_count; ++i) {
+    const uint8_t* ref = string_refs + size_t{i} * kPackedStringRefSize;
+    if (uint64_t{ReadU32(ref)} + ReadU32(ref + 4) > string_data_size) {
+      return PackedMenuError::kBadString;
+    }
+  }
+
+  for (uint32_t i = 0; i < node_count; ++i) {
+    const uint8_t* record = nodes + size_t{i} * kPackedNodeSize;
+    if (record[0] > kMaxItemType) return PackedMenuError::kBadNode;
+    for (size_t field = 8; field < 32; field += 4) {
+      if (ReadU32(record + field) >= string_count) {
+        return PackedMenuError::kBadString;
+      }
+    }
+  }
+
+  // Children must be exactly where CompileMenu puts them: each sibling block
+  // right after the blocks of the submenus before it, depth first. That also
+  // rules out shared children and cycles. Iterative, as nesting depth is
+  // only bounded by node_count.
+  struct Block {
+    uint32_t next;
+    uint32_t end;
+  };
+  std::vector<Block> blocks;
+  blocks.push_back({0, root_count});
+  uint32_t next_block = root_count;
+  while (!blocks.empty()) {
+    Block& block = blocks.back();
+    if (block.next == block.end) {
+      blocks.pop_back();
+      continue;
+    }
+    const uint8_t* record = nodes + size_t{block.next++} * kPackedNodeSize;
+    const uint32_t child_count = ReadU32(record + 36);
+    if (child_count == 0) continue;
+    if (!CanHaveChildren(static_cast<MenuItemType>(record[0])) ||
+        ReadU32(record + 32) != next_block ||
+        child_count > node_count - next_block) {
+      return PackedMenuError::kBadLayout;
+    }
+    blocks.push_back({next_block, next_block + child_count});
+    next_block += child_count;
+  }
+  if (next_block != node_count) return PackedMenuError::kBadLayout;
+
+  for (uint32_t i = 0; i < style_count; ++i) {
+    const uint8_t* record = styles + size_t{i} * kPackedStyleSize;
+    const uint32_t key = ReadU32(record);
+    if (key == kEmptyString || key >= string_count) {
+      return PackedMenuError::kBadStyle;
+    }
+    const uint32_t value = ReadU32(record + 8);
+    switch (static_cast<PackedStyleKind>(record[4])) {
+      case PackedStyleKind::kBool:
+      case PackedStyleKind::kInt:
+      case PackedStyleKind::kDouble:
+        break;
+      case PackedStyleKind::kString:
+        if (value >= string_count) return PackedMenuError::kBadStyle;
+        break;
+      case PackedStyleKind::kInsets:
+        if (value >= inset_count) return PackedMenuError::kBadStyle;
+        break;
+      default:
+        return PackedMenuError::kBadStyle;
+    }
+  }
+
+  string_count_ = string_count;
+  node_count_ = node_count;
+  root_count_ = root_count;
+  style_count_ = style_count;
+  inset_count_ = inset_count;
+  generation_ = ReadU32(data + 36);
+  string_refs_ = string_refs;
+  nodes_ = nodes;
+  styles_ = styles;
+  insets_ = insets;
+  string_data_ = string_data;
+  string_data_size_ = string_data_size;
+  return PackedMenuError::kNone;
+}
+
+MenuNode PackedMenuView::node(uint32_t index) const {
+  const uint8_t* record = nodes_ + size_t{index} * kPackedNodeSize;
+  MenuNode node;
+  node.type = static_cast<MenuItemType>(record[0]);
+  node.disabled = (record[1] & kPackedNodeDisabled) != 0;
+  node.checked = (record[1] & kPackedNodeChecked) != 0;
+  node.virtualized = (record[1] & kPackedNodeVirtualized) != 0;
+  node.id = static_cast<int32_t>(ReadU32(record + 4));
+  node.label = ReadU32(record + 8);
+  node.icon = ReadU32(record + 12);
+  node.icon_font_family = ReadU32(record + 16);
+  node.accelerator_text = ReadU32(record + 20);
+  node.tool_tip = ReadU32(record + 24);
+  node.radio_group = ReadU32(record + 28);
+  node.first_child = ReadU32(record + 32);
+  node.child_count = ReadU32(record + 36);
+  return node;
+}
+
+std::string_view PackedMenuView::str(StringId id) const {
+  const uint8_t* ref = string_refs_ + size_t{id} * kPackedStringRefSize;
+  return std::string_view(
+      reinterpret_cast<const char*>(string_data_) + ReadU32(ref),
+      ReadU32(ref + 4));
+}
+
+std::string_view PackedMenuView::style_key(uint32_t index) const {
+  return str(ReadU32(styles_ + size_t{index} * kPackedStyleSize));
+}
+
+flutter::EncodableValue PackedMenuView::style_value(uint32_t index) const {
+  const uint8_t* record = styles_ + size_t{index} * kPackedStyleSize;
+  const uint8_t* value = record + 8;
+  switch (static_cast<PackedStyleKind>(record[4])) {
+    case PackedStyleKind::kBool:
+      return flutter::EncodableValue(value[0] != 0);
+    case PackedStyleKind::kInt: {
+      const auto i = static_cast<int64_t>(ReadU64(value));
+      if (i >= INT32_MIN && i <= INT32_MAX) {
+        return flutter::EncodableValue(static_cast<int32_t>(i));
+      }
+      return flutter::EncodableValue(i);
+    }
+    case PackedStyleKind::kDouble:
+      return flutter::EncodableValue(ReadF64(value));
+    case PackedStyleKind::kString:
+      return flutter::EncodableValue(std::string(str(ReadU32(value))));
+    case PackedStyleKind::kInsets: {
+      const uint8_t* insets = insets_ + size_t{ReadU32(value)} * kPackedInsetsSize;
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("left")] =
+          flutter::EncodableValue(ReadF64(insets));
+      map[flutter::EncodableValue("top")] =
+          flutter::EncodableValue(ReadF64(insets + 8));
+      map[flutter::EncodableValue("right")] =
+          flutter::EncodableValue(ReadF64(insets + 16));
+      map[flutter::EncodableValue("bottom")] =
+          flutter::EncodableValue(ReadF64(insets + 24));
+      return flutter::EncodableValue(std::move(map));
+    }
+  }
+  return flutter::EncodableValue();
+}
+
+CompiledMenu CompileMenu(const PackedMenuView& packed) {
+  CompiledMenu menu;
+  menu.nodes_.resize(packed.node_count());
+  for (uint32_t i = 0; i < packed.node_count(); ++i) {
+    menu.nodes_[i] = packed.node(i);
+  }
+  menu.root_count_ = packed.root_count();
+
+  // The string table is validated and already interned by the packer, so it
+  // is taken over in one copy; ids and offsets stay the same.
+  const std::string_view data = packed.string_data();
+  menu.string_data_.assign(data.data(), data.size());
+  menu.strings_.resize(packed.string_count());
+  for (uint32_t i = 1; i < packed.string_count(); ++i) {
+    const std::string_view value = packed.str(i);
+    menu.strings_[i] = {static_cast<uint32_t>(value.data() - data.data()),
+                        static_cast<uint32_t>(value.size())};
+  }
+  menu.ConvertStrings();
+  menu.generation_ = packed.generation();
+  menu.BuildIndex();
+  return menu;
+}
+
+flutter::EncodableMap DecodePackedStyle(const PackedMenuView& packed) {
+  flutter::EncodableMap style;
+  for (uint32_t i = 0; i < packed.style_count(); ++i) {
+    style[flutter::EncodableValue(std::string(packed.style_key(i)))] =
+        packed.style_value(i);
+  }
+  return style;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,125 @@
+#ifndef TRAY_MANAGER_WINUI_PACKED_MENU_H_
+#define TRAY_MANAGER_WINUI_PACKED_MENU_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+
+/// Binary form of a setContextMenu call (menu plus style), sent by
+/// lib/src/packed_menu.dart over the "tray_manager_winui/packed_menu"
+/// BinaryMessenger channel. All integers are little-endian; the buffer is
+///
+///   header         u32 kPackedMenuMagic, u16 kPackedMenuVersion,
+///                  u16 kPackedHeaderSize, u32 total size, u32 string_count,
+///                  u32 string data size, u32 node_count, u32 root_count,
+///                  u32 style_count, u32 inset_count, u32 generation
+///                  (CompiledMenu::generation; 0 from older packers)
+///   string refs    string_count x {u32 offset, u32 length} into string data;
+///                  ref 0 is the empty string
+///   node records   node_count x kPackedNodeSize bytes, in CompiledMenu order
+///   style records  style_count x kPackedStyleSize bytes
+///   insets         inset_count x 4 f64 (left, top, right, bottom)
+///   string data    UTF-8
+///
+/// Node record: u8 type (MenuItemType), u8 flags (kPackedNode*), u16 0,
+/// i32 id, u32 string ids of label, icon, iconFontFamily, acceleratorText,
+/// toolTip and radioGroup, u32 first_child, u32 child_count.
+///
+/// Style record: u32 key string id, u8 kind (PackedStyleKind), 3 bytes 0,
+/// 8 value bytes: u8 for bools, i64, f64, u32 string id or u32 inset index.
+constexpr uint32_t kPackedMenuMagic = 0x50574D54;  // "TMWP"
+constexpr uint16_t kPackedMenuVersion = 1;
+constexpr size_t kPackedHeaderSize = 40;
+constexpr size_t kPackedStringRefSize = 8;
+constexpr size_t kPackedNodeSize = 40;
+constexpr size_t kPackedStyleSize = 16;
+constexpr size_t kPackedInsetsSize = 32;
+
+constexpr uint8_t kPackedNodeDisabled = 1 << 0;
+constexpr uint8_t kPackedNodeChecked = 1 << 1;
+constexpr uint8_t kPackedNodeVirtualized = 1 << 2;
+
+/// Value kinds of a style record.
+enum class PackedStyleKind : uint8_t {
+  kBool = 1,
+  kInt = 2,
+  kDouble = 3,
+  kString = 4,
+  /// EdgeInsets (padding), decoded as {left, top, right, bottom}.
+  kInsets = 5,
+};
+
+enum class PackedMenuError : uint8_t {
+  kNone,
+  kTruncated,
+  kBadMagic,
+  kUnsupportedVersion,
+  kBadSize,
+  kBadString,
+  kBadNode,
+  kBadLayout,
+  kBadStyle,
+};
+
+/// Read-only view of a packed menu buffer. Open validates everything up
+/// front (bounds, string ids, node types and the sibling-block layout that
+/// CompileMenu produces), so the accessors need no checks. The view does
+/// not copy or own the buffer, which must outlive it.
+class PackedMenuView {
+ public:
+  /// Validates data and points the view at it. On error the view is left
+  /// empty.
+  PackedMenuError Open(const uint8_t* data, size_t size);
+
+  uint32_t node_count() const { return node_count_; }
+  uint32_t root_count() const { return root_count_; }
+  uint32_t string_count() const { return string_count_; }
+  uint32_t style_count() const { return style_count_; }
+  uint32_t generation() const { return generation_; }
+
+  /// Node index; string fields are ids for str().
+  MenuNode node(uint32_t index) const;
+  std::string_view str(StringId id) const;
+  /// The string data section; every str() points into it.
+  std::string_view string_data() const {
+    return std::string_view(reinterpret_cast<const char*>(string_data_),
+                            string_data_size_);
+  }
+
+  /// Key and value of style record index.
+  std::string_view style_key(uint32_t index) const;
+  flutter::EncodableValue style_value(uint32_t index) const;
+
+ private:
+  uint32_t string_count_ = 0;
+  uint32_t node_count_ = 0;
+  uint32_t root_count_ = 0;
+  uint32_t style_count_ = 0;
+  uint32_t inset_count_ = 0;
+  uint32_t generation_ = 0;
+  uint32_t string_data_size_ = 0;
+  const uint8_t* string_refs_ = nullptr;
+  const uint8_t* nodes_ = nullptr;
+  const uint8_t* styles_ = nullptr;
+  const uint8_t* insets_ = nullptr;
+  const uint8_t* string_data_ = nullptr;
+};
+
+/// Builds the CompiledMenu that CompileMenu returns for the same menu JSON.
+/// The string table is taken over as is (the Dart packer interns it).
+CompiledMenu CompileMenu(const PackedMenuView& packed);
+
+/// The style map that WinUIContextMenuStyle.toJson() sends over the method
+/// channel, ints narrowed to int32 where they fit as StandardMethodCodec
+/// does. Empty if the buffer has no style.
+flutter::EncodableMap DecodePackedStyle(const PackedMenuView& packed);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_PACKED_MENU_H_
@@ -0,0 +1,199 @@
+#ifndef TRAY_MANAGER_WINUI_SHOW_SCHEDULER_H_
+#define TRAY_MANAGER_WINUI_SHOW_SCHEDULER_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tray_manager_winui {
+
+/// What ShowScheduler::Next asks the XAML thread to do.
+enum class ShowStep : uint8_t {
+  /// Nothing, or wait for the OnClosed of a show being closed.
+  kNone,
+  /// Build and open the flyout for the request, then report OnOpened (or
+  /// OnClosed if it fails).
+  kShow,
+  /// Hide the current show, then report OnClosed; a newer request waits.
+  kClose,
+};
+
+template <typename Request>
+struct ShowAction {
+  ShowStep step = ShowStep::kNone;
+  /// The show to open (kShow) or close (kClose).
+  uint64_t id = 0;
+  /// kShow only.
+  std::optional<Request> request;
+};
+
+/// Counters for tests and debug logging.
+struct ShowSchedulerStats {
+  uint64_t submitted = 0;
+  /// Requests replaced by a newer one before they were started.
+  uint64_t merged = 0;
+  /// Started shows closed for a newer request before they opened.
+  uint64_t superseded = 0;
+  /// Open shows closed for a newer request (re-shown at its position).
+  uint64_t reshown = 0;
+  uint64_t started = 0;
+  uint64_t opened = 0;
+  uint64_t failed = 0;
+};
+
+/// Latest-wins scheduling of context menu shows between the platform thread,
+/// which submits requests, and the XAML thread, which runs them one at a
+/// time.
+///
+/// At most one request waits: a newer one replaces it (keeping its position,
+/// placement and exclusion rect), and the callers of both are answered with
+/// the outcome of the show that runs. A show that is started but not yet open
+/// is closed in favour of a newer request, whose outcome its callers get too;
+/// an open menu is closed and shown again for it. Every callback is called
+/// exactly once: true when the show it ended up in opened, false when that
+/// show failed, closed before opening, or could not run at all.
+///
+/// Thread-safe; callbacks run outside the lock, on the thread that reports
+/// the outcome.
+template <typename Request>
+class ShowScheduler {
+ public:
+  using Callback = std::function<void(bool shown)>;
+
+  /// Platform thread: queues request, replacing a waiting one. Returns true
+  /// if the caller must run Next on the XAML thread; false if a run is
+  /// already scheduled or a close in progress will schedule it.
+  bool Submit(Request request, Callback done) {
+    std::lock_guard lock(mutex_);
+    ++stats_.submitted;
+    if (pending_) {
+      ++stats_.merged;
+    } else {
+      pending_.emplace();
+    }
+    pending_->request = std::move(request);
+    pending_->waiters.push_back(std::move(done));
+    if (next_scheduled_ || closing_) return false;
+    next_scheduled_ = true;
+    return true;
+  }
+
+  /// XAML thread: decides what to do about the waiting request.
+  ShowAction<Request> Next() {
+    std::lock_guard lock(mutex_);
+    next_scheduled_ = false;
+    ShowAction<Request> action;
+    if (!pending_ || closing_) return action;
+    if (current_) {
+      // Its callers now wait for the newer request.
+      closing_ = true;
+      if (opened_) {
+        ++stats_.reshown;
+      } else {
+        ++stats_.superseded;
+        pending_->waiters.insert(
+            pending_->waiters.begin(),
+            std::make_move_iterator(current_->waiters.begin()),
+            std::make_move_iterator(current_->waiters.end()));
+        current_->waiters.clear();
+      }
+      action.step = ShowStep::kClose;
+      action.id = current_id_;
+      return action;
+    }
+    current_ = std::move(pending_);
+    pending_.reset();
+    current_id_ = next_id_++;
+    opened_ = false;
+    ++stats_.started;
+    action.step = ShowStep::kShow;
+    action.id = current_id_;
+    action.request = std::move(current_->request);
+    return action;
+  }
+
+  /// XAML thread: show id opened. Ignored for an outdated id.
+  void OnOpened(uint64_t id) {
+    std::vector<Callback> waiters;
+    {
+      std::lock_guard lock(mutex_);
+      if (!current_ || id != current_id_ || opened_) return;
+      opened_ = true;
+      ++stats_.opened;
+      waiters.swap(current_->waiters);
+    }
+    for (Callback& done : waiters) done(true);
+  }
+
+  /// XAML thread: show id failed or its flyout closed. Returns true if the
+  /// caller must run Next again (a request is waiting). Ignored for an
+  /// outdated id.
+  bool OnClosed(uint64_t id) {
+    std::vector<Callback> waiters;
+    bool next = false;
+    {
+      std::lock_guard lock(mutex_);
+      if (!current_ || id != current_id_) return false;
+      if (!opened_) ++stats_.failed;
+      waiters.swap(current_->waiters);
+      current_.reset();
+      closing_ = false;
+      if (pending_ && !next_scheduled_) {
+        next_scheduled_ = true;
+        next = true;
+      }
+    }
+    for (Callback& done : waiters) done(false);
+    return next;
+  }
+
+  /// The scheduled Next cannot run (WinUI initialization failed or the XAML
+  /// thread refused it): answers the waiting request's callers with false.
+  void FailPending() {
+    std::vector<Callback> waiters;
+    {
+      std::lock_guard lock(mutex_);
+      next_scheduled_ = false;
+      if (!pending_) return;
+      waiters.swap(pending_->waiters);
+      pending_.reset();
+    }
+    for (Callback& done : waiters) done(false);
+  }
+
+  /// True from Next's kShow until OnClosed of that show.
+  bool busy() const {
+    std::lock_guard lock(mutex_);
+    return current_.has_value();
+  }
+
+  ShowSchedulerStats stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  struct Entry {
+    Request request;
+    std::vector<Callback> waiters;
+  };
+
+  mutable std::mutex mutex_;
+  std::optional<Entry> pending_;
+  std::optional<Entry> current_;
+  uint64_t current_id_ = 0;
+  uint64_t next_id_ = 1;
+  bool opened_ = false;
+  // A close was requested for current_; OnClosed schedules the next run.
+  bool closing_ = false;
+  // A Next is scheduled and has not run.
+  bool next_scheduled_ = false;
+  ShowSchedulerStats stats_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_SHOW_SCHEDULER_H_
@@ -0,0 +1,38 @@
+#ifndef TRAY_MANAGER_WINUI_SIMD_H_
+#define TRAY_MANAGER_WINUI_SIMD_H_
+
+// Picks the vector instruction set for the text fast paths (utf16.cpp,
+// xaml_writer.cpp): SSE2 on x86-64 (always present) and 32-bit x86 builds
+// that enable it, NEON on ARM64. Other targets use the scalar loops.
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRAY_MANAGER_WINUI_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TRAY_MANAGER_WINUI_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace tray_manager_winui {
+
+/// Index of the lowest set bit; mask must not be 0.
+inline int LowestSetBit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_SIMD_H_
@@ -0,0 +1,206 @@
+#include "span_trace.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <string_view>
+
+namespace tray_manager_winui {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+std::atomic<uint32_t> g_next_thread{0};
+
+void AppendJsonString(std::string& out, std::string_view value) {
+  out += '"';
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+// Microseconds with nanosecond precision, as trace viewers expect.
+void AppendMicros(std::string& out, uint64_t ns) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%03u", ns / 1000,
+                static_cast<unsigned>(ns % 1000));
+  out += buf;
+}
+
+}  // namespace
+
+SpanTrace::SpanTrace(size_t capacity)
+    : origin_ticks_(Now()), origin_ns_(NowNs()) {
+  const size_t size = RoundUpToPowerOfTwo(capacity);
+  slots_ = std::make_unique<Slot[]>(size);
+  mask_ = size - 1;
+}
+
+uint32_t SpanTrace::CurrentThread() {
+  thread_local const uint32_t thread =
+      g_next_thread.fetch_add(1, std::memory_order_relaxed) + 1;
+  return thread;
+}
+
+void SpanTrace::Write(const char* name, uint64_t start, uint64_t duration,
+                      bool instant) {
+  const uint64_t position = next_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[position & mask_];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start.store(start, std::memory_order_relaxed);
+  slot.duration.store(duration, std::memory_order_relaxed);
+  slot.thread.store(CurrentThread(), std::memory_order_relaxed);
+  slot.show.store(current_show_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+  slot.instant.store(instant, std::memory_order_relaxed);
+  slot.sequence.store(position + 1, std::memory_order_release);
+}
+
+void SpanTrace::NameThread(const char* name) {
+  const uint32_t thread = CurrentThread();
+  std::lock_guard<std::mutex> lock(names_mutex_);
+  for (auto& entry : thread_names_) {
+    if (entry.first == thread) {
+      entry.second = name;
+      return;
+    }
+  }
+  thread_names_.emplace_back(thread, name);
+}
+
+std::vector<std::pair<uint32_t, const char*>> SpanTrace::thread_names() const {
+  std::lock_guard<std::mutex> lock(names_mutex_);
+  return thread_names_;
+}
+
+std::vector<SpanRecord> SpanTrace::Snapshot() const {
+  const uint64_t end = next_.load(std::memory_order_acquire);
+  const uint64_t oldest = end > capacity() ? end - capacity() : 0;
+  const uint64_t begin =
+      std::max(oldest, cleared_.load(std::memory_order_acquire));
+
+#ifdef TRAY_MANAGER_WINUI_SPAN_TSC
+  // Nanoseconds per tick, measured over the trace's lifetime so far.
+  double ns_per_tick = 1.0;
+  const uint64_t now_ticks = Now();
+  const uint64_t now_ns = NowNs();
+  if (now_ticks > origin_ticks_ && now_ns > origin_ns_) {
+    ns_per_tick = static_cast<double>(now_ns - origin_ns_) /
+                  static_cast<double>(now_ticks - origin_ticks_);
+  }
+  auto to_ns = [this, ns_per_tick](uint64_t ticks) {
+    const double offset =
+        (static_cast<double>(ticks) - static_cast<double>(origin_ticks_)) *
+        ns_per_tick;
+    const double ns = static_cast<double>(origin_ns_) + offset;
+    return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+  };
+#endif
+
+  std::vector<SpanRecord> records;
+  records.reserve(static_cast<size_t>(end - begin));
+  for (uint64_t position = begin; position < end; ++position) {
+    const Slot& slot = slots_[position & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) continue;
+    SpanRecord record;
+    record.name = slot.name.load(std::memory_order_relaxed);
+    const uint64_t start = slot.start.load(std::memory_order_relaxed);
+    const uint64_t duration = slot.duration.load(std::memory_order_relaxed);
+    record.thread = slot.thread.load(std::memory_order_relaxed);
+    record.show = slot.show.load(std::memory_order_relaxed);
+    record.instant = slot.instant.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Overwritten while reading.
+    if (slot.sequence.load(std::memory_order_relaxed) != position + 1) continue;
+#ifdef TRAY_MANAGER_WINUI_SPAN_TSC
+    record.start_ns = to_ns(start);
+    record.duration_ns =
+        static_cast<uint64_t>(static_cast<double>(duration) * ns_per_tick);
+#else
+    record.start_ns = start;
+    record.duration_ns = duration;
+#endif
+    records.push_back(record);
+  }
+  std::stable_sort(records.begin(), records.end(),
+                   [](const SpanRecord& a, const SpanRecord& b) {
+                     return a.start_ns < b.start_ns;
+                   });
+  return records;
+}
+
+SpanTrace& GetSpanTrace() {
+  static SpanTrace trace;
+  return trace;
+}
+
+std::string ExportChromeTrace(
+    const std::vector<SpanRecord>& records,
+    const std::vector<std::pair<uint32_t, const char*>>& thread_names) {
+  const uint64_t origin = records.empty() ? 0 : records.front().start_ns;
+
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+  auto begin_event = [&out, &first] {
+    if (!first) out += ',';
+    first = false;
+    out += "\n{";
+  };
+  for (const auto& [thread, name] : thread_names) {
+    begin_event();
+    out += "\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+    out += std::to_string(thread);
+    out += ",\"args\":{\"name\":";
+    AppendJsonString(out, name);
+    out += "}}";
+  }
+  for (const SpanRecord& record : records) {
+    begin_event();
+    out += "\"name\":";
+    AppendJsonString(out, record.name);
+    out += ",\"cat\":\"tray_manager_winui\",\"ph\":";
+    out += record.instant ? "\"i\",\"s\":\"t\"" : "\"X\"";
+    out += ",\"ts\":";
+    AppendMicros(out, record.start_ns - origin);
+    if (!record.instant) {
+      out += ",\"dur\":";
+      AppendMicros(out, record.duration_ns);
+    }
+    out += ",\"pid\":1,\"tid\":";
+    out += std::to_string(record.thread);
+    out += ",\"args\":{\"show\":";
+    out += std::to_string(record.show);
+    out += "}}";
+  }
+  out += "\n],\"displayTimeUnit\":\"ms\"}";
+  return out;
+}
+
+std::string ExportChromeTrace(const SpanTrace& trace) {
+  return ExportChromeTrace(trace.Snapshot(), trace.thread_names());
+}
+
+}  // namespace tray_manager_winui
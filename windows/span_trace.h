@@ -0,0 +1,187 @@
+#ifndef TRAY_MANAGER_WINUI_SPAN_TRACE_H_
+#define TRAY_MANAGER_WINUI_SPAN_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRAY_MANAGER_WINUI_SPAN_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRAY_MANAGER_WINUI_SPAN_TSC 1
+#endif
+
+namespace tray_manager_winui {
+
+/// One recorded span, in steady_clock nanoseconds. Instants (events without a
+/// duration, e.g. Opened) have instant set and duration_ns 0.
+struct SpanRecord {
+  const char* name = "";
+  uint64_t start_ns = 0;
+  uint64_t duration_ns = 0;
+  /// Small per-thread number assigned on a thread's first span.
+  uint32_t thread = 0;
+  /// SpanTrace::BeginShow value current when the span was recorded.
+  uint32_t show = 0;
+  bool instant = false;
+};
+
+/// Fixed-size ring of spans for the show pipeline, written from any thread.
+/// Recording is off until set_enabled(true); a disabled trace costs one
+/// relaxed load per span. When full, the oldest spans are overwritten.
+///
+/// Spans are stamped with Now() ticks: the TSC on x86 (invariant on every
+/// CPU Windows 10+ supports, and what QueryPerformanceCounter reads anyway),
+/// steady_clock nanoseconds elsewhere. Snapshot converts ticks to steady_clock
+/// nanoseconds against a calibration pair taken at construction.
+///
+/// Names are not copied: pass string literals or other strings that outlive
+/// the trace.
+class SpanTrace {
+ public:
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  /// capacity is rounded up to a power of two (at least 2).
+  explicit SpanTrace(size_t capacity = kDefaultCapacity);
+
+  SpanTrace(const SpanTrace&) = delete;
+  SpanTrace& operator=(const SpanTrace&) = delete;
+
+  /// Monotonic nanoseconds (steady_clock).
+  static uint64_t NowNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  /// Timestamp in trace ticks, for Record.
+  static uint64_t Now() {
+#ifdef TRAY_MANAGER_WINUI_SPAN_TSC
+    return __rdtsc();
+#else
+    return NowNs();
+#endif
+  }
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /// Starts a new show; later spans carry the returned number.
+  uint32_t BeginShow() {
+    return current_show_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  /// Records [start, end] (Now() ticks) if enabled. For spans that begin on
+  /// one callback and end on another (e.g. ShowAt to Opened).
+  void Record(const char* name, uint64_t start, uint64_t end) {
+    if (!enabled()) return;
+    Write(name, start, end > start ? end - start : 0, false);
+  }
+
+  /// Records a point in time if enabled.
+  void Instant(const char* name) {
+    if (!enabled()) return;
+    Write(name, Now(), 0, true);
+  }
+
+  /// Names the calling thread in exports (e.g. "platform", "xaml").
+  void NameThread(const char* name);
+
+  /// Spans still in the ring since the last Clear, by start time. Spans being
+  /// written concurrently are skipped.
+  std::vector<SpanRecord> Snapshot() const;
+
+  /// Thread numbers named with NameThread.
+  std::vector<std::pair<uint32_t, const char*>> thread_names() const;
+
+  /// Forgets every span recorded so far.
+  void Clear() {
+    cleared_.store(next_.load(std::memory_order_acquire),
+                   std::memory_order_release);
+  }
+
+  /// Spans recorded since construction, including overwritten ones.
+  uint64_t recorded() const { return next_.load(std::memory_order_relaxed); }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  /// The calling thread's number in SpanRecord::thread.
+  static uint32_t CurrentThread();
+
+ private:
+  // A seqlock per slot: sequence is 0 while a writer fills it and
+  // position + 1 once complete, so Snapshot can read without blocking
+  // writers. Fields are atomics only to keep those reads well-defined.
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{""};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> duration{0};
+    std::atomic<uint32_t> thread{0};
+    std::atomic<uint32_t> show{0};
+    std::atomic<bool> instant{false};
+  };
+
+  void Write(const char* name, uint64_t start, uint64_t duration,
+             bool instant);
+
+  std::unique_ptr<Slot[]> slots_;
+  uint64_t origin_ticks_;
+  uint64_t origin_ns_;
+  size_t mask_;
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint32_t> current_show_{0};
+  std::atomic<uint64_t> next_{0};
+  std::atomic<uint64_t> cleared_{0};
+  mutable std::mutex names_mutex_;
+  std::vector<std::pair<uint32_t, const char*>> thread_names_;
+};
+
+/// The process-wide trace used by the plugin.
+SpanTrace& GetSpanTrace();
+
+/// Records the enclosing scope as a span in trace.
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(const char* name, SpanTrace& trace = GetSpanTrace())
+      : trace_(trace),
+        name_(name),
+        start_(trace.enabled() ? SpanTrace::Now() : 0) {}
+  ~ScopedSpan() {
+    if (start_ != 0) trace_.Record(name_, start_, SpanTrace::Now());
+  }
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  SpanTrace& trace_;
+  const char* name_;
+  uint64_t start_;
+};
+
+/// Writes spans as Chrome trace_event JSON (chrome://tracing, Perfetto):
+/// complete ("X") events for spans, thread-scoped instant ("i") events and
+/// thread_name metadata. Times are microseconds from the first record (pass
+/// them ordered by start); each event carries its show number in args.
+std::string ExportChromeTrace(
+    const std::vector<SpanRecord>& records,
+    const std::vector<std::pair<uint32_t, const char*>>& thread_names);
+
+/// ExportChromeTrace of trace.Snapshot().
+std::string ExportChromeTrace(const SpanTrace& trace);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_SPAN_TRACE_H_
@@ -0,0 +1,150 @@
+#include "style_fingerprint.h"
+
+#include <cstring>
+#include <string_view>
+
+namespace tray_manager_winui {
+
+namespace {
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+struct StringSink {
+  std::string& out;
+  void Put(const void* data, size_t size) {
+    out.append(static_cast<const char*>(data), size);
+  }
+};
+
+struct FnvSink {
+  uint64_t hash = kFnvOffsetBasis;
+  void Put(const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= kFnvPrime;
+    }
+  }
+};
+
+bool IsColourKey(const flutter::EncodableValue& key) {
+  const auto* s = std::get_if<std::string>(&key);
+  if (!s) return false;
+  constexpr std::string_view kSuffix = "Color";
+  return s->size() >= kSuffix.size() &&
+         std::string_view(*s).substr(s->size() - kSuffix.size()) == kSuffix;
+}
+
+// Emits a tag byte followed by a fixed-width little-endian payload, so the
+// encoding is identical on every host.
+template <typename Sink>
+class CanonicalWriter {
+ public:
+  explicit CanonicalWriter(Sink& sink) : sink_(sink) {}
+
+  void WriteMap(const flutter::EncodableMap& map) {
+    // EncodableMap is ordered, so iteration is already in sorted key order
+    // regardless of how the sender inserted the keys.
+    Tag('M');
+    U64(map.size());
+    for (const auto& [key, value] : map) {
+      Write(key, false);
+      Write(value, IsColourKey(key));
+    }
+  }
+
+ private:
+  void Write(const flutter::EncodableValue& value, bool colour) {
+    if (std::holds_alternative<std::monostate>(value)) {
+      Tag('N');
+    } else if (const auto* b = std::get_if<bool>(&value)) {
+      Tag(*b ? 'T' : 'F');
+    } else if (const auto* i32 = std::get_if<int32_t>(&value)) {
+      Int(*i32, colour);
+    } else if (const auto* i64 = std::get_if<int64_t>(&value)) {
+      Int(*i64, colour);
+    } else if (const auto* d = std::get_if<double>(&value)) {
+      Double(*d);
+    } else if (const auto* s = std::get_if<std::string>(&value)) {
+      Tag('S');
+      U64(s->size());
+      sink_.Put(s->data(), s->size());
+    } else if (const auto* map = std::get_if<flutter::EncodableMap>(&value)) {
+      WriteMap(*map);
+    } else if (const auto* list = std::get_if<flutter::EncodableList>(&value)) {
+      Tag('L');
+      U64(list->size());
+      for (const auto& element : *list) Write(element, false);
+    } else if (const auto* bytes = std::get_if<std::vector<uint8_t>>(&value)) {
+      Tag('B');
+      U64(bytes->size());
+      sink_.Put(bytes->data(), bytes->size());
+    } else if (const auto* ints = std::get_if<std::vector<int32_t>>(&value)) {
+      TypedList(*ints);
+    } else if (const auto* longs = std::get_if<std::vector<int64_t>>(&value)) {
+      TypedList(*longs);
+    } else if (const auto* doubles = std::get_if<std::vector<double>>(&value)) {
+      Tag('D');
+      U64(doubles->size());
+      for (double element : *doubles) Double(element);
+    } else if (const auto* floats = std::get_if<std::vector<float>>(&value)) {
+      Tag('D');
+      U64(floats->size());
+      for (float element : *floats) Double(element);
+    } else {
+      // CustomEncodableValue has no canonical form; styles never contain one.
+      Tag('C');
+    }
+  }
+
+  template <typename T>
+  void TypedList(const std::vector<T>& values) {
+    Tag('L');
+    U64(values.size());
+    for (T element : values) Int(element, false);
+  }
+
+  void Int(int64_t value, bool colour) {
+    Tag('I');
+    U64(colour ? (static_cast<uint64_t>(value) & 0xFFFFFFFFull)
+               : static_cast<uint64_t>(value));
+  }
+
+  void Double(double value) {
+    Tag('R');
+    if (value == 0) value = 0;  // Fold -0.0.
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    U64(bits);
+  }
+
+  void Tag(char tag) { sink_.Put(&tag, 1); }
+
+  void U64(uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+      bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    sink_.Put(bytes, sizeof(bytes));
+  }
+
+  Sink& sink_;
+};
+
+}  // namespace
+
+std::string CanonicalizeStyle(const flutter::EncodableMap& style) {
+  std::string out;
+  StringSink sink{out};
+  CanonicalWriter<StringSink>(sink).WriteMap(style);
+  return out;
+}
+
+uint64_t FingerprintStyle(const flutter::EncodableMap& style) {
+  FnvSink sink;
+  CanonicalWriter<FnvSink>(sink).WriteMap(style);
+  return sink.hash;
+}
+
+}  // namespace tray_manager_winui
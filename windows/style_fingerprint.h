@@ -0,0 +1,28 @@
+#ifndef TRAY_MANAGER_WINUI_STYLE_FINGERPRINT_H_
+#define TRAY_MANAGER_WINUI_STYLE_FINGERPRINT_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstdint>
+#include <string>
+
+namespace tray_manager_winui {
+
+/// Serializes a style map into a canonical byte string.
+///
+/// Two style maps that render identically produce the same bytes:
+/// - keys are emitted in sorted order, recursively for nested maps;
+/// - integers are widened to 64 bits, so int32 and int64 encodings of the same
+///   number match;
+/// - values of colour keys (names ending in "Color") are reduced to their
+///   32-bit ARGB value, matching how the XAML generator formats them;
+/// - -0.0 is folded into 0.0.
+std::string CanonicalizeStyle(const flutter::EncodableMap& style);
+
+/// 64-bit FNV-1a hash of CanonicalizeStyle(style), computed without building
+/// the intermediate string. Used as the key of compiled style caches.
+uint64_t FingerprintStyle(const flutter::EncodableMap& style);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_STYLE_FINGERPRINT_H_
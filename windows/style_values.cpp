@@ -0,0 +1,282 @@
+#include "style_values.h"
+
+#include <array>
+
+#include "style_fingerprint.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+// Indexed by StyleKey.
+constexpr std::array<std::string_view, kStyleKeyCount> kStyleKeyNames = {
+    "backgroundColor",
+    "textColor",
+    "fontSize",
+    "fontFamily",
+    "fontWeight",
+    "cornerRadius",
+    "padding",
+    "minWidth",
+    "themeMode",
+    "separatorColor",
+    "disabledTextColor",
+    "hoverBackgroundColor",
+    "subMenuOpenedBackgroundColor",
+    "subMenuOpenedTextColor",
+    "borderColor",
+    "borderThickness",
+    "fontStyle",
+    "itemHeight",
+    "shadowElevation",
+    "checkedIndicatorColor",
+    "checkedForegroundColor",
+    "checkedBackgroundColor",
+    "iconColor",
+    "keyboardAcceleratorColor",
+    "compactItemLayout",
+    "maxHeight",
+    "virtualizationThreshold",
+    "virtualizationPageSize",
+    "virtualizationMaxItems",
+    "virtualizationMoreLabel",
+    "virtualizationPreviousLabel",
+    "enableOpenCloseAnimations",
+    "dismissOnPointerMoveAway",
+    "backdropType",
+};
+
+// Perfect hash of the key names. The hash mixes the length with the first
+// and last eight bytes, which tell the keys apart (checkedForegroundColor
+// and checkedBackgroundColor end alike, the virtualization keys start
+// alike), so that a lookup costs two eight-byte words and two multiplies
+// rather than a pass over every byte. The seed is the first one under which
+// no two names share a slot of a power-of-two table; the compiler finds it,
+// so a new key that breaks the hash fails the build instead of a lookup.
+constexpr unsigned kKeySlotBits = 7;
+constexpr size_t kKeySlotCount = size_t{1} << kKeySlotBits;
+constexpr uint8_t kNoKey = 0xFF;
+constexpr uint64_t kMaxKeySeed = 4096;
+
+// Up to eight bytes of name from at, little-endian.
+constexpr uint64_t NameWord(std::string_view name, size_t at) {
+  uint64_t word = 0;
+  for (size_t i = 0; i < 8 && at + i < name.size(); ++i) {
+    word |= uint64_t{static_cast<uint8_t>(name[at + i])} << (8 * i);
+  }
+  return word;
+}
+
+constexpr size_t KeySlot(std::string_view name, uint64_t seed) {
+  const size_t tail = name.size() > 8 ? name.size() - 8 : 0;
+  uint64_t hash = (NameWord(name, 0) ^ seed) * 0x9E3779B97F4A7C15ull;
+  hash ^= (NameWord(name, tail) + name.size()) * 0xC2B2AE3D27D4EB4Full;
+  return static_cast<size_t>(hash >> (64 - kKeySlotBits));
+}
+
+constexpr bool IsPerfectSeed(uint64_t seed) {
+  std::array<bool, kKeySlotCount> used = {};
+  for (std::string_view name : kStyleKeyNames) {
+    const size_t slot = KeySlot(name, seed);
+    if (used[slot]) return false;
+    used[slot] = true;
+  }
+  return true;
+}
+
+constexpr uint64_t FindKeySeed() {
+  for (uint64_t seed = 0; seed < kMaxKeySeed; ++seed) {
+    if (IsPerfectSeed(seed)) return seed;
+  }
+  return kMaxKeySeed;
+}
+
+constexpr uint64_t kKeySeed = FindKeySeed();
+static_assert(kKeySeed < kMaxKeySeed,
+              "no perfect hash seed for the style keys; grow kKeySlotBits");
+
+// StyleKey of each slot, kNoKey for empty ones.
+constexpr std::array<uint8_t, kKeySlotCount> BuildKeySlots() {
+  std::array<uint8_t, kKeySlotCount> slots = {};
+  for (uint8_t& slot : slots) slot = kNoKey;
+  for (size_t key = 0; key < kStyleKeyCount; ++key) {
+    slots[KeySlot(kStyleKeyNames[key], kKeySeed)] = static_cast<uint8_t>(key);
+  }
+  return slots;
+}
+
+constexpr std::array<uint8_t, kKeySlotCount> kKeySlots = BuildKeySlots();
+
+// Dart ints arrive as int32 or int64, depending on their size.
+bool ReadInt(const flutter::EncodableValue& value, int64_t* out) {
+  if (const auto* i32 = std::get_if<int32_t>(&value)) {
+    *out = *i32;
+    return true;
+  }
+  if (const auto* i64 = std::get_if<int64_t>(&value)) {
+    *out = *i64;
+    return true;
+  }
+  return false;
+}
+
+// Sizes are Dart doubles, but a whole number may come as an int.
+bool ReadNumber(const flutter::EncodableValue& value, double* out) {
+  if (const auto* d = std::get_if<double>(&value)) {
+    *out = *d;
+    return true;
+  }
+  int64_t whole = 0;
+  if (!ReadInt(value, &whole)) return false;
+  *out = static_cast<double>(whole);
+  return true;
+}
+
+bool ReadColor(const flutter::EncodableValue& value, uint32_t* out) {
+  int64_t argb = 0;
+  if (!ReadInt(value, &argb)) return false;
+  *out = static_cast<uint32_t>(argb & 0xFFFFFFFF);
+  return true;
+}
+
+template <typename T>
+bool Read(const flutter::EncodableValue& value, T* out) {
+  const auto* typed = std::get_if<T>(&value);
+  if (!typed) return false;
+  *out = *typed;
+  return true;
+}
+
+double PaddingSide(const flutter::EncodableMap& padding, const char* side) {
+  double value = 0;
+  auto it = padding.find(flutter::EncodableValue(side));
+  if (it != padding.end()) ReadNumber(it->second, &value);
+  return value;
+}
+
+bool ReadPadding(const flutter::EncodableValue& value, StylePadding* out) {
+  const auto* padding = std::get_if<flutter::EncodableMap>(&value);
+  if (!padding) return false;
+  out->left = PaddingSide(*padding, "left");
+  out->top = PaddingSide(*padding, "top");
+  out->right = PaddingSide(*padding, "right");
+  out->bottom = PaddingSide(*padding, "bottom");
+  return true;
+}
+
+// Parses value into key's field of style; false if it has the wrong type.
+bool ReadStyleValue(StyleKey key, const flutter::EncodableValue& value,
+                    ResolvedStyle& style) {
+  switch (key) {
+    case StyleKey::kBackgroundColor:
+      return ReadColor(value, &style.background_color);
+    case StyleKey::kTextColor:
+      return ReadColor(value, &style.text_color);
+    case StyleKey::kFontSize:
+      return ReadNumber(value, &style.font_size);
+    case StyleKey::kFontFamily:
+      return Read(value, &style.font_family);
+    case StyleKey::kFontWeight:
+      return ReadInt(value, &style.font_weight);
+    case StyleKey::kCornerRadius:
+      return ReadNumber(value, &style.corner_radius);
+    case StyleKey::kPadding:
+      return ReadPadding(value, &style.padding);
+    case StyleKey::kMinWidth:
+      return ReadNumber(value, &style.min_width);
+    case StyleKey::kThemeMode:
+      return Read(value, &style.theme_mode);
+    case StyleKey::kSeparatorColor:
+      return ReadColor(value, &style.separator_color);
+    case StyleKey::kDisabledTextColor:
+      return ReadColor(value, &style.disabled_text_color);
+    case StyleKey::kHoverBackgroundColor:
+      return ReadColor(value, &style.hover_background_color);
+    case StyleKey::kSubMenuOpenedBackgroundColor:
+      return ReadColor(value, &style.sub_menu_opened_background_color);
+    case StyleKey::kSubMenuOpenedTextColor:
+      return ReadColor(value, &style.sub_menu_opened_text_color);
+    case StyleKey::kBorderColor:
+      return ReadColor(value, &style.border_color);
+    case StyleKey::kBorderThickness:
+      return ReadNumber(value, &style.border_thickness);
+    case StyleKey::kFontStyle:
+      return Read(value, &style.font_style);
+    case StyleKey::kItemHeight:
+      return ReadNumber(value, &style.item_height);
+    case StyleKey::kShadowElevation:
+      return ReadNumber(value, &style.shadow_elevation);
+    case StyleKey::kCheckedIndicatorColor:
+      return ReadColor(value, &style.checked_indicator_color);
+    case StyleKey::kCheckedForegroundColor:
+      return ReadColor(value, &style.checked_foreground_color);
+    case StyleKey::kCheckedBackgroundColor:
+      return ReadColor(value, &style.checked_background_color);
+    case StyleKey::kIconColor:
+      return ReadColor(value, &style.icon_color);
+    case StyleKey::kKeyboardAcceleratorColor:
+      return ReadColor(value, &style.keyboard_accelerator_color);
+    case StyleKey::kCompactItemLayout:
+      return Read(value, &style.compact_item_layout);
+    case StyleKey::kMaxHeight:
+      return ReadNumber(value, &style.max_height);
+    case StyleKey::kVirtualizationThreshold:
+      return ReadInt(value, &style.virtualization_threshold);
+    case StyleKey::kVirtualizationPageSize:
+      return ReadInt(value, &style.virtualization_page_size);
+    case StyleKey::kVirtualizationMaxItems:
+      return ReadInt(value, &style.virtualization_max_items);
+    case StyleKey::kVirtualizationMoreLabel:
+      return Read(value, &style.virtualization_more_label);
+    case StyleKey::kVirtualizationPreviousLabel:
+      return Read(value, &style.virtualization_previous_label);
+    case StyleKey::kEnableOpenCloseAnimations:
+      return Read(value, &style.enable_open_close_animations);
+    case StyleKey::kDismissOnPointerMoveAway:
+      return Read(value, &style.dismiss_on_pointer_move_away);
+    case StyleKey::kBackdropType:
+      return Read(value, &style.backdrop_type);
+  }
+  return false;
+}
+
+// Heap bytes of s beyond the object; short strings live inside it.
+size_t StringHeapBytes(const std::string& s) {
+  return s.capacity() > sizeof(std::string) ? s.capacity() + 1 : 0;
+}
+
+}  // namespace
+
+std::string_view StyleKeyName(StyleKey key) {
+  return kStyleKeyNames[static_cast<size_t>(key)];
+}
+
+std::optional<StyleKey> FindStyleKey(std::string_view name) {
+  const uint8_t key = kKeySlots[KeySlot(name, kKeySeed)];
+  if (key == kNoKey || kStyleKeyNames[key] != name) return std::nullopt;
+  return static_cast<StyleKey>(key);
+}
+
+size_t ResolvedStyle::memory_bytes() const {
+  return sizeof(*this) + StringHeapBytes(font_family) +
+         StringHeapBytes(font_style) + StringHeapBytes(theme_mode) +
+         StringHeapBytes(backdrop_type) +
+         StringHeapBytes(virtualization_more_label) +
+         StringHeapBytes(virtualization_previous_label);
+}
+
+ResolvedStyle ResolveStyle(const flutter::EncodableMap& style) {
+  ResolvedStyle resolved;
+  for (const auto& [key, value] : style) {
+    const auto* name = std::get_if<std::string>(&key);
+    if (!name) continue;
+    const std::optional<StyleKey> style_key = FindStyleKey(*name);
+    if (style_key && ReadStyleValue(*style_key, value, resolved)) {
+      resolved.present |= uint64_t{1} << static_cast<unsigned>(*style_key);
+    }
+  }
+  resolved.fingerprint = FingerprintStyle(style);
+  return resolved;
+}
+
+}  // namespace tray_manager_winui
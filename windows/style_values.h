@@ -0,0 +1,144 @@
+#ifndef TRAY_MANAGER_WINUI_STYLE_VALUES_H_
+#define TRAY_MANAGER_WINUI_STYLE_VALUES_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace tray_manager_winui {
+
+/// Keys of the map WinUIContextMenuStyle.toJson() sends, in its order. Each
+/// has one bit in ResolvedStyle::present.
+enum class StyleKey : uint8_t {
+  kBackgroundColor,
+  kTextColor,
+  kFontSize,
+  kFontFamily,
+  kFontWeight,
+  kCornerRadius,
+  kPadding,
+  kMinWidth,
+  kThemeMode,
+  kSeparatorColor,
+  kDisabledTextColor,
+  kHoverBackgroundColor,
+  kSubMenuOpenedBackgroundColor,
+  kSubMenuOpenedTextColor,
+  kBorderColor,
+  kBorderThickness,
+  kFontStyle,
+  kItemHeight,
+  kShadowElevation,
+  kCheckedIndicatorColor,
+  kCheckedForegroundColor,
+  kCheckedBackgroundColor,
+  kIconColor,
+  kKeyboardAcceleratorColor,
+  kCompactItemLayout,
+  kMaxHeight,
+  kVirtualizationThreshold,
+  kVirtualizationPageSize,
+  kVirtualizationMaxItems,
+  kVirtualizationMoreLabel,
+  kVirtualizationPreviousLabel,
+  kEnableOpenCloseAnimations,
+  kDismissOnPointerMoveAway,
+  kBackdropType,
+};
+
+constexpr size_t kStyleKeyCount =
+    static_cast<size_t>(StyleKey::kBackdropType) + 1;
+
+/// The key as it appears in the style map ("fontSize").
+std::string_view StyleKeyName(StyleKey key);
+
+/// The key named name, or nullopt for a name WinUIContextMenuStyle does not
+/// send. A perfect hash built at compile time: one hash of name, one table
+/// probe and one comparison, whatever the number of keys.
+std::optional<StyleKey> FindStyleKey(std::string_view name);
+
+/// padding of a WinUIContextMenuStyle, in pixels.
+struct StylePadding {
+  double left = 0;
+  double top = 0;
+  double right = 0;
+  double bottom = 0;
+};
+
+/// A WinUIContextMenuStyle map parsed once into typed fields, so that the
+/// flyout, item, paging and XAML code read plain members instead of looking
+/// up map keys.
+///
+/// A key is present if the map has it with a value of the field's type (any
+/// Dart int for int and colour fields, any number for double fields, a map
+/// for padding); a value of another type counts as missing. Fields of
+/// missing keys keep the defaults below: 0 for colours and numbers (colours
+/// are 0xAARRGGBB, and 0 is also "not set" for a present colour), "" for
+/// strings.
+struct ResolvedStyle {
+  /// Bit (1 << key) of every present key.
+  uint64_t present = 0;
+  /// FingerprintStyle of the map; equal fingerprints render the same.
+  uint64_t fingerprint = 0;
+
+  uint32_t background_color = 0;
+  uint32_t text_color = 0;
+  uint32_t separator_color = 0;
+  uint32_t disabled_text_color = 0;
+  uint32_t hover_background_color = 0;
+  uint32_t sub_menu_opened_background_color = 0;
+  uint32_t sub_menu_opened_text_color = 0;
+  uint32_t border_color = 0;
+  uint32_t checked_indicator_color = 0;
+  uint32_t checked_foreground_color = 0;
+  uint32_t checked_background_color = 0;
+  uint32_t icon_color = 0;
+  uint32_t keyboard_accelerator_color = 0;
+
+  double font_size = 0;
+  double corner_radius = 0;
+  double min_width = 0;
+  double border_thickness = 0;
+  double item_height = 0;
+  double shadow_elevation = 0;
+  double max_height = 0;
+  StylePadding padding;
+
+  int64_t font_weight = 0;
+  int64_t virtualization_threshold = 0;
+  int64_t virtualization_page_size = 0;
+  int64_t virtualization_max_items = 0;
+
+  /// UTF-8.
+  std::string font_family;
+  std::string font_style;
+  std::string theme_mode;
+  std::string backdrop_type;
+  std::string virtualization_more_label;
+  std::string virtualization_previous_label;
+
+  bool compact_item_layout = true;
+  bool enable_open_close_animations = true;
+  bool dismiss_on_pointer_move_away = false;
+
+  bool has(StyleKey key) const {
+    return (present >> static_cast<unsigned>(key)) & 1;
+  }
+
+  /// True if no known key is present: WinUI's default look.
+  bool empty() const { return present == 0; }
+
+  /// Approximate bytes held, strings included. For memory budgets.
+  size_t memory_bytes() const;
+};
+
+/// Parses style in one pass over its entries. Unknown keys are ignored.
+ResolvedStyle ResolveStyle(const flutter::EncodableMap& style);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_STYLE_VALUES_H_
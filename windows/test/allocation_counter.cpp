@@ -0,0 +1,34 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Per thread, so that threads left over from other tests do not count.
+thread_local int64_t g_thread_allocations = 0;
+
+void* CountedAlloc(std::size_t size) {
+  ++g_thread_allocations;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+}  // namespace
+
+// As in benchmark/benchmark_main.cpp; aligned and nothrow variants fall
+// through to these in the standard library.
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace tray_manager_winui {
+namespace testing {
+
+int64_t ThreadAllocationCount() { return g_thread_allocations; }
+
+}  // namespace testing
+}  // namespace tray_manager_winui
@@ -0,0 +1,27 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_ALLOCATION_COUNTER_H_
+#define TRAY_MANAGER_WINUI_TEST_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace tray_manager_winui {
+namespace testing {
+
+// Number of global operator new calls made by the calling thread so far.
+// allocation_counter.cpp replaces operator new for the test binary.
+int64_t ThreadAllocationCount();
+
+// Counts the allocations of the calling thread between construction and
+// count().
+class AllocationScope {
+ public:
+  AllocationScope() : start_(ThreadAllocationCount()) {}
+  int64_t count() const { return ThreadAllocationCount() - start_; }
+
+ private:
+  int64_t start_;
+};
+
+}  // namespace testing
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_ALLOCATION_COUNTER_H_
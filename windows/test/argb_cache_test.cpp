@@ -0,0 +1,108 @@
+#include "argb_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+
+namespace tray_manager_winui {
+namespace {
+
+// Stand-in for a brush: a refcounted handle that is falsy when null.
+using FakeBrush = std::shared_ptr<uint32_t>;
+
+struct CountingFactory {
+  int calls = 0;
+  FakeBrush operator()(uint32_t argb) {
+    ++calls;
+    return std::make_shared<uint32_t>(argb);
+  }
+};
+
+TEST(ArgbCacheTest, ToArgbKeyAcceptsInt32AndInt64Encodings) {
+  // 0xFF202020 arrives as int64 from Dart, 0x7F202020 fits int32.
+  EXPECT_EQ(ToArgbKey(int64_t{0xFF202020}), 0xFF202020u);
+  EXPECT_EQ(ToArgbKey(static_cast<int32_t>(0xFF202020)), 0xFF202020u);
+  EXPECT_EQ(ToArgbKey(0x7F202020), 0x7F202020u);
+}
+
+TEST(ArgbCacheTest, CreatesOncePerDistinctColour) {
+  ArgbCache<FakeBrush> cache;
+  CountingFactory factory;
+  // 300 items using three colours, like textColor/iconColor/separatorColor.
+  for (int i = 0; i < 300; ++i) {
+    const uint32_t argb = 0xFF000000u | static_cast<uint32_t>(i % 3);
+    FakeBrush brush = cache.GetOrCreate(argb, std::ref(factory));
+    ASSERT_TRUE(brush);
+    EXPECT_EQ(*brush, argb);
+  }
+  EXPECT_EQ(factory.calls, 3);
+  EXPECT_EQ(cache.misses(), 3u);
+  EXPECT_EQ(cache.hits(), 297u);
+  EXPECT_EQ(cache.size(), 3u);
+}
+
+TEST(ArgbCacheTest, ReturnsSameInstanceOnHit) {
+  ArgbCache<FakeBrush> cache;
+  CountingFactory factory;
+  FakeBrush a = cache.GetOrCreate(0xFF112233, std::ref(factory));
+  FakeBrush b = cache.GetOrCreate(0xFF112233, std::ref(factory));
+  EXPECT_EQ(a.get(), b.get());
+}
+
+TEST(ArgbCacheTest, EvictsLeastRecentlyUsed) {
+  ArgbCache<FakeBrush> cache(2);
+  CountingFactory factory;
+  cache.GetOrCreate(1, std::ref(factory));
+  cache.GetOrCreate(2, std::ref(factory));
+  cache.GetOrCreate(1, std::ref(factory));  // 2 becomes least recently used.
+  cache.GetOrCreate(3, std::ref(factory));
+
+  EXPECT_TRUE(cache.Contains(1));
+  EXPECT_FALSE(cache.Contains(2));
+  EXPECT_TRUE(cache.Contains(3));
+  EXPECT_EQ(cache.evictions(), 1u);
+  EXPECT_EQ(cache.size(), 2u);
+}
+
+TEST(ArgbCacheTest, DoesNotCacheFailures) {
+  ArgbCache<FakeBrush> cache;
+  int calls = 0;
+  auto failing = [&calls](uint32_t) {
+    ++calls;
+    return FakeBrush();
+  };
+  EXPECT_FALSE(cache.GetOrCreate(0xFF000000, failing));
+  EXPECT_FALSE(cache.GetOrCreate(0xFF000000, failing));
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(ArgbCacheTest, ClearAndResetStats) {
+  ArgbCache<FakeBrush> cache;
+  CountingFactory factory;
+  cache.GetOrCreate(1, std::ref(factory));
+  cache.GetOrCreate(1, std::ref(factory));
+  cache.ResetStats();
+  EXPECT_EQ(cache.hits(), 0u);
+  EXPECT_EQ(cache.misses(), 0u);
+  EXPECT_EQ(cache.size(), 1u);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0u);
+  cache.GetOrCreate(1, std::ref(factory));
+  EXPECT_EQ(factory.calls, 2);
+}
+
+TEST(ArgbCacheTest, ZeroCapacityHoldsOneEntry) {
+  ArgbCache<FakeBrush> cache(0);
+  CountingFactory factory;
+  cache.GetOrCreate(1, std::ref(factory));
+  cache.GetOrCreate(2, std::ref(factory));
+  EXPECT_EQ(cache.capacity(), 1u);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_TRUE(cache.Contains(2));
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
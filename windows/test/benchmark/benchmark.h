@@ -0,0 +1,60 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_BENCHMARK_BENCHMARK_H_
+#define TRAY_MANAGER_WINUI_TEST_BENCHMARK_BENCHMARK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tray_manager_winui {
+namespace bench {
+
+// Minimal self-timing benchmark harness. A benchmark body runs one
+// iteration; the harness repeats it until the time budget is used up and
+// reports ns per iteration, ns per item, heap allocations per iteration and
+// the process's peak resident set size so far.
+struct Case {
+  std::string name;
+  int64_t items_per_iteration;
+  std::function<void()> body;
+};
+
+std::vector<Case>& Registry();
+
+// Adds a case. Benchmark files call this from a static initializer so that
+// they can register one case per input size.
+inline bool Register(std::string name, int64_t items,
+                     std::function<void()> body) {
+  Registry().push_back({std::move(name), items, std::move(body)});
+  return true;
+}
+
+// Adds value to a named counter of the running case; the harness reports
+// counters per item next to the timings (e.g. wake-ups per event). Call from
+// the thread running the case.
+void AddCounter(const char* name, int64_t value);
+
+// Number of global operator new calls so far (all threads).
+int64_t AllocationCount();
+
+// Peak resident set size of the process so far, in bytes; 0 if unknown.
+int64_t PeakRssBytes();
+
+extern const void* volatile g_sink;
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  g_sink = &value;
+#endif
+}
+
+}  // namespace bench
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_BENCHMARK_BENCHMARK_H_
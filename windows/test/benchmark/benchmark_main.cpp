@@ -0,0 +1,144 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<int64_t> g_allocations{0};
+
+void* CountedAlloc(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+}  // namespace
+
+// Counts every allocation made through the global operator new. Aligned and
+// nothrow variants fall through to these in the standard library.
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace tray_manager_winui {
+namespace bench {
+
+const void* volatile g_sink = nullptr;
+
+int64_t AllocationCount() {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+int64_t PeakRssBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    return 0;
+  }
+  return static_cast<int64_t>(counters.PeakWorkingSetSize);
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return static_cast<int64_t>(usage.ru_maxrss);  // Bytes.
+#else
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;  // Kilobytes.
+#endif
+#endif
+}
+
+namespace {
+
+std::vector<std::pair<const char*, int64_t>>& Counters() {
+  static std::vector<std::pair<const char*, int64_t>> counters;
+  return counters;
+}
+
+}  // namespace
+
+void AddCounter(const char* name, int64_t value) {
+  for (auto& counter : Counters()) {
+    if (std::strcmp(counter.first, name) == 0) {
+      counter.second += value;
+      return;
+    }
+  }
+  Counters().emplace_back(name, value);
+}
+
+std::vector<Case>& Registry() {
+  static std::vector<Case> cases;
+  return cases;
+}
+
+namespace {
+
+constexpr auto kMinDuration = std::chrono::milliseconds(200);
+
+void RunCase(const Case& c) {
+  using Clock = std::chrono::steady_clock;
+  c.body();  // Warm-up.
+
+  int64_t iterations = 1;
+  int64_t allocations = 0;
+  Clock::duration elapsed{};
+  while (true) {
+    Counters().clear();
+    const int64_t allocations_before = AllocationCount();
+    auto start = Clock::now();
+    for (int64_t i = 0; i < iterations; ++i) c.body();
+    elapsed = Clock::now() - start;
+    allocations = AllocationCount() - allocations_before;
+    if (elapsed >= kMinDuration || iterations >= (int64_t{1} << 30)) break;
+    iterations *= 2;
+  }
+
+  double ns = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  double per_iter = ns / static_cast<double>(iterations);
+  double per_item =
+      per_iter / static_cast<double>(std::max<int64_t>(1, c.items_per_iteration));
+  double allocs_per_iter =
+      static_cast<double>(allocations) / static_cast<double>(iterations);
+  std::printf("%-56s %14.1f ns/op %10.2f ns/item %9.1f allocs/op %10lld iters",
+              c.name.c_str(), per_iter, per_item, allocs_per_iter,
+              static_cast<long long>(iterations));
+  const double items = static_cast<double>(iterations) *
+                       static_cast<double>(std::max<int64_t>(1, c.items_per_iteration));
+  std::printf(" %8.1f MB peak",
+              static_cast<double>(PeakRssBytes()) / (1024.0 * 1024.0));
+  for (const auto& [name, value] : Counters()) {
+    std::printf(" %10.4f %s/item", static_cast<double>(value) / items, name);
+  }
+  std::printf("\n");
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace tray_manager_winui
+
+// Usage: tray_manager_winui_bench [substring filter]
+int main(int argc, char** argv) {
+  const char* filter = argc > 1 ? argv[1] : nullptr;
+  for (const auto& c : tray_manager_winui::bench::Registry()) {
+    if (filter && c.name.find(filter) == std::string::npos) continue;
+    tray_manager_winui::bench::RunCase(c);
+  }
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "menu_event_queue.h"
+#include "menu_model.h"
+#include "menu_snapshot.h"
+#include "packed_menu.h"
+#include "packed_menu_writer.h"
+#include "recording_menu_backend.h"
+#include "synthetic_menu.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::LabelScript;
+using testing::SyntheticMenuSpec;
+
+// Inputs are generated on the first (warm-up) run of a case, so that the
+// large sizes only cost memory when they are selected.
+struct Inputs {
+  flutter::EncodableMap json;
+  std::vector<uint8_t> packed;
+  MenuSnapshotPtr menu;
+};
+
+std::shared_ptr<std::optional<Inputs>> LazyInputs() {
+  return std::make_shared<std::optional<Inputs>>();
+}
+
+const Inputs& Get(std::optional<Inputs>& inputs,
+                  const SyntheticMenuSpec& spec) {
+  if (!inputs) {
+    Inputs made;
+    made.json = testing::GenerateSyntheticMenu(spec);
+    made.menu = MakeMenuSnapshot(CompileMenu(made.json), {});
+    made.packed = testing::PackMenu(made.menu->menu, {});
+    inputs = std::move(made);
+  }
+  return *inputs;
+}
+
+// The stages of one setContextMenu + showContextMenu + click round trip that
+// do not need Windows, from 10 to 100k items and across menu shapes:
+//   compile        setContextMenu from the method channel map
+//   compile_packed setContextMenu from the packed buffer
+//   show_prepare   cold show with the headless backend (pool, flyout, items)
+//   event_dispatch queueing one event per item and draining them into
+//                  method names and arguments, as the platform thread does
+const bool kRegistered = [] {
+  std::vector<SyntheticMenuSpec> shapes;
+  {
+    SyntheticMenuSpec flat;
+    flat.depth = 0;
+    flat.label_length = 12;
+    shapes.push_back(flat);
+    SyntheticMenuSpec nested;
+    nested.depth = 2;
+    nested.width = 20;
+    nested.label_length = 24;
+    nested.script = LabelScript::kLatin;
+    shapes.push_back(nested);
+    SyntheticMenuSpec deep;
+    deep.depth = 4;
+    deep.width = 8;
+    deep.label_length = 40;
+    deep.script = LabelScript::kMixed;
+    shapes.push_back(deep);
+  }
+
+  for (int32_t size : {10, 100, 1000, 10000, 100000}) {
+    for (SyntheticMenuSpec spec : shapes) {
+      spec.item_count = size;
+      const std::string suffix = "/" + std::to_string(size) + "/" +
+                                 testing::DescribeSyntheticMenu(spec);
+
+      auto compile = LazyInputs();
+      bench::Register("core_pipeline/compile" + suffix, size,
+                      [compile, spec] {
+                        CompiledMenu menu = CompileMenu(Get(*compile, spec).json);
+                        bench::DoNotOptimize(menu);
+                      });
+
+      auto packed = LazyInputs();
+      bench::Register("core_pipeline/compile_packed" + suffix, size,
+                      [packed, spec] {
+                        const std::vector<uint8_t>& buffer =
+                            Get(*packed, spec).packed;
+                        PackedMenuView view;
+                        view.Open(buffer.data(), buffer.size());
+                        CompiledMenu menu = CompileMenu(view);
+                        bench::DoNotOptimize(menu);
+                      });
+
+      auto show = LazyInputs();
+      bench::Register("core_pipeline/show_prepare" + suffix, size,
+                      [show, spec] {
+                        testing::HeadlessContextMenu headless;
+                        headless.backend().set_logging(false);
+                        bool shown = headless.Show(Get(*show, spec).menu);
+                        headless.Close();
+                        bench::DoNotOptimize(shown);
+                      });
+    }
+
+    auto queue = std::make_shared<MenuEventQueue>();
+    bench::Register(
+        "core_pipeline/event_dispatch/" + std::to_string(size), size,
+        [queue, size] {
+          size_t delivered = 0;
+          auto deliver = [&delivered](const MenuEvent& event) {
+            auto args = MenuEventArguments(event);
+            bench::DoNotOptimize(MenuEventMethod(event.type));
+            bench::DoNotOptimize(args);
+            ++delivered;
+          };
+          MenuEvent click;
+          click.type = MenuEventType::kItemClick;
+          for (int32_t id = 1; id <= size; ++id) {
+            click.id = id;
+            if (queue->Push(click) == MenuEventPush::kOverflow) {
+              queue->Drain(deliver);
+              queue->Push(click);
+            }
+          }
+          queue->Drain(deliver);
+          bench::DoNotOptimize(delivered);
+        });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,146 @@
+#include "benchmark.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "live_items.h"
+
+namespace tray_manager_winui {
+namespace {
+
+constexpr int32_t kUpdatesPerProducer = 20000;
+// Items of a progress-heavy menu that stream updates.
+constexpr int32_t kLiveItems = 100;
+
+// The platform thread's message queue, as in menu_event_queue_benchmark.
+template <typename Message>
+class MessageLoop {
+ public:
+  void Post(Message message) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      messages_.push_back(std::move(message));
+    }
+    cv_.notify_one();
+  }
+
+  // Returns false once stopped and empty.
+  bool Take(Message& message) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !messages_.empty() || stopped_; });
+    if (messages_.empty()) return false;
+    message = std::move(messages_.front());
+    messages_.pop_front();
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Message> messages_;
+  bool stopped_ = false;
+};
+
+LiveItemUpdate MakeUpdate(int32_t i) {
+  LiveItemUpdate update;
+  update.id = i % kLiveItems;
+  update.label = "Progress " + std::to_string(i);
+  return update;
+}
+
+// One wake-up message per burst; each wake-up applies the latest value of
+// every item updated since the last one.
+void RunCoalescer(LiveItemCoalescer& coalescer, int producers) {
+  MessageLoop<bool> loop;
+  int64_t wakes = 0;
+  int64_t applied = 0;
+  auto apply = [&applied](const LiveItemUpdate& update) {
+    bench::DoNotOptimize(update);
+    ++applied;
+  };
+  std::thread consumer([&] {
+    bool message;
+    while (loop.Take(message)) {
+      ++wakes;
+      coalescer.Drain(apply);
+    }
+    coalescer.Drain(apply);
+  });
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&coalescer, &loop] {
+      for (int32_t i = 0; i < kUpdatesPerProducer; ++i) {
+        if (coalescer.Push(MakeUpdate(i)) == LiveItemPush::kQueuedWake) {
+          loop.Post(true);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  loop.Stop();
+  consumer.join();
+  bench::AddCounter("wakes", wakes);
+  bench::AddCounter("applied", applied);
+}
+
+// Without coalescing: every update is a message the platform thread
+// applies to the flyout.
+void RunPerUpdatePost(int producers) {
+  MessageLoop<std::unique_ptr<LiveItemUpdate>> loop;
+  int64_t applied = 0;
+  std::thread consumer([&] {
+    std::unique_ptr<LiveItemUpdate> update;
+    while (loop.Take(update)) {
+      bench::DoNotOptimize(*update);
+      ++applied;
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&loop] {
+      for (int32_t i = 0; i < kUpdatesPerProducer; ++i) {
+        loop.Post(std::make_unique<LiveItemUpdate>(MakeUpdate(i)));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  loop.Stop();
+  consumer.join();
+  bench::AddCounter("wakes", applied);
+  bench::AddCounter("applied", applied);
+}
+
+// ns/item is per update across all producers; applied/item is how many of
+// them reach the flyout. The consumer drains as fast as it is woken, so
+// this measures push and drain costs; the frame pacing in the plugin
+// coalesces far more.
+const bool kRegistered = [] {
+  for (int producers : {1, 2, 4}) {
+    const std::string suffix = "/" + std::to_string(producers);
+    const int64_t updates = int64_t{producers} * kUpdatesPerProducer;
+    auto coalescer = std::make_shared<LiveItemCoalescer>();
+    bench::Register("live_items/coalescer" + suffix, updates,
+                    [coalescer, producers] {
+                      RunCoalescer(*coalescer, producers);
+                    });
+    bench::Register("live_items/per_update_post" + suffix, updates,
+                    [producers] { RunPerUpdatePost(producers); });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
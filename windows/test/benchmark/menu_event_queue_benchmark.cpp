@@ -0,0 +1,135 @@
+#include "benchmark.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "menu_event_queue.h"
+
+namespace tray_manager_winui {
+namespace {
+
+constexpr int32_t kEventsPerProducer = 20000;
+
+// The platform thread's message queue: every Post is one message the
+// consumer has to take.
+template <typename Message>
+class MessageLoop {
+ public:
+  void Post(Message message) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      messages_.push_back(std::move(message));
+    }
+    cv_.notify_one();
+  }
+
+  // Returns false once stopped and empty.
+  bool Take(Message& message) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !messages_.empty() || stopped_; });
+    if (messages_.empty()) return false;
+    message = std::move(messages_.front());
+    messages_.pop_front();
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Message> messages_;
+  bool stopped_ = false;
+};
+
+// One queue, one wake-up message per burst, drain everything per wake-up.
+void RunQueue(MenuEventQueue& queue, int producers) {
+  MessageLoop<bool> loop;
+  int64_t wakes = 0;
+  int64_t received = 0;
+  std::thread consumer([&] {
+    bool message;
+    while (loop.Take(message)) {
+      ++wakes;
+      received += static_cast<int64_t>(
+          queue.Drain([](const MenuEvent& event) { bench::DoNotOptimize(event); }));
+    }
+    received += static_cast<int64_t>(queue.Drain([](const MenuEvent&) {}));
+  });
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, &loop] {
+      MenuEvent event;
+      event.type = MenuEventType::kItemClick;
+      for (int32_t i = 0; i < kEventsPerProducer; ++i) {
+        event.id = i;
+        if (queue.Push(event) == MenuEventPush::kQueuedWake) {
+          loop.Post(true);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  loop.Stop();
+  consumer.join();
+  bench::DoNotOptimize(received);
+  bench::AddCounter("wakes", wakes);
+}
+
+// What it replaced: a heap-allocated payload and one message per event.
+void RunPerEventPost(int producers) {
+  MessageLoop<std::unique_ptr<MenuEvent>> loop;
+  int64_t wakes = 0;
+  std::thread consumer([&] {
+    std::unique_ptr<MenuEvent> event;
+    while (loop.Take(event)) {
+      ++wakes;
+      bench::DoNotOptimize(*event);
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&loop] {
+      for (int32_t i = 0; i < kEventsPerProducer; ++i) {
+        auto event = std::make_unique<MenuEvent>();
+        event->type = MenuEventType::kItemClick;
+        event->id = i;
+        loop.Post(std::move(event));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  loop.Stop();
+  consumer.join();
+  bench::AddCounter("wakes", wakes);
+}
+
+// ns/item is per event across all producers; wakes/item is platform-thread
+// messages per event. Producers here outrun any real menu, so the queue is
+// sized to never overflow and measures the push, wake and drain costs only.
+const bool kRegistered = [] {
+  for (int producers : {1, 2, 4, 8}) {
+    const std::string suffix = "/" + std::to_string(producers);
+    const int64_t events = int64_t{producers} * kEventsPerProducer;
+    auto queue = std::make_shared<MenuEventQueue>(static_cast<size_t>(events));
+    bench::Register("menu_events/queue" + suffix, events,
+                    [queue, producers] { RunQueue(*queue, producers); });
+    bench::Register("menu_events/per_event_post" + suffix, events,
+                    [producers] { RunPerEventPost(producers); });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
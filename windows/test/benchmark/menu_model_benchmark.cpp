@@ -0,0 +1,152 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+
+#include "menu_fixtures.h"
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+namespace {
+
+// Mirrors the per-show field reads of the previous EncodableMap-walking
+// AddMenuItemsToCollection: one temporary key and std::map lookup per field,
+// strings copied out, submenus reached through two more lookups.
+size_t WalkMap(const flutter::EncodableList& items) {
+  size_t checksum = 0;
+  for (const auto& item_val : items) {
+    const auto* item_map = std::get_if<flutter::EncodableMap>(&item_val);
+    if (!item_map) continue;
+    auto get_str = [&](const char* key) -> std::string {
+      auto it = item_map->find(flutter::EncodableValue(key));
+      if (it == item_map->end()) return "";
+      const auto* s = std::get_if<std::string>(&it->second);
+      return s ? *s : "";
+    };
+    auto get_int = [&](const char* key) -> int {
+      auto it = item_map->find(flutter::EncodableValue(key));
+      if (it == item_map->end()) return 0;
+      const auto* i = std::get_if<int>(&it->second);
+      return i ? *i : 0;
+    };
+    auto get_bool = [&](const char* key) -> bool {
+      auto it = item_map->find(flutter::EncodableValue(key));
+      if (it == item_map->end()) return false;
+      const auto* b = std::get_if<bool>(&it->second);
+      return b ? *b : false;
+    };
+    std::string type = get_str("type");
+    int id = get_int("id");
+    std::string label = get_str("label");
+    bool disabled = get_bool("disabled");
+    std::string icon = get_str("icon");
+    std::string icon_font = get_str("iconFontFamily");
+    std::string accel = get_str("acceleratorText");
+    std::string tool_tip = get_str("toolTip");
+    checksum += static_cast<size_t>(id) + label.size() + tool_tip.size() +
+                icon.size() + icon_font.size() + accel.size() + disabled;
+    if (type == "submenu" || type == "split") {
+      auto sub_it = item_map->find(flutter::EncodableValue("submenu"));
+      if (sub_it == item_map->end()) continue;
+      const auto* sub_map = std::get_if<flutter::EncodableMap>(&sub_it->second);
+      if (!sub_map) continue;
+      auto items_it = sub_map->find(flutter::EncodableValue("items"));
+      if (items_it == sub_map->end()) continue;
+      const auto* sub_items =
+          std::get_if<flutter::EncodableList>(&items_it->second);
+      if (sub_items) checksum += WalkMap(*sub_items);
+    }
+  }
+  return checksum;
+}
+
+size_t WalkCompiled(const CompiledMenu& menu, uint32_t first, uint32_t count) {
+  size_t checksum = 0;
+  for (uint32_t i = first; i < first + count; ++i) {
+    const MenuNode& node = menu.node(i);
+    checksum += static_cast<size_t>(node.id) + menu.str(node.label).size() +
+                menu.str(node.tool_tip).size() + menu.str(node.icon).size() +
+                menu.str(node.icon_font_family).size() +
+                menu.str(node.accelerator_text).size() + node.disabled;
+    if (node.has_children()) {
+      checksum += WalkCompiled(menu, node.first_child, node.child_count);
+    }
+  }
+  return checksum;
+}
+
+// Depth-first search for id, as Dart's Menu.getMenuItemById walks the item
+// tree; the cost of resolving a click without an index.
+uint32_t SearchCompiled(const CompiledMenu& menu, uint32_t first,
+                        uint32_t count, int32_t id) {
+  for (uint32_t i = first; i < first + count; ++i) {
+    const MenuNode& node = menu.node(i);
+    if (node.id == id) return i;
+    if (node.has_children()) {
+      const uint32_t found =
+          SearchCompiled(menu, node.first_child, node.child_count, id);
+      if (found != CompiledMenu::kNoNode) return found;
+    }
+  }
+  return CompiledMenu::kNoNode;
+}
+
+constexpr int32_t kLookups = 64;
+
+const bool kRegistered = [] {
+  for (int32_t size : {10, 100, 1000, 10000, 50000}) {
+    auto json = std::make_shared<flutter::EncodableMap>(
+        testing::MakeSyntheticMenu(size, 100));
+    auto compiled = std::make_shared<CompiledMenu>(CompileMenu(*json));
+    const std::string suffix = "/" + std::to_string(size);
+
+    bench::Register("menu_model/compile" + suffix, size, [json] {
+      CompiledMenu menu = CompileMenu(*json);
+      bench::DoNotOptimize(menu);
+    });
+    bench::Register("menu_model/show_walk_encodable_map" + suffix, size,
+                    [json] {
+                      const auto& items = std::get<flutter::EncodableList>(
+                          json->at(flutter::EncodableValue("items")));
+                      size_t checksum = WalkMap(items);
+                      bench::DoNotOptimize(checksum);
+                    });
+    bench::Register("menu_model/show_walk_compiled" + suffix, size,
+                    [compiled] {
+                      size_t checksum =
+                          WalkCompiled(*compiled, 0, compiled->root_count());
+                      bench::DoNotOptimize(checksum);
+                    });
+
+    // kLookups ids spread over the menu, per iteration.
+    bench::Register("menu_model/find_by_id_search" + suffix, kLookups,
+                    [compiled, size] {
+                      for (int32_t i = 0; i < kLookups; ++i) {
+                        uint32_t found = SearchCompiled(
+                            *compiled, 0, compiled->root_count(),
+                            1 + i * size / kLookups);
+                        bench::DoNotOptimize(found);
+                      }
+                    });
+    bench::Register("menu_model/find_by_id_index" + suffix, kLookups,
+                    [compiled, size] {
+                      for (int32_t i = 0; i < kLookups; ++i) {
+                        uint32_t found =
+                            compiled->FindNode(1 + i * size / kLookups);
+                        bench::DoNotOptimize(found);
+                      }
+                    });
+    bench::Register("menu_model/click_event" + suffix, kLookups,
+                    [compiled, size] {
+                      for (int32_t i = 0; i < kLookups; ++i) {
+                        MenuClick click = compiled->ClickOn(
+                            compiled->FindNode(1 + i * size / kLookups));
+                        bench::DoNotOptimize(click);
+                      }
+                    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
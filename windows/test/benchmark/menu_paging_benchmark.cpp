@@ -0,0 +1,78 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+
+#include "menu_fixtures.h"
+#include "menu_model.h"
+#include "menu_paging.h"
+#include "menu_snapshot.h"
+#include "recording_menu_backend.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::HeadlessContextMenu;
+
+flutter::EncodableMap FlatMenu(int32_t count) {
+  flutter::EncodableList items;
+  items.reserve(static_cast<size_t>(count));
+  for (int32_t id = 1; id <= count; ++id) {
+    items.emplace_back(
+        testing::MakeItem(id, "normal", "Recent file " + std::to_string(id)));
+  }
+  return testing::MakeMenu(std::move(items));
+}
+
+flutter::EncodableMap PagingStyle(bool paged) {
+  flutter::EncodableMap style;
+  style[flutter::EncodableValue("maxHeight")] = flutter::EncodableValue(480.0);
+  style[flutter::EncodableValue("virtualizationThreshold")] =
+      flutter::EncodableValue(paged ? 256 : 0);
+  return style;
+}
+
+// A flat "recent files" list shown with and without paging, and the cost of
+// one page step once it is open. The pool shares the menu snapshot, so item
+// work stops at a page.
+const bool kRegistered = [] {
+  for (int32_t size : {1000, 10000, 100000}) {
+    const CompiledMenu compiled = CompileMenu(FlatMenu(size));
+    const std::string suffix = "/" + std::to_string(size);
+    for (bool paged : {true, false}) {
+      MenuSnapshotPtr menu = MakeMenuSnapshot(compiled, PagingStyle(paged));
+      bench::Register(
+          std::string("menu_paging/") + (paged ? "show_paged" : "show_full") +
+              suffix,
+          size, [menu] {
+            HeadlessContextMenu headless;
+            headless.backend().set_logging(false);
+            bool shown = headless.Show(menu);
+            bench::DoNotOptimize(shown);
+          });
+    }
+
+    // Alternates forward and back so the window keeps moving; each step
+    // builds one page and, at the cap, removes one.
+    auto open = std::make_shared<HeadlessContextMenu>();
+    open->backend().set_logging(false);
+    open->Show(MakeMenuSnapshot(compiled, PagingStyle(true)));
+    for (int i = 0; i < 8; ++i) {
+      open->backend().ShowPage(kRootWidget, MenuPageDirection::kNext);
+    }
+    auto flip = std::make_shared<bool>(false);
+    const int64_t page_size = open->backend().paging().page_size;
+    bench::Register("menu_paging/page_step" + suffix, page_size,
+                    [open, flip] {
+                      *flip = !*flip;
+                      bool moved = open->backend().ShowPage(
+                          kRootWidget, *flip ? MenuPageDirection::kNext
+                                             : MenuPageDirection::kPrevious);
+                      bench::DoNotOptimize(moved);
+                    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,84 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+
+#include "menu_fixtures.h"
+#include "menu_model.h"
+#include "menu_patch.h"
+#include "menu_snapshot.h"
+
+namespace tray_manager_winui {
+namespace {
+
+flutter::EncodableValue Patch(int32_t id, const char* field,
+                              flutter::EncodableValue value) {
+  flutter::EncodableMap patch;
+  patch[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
+  patch[flutter::EncodableValue("field")] = flutter::EncodableValue(field);
+  patch[flutter::EncodableValue("value")] = std::move(value);
+  return flutter::EncodableValue(patch);
+}
+
+// A checkbox toggle: what the click handler used to resend the whole tree for.
+// Compares applying the patch with compiling the full menu again, which is the
+// native part of a setContextMenu resend (channel encoding/decoding of the
+// tree comes on top and scales the same way).
+const bool kRegistered = [] {
+  for (int32_t size : {100, 2000, 10000}) {
+    auto json = std::make_shared<flutter::EncodableMap>(
+        testing::MakeSyntheticMenu(size, 100));
+    auto menu = std::make_shared<CompiledMenu>(CompileMenu(*json));
+    // Id 3 is a checkbox inside the first submenu; the last id is a leaf.
+    auto toggle = std::make_shared<flutter::EncodableList>(flutter::EncodableList{
+        Patch(3, "checked", flutter::EncodableValue(true))});
+    auto relabel = std::make_shared<flutter::EncodableList>(flutter::EncodableList{
+        Patch(3, "checked", flutter::EncodableValue(false)),
+        Patch(size, "label", flutter::EncodableValue("Renamed")),
+        Patch(size, "disabled", flutter::EncodableValue(true))});
+    const std::string suffix = "/" + std::to_string(size);
+
+    bench::Register("menu_patch/full_resend_compile" + suffix, size, [json] {
+      CompiledMenu compiled = CompileMenu(*json);
+      bench::DoNotOptimize(compiled);
+    });
+    bench::Register("menu_patch/apply_toggle" + suffix, size,
+                    [menu, toggle] {
+                      MenuPatchResult result = ApplyMenuPatches(*menu, *toggle);
+                      bench::DoNotOptimize(result);
+                    });
+    // Relabelling appends to the string table; start from a fresh copy so the
+    // table does not grow across iterations.
+    bench::Register("menu_patch/copy_and_apply_3" + suffix, size,
+                    [menu, relabel] {
+                      CompiledMenu copy = *menu;
+                      MenuPatchResult result = ApplyMenuPatches(copy, *relabel);
+                      bench::DoNotOptimize(result);
+                    });
+
+    // updateMenuItems with a toggle, on the plugin's snapshot: in place while
+    // nothing else holds it, copy-on-write while the pooled flyout does.
+    auto owned = std::make_shared<std::shared_ptr<MenuSnapshot>>(
+        MakeMenuSnapshot(CompileMenu(*json), {}));
+    bench::Register("menu_patch/snapshot_in_place" + suffix, size,
+                    [owned, toggle] {
+                      MenuPatchResult result =
+                          PatchMenuSnapshot(*owned, *toggle);
+                      bench::DoNotOptimize(result);
+                    });
+    // The copy replaces current only, so every iteration copies again.
+    std::shared_ptr<MenuSnapshot> pooled =
+        MakeMenuSnapshot(CompileMenu(*json), {});
+    bench::Register("menu_patch/snapshot_held" + suffix, size,
+                    [pooled, toggle] {
+                      std::shared_ptr<MenuSnapshot> current = pooled;
+                      MenuPatchResult result =
+                          PatchMenuSnapshot(current, *toggle);
+                      bench::DoNotOptimize(result);
+                    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,151 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "menu_fixtures.h"
+#include "menu_model.h"
+#include "menu_patch.h"
+#include "menu_snapshot.h"
+#include "recording_menu_backend.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::HeadlessContextMenu;
+
+flutter::EncodableMap ProductionStyle() {
+  flutter::EncodableMap style;
+  style[flutter::EncodableValue("fontSize")] = flutter::EncodableValue(13.0);
+  style[flutter::EncodableValue("itemHeight")] = flutter::EncodableValue(30.0);
+  style[flutter::EncodableValue("textColor")] =
+      flutter::EncodableValue(int64_t{0xFFEEEEEE});
+  style[flutter::EncodableValue("disabledTextColor")] =
+      flutter::EncodableValue(int64_t{0xFF888888});
+  style[flutter::EncodableValue("separatorColor")] =
+      flutter::EncodableValue(int64_t{0xFF444444});
+  style[flutter::EncodableValue("backgroundColor")] =
+      flutter::EncodableValue(int64_t{0xFF202020});
+  style[flutter::EncodableValue("cornerRadius")] = flutter::EncodableValue(8.0);
+  return style;
+}
+
+// Six submenus of children_per_submenu items plus two plain root items, the
+// shape of a tray menu with a few large submenus.
+flutter::EncodableMap MakeWideSubmenuMenu(int32_t children_per_submenu) {
+  flutter::EncodableList root;
+  int32_t id = 1;
+  root.emplace_back(testing::MakeItem(id++, "normal", "Open"));
+  for (int s = 0; s < 6; ++s) {
+    const int32_t sub_id = id++;
+    flutter::EncodableList children;
+    for (int32_t i = 0; i < children_per_submenu; ++i, ++id) {
+      children.emplace_back(
+          testing::MakeItem(id, "normal", "Entry " + std::to_string(id)));
+    }
+    root.emplace_back(testing::MakeSubmenu(
+        sub_id, "Submenu " + std::to_string(s), std::move(children)));
+  }
+  root.emplace_back(testing::MakeItem(id++, "normal", "Quit"));
+  return testing::MakeMenu(std::move(root));
+}
+
+// Full show path below the XAML thread hop: pool, item building and style
+// resolution, with a recording backend instead of WinUI. Widget work is what
+// the WinUI backend turns into XAML calls, so per-item costs here are the
+// floor that the platform adds to.
+const bool kRegistered = [] {
+  for (int32_t size : {50, 500, 5000}) {
+    CompiledMenu compiled = CompileMenu(testing::MakeSyntheticMenu(size, 25));
+    // Id 3 is a checkbox in the first submenu.
+    CompiledMenu toggled_menu = compiled;
+    ApplyMenuPatches(toggled_menu, flutter::EncodableList{[] {
+      flutter::EncodableMap patch;
+      patch[flutter::EncodableValue("id")] = flutter::EncodableValue(3);
+      patch[flutter::EncodableValue("field")] =
+          flutter::EncodableValue("checked");
+      patch[flutter::EncodableValue("value")] = flutter::EncodableValue(true);
+      return flutter::EncodableValue(patch);
+    }()});
+    // Made once, as setContextMenu does; shows share them.
+    MenuSnapshotPtr menu =
+        MakeMenuSnapshot(std::move(compiled), ProductionStyle());
+    MenuSnapshotPtr toggled =
+        MakeMenuSnapshot(std::move(toggled_menu), ProductionStyle());
+    const std::string suffix = "/" + std::to_string(size);
+
+    bench::Register("menu_pipeline/cold_show" + suffix, size, [menu] {
+      HeadlessContextMenu headless;
+      headless.backend().set_logging(false);
+      bool shown = headless.Show(menu);
+      headless.Close();
+      bench::DoNotOptimize(shown);
+    });
+
+    auto warm = std::make_shared<HeadlessContextMenu>();
+    warm->backend().set_logging(false);
+    bench::Register("menu_pipeline/warm_reshow" + suffix, size,
+                    [warm, menu] {
+                      bool shown = warm->Show(menu);
+                      warm->Close();
+                      bench::DoNotOptimize(shown);
+                    });
+
+    // After prepareContextMenu: the show only opens the flyout.
+    auto prepared = std::make_shared<HeadlessContextMenu>();
+    prepared->backend().set_logging(false);
+    bench::Register("menu_pipeline/prepared_show" + suffix, size,
+                    [prepared, menu] {
+                      if (prepared->pool().state() == MenuHostState::kCold) {
+                        prepared->pool().Prepare(menu);
+                      }
+                      bool shown = prepared->pool().ShowPrepared({});
+                      prepared->Close();
+                      bench::DoNotOptimize(shown);
+                    });
+
+    auto toggling = std::make_shared<HeadlessContextMenu>();
+    toggling->backend().set_logging(false);
+    auto flip = std::make_shared<bool>(false);
+    bench::Register("menu_pipeline/warm_reshow_toggled" + suffix, size,
+                    [toggling, menu, toggled, flip] {
+                      *flip = !*flip;
+                      bool shown = toggling->Show(*flip ? toggled : menu);
+                      toggling->Close();
+                      bench::DoNotOptimize(shown);
+                    });
+  }
+
+  // Time until the root menu can open: with lazy submenus it stays flat as
+  // the submenus grow; eager building scales with the whole tree.
+  for (int32_t children : {10, 100, 1000}) {
+    MenuSnapshotPtr menu = MakeMenuSnapshot(
+        CompileMenu(MakeWideSubmenuMenu(children)), flutter::EncodableMap());
+    const auto total = static_cast<int64_t>(menu->menu.nodes().size());
+    const std::string suffix = "/6x" + std::to_string(children);
+    for (bool lazy : {true, false}) {
+      bench::Register(
+          std::string("menu_pipeline/") +
+              (lazy ? "root_open_lazy" : "root_open_eager") + suffix,
+          total, [menu, lazy] {
+            HeadlessContextMenu headless;
+            headless.backend().set_logging(false);
+            headless.backend().set_lazy_submenus(lazy);
+            bool shown = headless.Show(menu);
+            bench::DoNotOptimize(shown);
+          });
+    }
+    bench::Register("menu_pipeline/open_one_submenu" + suffix, total, [menu] {
+      HeadlessContextMenu headless;
+      headless.backend().set_logging(false);
+      headless.Show(menu);
+      bool built = headless.backend().OpenSubmenu(1);
+      bench::DoNotOptimize(built);
+    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
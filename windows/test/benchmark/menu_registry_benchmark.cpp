@@ -0,0 +1,133 @@
+#include "benchmark.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "menu_model.h"
+#include "menu_registry.h"
+#include "menu_snapshot.h"
+#include "synthetic_menu.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::LabelScript;
+using testing::SyntheticMenuSpec;
+
+constexpr int32_t kMenuCount = 50;
+
+// What a show hands to the XAML thread (see PendingShow in
+// winui_context_menu.cpp).
+struct ShowRequest {
+  MenuSnapshotPtr snapshot;
+};
+
+// One application's set of menus: a tray menu, per-document and per-row
+// context menus of differing sizes, each with its own style.
+struct Inputs {
+  std::vector<std::string> handles;
+  std::vector<flutter::EncodableMap> json;
+  std::vector<flutter::EncodableMap> styles;
+  size_t total_bytes = 0;
+};
+
+const Inputs& Get(std::optional<Inputs>& inputs) {
+  if (!inputs) {
+    Inputs made;
+    MenuRegistry probe(SIZE_MAX);
+    for (int32_t i = 0; i < kMenuCount; ++i) {
+      SyntheticMenuSpec spec;
+      spec.item_count = 20 + (i % 5) * 40;
+      spec.depth = i % 3;
+      spec.width = 8;
+      spec.label_length = 16;
+      spec.script = i % 2 ? LabelScript::kMixed : LabelScript::kLatin;
+      spec.seed = static_cast<uint32_t>(i + 1);
+      made.handles.push_back("menu" + std::to_string(i));
+      made.json.push_back(testing::GenerateSyntheticMenu(spec));
+      flutter::EncodableMap style;
+      style[flutter::EncodableValue("fontSize")] =
+          flutter::EncodableValue(12.0 + i % 4);
+      style[flutter::EncodableValue("textColor")] =
+          flutter::EncodableValue(int64_t{0xFF000000} + i);
+      made.styles.push_back(style);
+      probe.Register(made.handles.back(),
+                     MakeMenuSnapshot(CompileMenu(made.json.back()), style));
+    }
+    made.total_bytes = probe.used_bytes();
+    inputs = std::move(made);
+  }
+  return *inputs;
+}
+
+struct State {
+  std::optional<Inputs> inputs;
+  std::unique_ptr<MenuRegistry> registry;
+  int32_t next = 0;
+};
+
+// Registers all menus on the warm-up run; budget_share of the total bytes
+// (1 or more keeps them all).
+MenuRegistry& GetRegistry(State& state, double budget_share) {
+  const Inputs& inputs = Get(state.inputs);
+  if (!state.registry) {
+    state.registry = std::make_unique<MenuRegistry>(
+        static_cast<size_t>(inputs.total_bytes * budget_share));
+    for (int32_t i = 0; i < kMenuCount; ++i) {
+      state.registry->Register(
+          inputs.handles[i],
+          MakeMenuSnapshot(CompileMenu(inputs.json[i]), inputs.styles[i]));
+    }
+  }
+  return *state.registry;
+}
+
+// Showing each of 50 menus in turn:
+//   switch            registry lookup by handle; the show shares the snapshot
+//   switch_recompile  the single-menu path: setContextMenu compiles the
+//                     menu from the method channel map before every show
+//   switch_evicting   registry with a budget for a fifth of the menus; shows
+//                     in round-robin order always miss, so each is compiled
+//                     and registered again (worst case)
+const bool kRegistered = [] {
+  auto registered = std::make_shared<State>();
+  bench::Register("menu_registry/switch/50", 1, [registered] {
+    MenuRegistry& registry = GetRegistry(*registered, 2.0);
+    const Inputs& inputs = *registered->inputs;
+    const RegisteredMenu* entry =
+        registry.Use(inputs.handles[registered->next++ % kMenuCount]);
+    ShowRequest show{entry->snapshot};
+    bench::DoNotOptimize(show);
+  });
+
+  auto recompile = std::make_shared<State>();
+  bench::Register("menu_registry/switch_recompile/50", 1, [recompile] {
+    const Inputs& inputs = Get(recompile->inputs);
+    const int32_t i = recompile->next++ % kMenuCount;
+    ShowRequest show{
+        MakeMenuSnapshot(CompileMenu(inputs.json[i]), inputs.styles[i])};
+    bench::DoNotOptimize(show);
+  });
+
+  auto evicting = std::make_shared<State>();
+  bench::Register("menu_registry/switch_evicting/50", 1, [evicting] {
+    MenuRegistry& registry = GetRegistry(*evicting, 0.2);
+    const Inputs& inputs = *evicting->inputs;
+    const int32_t i = evicting->next++ % kMenuCount;
+    const RegisteredMenu* entry = registry.Use(inputs.handles[i]);
+    if (!entry) {
+      entry = &registry.Register(
+          inputs.handles[i],
+          MakeMenuSnapshot(CompileMenu(inputs.json[i]), inputs.styles[i]));
+    }
+    ShowRequest show{entry->snapshot};
+    bench::DoNotOptimize(show);
+  });
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
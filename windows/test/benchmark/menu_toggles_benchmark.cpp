@@ -0,0 +1,107 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "menu_model.h"
+#include "menu_snapshot.h"
+#include "menu_toggles.h"
+#include "recording_menu_backend.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::HeadlessContextMenu;
+
+// A root list of radio items in one group, the first one checked.
+flutter::EncodableMap MakeRadioGroup(int32_t size) {
+  flutter::EncodableList items;
+  for (int32_t id = 1; id <= size; ++id) {
+    flutter::EncodableMap item;
+    item[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
+    item[flutter::EncodableValue("type")] = flutter::EncodableValue("radio");
+    item[flutter::EncodableValue("label")] =
+        flutter::EncodableValue("Option " + std::to_string(id));
+    item[flutter::EncodableValue("radioGroup")] =
+        flutter::EncodableValue("group");
+    item[flutter::EncodableValue("checked")] = flutter::EncodableValue(id == 1);
+    items.emplace_back(std::move(item));
+  }
+  flutter::EncodableMap menu;
+  menu[flutter::EncodableValue("items")] =
+      flutter::EncodableValue(std::move(items));
+  return menu;
+}
+
+// Paging off, so that every option has an item a click can reach.
+flutter::EncodableMap Unpaged() {
+  flutter::EncodableMap style;
+  style[flutter::EncodableValue("virtualizationThreshold")] =
+      flutter::EncodableValue(int32_t{0});
+  return style;
+}
+
+// Selecting another radio item of a group of size, as the user clicks
+// through it:
+//   select          MenuToggleState::Toggle alone
+//   click           the click handler: toggle, set the clicked and the
+//                   unchecked item in place, make the event
+//   resend_resync   the round trip this replaces, native part: Dart flips
+//                   the items and resends the menu, which is compiled and
+//                   synced into the open flyout's items
+const bool kRegistered = [] {
+  for (int32_t size : {10, 1000}) {
+    auto json = std::make_shared<flutter::EncodableMap>(MakeRadioGroup(size));
+    const std::string suffix = "/" + std::to_string(size);
+
+    auto menu = std::make_shared<CompiledMenu>(CompileMenu(*json));
+    auto next = std::make_shared<uint32_t>(0);
+    bench::Register("menu_toggles/select" + suffix, 1, [menu, next, size] {
+      *next = (*next + 7) % static_cast<uint32_t>(size);
+      MenuToggleResult result = menu->toggles().Toggle(*menu, *next);
+      bench::DoNotOptimize(result);
+    });
+
+    auto clicking = std::make_shared<HeadlessContextMenu>();
+    clicking->backend().set_logging(false);
+    auto click_id = std::make_shared<int32_t>(0);
+    bench::Register(
+        "menu_toggles/click" + suffix, 1, [clicking, json, click_id, size] {
+          if (!clicking->backend().is_open()) {
+            clicking->Show(MakeMenuSnapshot(CompileMenu(*json), Unpaged()));
+          }
+          *click_id = (*click_id + 7) % size;
+          bool clicked = clicking->Click(*click_id + 1);
+          bench::DoNotOptimize(clicked);
+        });
+
+    auto resending = std::make_shared<HeadlessContextMenu>();
+    resending->backend().set_logging(false);
+    auto resend_json =
+        std::make_shared<flutter::EncodableMap>(MakeRadioGroup(size));
+    auto checked = std::make_shared<int32_t>(0);
+    bench::Register(
+        "menu_toggles/resend_resync" + suffix, 1,
+        [resending, resend_json, checked, size] {
+          auto& items = std::get<flutter::EncodableList>(
+              resend_json->at(flutter::EncodableValue("items")));
+          auto set = [&items](int32_t index, bool value) {
+            std::get<flutter::EncodableMap>(items[index])
+                [flutter::EncodableValue("checked")] =
+                    flutter::EncodableValue(value);
+          };
+          set(*checked, false);
+          *checked = (*checked + 7) % size;
+          set(*checked, true);
+          bool shown = resending->Show(
+              MakeMenuSnapshot(CompileMenu(*resend_json), Unpaged()));
+          resending->Close();
+          bench::DoNotOptimize(shown);
+        });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
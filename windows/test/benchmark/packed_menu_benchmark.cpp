@@ -0,0 +1,249 @@
+#include "benchmark.h"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "menu_fixtures.h"
+#include "menu_model.h"
+#include "packed_menu.h"
+#include "packed_menu_writer.h"
+
+namespace tray_manager_winui {
+namespace {
+
+// Reference implementation of the StandardMessageCodec wire format for the
+// value types a setContextMenu call uses. The client wrapper's codec is not
+// part of the header-only dependency of this project, so the baseline is
+// reimplemented here; it does the same per-value work (a tag switch, a size
+// read, a std::string or container per node).
+class CodecWriter {
+ public:
+  void Value(const flutter::EncodableValue& value) {
+    if (std::holds_alternative<std::monostate>(value)) {
+      out_.push_back(0);
+    } else if (const auto* b = std::get_if<bool>(&value)) {
+      out_.push_back(*b ? 1 : 2);
+    } else if (const auto* i = std::get_if<int32_t>(&value)) {
+      out_.push_back(3);
+      Raw(i, 4);
+    } else if (const auto* l = std::get_if<int64_t>(&value)) {
+      out_.push_back(4);
+      Raw(l, 8);
+    } else if (const auto* d = std::get_if<double>(&value)) {
+      out_.push_back(6);
+      while (out_.size() % 8) out_.push_back(0);
+      Raw(d, 8);
+    } else if (const auto* s = std::get_if<std::string>(&value)) {
+      out_.push_back(7);
+      Size(s->size());
+      Raw(s->data(), s->size());
+    } else if (const auto* list = std::get_if<flutter::EncodableList>(&value)) {
+      out_.push_back(12);
+      Size(list->size());
+      for (const auto& item : *list) Value(item);
+    } else if (const auto* map = std::get_if<flutter::EncodableMap>(&value)) {
+      out_.push_back(13);
+      Size(map->size());
+      for (const auto& [k, v] : *map) {
+        Value(k);
+        Value(v);
+      }
+    } else {
+      throw std::logic_error("unsupported value");
+    }
+  }
+
+  std::vector<uint8_t>& out() { return out_; }
+
+ private:
+  void Raw(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    out_.insert(out_.end(), bytes, bytes + size);
+  }
+  void Size(size_t size) {
+    if (size < 254) {
+      out_.push_back(static_cast<uint8_t>(size));
+    } else if (size <= 0xFFFF) {
+      out_.push_back(254);
+      const auto value = static_cast<uint16_t>(size);
+      Raw(&value, 2);
+    } else {
+      out_.push_back(255);
+      const auto value = static_cast<uint32_t>(size);
+      Raw(&value, 4);
+    }
+  }
+
+  std::vector<uint8_t> out_;
+};
+
+class CodecReader {
+ public:
+  CodecReader(const uint8_t* data, size_t size)
+      : data_(data), size_(size) {}
+
+  flutter::EncodableValue Value() {
+    switch (Byte()) {
+      case 0:
+        return flutter::EncodableValue();
+      case 1:
+        return flutter::EncodableValue(true);
+      case 2:
+        return flutter::EncodableValue(false);
+      case 3: {
+        int32_t value;
+        Raw(&value, 4);
+        return flutter::EncodableValue(value);
+      }
+      case 4: {
+        int64_t value;
+        Raw(&value, 8);
+        return flutter::EncodableValue(value);
+      }
+      case 6: {
+        pos_ = (pos_ + 7) & ~size_t{7};
+        double value;
+        Raw(&value, 8);
+        return flutter::EncodableValue(value);
+      }
+      case 7: {
+        const size_t size = Size();
+        Check(size);
+        std::string value(reinterpret_cast<const char*>(data_ + pos_), size);
+        pos_ += size;
+        return flutter::EncodableValue(std::move(value));
+      }
+      case 12: {
+        flutter::EncodableList list;
+        const size_t size = Size();
+        list.reserve(size);
+        for (size_t i = 0; i < size; ++i) list.push_back(Value());
+        return flutter::EncodableValue(std::move(list));
+      }
+      case 13: {
+        flutter::EncodableMap map;
+        const size_t size = Size();
+        for (size_t i = 0; i < size; ++i) {
+          flutter::EncodableValue key = Value();
+          map.emplace(std::move(key), Value());
+        }
+        return flutter::EncodableValue(std::move(map));
+      }
+    }
+    throw std::runtime_error("bad tag");
+  }
+
+ private:
+  void Check(size_t size) {
+    if (size > size_ - pos_) throw std::runtime_error("truncated");
+  }
+  uint8_t Byte() {
+    Check(1);
+    return data_[pos_++];
+  }
+  void Raw(void* out, size_t size) {
+    Check(size);
+    std::memcpy(out, data_ + pos_, size);
+    pos_ += size;
+  }
+  size_t Size() {
+    const uint8_t first = Byte();
+    if (first < 254) return first;
+    if (first == 254) {
+      uint16_t value;
+      Raw(&value, 2);
+      return value;
+    }
+    uint32_t value;
+    Raw(&value, 4);
+    return value;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+flutter::EncodableMap BenchStyle() {
+  flutter::EncodableMap padding;
+  for (const char* side : {"left", "top", "right", "bottom"}) {
+    padding[flutter::EncodableValue(side)] = flutter::EncodableValue(4.0);
+  }
+  flutter::EncodableMap style;
+  style[flutter::EncodableValue("compactItemLayout")] =
+      flutter::EncodableValue(true);
+  style[flutter::EncodableValue("fontFamily")] =
+      flutter::EncodableValue("Segoe UI Variable");
+  style[flutter::EncodableValue("fontSize")] = flutter::EncodableValue(13.0);
+  style[flutter::EncodableValue("fontWeight")] = flutter::EncodableValue(400);
+  style[flutter::EncodableValue("maxHeight")] = flutter::EncodableValue(480.0);
+  style[flutter::EncodableValue("backgroundColor")] =
+      flutter::EncodableValue(int64_t{0xFF202020});
+  style[flutter::EncodableValue("textColor")] =
+      flutter::EncodableValue(int64_t{0xFFEEEEEE});
+  style[flutter::EncodableValue("padding")] = flutter::EncodableValue(padding);
+  return style;
+}
+
+// What the plugin does with one setContextMenu message, from bytes to the
+// cached CompiledMenu and style map: the method channel decodes the call
+// into EncodableValues and the handler compiles the menu map and copies the
+// style; the packed channel validates the buffer and compiles from the view.
+const bool kRegistered = [] {
+  for (int32_t size : {50, 500, 5000}) {
+    const flutter::EncodableMap menu_map =
+        testing::MakeSyntheticMenu(size, size / 10);
+    const flutter::EncodableMap style = BenchStyle();
+    const std::string suffix = "/" + std::to_string(size);
+
+    flutter::EncodableMap args;
+    args[flutter::EncodableValue("menu")] = flutter::EncodableValue(menu_map);
+    args[flutter::EncodableValue("style")] = flutter::EncodableValue(style);
+    CodecWriter writer;
+    writer.Value(flutter::EncodableValue("setContextMenu"));
+    writer.Value(flutter::EncodableValue(args));
+    auto codec = std::make_shared<std::vector<uint8_t>>(
+        std::move(writer.out()));
+    auto packed = std::make_shared<std::vector<uint8_t>>(
+        testing::PackMenu(CompileMenu(menu_map), style));
+
+    bench::Register("packed_menu/standard_codec" + suffix, size, [codec] {
+      CodecReader reader(codec->data(), codec->size());
+      flutter::EncodableValue method = reader.Value();
+      flutter::EncodableValue call = reader.Value();
+      const auto& call_args = std::get<flutter::EncodableMap>(call);
+      CompiledMenu menu = CompileMenu(std::get<flutter::EncodableMap>(
+          call_args.at(flutter::EncodableValue("menu"))));
+      flutter::EncodableMap cached_style = std::get<flutter::EncodableMap>(
+          call_args.at(flutter::EncodableValue("style")));
+      bench::DoNotOptimize(method);
+      bench::DoNotOptimize(menu);
+      bench::DoNotOptimize(cached_style);
+    });
+
+    bench::Register("packed_menu/packed" + suffix, size, [packed] {
+      PackedMenuView view;
+      if (view.Open(packed->data(), packed->size()) !=
+          PackedMenuError::kNone) {
+        throw std::logic_error("packed buffer rejected");
+      }
+      CompiledMenu menu = CompileMenu(view);
+      flutter::EncodableMap cached_style = DecodePackedStyle(view);
+      bench::DoNotOptimize(menu);
+      bench::DoNotOptimize(cached_style);
+    });
+
+    bench::Register("packed_menu/open_only" + suffix, size, [packed] {
+      PackedMenuView view;
+      PackedMenuError error = view.Open(packed->data(), packed->size());
+      bench::DoNotOptimize(error);
+    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,63 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+
+#include "span_trace.h"
+
+namespace tray_manager_winui {
+namespace {
+
+// Per-span cost of the show-pipeline instrumentation: the budget is 50 ns
+// per span while tracing is on.
+const bool kRegistered = [] {
+  constexpr int64_t kSpans = 1000;
+  auto enabled = std::make_shared<SpanTrace>();
+  enabled->set_enabled(true);
+  auto disabled = std::make_shared<SpanTrace>();
+
+  bench::Register("span_trace/scoped/enabled", kSpans, [enabled] {
+    for (int64_t i = 0; i < kSpans; ++i) {
+      ScopedSpan span("CreateHost", *enabled);
+    }
+  });
+  bench::Register("span_trace/scoped/disabled", kSpans, [disabled] {
+    for (int64_t i = 0; i < kSpans; ++i) {
+      ScopedSpan span("CreateHost", *disabled);
+    }
+  });
+  // Spans between two callbacks: one timestamp read at each end.
+  bench::Register("span_trace/record/enabled", kSpans, [enabled] {
+    const uint64_t start = SpanTrace::Now();
+    for (int64_t i = 0; i < kSpans; ++i) {
+      enabled->Record("ShowAt->Opened", start, SpanTrace::Now());
+    }
+  });
+  bench::Register("span_trace/clock/steady", kSpans, [] {
+    for (int64_t i = 0; i < kSpans; ++i) {
+      bench::DoNotOptimize(SpanTrace::NowNs());
+    }
+  });
+  bench::Register("span_trace/clock/trace_ticks", kSpans, [] {
+    for (int64_t i = 0; i < kSpans; ++i) {
+      bench::DoNotOptimize(SpanTrace::Now());
+    }
+  });
+
+  // Dumping a full ring through getTrace.
+  auto full = std::make_shared<SpanTrace>();
+  full->set_enabled(true);
+  for (size_t i = 0; i < full->capacity(); ++i) {
+    const uint64_t start = SpanTrace::Now();
+    full->Record("BuildItems", start, start + 700);
+  }
+  bench::Register("span_trace/export_chrome_json/4096",
+                  static_cast<int64_t>(full->capacity()), [full] {
+                    std::string json = ExportChromeTrace(*full);
+                    bench::DoNotOptimize(json);
+                  });
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,121 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "style_values.h"
+
+namespace tray_manager_winui {
+namespace {
+
+// Every key WinUIContextMenuStyle sends, with a value of its type.
+flutter::EncodableMap MakeFullStyle() {
+  flutter::EncodableMap style;
+  for (size_t i = 0; i < kStyleKeyCount; ++i) {
+    const StyleKey key = static_cast<StyleKey>(i);
+    flutter::EncodableValue value(int64_t{0xFF202020});
+    switch (key) {
+      case StyleKey::kFontFamily:
+      case StyleKey::kFontStyle:
+      case StyleKey::kThemeMode:
+      case StyleKey::kBackdropType:
+      case StyleKey::kVirtualizationMoreLabel:
+      case StyleKey::kVirtualizationPreviousLabel:
+        value = flutter::EncodableValue("Segoe UI Variable Display");
+        break;
+      case StyleKey::kCompactItemLayout:
+      case StyleKey::kEnableOpenCloseAnimations:
+      case StyleKey::kDismissOnPointerMoveAway:
+        value = flutter::EncodableValue(true);
+        break;
+      case StyleKey::kPadding: {
+        flutter::EncodableMap padding;
+        for (const char* side : {"left", "top", "right", "bottom"}) {
+          padding[flutter::EncodableValue(side)] = flutter::EncodableValue(4.0);
+        }
+        value = flutter::EncodableValue(padding);
+        break;
+      }
+      case StyleKey::kFontSize:
+      case StyleKey::kCornerRadius:
+      case StyleKey::kMinWidth:
+      case StyleKey::kBorderThickness:
+      case StyleKey::kItemHeight:
+      case StyleKey::kShadowElevation:
+      case StyleKey::kMaxHeight:
+        value = flutter::EncodableValue(14.0);
+        break;
+      default:
+        break;
+    }
+    style[flutter::EncodableValue(std::string(StyleKeyName(key)))] = value;
+  }
+  return style;
+}
+
+// Values an item build reads for every item (font size, height, text and
+// disabled text colour).
+const char* const kItemKeys[] = {"fontSize", "itemHeight", "textColor",
+                                 "disabledTextColor"};
+
+// Matching key names, against the std::map search with a temporary
+// EncodableValue key that every style read used to do; parsing a whole
+// style; and the per-item reads of a 1000-item build either way.
+const bool kRegistered = [] {
+  auto map = std::make_shared<flutter::EncodableMap>(MakeFullStyle());
+  auto names = std::make_shared<std::vector<std::string>>();
+  for (size_t i = 0; i < kStyleKeyCount; ++i) {
+    names->emplace_back(StyleKeyName(static_cast<StyleKey>(i)));
+  }
+  const auto key_count = static_cast<int64_t>(kStyleKeyCount);
+
+  bench::Register("style_values/find_key/perfect_hash", key_count, [names] {
+    unsigned found = 0;
+    for (const std::string& name : *names) {
+      found += FindStyleKey(name).has_value();
+    }
+    bench::DoNotOptimize(found);
+  });
+  bench::Register("style_values/find_key/map", key_count, [map, names] {
+    unsigned found = 0;
+    for (const std::string& name : *names) {
+      found += map->find(flutter::EncodableValue(name.c_str())) != map->end();
+    }
+    bench::DoNotOptimize(found);
+  });
+
+  bench::Register("style_values/resolve/full", key_count, [map] {
+    ResolvedStyle style = ResolveStyle(*map);
+    bench::DoNotOptimize(style);
+  });
+
+  constexpr int64_t kItems = 1000;
+  bench::Register("style_values/item_reads/map", kItems, [map] {
+    double total = 0;
+    for (int64_t item = 0; item < kItems; ++item) {
+      for (const char* key : kItemKeys) {
+        auto it = map->find(flutter::EncodableValue(key));
+        if (it == map->end()) continue;
+        if (const auto* d = std::get_if<double>(&it->second)) total += *d;
+        if (const auto* i = std::get_if<int64_t>(&it->second)) total += *i;
+      }
+    }
+    bench::DoNotOptimize(total);
+  });
+  auto resolved = std::make_shared<ResolvedStyle>(ResolveStyle(*map));
+  bench::Register("style_values/item_reads/resolved", kItems, [resolved] {
+    double total = 0;
+    for (int64_t item = 0; item < kItems; ++item) {
+      const ResolvedStyle& style = *resolved;
+      bench::DoNotOptimize(style);
+      total += style.font_size + style.item_height + style.text_color +
+               style.disabled_text_color;
+    }
+    bench::DoNotOptimize(total);
+  });
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
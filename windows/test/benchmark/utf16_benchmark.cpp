@@ -0,0 +1,76 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+
+#include "menu_fixtures.h"
+#include "menu_model.h"
+#include "utf16.h"
+
+namespace tray_manager_winui {
+namespace {
+
+std::string Repeat(const std::string& piece, size_t bytes) {
+  std::string text;
+  while (text.size() < bytes) text += piece;
+  return text;
+}
+
+// Throughput per input byte. The show path used to size and convert every
+// label with two MultiByteToWideChar calls into a fresh std::wstring;
+// "two_pass" models that with the scalar converter.
+const bool kRegistered = [] {
+  constexpr size_t kBytes = 64 * 1024;
+  const std::pair<const char*, std::string> inputs[] = {
+      {"ascii", Repeat("Recent file 1234.txt ", kBytes)},
+      {"latin", Repeat("Zuletzt ge\xC3\xB6" "ffnet \xC3\xA4\xC3\xBC ", kBytes)},
+      {"cjk", Repeat("\xE6\x9C\x80\xE8\xBF\x91\xE6\x89\x93\xE5\xBC\x80 ",
+                     kBytes)},
+  };
+  for (const auto& [name, text] : inputs) {
+    auto input = std::make_shared<std::string>(text);
+    auto out = std::make_shared<std::u16string>(input->size(), 0);
+    const std::string suffix = std::string("/") + name;
+    const auto bytes = static_cast<int64_t>(input->size());
+
+    bench::Register("utf16/convert" + suffix, bytes, [input, out] {
+      size_t written = Utf8ToUtf16(*input, out->data());
+      bench::DoNotOptimize(written);
+    });
+    bench::Register("utf16/scalar" + suffix, bytes, [input, out] {
+      size_t written = Utf8ToUtf16Scalar(*input, out->data());
+      bench::DoNotOptimize(written);
+    });
+    bench::Register("utf16/two_pass" + suffix, bytes, [input, out] {
+      std::u16string result(Utf8ToUtf16Scalar(*input, out->data()), 0);
+      Utf8ToUtf16Scalar(*input, result.data());
+      bench::DoNotOptimize(result);
+    });
+  }
+
+  // Converting all strings of a menu once at compile time, against the
+  // per-show conversion of each label it replaces.
+  for (int32_t size : {100, 1000, 10000}) {
+    auto menu = std::make_shared<CompiledMenu>(
+        CompileMenu(testing::MakeSyntheticMenu(size, 20)));
+    const std::string suffix = "/" + std::to_string(size);
+    bench::Register("utf16/per_show_labels" + suffix, size, [menu] {
+      size_t total = 0;
+      for (const MenuNode& node : menu->nodes()) {
+        total += Utf8ToUtf16(menu->str(node.label)).size();
+      }
+      bench::DoNotOptimize(total);
+    });
+    bench::Register("utf16/pre_converted_labels" + suffix, size, [menu] {
+      size_t total = 0;
+      for (const MenuNode& node : menu->nodes()) {
+        total += menu->text(node.label).utf16.size();
+      }
+      bench::DoNotOptimize(total);
+    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,145 @@
+#include "benchmark.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "xaml_writer.h"
+
+namespace tray_manager_winui {
+namespace {
+
+std::wstring AsciiToWide(std::string_view utf8) {
+  return std::wstring(utf8.begin(), utf8.end());
+}
+
+void Set(flutter::EncodableMap& style, const char* key,
+         flutter::EncodableValue value) {
+  style[flutter::EncodableValue(key)] = std::move(value);
+}
+
+// Roughly what WinUIContextMenuStyle produces for a themed dark menu.
+flutter::EncodableMap MakeTypicalStyle() {
+  flutter::EncodableMap style;
+  Set(style, "backgroundColor", flutter::EncodableValue(int64_t{0xFF202020}));
+  Set(style, "textColor", flutter::EncodableValue(int64_t{0xFFF0F0F0}));
+  Set(style, "hoverBackgroundColor",
+      flutter::EncodableValue(int64_t{0xFF404040}));
+  Set(style, "fontSize", flutter::EncodableValue(14.0));
+  Set(style, "cornerRadius", flutter::EncodableValue(8.0));
+  Set(style, "themeMode", flutter::EncodableValue("dark"));
+  return style;
+}
+
+// Every key the presenter generator reads.
+flutter::EncodableMap MakeFullStyle() {
+  flutter::EncodableMap style = MakeTypicalStyle();
+  Set(style, "separatorColor", flutter::EncodableValue(int64_t{0x33FFFFFF}));
+  Set(style, "disabledTextColor", flutter::EncodableValue(int64_t{0x7F808080}));
+  Set(style, "subMenuOpenedBackgroundColor",
+      flutter::EncodableValue(int64_t{0xFF303030}));
+  Set(style, "subMenuOpenedTextColor",
+      flutter::EncodableValue(int64_t{0xFFFFFFFF}));
+  Set(style, "checkedForegroundColor",
+      flutter::EncodableValue(int64_t{0xFF60CDFF}));
+  Set(style, "checkedBackgroundColor",
+      flutter::EncodableValue(int64_t{0xFF2B2B2B}));
+  Set(style, "keyboardAcceleratorColor",
+      flutter::EncodableValue(int64_t{0xFFAAAAAA}));
+  Set(style, "checkedIndicatorColor",
+      flutter::EncodableValue(int64_t{0xFF0078D4}));
+  Set(style, "fontFamily", flutter::EncodableValue("Segoe UI Variable"));
+  Set(style, "fontWeight", flutter::EncodableValue(int32_t{600}));
+  flutter::EncodableMap padding;
+  Set(padding, "left", flutter::EncodableValue(4.0));
+  Set(padding, "top", flutter::EncodableValue(4.0));
+  Set(padding, "right", flutter::EncodableValue(4.0));
+  Set(padding, "bottom", flutter::EncodableValue(4.0));
+  Set(style, "padding", flutter::EncodableValue(padding));
+  Set(style, "minWidth", flutter::EncodableValue(200.0));
+  Set(style, "borderColor", flutter::EncodableValue(int64_t{0xFF101010}));
+  Set(style, "borderThickness", flutter::EncodableValue(1.0));
+  Set(style, "fontStyle", flutter::EncodableValue("normal"));
+  Set(style, "shadowElevation", flutter::EncodableValue(0.0));
+  Set(style, "maxHeight", flutter::EncodableValue(600.0));
+  return style;
+}
+
+// The escaper before the vector scan: one character at a time into a
+// growing string.
+std::wstring LegacyEscapeAttribute(const std::wstring& input) {
+  std::wstring result;
+  result.reserve(input.size() + input.size() / 4);
+  for (wchar_t c : input) {
+    switch (c) {
+      case L'&': result += L"&amp;"; break;
+      case L'<': result += L"&lt;"; break;
+      case L'>': result += L"&gt;"; break;
+      case L'"': result += L"&quot;"; break;
+      case L'\'': result += L"&apos;"; break;
+      default: result += c; break;
+    }
+  }
+  return result;
+}
+
+std::wstring EveryNth(size_t size, size_t n, wchar_t special) {
+  std::wstring text;
+  for (size_t i = 0; i < size; ++i) {
+    text += i % n == n - 1 ? special : static_cast<wchar_t>(L'a' + i % 26);
+  }
+  return text;
+}
+
+const bool kRegistered = [] {
+  auto typical =
+      std::make_shared<ResolvedStyle>(ResolveStyle(MakeTypicalStyle()));
+  auto full = std::make_shared<ResolvedStyle>(ResolveStyle(MakeFullStyle()));
+
+  bench::Register("xaml_writer/presenter/typical", 1, [typical] {
+    std::wstring xaml = BuildPresenterStyleXaml(*typical, AsciiToWide);
+    bench::DoNotOptimize(xaml);
+  });
+  bench::Register("xaml_writer/presenter/full", 1, [full] {
+    std::wstring xaml = BuildPresenterStyleXaml(*full, AsciiToWide);
+    bench::DoNotOptimize(xaml);
+  });
+  bench::Register("xaml_writer/compact_items/default", 3, [] {
+    CompactItemStylesXaml xaml = BuildCompactItemStylesXaml(ResolvedStyle());
+    bench::DoNotOptimize(xaml);
+  });
+  bench::Register("xaml_writer/compact_items/full", 3, [full] {
+    CompactItemStylesXaml xaml = BuildCompactItemStylesXaml(*full);
+    bench::DoNotOptimize(xaml);
+  });
+
+  // Items are code units. font_family and label are typical inputs; clean,
+  // sparse (one '&' in 64) and worst (all '<') are 4096 units long.
+  const std::pair<const char*, std::wstring> inputs[] = {
+      {"font_family", L"Segoe UI Variable Display"},
+      {"label", L"Open recent project in a new window"},
+      {"clean", EveryNth(4096, 4097, L'&')},
+      {"sparse", EveryNth(4096, 64, L'&')},
+      {"worst", std::wstring(4096, L'<')},
+  };
+  for (const auto& [name, text] : inputs) {
+    auto input = std::make_shared<std::wstring>(text);
+    auto buffer = std::make_shared<std::wstring>();
+    const auto units = static_cast<int64_t>(input->size());
+    bench::Register(std::string("xaml_writer/escape/") + name, units,
+                    [input, buffer] {
+                      std::wstring_view escaped =
+                          XamlEscapeAttribute(*input, *buffer);
+                      bench::DoNotOptimize(escaped);
+                    });
+    bench::Register(std::string("xaml_writer/escape_legacy/") + name, units,
+                    [input] {
+                      std::wstring escaped = LegacyEscapeAttribute(*input);
+                      bench::DoNotOptimize(escaped);
+                    });
+  }
+  return true;
+}();
+
+}  // namespace
+}  // namespace tray_manager_winui
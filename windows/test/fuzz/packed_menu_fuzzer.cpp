@@ -0,0 +1,24 @@
+// libFuzzer target for the packed menu decoder. Anything Open accepts must
+// be safe to compile and decode; ASan/UBSan catch the rest.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "packed_menu.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  using namespace tray_manager_winui;
+  PackedMenuView view;
+  if (view.Open(data, size) != PackedMenuError::kNone) return 0;
+  const CompiledMenu menu = CompileMenu(view);
+  size_t total = 0;
+  for (const MenuNode& node : menu.nodes()) {
+    for (StringId id : {node.label, node.icon, node.icon_font_family,
+                        node.accelerator_text, node.tool_tip,
+                        node.radio_group}) {
+      total += menu.str(id).size();
+    }
+  }
+  total += DecodePackedStyle(view).size();
+  return total == SIZE_MAX ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+// libFuzzer target comparing XamlEscapeAttribute with the original
+// one-character-at-a-time escaper on arbitrary code units.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "xaml_writer.h"
+
+namespace {
+
+std::wstring ReferenceEscape(const std::wstring& input) {
+  std::wstring result;
+  for (wchar_t c : input) {
+    switch (c) {
+      case L'&': result += L"&amp;"; break;
+      case L'<': result += L"&lt;"; break;
+      case L'>': result += L"&gt;"; break;
+      case L'"': result += L"&quot;"; break;
+      case L'\'': result += L"&apos;"; break;
+      default: result += c; break;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  std::wstring input(size / sizeof(wchar_t), L'\0');
+  std::memcpy(input.data(), data, input.size() * sizeof(wchar_t));
+  std::wstring buffer;
+  const std::wstring_view escaped =
+      tray_manager_winui::XamlEscapeAttribute(input, buffer);
+  if (escaped != ReferenceEscape(input)) std::abort();
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "lazy_submenus.h"
+
+#include <gtest/gtest.h>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeSubmenu;
+
+// Nodes: 0 Open, 1 Recent, 2 Split | 3 a.txt, 4 Older | 5 b.txt | 6 Child
+CompiledMenu NestedMenu() {
+  return CompileMenu(MakeMenu({
+      MakeItem(1, "normal", "Open"),
+      MakeSubmenu(2, "Recent", {MakeItem(3, "normal", "a.txt"),
+                                MakeSubmenu(4, "Older", {
+                                    MakeItem(5, "normal", "b.txt")})}),
+      [] {
+        auto split = MakeSubmenu(6, "Split", {MakeItem(7, "normal", "Child")});
+        split[flutter::EncodableValue("type")] = flutter::EncodableValue("split");
+        return split;
+      }(),
+  }));
+}
+
+TEST(LazySubmenuTrackerTest, StartsWithEverySubmenuPending) {
+  LazySubmenuTracker tracker;
+  tracker.Reset(NestedMenu());
+  EXPECT_EQ(tracker.pending_count(), 3u);
+  EXPECT_EQ(tracker.built_count(), 0u);
+  EXPECT_FALSE(tracker.IsPending(0));
+  EXPECT_TRUE(tracker.IsPending(1));
+  EXPECT_TRUE(tracker.IsPending(2));
+  EXPECT_TRUE(tracker.IsPending(4));
+  EXPECT_FALSE(tracker.IsPending(99));
+}
+
+TEST(LazySubmenuTrackerTest, ChildrenMaterializeWithTheirParent) {
+  LazySubmenuTracker tracker;
+  tracker.Reset(NestedMenu());
+  EXPECT_TRUE(tracker.IsMaterialized(0));
+  EXPECT_TRUE(tracker.IsMaterialized(2));
+  EXPECT_FALSE(tracker.IsMaterialized(3));
+  EXPECT_FALSE(tracker.IsMaterialized(6));
+
+  EXPECT_TRUE(tracker.MarkBuilt(1));
+  EXPECT_TRUE(tracker.IsMaterialized(3));
+  EXPECT_TRUE(tracker.IsMaterialized(4));
+  EXPECT_FALSE(tracker.IsMaterialized(5));
+  EXPECT_FALSE(tracker.IsMaterialized(6));
+
+  EXPECT_TRUE(tracker.MarkBuilt(4));
+  EXPECT_TRUE(tracker.IsMaterialized(5));
+  EXPECT_FALSE(tracker.IsMaterialized(6));
+  EXPECT_EQ(tracker.pending_count(), 1u);
+  EXPECT_EQ(tracker.built_count(), 2u);
+}
+
+TEST(LazySubmenuTrackerTest, BuildsEachSubmenuOnce) {
+  LazySubmenuTracker tracker;
+  tracker.Reset(NestedMenu());
+  EXPECT_TRUE(tracker.MarkBuilt(2));
+  EXPECT_FALSE(tracker.MarkBuilt(2));
+  EXPECT_FALSE(tracker.MarkBuilt(0));   // Not a submenu.
+  EXPECT_FALSE(tracker.MarkBuilt(99));  // Out of range.
+  EXPECT_EQ(tracker.built_count(), 1u);
+}
+
+TEST(LazySubmenuTrackerTest, UnbuiltSubmenusArePendingAgain) {
+  LazySubmenuTracker tracker;
+  tracker.Reset(NestedMenu());
+  EXPECT_EQ(tracker.parent(3), 1u);
+  EXPECT_EQ(tracker.parent(0), LazySubmenuTracker::kNoParent);
+  EXPECT_FALSE(tracker.MarkUnbuilt(1));  // Still pending.
+  tracker.MarkBuilt(1);
+  EXPECT_TRUE(tracker.MarkUnbuilt(1));
+  EXPECT_FALSE(tracker.IsMaterialized(3));
+  EXPECT_EQ(tracker.pending_count(), 3u);
+  EXPECT_TRUE(tracker.MarkBuilt(1));
+}
+
+TEST(LazySubmenuTrackerTest, ResetAndClearStartOver) {
+  LazySubmenuTracker tracker;
+  CompiledMenu menu = NestedMenu();
+  tracker.Reset(menu);
+  tracker.MarkBuilt(1);
+  tracker.Reset(menu);
+  EXPECT_TRUE(tracker.IsPending(1));
+  EXPECT_EQ(tracker.built_count(), 0u);
+
+  tracker.Clear();
+  EXPECT_FALSE(tracker.IsPending(1));
+  EXPECT_FALSE(tracker.IsMaterialized(0));
+  EXPECT_EQ(tracker.pending_count(), 0u);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
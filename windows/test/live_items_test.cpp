@@ -0,0 +1,429 @@
+#include "live_items.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tray_manager_winui {
+namespace {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+LiveItemUpdate Label(int32_t id, std::string label) {
+  LiveItemUpdate update;
+  update.id = id;
+  update.label = std::move(label);
+  return update;
+}
+
+LiveItemUpdate Disabled(int32_t id, bool disabled) {
+  LiveItemUpdate update;
+  update.id = id;
+  update.disabled = disabled;
+  return update;
+}
+
+std::vector<LiveItemUpdate> DrainAll(LiveItemCoalescer& coalescer) {
+  std::vector<LiveItemUpdate> updates;
+  coalescer.Drain(
+      [&updates](const LiveItemUpdate& u) { updates.push_back(u); });
+  return updates;
+}
+
+flutter::EncodableValue Entry(
+    std::initializer_list<std::pair<const char*, flutter::EncodableValue>>
+        fields) {
+  flutter::EncodableMap map;
+  for (const auto& [key, value] : fields) {
+    map[flutter::EncodableValue(key)] = value;
+  }
+  return flutter::EncodableValue(map);
+}
+
+TEST(LiveItemsTest, ParsesUpdates) {
+  LiveItemUpdate update;
+  ASSERT_TRUE(ParseLiveItemUpdate(
+      Entry({{"id", flutter::EncodableValue(7)},
+             {"label", flutter::EncodableValue("Upload 42%")},
+             {"icon", flutter::EncodableValue("0xE898")},
+             {"disabled", flutter::EncodableValue(true)}}),
+      &update));
+  EXPECT_EQ(update.id, 7);
+  EXPECT_EQ(update.label, std::optional<std::string>("Upload 42%"));
+  EXPECT_EQ(update.icon, std::optional<std::string>("0xE898"));
+  EXPECT_EQ(update.disabled, std::optional<bool>(true));
+
+  ASSERT_TRUE(
+      ParseLiveItemUpdate(Entry({{"id", flutter::EncodableValue(8)}}), &update));
+  EXPECT_EQ(update.id, 8);
+  EXPECT_TRUE(update.empty());
+
+  EXPECT_FALSE(ParseLiveItemUpdate(flutter::EncodableValue(7), &update));
+  EXPECT_FALSE(ParseLiveItemUpdate(
+      Entry({{"label", flutter::EncodableValue("x")}}), &update));
+  EXPECT_FALSE(ParseLiveItemUpdate(
+      Entry({{"id", flutter::EncodableValue(1)},
+             {"label", flutter::EncodableValue(3)}}),
+      &update));
+  EXPECT_FALSE(ParseLiveItemUpdate(
+      Entry({{"id", flutter::EncodableValue(1)},
+             {"disabled", flutter::EncodableValue("yes")}}),
+      &update));
+}
+
+TEST(LiveItemsTest, LatestValueWinsPerItemAndField) {
+  LiveItemCoalescer coalescer;
+  EXPECT_EQ(coalescer.Push(Label(1, "10%")), LiveItemPush::kQueuedWake);
+  EXPECT_EQ(coalescer.Push(Label(1, "20%")), LiveItemPush::kQueued);
+  EXPECT_EQ(coalescer.Push(Disabled(1, true)), LiveItemPush::kQueued);
+  EXPECT_EQ(coalescer.Push(Label(2, "Online")), LiveItemPush::kQueued);
+  EXPECT_EQ(coalescer.Push(Label(1, "30%")), LiveItemPush::kQueued);
+
+  std::vector<LiveItemUpdate> updates = DrainAll(coalescer);
+  ASSERT_EQ(updates.size(), 2u);
+  // Most recently queued first; the order of different items is not kept.
+  EXPECT_EQ(updates[0].id, 2);
+  EXPECT_EQ(updates[0].label, std::optional<std::string>("Online"));
+  EXPECT_FALSE(updates[0].disabled);
+  EXPECT_EQ(updates[1].id, 1);
+  EXPECT_EQ(updates[1].label, std::optional<std::string>("30%"));
+  EXPECT_EQ(updates[1].disabled, std::optional<bool>(true));
+  EXPECT_FALSE(updates[1].icon);
+
+  // Taken: the next drain only sees newer values, and wakes again.
+  EXPECT_TRUE(DrainAll(coalescer).empty());
+  EXPECT_EQ(coalescer.Push(Disabled(1, false)), LiveItemPush::kQueuedWake);
+  updates = DrainAll(coalescer);
+  ASSERT_EQ(updates.size(), 1u);
+  EXPECT_FALSE(updates[0].label);
+  EXPECT_EQ(updates[0].disabled, std::optional<bool>(false));
+}
+
+TEST(LiveItemsTest, EmptyUpdatesWakeWithoutReachingTheConsumer) {
+  LiveItemCoalescer coalescer;
+  LiveItemUpdate empty;
+  empty.id = 3;
+  EXPECT_EQ(coalescer.Push(empty), LiveItemPush::kQueuedWake);
+  EXPECT_EQ(coalescer.Drain([](const LiveItemUpdate&) {}), 0u);
+}
+
+TEST(LiveItemsTest, CancelledWakeIsRetriedByTheNextPush) {
+  LiveItemCoalescer coalescer;
+  ASSERT_EQ(coalescer.Push(Label(1, "a")), LiveItemPush::kQueuedWake);
+  coalescer.CancelWake();  // As if the flush could not be posted.
+  EXPECT_EQ(coalescer.Push(Label(2, "b")), LiveItemPush::kQueuedWake);
+  EXPECT_EQ(DrainAll(coalescer).size(), 2u);
+}
+
+TEST(LiveItemsTest, CountsIdsBeyondCapacityAsOverflow) {
+  LiveItemCoalescer coalescer(4);
+  EXPECT_EQ(coalescer.capacity(), 4u);
+  for (int32_t id = 1; id <= 4; ++id) {
+    EXPECT_NE(coalescer.Push(Label(id, "x")), LiveItemPush::kOverflow);
+  }
+  EXPECT_EQ(coalescer.Push(Label(5, "x")), LiveItemPush::kOverflow);
+  EXPECT_EQ(coalescer.overflow_count(), 1u);
+  // A drain frees the slots for other ids.
+  EXPECT_EQ(DrainAll(coalescer).size(), 4u);
+  EXPECT_NE(coalescer.Push(Label(5, "y")), LiveItemPush::kOverflow);
+  EXPECT_EQ(coalescer.overflow_count(), 1u);
+  EXPECT_EQ(LiveItemCoalescer(0).capacity(), 2u);
+  EXPECT_EQ(LiveItemCoalescer(5).capacity(), 8u);
+}
+
+TEST(LiveItemsTest, DrainedSlotsServeNewIdsForever) {
+  // Menu ids keep growing as the app rebuilds its menus: 10 menus of 3 new
+  // ids each go through 4 slots.
+  LiveItemCoalescer coalescer(4);
+  int32_t id = 1;
+  for (int menu = 0; menu < 10; ++menu) {
+    for (int item = 0; item < 3; ++item, ++id) {
+      EXPECT_NE(coalescer.Push(Label(id, "a")), LiveItemPush::kOverflow);
+      EXPECT_NE(coalescer.Push(Label(id, "b")), LiveItemPush::kOverflow);
+    }
+    std::vector<LiveItemUpdate> updates = DrainAll(coalescer);
+    ASSERT_EQ(updates.size(), 3u);
+    for (const LiveItemUpdate& update : updates) {
+      EXPECT_GE(update.id, id - 3);
+      EXPECT_EQ(update.label, std::optional<std::string>("b"));
+    }
+  }
+  EXPECT_EQ(coalescer.overflow_count(), 0u);
+}
+
+TEST(LiveItemsTest, FreesValuesThatWereNeverDrained) {
+  // Leaks show up under -DTRAY_MANAGER_WINUI_SANITIZER=address.
+  LiveItemCoalescer coalescer;
+  coalescer.Push(Label(1, std::string(100, 'a')));
+  coalescer.Push(Label(1, std::string(100, 'b')));
+}
+
+// Initializes at once and runs posted tasks on the posting thread.
+class InlinePlatform : public XamlThreadPlatform {
+ public:
+  bool Initialize() override { return true; }
+  bool Post(std::function<void()> task) override {
+    task();
+    return true;
+  }
+};
+
+TEST(LiveItemsTest, SubmitDropsUpdatesUntilWinUIIsReady) {
+  InlinePlatform platform;
+  XamlThreadGate gate(platform);
+  LiveItemCoalescer coalescer;
+  std::vector<LiveItemUpdate> flushed;
+  auto flush = [&] {
+    coalescer.Drain(
+        [&flushed](const LiveItemUpdate& u) { flushed.push_back(u); });
+  };
+  const flutter::EncodableList entries{
+      Entry({{"id", flutter::EncodableValue(1)},
+             {"label", flutter::EncodableValue("Syncing")}})};
+
+  EXPECT_FALSE(SubmitLiveItems(entries, coalescer, gate, flush));
+  EXPECT_EQ(gate.state(), XamlThreadState::kNotStarted);
+  EXPECT_TRUE(flushed.empty());
+  EXPECT_TRUE(DrainAll(coalescer).empty());
+
+  gate.Start();
+  ASSERT_TRUE(gate.WaitForInit(std::chrono::seconds(10)));
+  EXPECT_TRUE(SubmitLiveItems(entries, coalescer, gate, flush));
+  ASSERT_EQ(flushed.size(), 1u);
+  EXPECT_EQ(flushed[0].label, "Syncing");
+
+  // A malformed entry is reported; the others are still applied.
+  const flutter::EncodableList mixed{
+      Entry({{"label", flutter::EncodableValue("no id")}}), entries[0]};
+  EXPECT_FALSE(SubmitLiveItems(mixed, coalescer, gate, flush));
+  EXPECT_EQ(flushed.size(), 2u);
+}
+
+TEST(LiveItemsTest, PacerSpacesFlushesAFrameApart) {
+  using Clock = LiveItemFlushPacer::Clock;
+  LiveItemFlushPacer pacer(microseconds(16000));
+  const Clock::time_point start;
+  EXPECT_EQ(pacer.Delay(start).count(), 0);
+  pacer.OnFlushed(start);
+  EXPECT_EQ(pacer.Delay(start), microseconds(16000));
+  EXPECT_EQ(pacer.Delay(start + microseconds(6000)), microseconds(10000));
+  EXPECT_EQ(pacer.Delay(start + microseconds(16000)).count(), 0);
+  EXPECT_EQ(pacer.Delay(start + milliseconds(100)).count(), 0);
+
+  pacer.set_refresh_rate(144);
+  EXPECT_EQ(pacer.frame_interval(), microseconds(6945));
+  pacer.set_refresh_rate(0);
+  EXPECT_EQ(pacer.frame_interval(), microseconds(6945));
+  EXPECT_EQ(LiveItemFlushPacer().frame_interval(),
+            LiveItemFlushPacer::kDefaultFrameInterval);
+}
+
+// Stand-in for the XAML thread's queue: producers post a flush, the consumer
+// waits for one.
+class FlushChannel {
+ public:
+  void Post() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++pending_;
+    }
+    cv_.notify_one();
+  }
+
+  // Returns false once stopped and no flushes are left.
+  bool Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_ > 0 || stopped_; });
+    if (pending_ == 0) return false;
+    --pending_;
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int64_t pending_ = 0;
+  bool stopped_ = false;
+};
+
+// 10k updates per second across 100 items from two producer threads, for
+// half a second, flushed by a consumer paced like the XAML thread. Each
+// producer owns 50 items and labels them with increasing sequence numbers.
+// Run under -DTRAY_MANAGER_WINUI_SANITIZER=thread.
+TEST(LiveItemsTest, CoalescesTenThousandUpdatesPerSecondToFrameRate) {
+  constexpr int kProducers = 2;
+  constexpr int32_t kItems = 100;
+  constexpr int32_t kItemsPerProducer = kItems / kProducers;
+  constexpr int kUpdatesPerProducer = 2500;
+  // 10k per second overall.
+  constexpr microseconds kProducerInterval(kProducers * 100);
+  constexpr microseconds kFrame(16667);
+
+  LiveItemCoalescer coalescer;
+  FlushChannel channel;
+  LiveItemFlushPacer pacer(kFrame);
+  std::vector<int> last_seen(kItems, -1);
+  std::vector<bool> seen_disabled(kItems, false);
+  int64_t flushes = 0;
+  int64_t drained = 0;
+  size_t largest_flush = 0;
+  bool out_of_order = false;
+  LiveItemFlushPacer::Clock::duration shortest_gap =
+      LiveItemFlushPacer::Clock::duration::max();
+  std::optional<LiveItemFlushPacer::Clock::time_point> previous_flush;
+
+  auto drain = [&] {
+    const size_t count = coalescer.Drain([&](const LiveItemUpdate& update) {
+      ASSERT_GE(update.id, 0);
+      ASSERT_LT(update.id, kItems);
+      if (update.label) {
+        const int sequence = std::stoi(*update.label);
+        if (sequence <= last_seen[update.id]) out_of_order = true;
+        last_seen[update.id] = sequence;
+      }
+      if (update.disabled) seen_disabled[update.id] = *update.disabled;
+    });
+    drained += static_cast<int64_t>(count);
+    largest_flush = std::max(largest_flush, count);
+  };
+  auto flush = [&] {
+    const auto now = LiveItemFlushPacer::Clock::now();
+    pacer.OnFlushed(now);
+    if (previous_flush) {
+      shortest_gap = std::min(shortest_gap, now - *previous_flush);
+    }
+    previous_flush = now;
+    ++flushes;
+    drain();
+  };
+
+  std::thread consumer([&] {
+    while (channel.Wait()) {
+      std::this_thread::sleep_for(
+          pacer.Delay(LiveItemFlushPacer::Clock::now()));
+      flush();
+    }
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kUpdatesPerProducer; ++i) {
+        std::this_thread::sleep_until(start + i * kProducerInterval);
+        LiveItemUpdate update;
+        update.id = p * kItemsPerProducer + i % kItemsPerProducer;
+        update.label = std::to_string(i);
+        update.disabled = (i / kItemsPerProducer) % 2 == 1;
+        const LiveItemPush pushed = coalescer.Push(std::move(update));
+        ASSERT_NE(pushed, LiveItemPush::kOverflow);
+        if (pushed == LiveItemPush::kQueuedWake) channel.Post();
+      }
+    });
+  }
+  for (auto& thread : producers) thread.join();
+  channel.Stop();
+  consumer.join();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  // Updates whose wake-up an earlier flush took.
+  drain();
+
+  // Every item ends on the last value its producer sent, and never went
+  // back to an older one.
+  EXPECT_FALSE(out_of_order);
+  for (int32_t id = 0; id < kItems; ++id) {
+    const int32_t slot = id % kItemsPerProducer;
+    const int last = kUpdatesPerProducer - kItemsPerProducer + slot;
+    EXPECT_EQ(last_seen[id], last) << "item " << id;
+    EXPECT_EQ(seen_disabled[id], (last / kItemsPerProducer) % 2 == 1);
+  }
+  // One update per item and flush at most, flushes at most once per frame.
+  EXPECT_LE(largest_flush, static_cast<size_t>(kItems));
+  EXPECT_GE(shortest_gap, kFrame);
+  const int64_t frames = elapsed / kFrame + 2;
+  EXPECT_LE(flushes, frames);
+  EXPECT_LE(drained, (flushes + 1) * kItems);
+  EXPECT_LT(drained, kProducers * kUpdatesPerProducer);
+  EXPECT_EQ(coalescer.overflow_count(), 0u);
+}
+
+// Two producers move through 800 fresh ids each, four at a time, against 16
+// slots and a consumer that drains in a loop: ids keep finding slots, and
+// each ends on its last value. Run under
+// -DTRAY_MANAGER_WINUI_SANITIZER=thread.
+TEST(LiveItemsTest, ReusesSlotsAcrossIdsWhileDraining) {
+  constexpr int kProducers = 2;
+  constexpr int32_t kIdsPerProducer = 800;
+  constexpr int32_t kIdsAtATime = 4;
+  constexpr int kUpdatesPerId = 20;
+  constexpr int32_t kIds = kProducers * kIdsPerProducer;
+
+  LiveItemCoalescer coalescer(16);
+  std::vector<int> last_seen(kIds, -1);
+  bool out_of_order = false;
+  auto drain = [&] {
+    coalescer.Drain([&](const LiveItemUpdate& update) {
+      ASSERT_GE(update.id, 0);
+      ASSERT_LT(update.id, kIds);
+      ASSERT_TRUE(update.label);
+      const int sequence = std::stoi(*update.label);
+      if (sequence <= last_seen[update.id]) out_of_order = true;
+      last_seen[update.id] = sequence;
+    });
+  };
+
+  std::atomic<int> running(kProducers);
+  std::thread consumer([&] {
+    while (running.load() > 0) drain();
+  });
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int32_t first = 0; first < kIdsPerProducer; first += kIdsAtATime) {
+        for (int sequence = 0; sequence < kUpdatesPerId; ++sequence) {
+          for (int32_t i = first; i < first + kIdsAtATime; ++i) {
+            // Ids of both producers interleave over the table.
+            const int32_t id = i * kProducers + p;
+            // Full until the consumer catches up; sent again, in order.
+            while (coalescer.Push(Label(id, std::to_string(sequence))) ==
+                   LiveItemPush::kOverflow) {
+              std::this_thread::yield();
+            }
+          }
+        }
+      }
+      running.fetch_sub(1);
+    });
+  }
+  for (auto& thread : producers) thread.join();
+  consumer.join();
+  drain();
+
+  EXPECT_FALSE(out_of_order);
+  for (int32_t id = 0; id < kIds; ++id) {
+    EXPECT_EQ(last_seen[id], kUpdatesPerId - 1) << "item " << id;
+  }
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
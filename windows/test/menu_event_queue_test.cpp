@@ -0,0 +1,257 @@
+#include "menu_event_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tray_manager_winui {
+namespace {
+
+MenuEvent Event(MenuEventType type, int32_t id = 0) {
+  MenuEvent event;
+  event.type = type;
+  event.id = id;
+  return event;
+}
+
+MenuEvent Click(int32_t id) { return Event(MenuEventType::kItemClick, id); }
+
+std::vector<int32_t> DrainIds(MenuEventQueue& queue) {
+  std::vector<int32_t> ids;
+  queue.Drain([&ids](const MenuEvent& event) { ids.push_back(event.id); });
+  return ids;
+}
+
+TEST(MenuEventQueueTest, OnlyTheFirstEventOfABurstWakes) {
+  MenuEventQueue queue;
+  EXPECT_EQ(queue.Push(Click(1)), MenuEventPush::kQueuedWake);
+  EXPECT_EQ(queue.Push(Click(2)), MenuEventPush::kQueued);
+  EXPECT_EQ(queue.Push(Event(MenuEventType::kClosed)), MenuEventPush::kQueued);
+
+  std::vector<MenuEvent> drained;
+  EXPECT_EQ(queue.Drain([&](const MenuEvent& e) { drained.push_back(e); }),
+            3u);
+  ASSERT_EQ(drained.size(), 3u);
+  EXPECT_EQ(drained[0].id, 1);
+  EXPECT_EQ(drained[1].id, 2);
+  EXPECT_EQ(drained[2].type, MenuEventType::kClosed);
+
+  // Drained: the next event wakes again.
+  EXPECT_EQ(queue.Push(Click(3)), MenuEventPush::kQueuedWake);
+  EXPECT_EQ(DrainIds(queue), std::vector<int32_t>{3});
+}
+
+TEST(MenuEventQueueTest, EmptyDrainRearmsTheWake) {
+  MenuEventQueue queue;
+  EXPECT_EQ(queue.Drain([](const MenuEvent&) {}), 0u);
+  EXPECT_EQ(queue.Push(Click(1)), MenuEventPush::kQueuedWake);
+}
+
+TEST(MenuEventQueueTest, CountsOverflowInsteadOfBlocking) {
+  MenuEventQueue queue(4);
+  EXPECT_EQ(queue.capacity(), 4u);
+  for (int32_t id = 1; id <= 4; ++id) {
+    EXPECT_NE(queue.Push(Click(id)), MenuEventPush::kOverflow);
+  }
+  EXPECT_EQ(queue.Push(Click(5)), MenuEventPush::kOverflow);
+  EXPECT_EQ(queue.Push(Click(6)), MenuEventPush::kOverflow);
+  EXPECT_EQ(queue.overflow_count(), 2u);
+  EXPECT_EQ(DrainIds(queue), (std::vector<int32_t>{1, 2, 3, 4}));
+
+  // Slots are reused after the wrap.
+  for (int32_t id = 7; id <= 10; ++id) queue.Push(Click(id));
+  EXPECT_EQ(DrainIds(queue), (std::vector<int32_t>{7, 8, 9, 10}));
+  EXPECT_EQ(queue.overflow_count(), 2u);
+}
+
+TEST(MenuEventQueueTest, RoundsCapacityUpToAPowerOfTwo) {
+  EXPECT_EQ(MenuEventQueue(0).capacity(), 2u);
+  EXPECT_EQ(MenuEventQueue(5).capacity(), 8u);
+  EXPECT_EQ(MenuEventQueue().capacity(), MenuEventQueue::kDefaultCapacity);
+}
+
+TEST(MenuEventQueueTest, CancelledWakeIsRetriedByTheNextPush) {
+  MenuEventQueue queue;
+  ASSERT_EQ(queue.Push(Click(1)), MenuEventPush::kQueuedWake);
+  queue.CancelWake();  // As if PostMessage had failed.
+  EXPECT_EQ(queue.Push(Click(2)), MenuEventPush::kQueuedWake);
+  EXPECT_EQ(DrainIds(queue), (std::vector<int32_t>{1, 2}));
+}
+
+TEST(MenuEventQueueTest, MapsEventsToDartMethods) {
+  EXPECT_STREQ(MenuEventMethod(MenuEventType::kItemClick), "onMenuItemClick");
+  EXPECT_STREQ(MenuEventMethod(MenuEventType::kOpening), "onMenuOpening");
+  EXPECT_STREQ(MenuEventMethod(MenuEventType::kClosing), "onMenuClosing");
+  EXPECT_STREQ(MenuEventMethod(MenuEventType::kClosed), "onMenuClosed");
+
+  auto args = MenuEventArguments(Click(42));
+  ASSERT_TRUE(args);
+  flutter::EncodableMap expected;
+  expected[flutter::EncodableValue("id")] = flutter::EncodableValue(42);
+  expected[flutter::EncodableValue("generation")] =
+      flutter::EncodableValue(int64_t{0});
+  EXPECT_EQ(*args, flutter::EncodableValue(expected));
+  EXPECT_FALSE(MenuEventArguments(Event(MenuEventType::kClosed)));
+
+  MenuClick click;
+  click.generation = 0xFFFFFFF0u;
+  click.id = 7;
+  click.path.length = 2;
+  click.path.positions = {3, 1};
+  args = MenuEventArguments(MakeClickEvent(click));
+  ASSERT_TRUE(args);
+  expected[flutter::EncodableValue("id")] = flutter::EncodableValue(7);
+  expected[flutter::EncodableValue("generation")] =
+      flutter::EncodableValue(int64_t{0xFFFFFFF0});
+  expected[flutter::EncodableValue("path")] =
+      flutter::EncodableValue(flutter::EncodableList{
+          flutter::EncodableValue(int64_t{3}),
+          flutter::EncodableValue(int64_t{1})});
+  EXPECT_EQ(*args, flutter::EncodableValue(expected));
+
+  // A radio click that unchecked another item.
+  click.checked = true;
+  click.unchecked_id = 9;
+  click.unchecked_path.length = 1;
+  click.unchecked_path.positions = {4};
+  args = MenuEventArguments(MakeClickEvent(click));
+  ASSERT_TRUE(args);
+  expected[flutter::EncodableValue("checked")] = flutter::EncodableValue(true);
+  expected[flutter::EncodableValue("uncheckedId")] = flutter::EncodableValue(9);
+  expected[flutter::EncodableValue("uncheckedPath")] =
+      flutter::EncodableValue(
+          flutter::EncodableList{flutter::EncodableValue(int64_t{4})});
+  EXPECT_EQ(*args, flutter::EncodableValue(expected));
+}
+
+// Stand-in for the platform thread's message queue: producers post a wake-up,
+// the consumer waits for one and drains.
+class WakeChannel {
+ public:
+  void Post() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++pending_;
+      ++posted_;
+    }
+    cv_.notify_one();
+  }
+
+  // Returns false once stopped and no wake-ups are left.
+  bool Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_ > 0 || stopped_; });
+    if (pending_ == 0) return false;
+    --pending_;
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_one();
+  }
+
+  int64_t posted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return posted_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int64_t pending_ = 0;
+  int64_t posted_ = 0;
+  bool stopped_ = false;
+};
+
+struct StressResult {
+  std::vector<std::vector<int32_t>> received;  // Per producer.
+  int64_t overflowed = 0;
+  int64_t wakes = 0;
+};
+
+// Producers push ids 0..per_producer-1 tagged with their index. With
+// retry_on_overflow every event must arrive; otherwise received plus
+// overflowed must add up. Run under -DTRAY_MANAGER_WINUI_SANITIZER=thread.
+StressResult RunStress(int producers, int32_t per_producer, size_t capacity,
+                       bool retry_on_overflow) {
+  MenuEventQueue queue(capacity);
+  WakeChannel wake;
+  StressResult result;
+  result.received.resize(producers);
+  std::atomic<int64_t> overflowed{0};
+
+  std::thread consumer([&] {
+    while (wake.Wait()) {
+      queue.Drain([&](const MenuEvent& event) {
+        result.received[event.id >> 24].push_back(event.id & 0xFFFFFF);
+      });
+    }
+    // Events whose producer's wake-up was taken by an earlier drain.
+    queue.Drain([&](const MenuEvent& event) {
+      result.received[event.id >> 24].push_back(event.id & 0xFFFFFF);
+    });
+  });
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int32_t i = 0; i < per_producer; ++i) {
+        const MenuEvent event = Click((p << 24) | i);
+        MenuEventPush pushed;
+        while ((pushed = queue.Push(event)) == MenuEventPush::kOverflow) {
+          overflowed.fetch_add(1, std::memory_order_relaxed);
+          if (!retry_on_overflow) break;
+          std::this_thread::yield();
+        }
+        if (pushed == MenuEventPush::kQueuedWake) wake.Post();
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  wake.Stop();
+  consumer.join();
+
+  result.overflowed = overflowed.load();
+  result.wakes = wake.posted();
+  EXPECT_EQ(static_cast<uint64_t>(result.overflowed), queue.overflow_count());
+  return result;
+}
+
+TEST(MenuEventQueueTest, StressDeliversEveryEventInProducerOrder) {
+  constexpr int kProducers = 4;
+  constexpr int32_t kPerProducer = 50000;
+  StressResult result = RunStress(kProducers, kPerProducer, 64, true);
+  for (int p = 0; p < kProducers; ++p) {
+    const auto& ids = result.received[p];
+    ASSERT_EQ(ids.size(), static_cast<size_t>(kPerProducer)) << p;
+    for (int32_t i = 0; i < kPerProducer; ++i) {
+      ASSERT_EQ(ids[i], i) << "producer " << p;
+    }
+  }
+  EXPECT_GT(result.wakes, 0);
+  EXPECT_LE(result.wakes, int64_t{kProducers} * kPerProducer);
+}
+
+TEST(MenuEventQueueTest, StressCountsEveryDroppedEvent) {
+  constexpr int kProducers = 4;
+  constexpr int32_t kPerProducer = 20000;
+  StressResult result = RunStress(kProducers, kPerProducer, 8, false);
+  int64_t received = 0;
+  for (const auto& ids : result.received) {
+    for (size_t i = 1; i < ids.size(); ++i) ASSERT_LT(ids[i - 1], ids[i]);
+    received += static_cast<int64_t>(ids.size());
+  }
+  EXPECT_EQ(received + result.overflowed, int64_t{kProducers} * kPerProducer);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,111 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_MENU_FIXTURES_H_
+#define TRAY_MANAGER_WINUI_TEST_MENU_FIXTURES_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "menu_model.h"
+#include "menu_snapshot.h"
+
+namespace tray_manager_winui {
+namespace testing {
+
+// Builds a menu item map in the format produced by MenuItem.toJson().
+inline flutter::EncodableMap MakeItem(int32_t id, const std::string& type,
+                                      const std::string& label) {
+  flutter::EncodableMap item;
+  item[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
+  item[flutter::EncodableValue("type")] = flutter::EncodableValue(type);
+  item[flutter::EncodableValue("label")] = flutter::EncodableValue(label);
+  item[flutter::EncodableValue("disabled")] = flutter::EncodableValue(false);
+  return item;
+}
+
+inline flutter::EncodableMap MakeMenu(flutter::EncodableList items) {
+  flutter::EncodableMap menu;
+  menu[flutter::EncodableValue("items")] =
+      flutter::EncodableValue(std::move(items));
+  return menu;
+}
+
+inline flutter::EncodableMap MakeSubmenu(int32_t id, const std::string& label,
+                                         flutter::EncodableList children) {
+  flutter::EncodableMap item = MakeItem(id, "submenu", label);
+  item[flutter::EncodableValue("submenu")] =
+      flutter::EncodableValue(MakeMenu(std::move(children)));
+  return item;
+}
+
+// A radio item; an empty group leaves radioGroup out.
+inline flutter::EncodableMap MakeRadio(int32_t id, const std::string& group,
+                                       bool checked = false) {
+  flutter::EncodableMap item =
+      MakeItem(id, "radio", "Radio " + std::to_string(id));
+  if (!group.empty()) {
+    item[flutter::EncodableValue("radioGroup")] =
+        flutter::EncodableValue(group);
+  }
+  item[flutter::EncodableValue("checked")] = flutter::EncodableValue(checked);
+  return item;
+}
+
+using StyleEntry = std::pair<const char*, flutter::EncodableValue>;
+
+// Builds a style map in the format produced by WinUIContextMenuStyle.toJson(),
+// inserting entries in the given order.
+inline flutter::EncodableMap MakeStyle(const std::vector<StyleEntry>& entries) {
+  flutter::EncodableMap style;
+  for (const auto& [key, value] : entries) {
+    style.emplace(flutter::EncodableValue(key), value);
+  }
+  return style;
+}
+
+// A style with a font; styles that differ in font_size are different styles.
+inline flutter::EncodableMap MakeFontStyle(double font_size) {
+  return MakeStyle({
+      {"fontSize", flutter::EncodableValue(font_size)},
+      {"fontFamily", flutter::EncodableValue("Segoe UI Variable Display")},
+  });
+}
+
+inline MenuSnapshotPtr MakeSnapshot(CompiledMenu menu, double font_size = 14) {
+  return MakeMenuSnapshot(std::move(menu), MakeFontStyle(font_size));
+}
+
+// Generates a menu with item_count items in total. Every fanout-th root item
+// is a submenu holding the following fanout - 1 items, which mirrors tray
+// menus with a flat root and a few large submenus.
+inline flutter::EncodableMap MakeSyntheticMenu(int32_t item_count,
+                                               int32_t fanout) {
+  flutter::EncodableList root;
+  int32_t id = 1;
+  while (id <= item_count) {
+    if (fanout > 1 && id % fanout == 1 && id + 1 <= item_count) {
+      const int32_t sub_id = id++;
+      flutter::EncodableList children;
+      for (int32_t i = 1; i < fanout && id <= item_count; ++i, ++id) {
+        auto child = MakeItem(id, i % 3 == 0 ? "checkbox" : "normal",
+                              "Item " + std::to_string(id));
+        child[flutter::EncodableValue("toolTip")] =
+            flutter::EncodableValue("Tooltip for item");
+        children.emplace_back(std::move(child));
+      }
+      root.emplace_back(MakeSubmenu(sub_id, "Submenu " + std::to_string(sub_id),
+                                    std::move(children)));
+    } else {
+      root.emplace_back(MakeItem(id, "normal", "Item " + std::to_string(id)));
+      ++id;
+    }
+  }
+  return MakeMenu(std::move(root));
+}
+
+}  // namespace testing
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_MENU_FIXTURES_H_
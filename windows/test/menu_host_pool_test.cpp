@@ -0,0 +1,295 @@
+#include "menu_host_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeSnapshot;
+using testing::MakeSubmenu;
+
+// Records backend calls; each step can be made to fail.
+class FakeBackend : public MenuHostBackend {
+ public:
+  bool CreateHost() override {
+    ++host_creates;
+    host_alive = !fail_create_host;
+    return !fail_create_host;
+  }
+  void DestroyHost() override {
+    ++host_destroys;
+    host_alive = false;
+  }
+  bool IsHostAlive() const override { return host_alive; }
+  bool CreateFlyout(const ResolvedStyle&) override {
+    ++flyout_creates;
+    return true;
+  }
+  void DestroyFlyout() override { ++flyout_destroys; }
+  bool BuildItems(const CompiledMenu& menu) override {
+    ++item_builds;
+    built_nodes = menu.nodes().size();
+    return true;
+  }
+  bool UpdateItem(const CompiledMenu&, const CompiledMenu&,
+                  uint32_t index) override {
+    updated.push_back(index);
+    return !refuse_updates;
+  }
+  void RebindItems(const CompiledMenu& menu) override {
+    ++rebinds;
+    built_nodes = menu.nodes().size();
+  }
+  bool Show(const MenuShowRequest&) override {
+    ++shows;
+    return !fail_show;
+  }
+
+  bool host_alive = false;
+  bool fail_create_host = false;
+  bool fail_show = false;
+  bool refuse_updates = false;
+  int host_creates = 0;
+  int host_destroys = 0;
+  int flyout_creates = 0;
+  int flyout_destroys = 0;
+  int item_builds = 0;
+  int rebinds = 0;
+  int shows = 0;
+  size_t built_nodes = 0;
+  std::vector<uint32_t> updated;
+};
+
+CompiledMenu MakeTestMenu(bool checked, const std::string& label = "Open") {
+  auto toggle = MakeItem(2, "checkbox", "Wrap");
+  toggle[flutter::EncodableValue("checked")] = flutter::EncodableValue(checked);
+  return CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeItem(1, "normal", label)),
+      flutter::EncodableValue(toggle),
+      flutter::EncodableValue(MakeSubmenu(
+          3, "More", {flutter::EncodableValue(MakeItem(4, "normal", "Inner"))})),
+  }));
+}
+
+TEST(MenuHostPoolTest, FirstShowCreatesEverything) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  EXPECT_EQ(pool.state(), MenuHostState::kCold);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(pool.state(), MenuHostState::kShowing);
+  EXPECT_EQ(backend.host_creates, 1);
+  EXPECT_EQ(backend.flyout_creates, 1);
+  EXPECT_EQ(backend.item_builds, 1);
+  EXPECT_EQ(backend.built_nodes, 4u);
+  EXPECT_EQ(backend.shows, 1);
+}
+
+TEST(MenuHostPoolTest, RejectsShowWhileShowing) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_FALSE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(backend.shows, 1);
+  pool.OnClosed();
+  EXPECT_EQ(pool.state(), MenuHostState::kWarm);
+}
+
+TEST(MenuHostPoolTest, ReusesHostFlyoutAndItems) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+    pool.OnClosed();
+  }
+  EXPECT_EQ(backend.host_creates, 1);
+  EXPECT_EQ(backend.flyout_creates, 1);
+  EXPECT_EQ(backend.item_builds, 1);
+  EXPECT_TRUE(backend.updated.empty());
+  EXPECT_EQ(backend.shows, 3);
+  EXPECT_EQ(pool.stats().shows, 3u);
+}
+
+TEST(MenuHostPoolTest, UpdatesOnlyChangedItems) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  pool.OnClosed();
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(true)), {}));
+  pool.OnClosed();
+  EXPECT_EQ(backend.item_builds, 1);
+  EXPECT_EQ(backend.updated, std::vector<uint32_t>{1});
+
+  backend.updated.clear();
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(true, "Reopen")), {}));
+  EXPECT_EQ(backend.updated, std::vector<uint32_t>{0});
+  EXPECT_EQ(pool.stats().item_updates, 2u);
+}
+
+TEST(MenuHostPoolTest, RebuildsItemsWhenLayoutChanges) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  pool.OnClosed();
+  CompiledMenu other = CompileMenu(
+      MakeMenu({flutter::EncodableValue(MakeItem(1, "normal", "Open"))}));
+  ASSERT_TRUE(pool.Show(MakeSnapshot(other), {}));
+  EXPECT_EQ(backend.item_builds, 2);
+  EXPECT_EQ(backend.built_nodes, 1u);
+  EXPECT_EQ(backend.flyout_creates, 1);
+}
+
+TEST(MenuHostPoolTest, RebuildsItemsWhenUpdateIsRefused) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  pool.OnClosed();
+  backend.refuse_updates = true;
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(true)), {}));
+  EXPECT_EQ(backend.item_builds, 2);
+}
+
+TEST(MenuHostPoolTest, StyleChangeInvalidatesFlyoutButKeepsHost) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  pool.OnClosed();
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false), 16), {}));
+  pool.OnClosed();
+  EXPECT_EQ(backend.host_creates, 1);
+  EXPECT_EQ(backend.flyout_creates, 2);
+  EXPECT_EQ(backend.flyout_destroys, 1);
+  // Items belong to the old flyout and must be rebuilt.
+  EXPECT_EQ(backend.item_builds, 2);
+
+  // Same style again: nothing new.
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false), 16), {}));
+  EXPECT_EQ(backend.flyout_creates, 2);
+  EXPECT_EQ(backend.item_builds, 2);
+}
+
+TEST(MenuHostPoolTest, RecoversAfterFailedShow) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  backend.fail_show = true;
+  EXPECT_FALSE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(pool.state(), MenuHostState::kCold);
+  EXPECT_EQ(backend.host_destroys, 1);
+  EXPECT_EQ(backend.flyout_destroys, 1);
+  EXPECT_EQ(pool.stats().recoveries, 1u);
+
+  backend.fail_show = false;
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(backend.host_creates, 2);
+  EXPECT_EQ(backend.flyout_creates, 2);
+  EXPECT_EQ(backend.item_builds, 2);
+}
+
+TEST(MenuHostPoolTest, RecoversAfterFailedHostCreation) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  backend.fail_create_host = true;
+  EXPECT_FALSE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(backend.flyout_creates, 0);
+  backend.fail_create_host = false;
+  EXPECT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+}
+
+TEST(MenuHostPoolTest, RecoversWhenHostDiesWhileShowing) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  // The window was destroyed and Closed never arrived.
+  backend.host_alive = false;
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(backend.host_creates, 2);
+  EXPECT_EQ(backend.item_builds, 2);
+  EXPECT_EQ(pool.stats().recoveries, 1u);
+}
+
+TEST(MenuHostPoolTest, PrepareBuildsEverythingWithoutShowing) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Prepare(MakeSnapshot(MakeTestMenu(false))));
+  EXPECT_EQ(pool.state(), MenuHostState::kWarm);
+  EXPECT_EQ(backend.host_creates, 1);
+  EXPECT_EQ(backend.flyout_creates, 1);
+  EXPECT_EQ(backend.item_builds, 1);
+  EXPECT_EQ(backend.shows, 0);
+  EXPECT_EQ(pool.stats().prepares, 1u);
+  EXPECT_EQ(pool.stats().shows, 0u);
+}
+
+TEST(MenuHostPoolTest, ShowPreparedOnlyOpensTheFlyout) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Prepare(MakeSnapshot(MakeTestMenu(false))));
+  ASSERT_TRUE(pool.ShowPrepared({}));
+  EXPECT_EQ(pool.state(), MenuHostState::kShowing);
+  EXPECT_EQ(backend.host_creates, 1);
+  EXPECT_EQ(backend.item_builds, 1);
+  EXPECT_TRUE(backend.updated.empty());
+  EXPECT_EQ(backend.shows, 1);
+  EXPECT_EQ(pool.stats().prepared_shows, 1u);
+
+  // Not while showing, and preparing leaves the open flyout alone.
+  EXPECT_FALSE(pool.ShowPrepared({}));
+  EXPECT_FALSE(pool.Prepare(MakeSnapshot(MakeTestMenu(true))));
+  EXPECT_TRUE(backend.updated.empty());
+  pool.OnClosed();
+
+  // Preparing a changed menu updates the built items ahead of the show.
+  ASSERT_TRUE(pool.Prepare(MakeSnapshot(MakeTestMenu(true))));
+  EXPECT_EQ(backend.updated, std::vector<uint32_t>{1});
+  ASSERT_TRUE(pool.ShowPrepared({}));
+  EXPECT_EQ(backend.updated, std::vector<uint32_t>{1});
+}
+
+TEST(MenuHostPoolTest, ShowPreparedNeedsABuiltFlyout) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  EXPECT_FALSE(pool.ShowPrepared({}));
+  EXPECT_EQ(pool.state(), MenuHostState::kCold);
+  EXPECT_EQ(backend.host_creates, 0);
+  EXPECT_EQ(pool.stats().shows, 0u);
+
+  // The host died after preparing: the caller falls back to Show.
+  ASSERT_TRUE(pool.Prepare(MakeSnapshot(MakeTestMenu(false))));
+  backend.host_alive = false;
+  EXPECT_FALSE(pool.ShowPrepared({}));
+  EXPECT_EQ(backend.shows, 0);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  EXPECT_EQ(backend.host_creates, 2);
+}
+
+TEST(MenuHostPoolTest, ShowPreparedRecoversWhenShowFails) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Prepare(MakeSnapshot(MakeTestMenu(false))));
+  backend.fail_show = true;
+  EXPECT_FALSE(pool.ShowPrepared({}));
+  EXPECT_EQ(pool.state(), MenuHostState::kCold);
+  EXPECT_EQ(pool.stats().recoveries, 1u);
+}
+
+TEST(MenuHostPoolTest, ResetReleasesEverything) {
+  FakeBackend backend;
+  MenuHostPool pool(backend);
+  ASSERT_TRUE(pool.Show(MakeSnapshot(MakeTestMenu(false)), {}));
+  pool.OnClosed();
+  pool.Reset();
+  EXPECT_EQ(pool.state(), MenuHostState::kCold);
+  EXPECT_EQ(backend.host_destroys, 1);
+  EXPECT_EQ(backend.flyout_destroys, 1);
+  pool.Reset();
+  EXPECT_EQ(backend.host_destroys, 1);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,268 @@
+#include "menu_model.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeSubmenu;
+using testing::MakeSyntheticMenu;
+
+TEST(MenuModelTest, EmptyMapCompilesToNoItems) {
+  CompiledMenu menu = CompileMenu(flutter::EncodableMap());
+  EXPECT_EQ(menu.root_count(), 0u);
+  EXPECT_TRUE(menu.nodes().empty());
+  EXPECT_EQ(menu.str(kEmptyString), "");
+}
+
+TEST(MenuModelTest, ParsesTypedFields) {
+  auto item = MakeItem(7, "checkbox", "Wrap lines");
+  item[flutter::EncodableValue("checked")] = flutter::EncodableValue(true);
+  item[flutter::EncodableValue("disabled")] = flutter::EncodableValue(true);
+  item[flutter::EncodableValue("icon")] = flutter::EncodableValue("0xE8C8");
+  item[flutter::EncodableValue("iconFontFamily")] =
+      flutter::EncodableValue("Segoe Fluent Icons");
+  item[flutter::EncodableValue("acceleratorText")] =
+      flutter::EncodableValue("Ctrl+W");
+  item[flutter::EncodableValue("toolTip")] = flutter::EncodableValue("Tip");
+
+  CompiledMenu menu = CompileMenu(MakeMenu({flutter::EncodableValue(item)}));
+  ASSERT_EQ(menu.root_count(), 1u);
+  const MenuNode& node = menu.node(0);
+  EXPECT_EQ(node.type, MenuItemType::kCheckbox);
+  EXPECT_EQ(node.id, 7);
+  EXPECT_TRUE(node.checked);
+  EXPECT_TRUE(node.disabled);
+  EXPECT_EQ(menu.str(node.label), "Wrap lines");
+  EXPECT_EQ(menu.str(node.icon), "0xE8C8");
+  EXPECT_EQ(menu.str(node.icon_font_family), "Segoe Fluent Icons");
+  EXPECT_EQ(menu.str(node.accelerator_text), "Ctrl+W");
+  EXPECT_EQ(menu.str(node.tool_tip), "Tip");
+  EXPECT_EQ(node.radio_group, kEmptyString);
+}
+
+TEST(MenuModelTest, ParsesVirtualizedFlag) {
+  auto paged = MakeSubmenu(1, "Recent", {MakeItem(2, "normal", "a.txt")});
+  paged[flutter::EncodableValue("virtualized")] = flutter::EncodableValue(true);
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      flutter::EncodableValue(paged),
+      MakeSubmenu(3, "Plain", {MakeItem(4, "normal", "b.txt")}),
+  }));
+  EXPECT_TRUE(menu.node(0).virtualized);
+  EXPECT_FALSE(menu.node(1).virtualized);
+}
+
+TEST(MenuModelTest, MapsItemTypes) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeItem(1, "normal", "a")),
+      flutter::EncodableValue(MakeItem(2, "separator", "")),
+      flutter::EncodableValue(MakeItem(3, "radio", "c")),
+      flutter::EncodableValue(MakeItem(4, "unknown", "d")),
+  }));
+  ASSERT_EQ(menu.root_count(), 4u);
+  EXPECT_EQ(menu.node(0).type, MenuItemType::kNormal);
+  EXPECT_EQ(menu.node(1).type, MenuItemType::kSeparator);
+  EXPECT_EQ(menu.node(2).type, MenuItemType::kRadio);
+  EXPECT_EQ(menu.node(3).type, MenuItemType::kNormal);
+}
+
+TEST(MenuModelTest, SkipsNonMapEntries) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      flutter::EncodableValue(1),
+      flutter::EncodableValue(MakeItem(2, "normal", "b")),
+      flutter::EncodableValue(),
+  }));
+  ASSERT_EQ(menu.root_count(), 1u);
+  EXPECT_EQ(menu.node(0).id, 2);
+}
+
+TEST(MenuModelTest, LaysOutSiblingsContiguously) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeSubmenu(
+          1, "File",
+          {flutter::EncodableValue(MakeItem(2, "normal", "Open")),
+           flutter::EncodableValue(MakeSubmenu(
+               3, "Recent",
+               {flutter::EncodableValue(MakeItem(4, "normal", "a.txt"))}))})),
+      flutter::EncodableValue(MakeItem(5, "normal", "Exit")),
+  }));
+
+  ASSERT_EQ(menu.root_count(), 2u);
+  ASSERT_EQ(menu.nodes().size(), 5u);
+  EXPECT_EQ(menu.node(0).id, 1);
+  EXPECT_EQ(menu.node(1).id, 5);
+
+  const MenuNode& file = menu.node(0);
+  ASSERT_EQ(file.child_count, 2u);
+  EXPECT_EQ(file.first_child, 2u);
+  EXPECT_EQ(menu.node(file.first_child).id, 2);
+  EXPECT_EQ(menu.node(file.first_child + 1).id, 3);
+
+  const MenuNode& recent = menu.node(file.first_child + 1);
+  ASSERT_EQ(recent.child_count, 1u);
+  EXPECT_EQ(menu.node(recent.first_child).id, 4);
+  EXPECT_FALSE(menu.node(1).has_children());
+}
+
+TEST(MenuModelTest, IgnoresSubmenuOnNonContainerItems) {
+  auto item = MakeItem(1, "normal", "Plain");
+  item[flutter::EncodableValue("submenu")] = flutter::EncodableValue(
+      MakeMenu({flutter::EncodableValue(MakeItem(2, "normal", "x"))}));
+  CompiledMenu menu = CompileMenu(MakeMenu({flutter::EncodableValue(item)}));
+  EXPECT_EQ(menu.nodes().size(), 1u);
+  EXPECT_FALSE(menu.node(0).has_children());
+}
+
+TEST(MenuModelTest, CompilesSplitChildren) {
+  auto split = MakeSubmenu(1, "Save", {flutter::EncodableValue(
+                                          MakeItem(2, "normal", "Save as"))});
+  split[flutter::EncodableValue("type")] = flutter::EncodableValue("split");
+  CompiledMenu menu = CompileMenu(MakeMenu({flutter::EncodableValue(split)}));
+  ASSERT_EQ(menu.node(0).type, MenuItemType::kSplit);
+  EXPECT_EQ(menu.node(0).child_count, 1u);
+}
+
+TEST(MenuModelTest, InternsDuplicateStrings) {
+  auto a = MakeItem(1, "normal", "Same");
+  auto b = MakeItem(2, "normal", "Same");
+  a[flutter::EncodableValue("toolTip")] = flutter::EncodableValue("Same");
+  CompiledMenu menu = CompileMenu(
+      MakeMenu({flutter::EncodableValue(a), flutter::EncodableValue(b)}));
+  EXPECT_EQ(menu.node(0).label, menu.node(1).label);
+  EXPECT_EQ(menu.node(0).tool_tip, menu.node(0).label);
+  // "" plus "Same".
+  EXPECT_EQ(menu.string_count(), 2u);
+}
+
+TEST(MenuModelTest, ConvertsStringsToUtf16Once) {
+  auto item = MakeItem(1, "normal", "Caf\xC3\xA9 \xF0\x9F\x8D\xB5");
+  item[flutter::EncodableValue("toolTip")] = flutter::EncodableValue("tip");
+  CompiledMenu menu = CompileMenu(MakeMenu({flutter::EncodableValue(item)}));
+  EXPECT_EQ(menu.text(menu.node(0).label).utf16,
+            u"Caf\u00E9 \U0001F375");
+  EXPECT_EQ(menu.text(menu.node(0).tool_tip).utf16, u"tip");
+  EXPECT_TRUE(menu.text(kEmptyString).utf16.empty());
+
+  // Strings added by updates get their UTF-16 form too.
+  const StringId added = menu.AddString("Neu \xE2\x80\x93 2");
+  EXPECT_EQ(menu.text(added).utf8, "Neu \xE2\x80\x93 2");
+  EXPECT_EQ(menu.text(added).utf16, u"Neu \u2013 2");
+  EXPECT_EQ(menu.text(menu.node(0).tool_tip).utf16, u"tip");
+}
+
+TEST(MenuModelTest, IgnoresMistypedFields) {
+  flutter::EncodableMap item;
+  item[flutter::EncodableValue("id")] = flutter::EncodableValue("7");
+  item[flutter::EncodableValue("label")] = flutter::EncodableValue(3);
+  item[flutter::EncodableValue("checked")] = flutter::EncodableValue(1);
+  CompiledMenu menu = CompileMenu(MakeMenu({flutter::EncodableValue(item)}));
+  ASSERT_EQ(menu.root_count(), 1u);
+  EXPECT_EQ(menu.node(0).id, 0);
+  EXPECT_EQ(menu.node(0).label, kEmptyString);
+  EXPECT_FALSE(menu.node(0).checked);
+}
+
+TEST(MenuModelTest, CompilesLargeMenus) {
+  CompiledMenu menu = CompileMenu(MakeSyntheticMenu(50000, 100));
+  EXPECT_EQ(menu.nodes().size(), 50000u);
+  uint32_t reachable = menu.root_count();
+  for (const MenuNode& node : menu.nodes()) reachable += node.child_count;
+  EXPECT_EQ(reachable, 50000u);
+}
+
+TEST(MenuModelTest, FindsEveryNodeById) {
+  CompiledMenu menu = CompileMenu(MakeSyntheticMenu(10000, 100));
+  for (uint32_t i = 0; i < menu.nodes().size(); ++i) {
+    ASSERT_EQ(menu.FindNode(menu.node(i).id), i);
+  }
+  EXPECT_EQ(menu.FindNode(0), CompiledMenu::kNoNode);
+  EXPECT_EQ(menu.FindNode(10001), CompiledMenu::kNoNode);
+  EXPECT_EQ(menu.FindNode(-1), CompiledMenu::kNoNode);
+
+  CompiledMenu empty = CompileMenu(flutter::EncodableMap());
+  EXPECT_EQ(empty.FindNode(0), CompiledMenu::kNoNode);
+}
+
+TEST(MenuModelTest, VisitsDuplicateIdsInNodeOrder) {
+  // Ids are not required to be unique; each id here is used three times,
+  // and the ids collide in the table.
+  flutter::EncodableList items;
+  for (int32_t i = 0; i < 300; ++i) {
+    items.push_back(flutter::EncodableValue(
+        MakeItem((i % 100) * 1024, "normal", "Item")));
+  }
+  CompiledMenu menu = CompileMenu(MakeMenu(std::move(items)));
+  for (int32_t id = 0; id < 100; ++id) {
+    std::vector<uint32_t> visited;
+    menu.ForEachNodeWithId(id * 1024,
+                           [&](uint32_t index) { visited.push_back(index); });
+    const auto first = static_cast<uint32_t>(id);
+    EXPECT_EQ(visited, (std::vector<uint32_t>{first, first + 100, first + 200}));
+    EXPECT_EQ(menu.FindNode(id * 1024), first);
+  }
+}
+
+TEST(MenuModelTest, RecordsParentsAndPaths) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeSubmenu(
+          1, "File",
+          {flutter::EncodableValue(MakeItem(2, "normal", "Open")),
+           flutter::EncodableValue(MakeSubmenu(
+               3, "Recent",
+               {flutter::EncodableValue(MakeItem(4, "normal", "a.txt"))}))})),
+      flutter::EncodableValue(MakeItem(5, "normal", "Exit")),
+  }));
+  const uint32_t recent = menu.FindNode(3);
+  const uint32_t file = menu.FindNode(4);
+  EXPECT_EQ(menu.parent(menu.FindNode(1)), CompiledMenu::kNoNode);
+  EXPECT_EQ(menu.parent(recent), menu.FindNode(1));
+  EXPECT_EQ(menu.parent(file), recent);
+
+  const MenuPath path = menu.PathOf(file);
+  ASSERT_EQ(path.length, 3u);
+  EXPECT_EQ(path.positions[0], 0u);
+  EXPECT_EQ(path.positions[1], 1u);
+  EXPECT_EQ(path.positions[2], 0u);
+  const MenuPath exit = menu.PathOf(menu.FindNode(5));
+  ASSERT_EQ(exit.length, 1u);
+  EXPECT_EQ(exit.positions[0], 1u);
+}
+
+TEST(MenuModelTest, PathsBeyondMaxDepthAreEmpty) {
+  // Item 0 inside MenuPath::kMaxDepth + 1 levels of submenus.
+  flutter::EncodableMap item = MakeItem(0, "normal", "Deep");
+  for (int32_t level = 1; level <= int32_t{MenuPath::kMaxDepth}; ++level) {
+    item = MakeSubmenu(level, "Level", {flutter::EncodableValue(item)});
+  }
+  CompiledMenu menu = CompileMenu(MakeMenu({flutter::EncodableValue(item)}));
+  EXPECT_EQ(menu.PathOf(menu.FindNode(1)).length, MenuPath::kMaxDepth);
+  EXPECT_EQ(menu.PathOf(menu.FindNode(0)).length, 0u);
+}
+
+TEST(MenuModelTest, ClicksCarryTheGeneration) {
+  CompiledMenu menu = CompileMenu(MakeSyntheticMenu(20, 10));
+  menu.set_generation(42);
+  const uint32_t index = menu.FindNode(13);
+  const MenuClick click = menu.ClickOn(index);
+  EXPECT_EQ(click.generation, 42u);
+  EXPECT_EQ(click.id, 13);
+  // Item 13 is the second child of submenu 11, the second root item.
+  ASSERT_EQ(click.path.length, 2u);
+  EXPECT_EQ(click.path.positions[0], 1u);
+  EXPECT_EQ(click.path.positions[1], 1u);
+
+  // Copies (PatchMenuSnapshot) keep the index and the generation.
+  const CompiledMenu copy = menu;
+  EXPECT_EQ(copy.FindNode(13), index);
+  EXPECT_EQ(copy.generation(), 42u);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
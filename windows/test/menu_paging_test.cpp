@@ -0,0 +1,150 @@
+#include "menu_paging.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace {
+
+ResolvedStyle Style(const std::vector<testing::StyleEntry>& entries) {
+  return ResolveStyle(testing::MakeStyle(entries));
+}
+
+TEST(MenuPagingTest, ResolvesDefaults) {
+  MenuPagingOptions options = ResolveMenuPaging(ResolvedStyle());
+  EXPECT_EQ(options.threshold, kDefaultPagingThreshold);
+  EXPECT_EQ(options.page_size, kDefaultVisibleRows + kPageMargin);
+  EXPECT_EQ(options.max_items, kDefaultPagingThreshold);
+  EXPECT_EQ(options.more_label, "More\xE2\x80\xA6");
+}
+
+TEST(MenuPagingTest, DerivesPageSizeFromMaxHeight) {
+  MenuPagingOptions options = ResolveMenuPaging(
+      Style({{"maxHeight", flutter::EncodableValue(400.0)}}));
+  EXPECT_EQ(options.page_size, 13 + kPageMargin);  // ceil(400 / 32)
+
+  options = ResolveMenuPaging(Style({
+      {"maxHeight", flutter::EncodableValue(400.0)},
+      {"itemHeight", flutter::EncodableValue(20.0)},
+  }));
+  EXPECT_EQ(options.page_size, 20 + kPageMargin);
+}
+
+TEST(MenuPagingTest, ExplicitKeysWin) {
+  MenuPagingOptions options = ResolveMenuPaging(Style({
+      {"maxHeight", flutter::EncodableValue(400.0)},
+      {"virtualizationThreshold", flutter::EncodableValue(0)},
+      {"virtualizationPageSize", flutter::EncodableValue(25)},
+      {"virtualizationMaxItems", flutter::EncodableValue(int64_t{100})},
+      {"virtualizationMoreLabel", flutter::EncodableValue("Mehr")},
+  }));
+  EXPECT_EQ(options.threshold, 0u);
+  EXPECT_EQ(options.page_size, 25u);
+  EXPECT_EQ(options.max_items, 100u);
+  EXPECT_EQ(options.more_label, "Mehr");
+  EXPECT_EQ(options.previous_label, "Previous\xE2\x80\xA6");
+}
+
+TEST(MenuPagingTest, ClampsMaxItemsToPageSize) {
+  MenuPagingOptions options = ResolveMenuPaging(Style({
+      {"virtualizationPageSize", flutter::EncodableValue(0)},
+      {"virtualizationMaxItems", flutter::EncodableValue(-5)},
+  }));
+  EXPECT_EQ(options.page_size, 1u);
+  EXPECT_EQ(options.max_items, kDefaultPagingThreshold);
+
+  options = ResolveMenuPaging(Style({
+      {"virtualizationPageSize", flutter::EncodableValue(50)},
+      {"virtualizationMaxItems", flutter::EncodableValue(10)},
+  }));
+  EXPECT_EQ(options.max_items, 50u);
+}
+
+TEST(MenuPagingTest, PagesLongOrVirtualizedLists) {
+  MenuPagingOptions options;
+  options.threshold = 100;
+  options.page_size = 20;
+  EXPECT_FALSE(ShouldPageList(options, 100, false));
+  EXPECT_TRUE(ShouldPageList(options, 101, false));
+  EXPECT_TRUE(ShouldPageList(options, 21, true));
+  // A single page is never paged.
+  EXPECT_FALSE(ShouldPageList(options, 20, true));
+
+  options.threshold = 0;
+  EXPECT_FALSE(ShouldPageList(options, 100000, false));
+  EXPECT_TRUE(ShouldPageList(options, 100000, true));
+}
+
+TEST(MenuPageWindowTest, StartsAtTheFirstPage) {
+  MenuPageWindow window(1000, 40, 120);
+  EXPECT_EQ(window.begin(), 0u);
+  EXPECT_EQ(window.end(), 40u);
+  EXPECT_FALSE(window.has_previous());
+  EXPECT_TRUE(window.has_more());
+  EXPECT_TRUE(window.Contains(39));
+  EXPECT_FALSE(window.Contains(40));
+
+  MenuPageWindow short_list(10, 40, 120);
+  EXPECT_EQ(short_list.end(), 10u);
+  EXPECT_FALSE(short_list.has_more());
+}
+
+TEST(MenuPageWindowTest, GrowsUntilTheCapThenSlides) {
+  MenuPageWindow window(1000, 40, 100);
+  MenuPageChange change = window.Step(MenuPageDirection::kNext);
+  EXPECT_EQ(change.added_first, 40u);
+  EXPECT_EQ(change.added_count, 40u);
+  EXPECT_EQ(change.removed_count, 0u);
+
+  change = window.Step(MenuPageDirection::kNext);
+  EXPECT_EQ(change.added_first, 80u);
+  EXPECT_EQ(change.added_count, 40u);
+  EXPECT_EQ(change.removed_first, 0u);
+  EXPECT_EQ(change.removed_count, 20u);
+  EXPECT_EQ(window.begin(), 20u);
+  EXPECT_EQ(window.end(), 120u);
+  EXPECT_TRUE(window.has_previous());
+}
+
+TEST(MenuPageWindowTest, StopsAtTheEnds) {
+  MenuPageWindow window(90, 40, 100);
+  EXPECT_TRUE(window.Step(MenuPageDirection::kPrevious).empty());
+  window.Step(MenuPageDirection::kNext);
+  MenuPageChange change = window.Step(MenuPageDirection::kNext);
+  EXPECT_EQ(change.added_count, 10u);  // The last, partial page.
+  EXPECT_EQ(change.removed_count, 0u);
+  EXPECT_FALSE(window.has_more());
+  EXPECT_TRUE(window.Step(MenuPageDirection::kNext).empty());
+}
+
+TEST(MenuPageWindowTest, PagesBackDroppingTheTail) {
+  MenuPageWindow window(1000, 40, 80);
+  for (int i = 0; i < 5; ++i) window.Step(MenuPageDirection::kNext);
+  ASSERT_EQ(window.begin(), 160u);
+  ASSERT_EQ(window.end(), 240u);
+
+  MenuPageChange change = window.Step(MenuPageDirection::kPrevious);
+  EXPECT_EQ(change.added_first, 120u);
+  EXPECT_EQ(change.added_count, 40u);
+  EXPECT_EQ(change.removed_first, 200u);
+  EXPECT_EQ(change.removed_count, 40u);
+  EXPECT_EQ(window.begin(), 120u);
+  EXPECT_EQ(window.end(), 200u);
+}
+
+TEST(MenuPageWindowTest, NeverExceedsTheCap) {
+  MenuPageWindow window(100000, 37, 150);
+  for (int i = 0; i < 5000; ++i) {
+    window.Step(i % 7 == 6 ? MenuPageDirection::kPrevious
+                           : MenuPageDirection::kNext);
+    ASSERT_LE(window.size(), 150u);
+    ASSERT_LE(window.end(), window.count());
+  }
+  EXPECT_EQ(window.end(), 100000u);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,182 @@
+#include "menu_patch.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeSubmenu;
+
+flutter::EncodableValue Patch(int32_t id, const char* field,
+                              flutter::EncodableValue value) {
+  flutter::EncodableMap patch;
+  patch[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
+  patch[flutter::EncodableValue("field")] = flutter::EncodableValue(field);
+  patch[flutter::EncodableValue("value")] = std::move(value);
+  return flutter::EncodableValue(patch);
+}
+
+CompiledMenu MakeTestMenu() {
+  auto check = MakeItem(2, "checkbox", "Wrap");
+  check[flutter::EncodableValue("checked")] = flutter::EncodableValue(false);
+  return CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeItem(1, "normal", "Open")),
+      flutter::EncodableValue(check),
+      flutter::EncodableValue(MakeSubmenu(
+          3, "More",
+          {flutter::EncodableValue(MakeItem(4, "normal", "Open")),
+           flutter::EncodableValue(MakeItem(5, "normal", "Close"))})),
+  }));
+}
+
+const MenuNode* FindNode(const CompiledMenu& menu, int32_t id) {
+  for (const auto& node : menu.nodes()) {
+    if (node.id == id) return &node;
+  }
+  return nullptr;
+}
+
+TEST(MenuPatchTest, ParsesPatchableFields) {
+  MenuField field;
+  EXPECT_TRUE(ParseMenuField("label", &field));
+  EXPECT_EQ(field, MenuField::kLabel);
+  EXPECT_TRUE(ParseMenuField("acceleratorText", &field));
+  EXPECT_EQ(field, MenuField::kAcceleratorText);
+  EXPECT_FALSE(ParseMenuField("type", &field));
+  EXPECT_FALSE(ParseMenuField("radioGroup", &field));
+  EXPECT_FALSE(ParseMenuField("submenu", &field));
+}
+
+TEST(MenuPatchTest, AppliesBoolAndStringFields) {
+  CompiledMenu menu = MakeTestMenu();
+  MenuPatchResult result = ApplyMenuPatches(
+      menu, {Patch(2, "checked", flutter::EncodableValue(true)),
+             Patch(1, "disabled", flutter::EncodableValue(true)),
+             Patch(5, "label", flutter::EncodableValue("Close all")),
+             Patch(5, "toolTip", flutter::EncodableValue("Closes everything")),
+             Patch(1, "icon", flutter::EncodableValue("0xE8E5"))});
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(result.applied, 5u);
+
+  EXPECT_TRUE(FindNode(menu, 2)->checked);
+  EXPECT_TRUE(FindNode(menu, 1)->disabled);
+  EXPECT_EQ(menu.str(FindNode(menu, 5)->label), "Close all");
+  EXPECT_EQ(menu.str(FindNode(menu, 5)->tool_tip), "Closes everything");
+  EXPECT_EQ(menu.str(FindNode(menu, 1)->icon), "0xE8E5");
+}
+
+TEST(MenuPatchTest, SharedInternedLabelsStayIndependent) {
+  CompiledMenu menu = MakeTestMenu();
+  // Items 1 and 4 share the interned "Open".
+  ASSERT_EQ(FindNode(menu, 1)->label, FindNode(menu, 4)->label);
+  ApplyMenuPatches(menu, {Patch(4, "label", flutter::EncodableValue("Reopen"))});
+  EXPECT_EQ(menu.str(FindNode(menu, 1)->label), "Open");
+  EXPECT_EQ(menu.str(FindNode(menu, 4)->label), "Reopen");
+}
+
+TEST(MenuPatchTest, NullClearsField) {
+  CompiledMenu menu = MakeTestMenu();
+  ApplyMenuPatches(menu, {Patch(2, "checked", flutter::EncodableValue(true))});
+  MenuPatchResult result = ApplyMenuPatches(
+      menu, {Patch(2, "checked", flutter::EncodableValue()),
+             Patch(3, "label", flutter::EncodableValue())});
+  EXPECT_TRUE(result.ok());
+  EXPECT_FALSE(FindNode(menu, 2)->checked);
+  EXPECT_EQ(FindNode(menu, 3)->label, kEmptyString);
+}
+
+TEST(MenuPatchTest, UnchangedStringDoesNotGrowTable) {
+  CompiledMenu menu = MakeTestMenu();
+  const size_t strings = menu.string_count();
+  ApplyMenuPatches(menu, {Patch(5, "label", flutter::EncodableValue("Close"))});
+  EXPECT_EQ(menu.string_count(), strings);
+}
+
+TEST(MenuPatchTest, CompactsReplacedStrings) {
+  auto radio = MakeItem(6, "radio", "Fast");
+  radio[flutter::EncodableValue("radioGroup")] =
+      flutter::EncodableValue("speed");
+  auto menu_json = MakeMenu({
+      flutter::EncodableValue(MakeItem(1, "normal", "Open")),
+      flutter::EncodableValue(MakeItem(2, "normal", "Open")),
+      flutter::EncodableValue(radio),
+  });
+  CompiledMenu menu = CompileMenu(menu_json);
+  const size_t strings = menu.string_count();
+  const std::string long_label(1000, 'x');
+  for (char c = 'a'; c <= 'z'; ++c) {
+    ApplyMenuPatches(menu, {Patch(1, "label",
+                                  flutter::EncodableValue(long_label + c))});
+  }
+
+  // Only the live strings remain, interned again, with their UTF-16 forms.
+  EXPECT_LE(menu.string_count(), strings + 5);
+  EXPECT_EQ(menu.text(FindNode(menu, 1)->label).utf16.size(), 1001u);
+  EXPECT_EQ(menu.str(FindNode(menu, 1)->label).back(), 'z');
+  EXPECT_EQ(menu.text(FindNode(menu, 2)->label).utf16, u"Open");
+  EXPECT_EQ(menu.str(FindNode(menu, 6)->radio_group), "speed");
+}
+
+TEST(MenuPatchTest, LastPatchForSameFieldWins) {
+  CompiledMenu menu = MakeTestMenu();
+  ApplyMenuPatches(menu, {Patch(5, "label", flutter::EncodableValue("A")),
+                          Patch(1, "label", flutter::EncodableValue("X")),
+                          Patch(5, "label", flutter::EncodableValue("B"))});
+  EXPECT_EQ(menu.str(FindNode(menu, 5)->label), "B");
+  EXPECT_EQ(menu.str(FindNode(menu, 1)->label), "X");
+}
+
+TEST(MenuPatchTest, PatchesEveryNodeWithTheId) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeItem(1, "normal", "Open")),
+      flutter::EncodableValue(MakeSubmenu(
+          2, "More", {flutter::EncodableValue(MakeItem(1, "normal", "Open"))})),
+  }));
+  MenuPatchResult result = ApplyMenuPatches(
+      menu, {Patch(1, "disabled", flutter::EncodableValue(true))});
+  EXPECT_EQ(result.applied, 1u);
+  EXPECT_TRUE(menu.node(0).disabled);
+  EXPECT_TRUE(menu.node(menu.node(1).first_child).disabled);
+}
+
+TEST(MenuPatchTest, ReportsUnknownIdsAndInvalidPatches) {
+  CompiledMenu menu = MakeTestMenu();
+  flutter::EncodableMap missing_field;
+  missing_field[flutter::EncodableValue("id")] = flutter::EncodableValue(1);
+  MenuPatchResult result = ApplyMenuPatches(
+      menu, {Patch(99, "label", flutter::EncodableValue("x")),
+             Patch(1, "type", flutter::EncodableValue("separator")),
+             Patch(1, "checked", flutter::EncodableValue("yes")),
+             Patch(1, "label", flutter::EncodableValue(true)),
+             flutter::EncodableValue(missing_field),
+             flutter::EncodableValue(7),
+             Patch(2, "checked", flutter::EncodableValue(true))});
+  EXPECT_FALSE(result.ok());
+  EXPECT_EQ(result.applied, 1u);
+  EXPECT_EQ(result.unknown_id, 1u);
+  EXPECT_EQ(result.invalid, 5u);
+  EXPECT_TRUE(FindNode(menu, 2)->checked);
+  EXPECT_EQ(FindNode(menu, 1)->type, MenuItemType::kNormal);
+  EXPECT_EQ(menu.str(FindNode(menu, 1)->label), "Open");
+}
+
+TEST(MenuPatchTest, LayoutIsUntouched) {
+  CompiledMenu menu = MakeTestMenu();
+  const MenuNode before = *FindNode(menu, 3);
+  ApplyMenuPatches(menu, {Patch(3, "label", flutter::EncodableValue("Less")),
+                          Patch(3, "disabled", flutter::EncodableValue(true))});
+  const MenuNode& after = *FindNode(menu, 3);
+  EXPECT_EQ(after.first_child, before.first_child);
+  EXPECT_EQ(after.child_count, before.child_count);
+  EXPECT_EQ(after.type, MenuItemType::kSubmenu);
+  EXPECT_EQ(menu.root_count(), 3u);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
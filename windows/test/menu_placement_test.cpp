@@ -0,0 +1,59 @@
+#include "menu_placement.h"
+
+#include <gtest/gtest.h>
+
+namespace tray_manager_winui {
+namespace {
+
+TEST(MenuPlacementTest, ParsesEveryDartPlacementName) {
+  // WinUIFlyoutPlacement in lib/src/winui_flyout_placement.dart.
+  EXPECT_EQ(ParseMenuPlacement("top"), MenuPlacement::kTop);
+  EXPECT_EQ(ParseMenuPlacement("bottom"), MenuPlacement::kBottom);
+  EXPECT_EQ(ParseMenuPlacement("left"), MenuPlacement::kLeft);
+  EXPECT_EQ(ParseMenuPlacement("right"), MenuPlacement::kRight);
+  EXPECT_EQ(ParseMenuPlacement("full"), MenuPlacement::kFull);
+  EXPECT_EQ(ParseMenuPlacement("auto"), MenuPlacement::kAuto);
+  EXPECT_EQ(ParseMenuPlacement("topEdgeAlignedLeft"),
+            MenuPlacement::kTopEdgeAlignedLeft);
+  EXPECT_EQ(ParseMenuPlacement("topEdgeAlignedRight"),
+            MenuPlacement::kTopEdgeAlignedRight);
+  EXPECT_EQ(ParseMenuPlacement("bottomEdgeAlignedLeft"),
+            MenuPlacement::kBottomEdgeAlignedLeft);
+  EXPECT_EQ(ParseMenuPlacement("bottomEdgeAlignedRight"),
+            MenuPlacement::kBottomEdgeAlignedRight);
+  EXPECT_EQ(ParseMenuPlacement("leftEdgeAlignedTop"),
+            MenuPlacement::kLeftEdgeAlignedTop);
+  EXPECT_EQ(ParseMenuPlacement("leftEdgeAlignedBottom"),
+            MenuPlacement::kLeftEdgeAlignedBottom);
+  EXPECT_EQ(ParseMenuPlacement("rightEdgeAlignedTop"),
+            MenuPlacement::kRightEdgeAlignedTop);
+  EXPECT_EQ(ParseMenuPlacement("rightEdgeAlignedBottom"),
+            MenuPlacement::kRightEdgeAlignedBottom);
+}
+
+TEST(MenuPlacementTest, RejectsUnknownNames) {
+  EXPECT_FALSE(ParseMenuPlacement("").has_value());
+  EXPECT_FALSE(ParseMenuPlacement("Top").has_value());
+  EXPECT_FALSE(ParseMenuPlacement("topEdgeAligned").has_value());
+}
+
+TEST(MenuPlacementTest, ParsesExclusionRects) {
+  flutter::EncodableMap rect;
+  rect[flutter::EncodableValue("x")] = flutter::EncodableValue(10.5);
+  rect[flutter::EncodableValue("y")] = flutter::EncodableValue(int32_t{20});
+  rect[flutter::EncodableValue("width")] =
+      flutter::EncodableValue(int64_t{300});
+  rect[flutter::EncodableValue("height")] = flutter::EncodableValue("40");
+  const MenuRect parsed = ParseMenuRect(rect);
+  EXPECT_EQ(parsed.x, 10.5);
+  EXPECT_EQ(parsed.y, 20.0);
+  EXPECT_EQ(parsed.width, 300.0);
+  // Not a number.
+  EXPECT_EQ(parsed.height, 0.0);
+
+  const MenuRect empty = ParseMenuRect(flutter::EncodableMap());
+  EXPECT_EQ(empty.width, 0.0);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,192 @@
+#include "menu_prepare.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include "task_thread.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::TaskThread;
+
+TEST(MenuPrepareTest, PrepareThenShowOpensThePreparedFlyout) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  ASSERT_NE(ticket, 0u);
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kPreparing);
+  ASSERT_TRUE(tracker.StartPrepare(ticket, version));
+  tracker.FinishPrepare(ticket, true);
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kPrepared);
+
+  EXPECT_EQ(tracker.BeginShow(version), MenuPrepareShow::kUsePrepared);
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kConsumed);
+  // Consumed: the next show compares menus again.
+  EXPECT_EQ(tracker.BeginShow(version), MenuPrepareShow::kBuild);
+  EXPECT_EQ(tracker.stats().hits, 1u);
+  EXPECT_EQ(tracker.stats().misses, 1u);
+}
+
+TEST(MenuPrepareTest, RepeatedRequestsForTheSameMenuAreDropped) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  EXPECT_EQ(tracker.RequestPrepare(), 0u);  // Preparing.
+  ASSERT_TRUE(tracker.StartPrepare(ticket, version));
+  tracker.FinishPrepare(ticket, true);
+  EXPECT_EQ(tracker.RequestPrepare(), 0u);  // Prepared.
+  EXPECT_EQ(tracker.stats().duplicates, 2u);
+
+  // After a show, hovering again prepares again.
+  tracker.BeginShow(version);
+  EXPECT_NE(tracker.RequestPrepare(), 0u);
+}
+
+TEST(MenuPrepareTest, SetDuringPrepareLeavesItStale) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  ASSERT_TRUE(tracker.StartPrepare(ticket, version));
+  const uint64_t next = tracker.OnMenuChanged();
+  tracker.FinishPrepare(ticket, true);
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kStale);
+  EXPECT_EQ(tracker.BeginShow(next), MenuPrepareShow::kBuild);
+}
+
+TEST(MenuPrepareTest, SetAfterPrepareMakesItStale) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  ASSERT_TRUE(tracker.StartPrepare(ticket, version));
+  tracker.FinishPrepare(ticket, true);
+  const uint64_t next = tracker.OnMenuChanged();
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kStale);
+  // A show still queued with the old menu cannot use it either.
+  EXPECT_EQ(tracker.BeginShow(version), MenuPrepareShow::kBuild);
+
+  const uint64_t again = tracker.RequestPrepare();
+  ASSERT_NE(again, 0u);
+  ASSERT_TRUE(tracker.StartPrepare(again, next));
+  tracker.FinishPrepare(again, true);
+  EXPECT_EQ(tracker.BeginShow(next), MenuPrepareShow::kUsePrepared);
+}
+
+TEST(MenuPrepareTest, SetBeforePrepareStartsSkipsTheBuild) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  tracker.OnMenuChanged();
+  EXPECT_FALSE(tracker.StartPrepare(ticket, version));
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kStale);
+  EXPECT_EQ(tracker.stats().skipped, 1u);
+}
+
+TEST(MenuPrepareTest, ShowQueuedBeforeThePrepareOvertakesIt) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  // The show runs first and builds the menu itself; the prepare must not
+  // touch the open flyout afterwards.
+  EXPECT_EQ(tracker.BeginShow(version), MenuPrepareShow::kBuild);
+  EXPECT_FALSE(tracker.StartPrepare(ticket, version));
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kConsumed);
+}
+
+TEST(MenuPrepareTest, ShowArrivingMidPrepareDiscardsItsResult) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  const uint64_t ticket = tracker.RequestPrepare();
+  ASSERT_TRUE(tracker.StartPrepare(ticket, version));
+  EXPECT_EQ(tracker.BeginShow(version), MenuPrepareShow::kBuild);
+  tracker.FinishPrepare(ticket, true);
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kConsumed);
+  EXPECT_EQ(tracker.stats().completed, 0u);
+}
+
+TEST(MenuPrepareTest, NewerPrepareSupersedesAnOlderOne) {
+  MenuPrepareTracker tracker;
+  const uint64_t first_version = tracker.OnMenuChanged();
+  const uint64_t first = tracker.RequestPrepare();
+  const uint64_t second_version = tracker.OnMenuChanged();
+  const uint64_t second = tracker.RequestPrepare();
+  ASSERT_NE(second, 0u);
+  EXPECT_NE(first, second);
+  EXPECT_FALSE(tracker.StartPrepare(first, first_version));
+  tracker.FinishPrepare(first, true);  // Ignored.
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kPreparing);
+  ASSERT_TRUE(tracker.StartPrepare(second, second_version));
+  tracker.FinishPrepare(second, true);
+  EXPECT_EQ(tracker.BeginShow(second_version), MenuPrepareShow::kUsePrepared);
+}
+
+TEST(MenuPrepareTest, FailureAndInvalidateReturnToIdle) {
+  MenuPrepareTracker tracker;
+  const uint64_t version = tracker.OnMenuChanged();
+  uint64_t ticket = tracker.RequestPrepare();
+  ASSERT_TRUE(tracker.StartPrepare(ticket, version));
+  tracker.FinishPrepare(ticket, false);
+  EXPECT_EQ(tracker.state(), MenuPrepareState::kIdle);
+  EXPECT_EQ(tracker.stats().failed, 1u);
+
+  ticket = tracker.RequestPrepare();
+  ASSERT_NE(ticket, 0u);
+  tracker.Invalidate();  // E.g. the pool was reset for a new channel.
+  EXPECT_FALSE(tracker.StartPrepare(ticket, version));
+  EXPECT_EQ(tracker.BeginShow(version), MenuPrepareShow::kBuild);
+}
+
+// The platform thread changes the menu, requests prepares and shows at
+// random while the XAML thread runs them against a model pool that records
+// which menu version its items hold. A show may only skip building when the
+// items hold exactly its menu.
+TEST(MenuPrepareTest, ShowsNeverOpenAFlyoutBuiltForAnotherMenu) {
+  MenuPrepareTracker tracker;
+  uint64_t built_version = 0;  // XAML thread only.
+  std::atomic<int> wrong{0};
+  std::atomic<int> builds_by_prepare{0};
+  {
+    TaskThread xaml;
+    std::mt19937 rng(7);
+    uint64_t version = tracker.OnMenuChanged();
+    for (int i = 0; i < 20000; ++i) {
+      switch (rng() % 4) {
+        case 0:
+          version = tracker.OnMenuChanged();
+          break;
+        case 1:
+        case 2:
+          if (const uint64_t ticket = tracker.RequestPrepare()) {
+            xaml.Post([&, ticket, version] {
+              if (!tracker.StartPrepare(ticket, version)) return;
+              built_version = version;
+              ++builds_by_prepare;
+              tracker.FinishPrepare(ticket, true);
+            });
+          }
+          break;
+        default:
+          xaml.Post([&, version] {
+            if (tracker.BeginShow(version) == MenuPrepareShow::kUsePrepared) {
+              if (built_version != version) ++wrong;
+            } else {
+              built_version = version;
+            }
+          });
+          break;
+      }
+      if (i % 64 == 0) std::this_thread::yield();
+    }
+  }
+  EXPECT_EQ(wrong.load(), 0);
+  const MenuPrepareStats stats = tracker.stats();
+  EXPECT_GT(stats.hits, 0u);
+  EXPECT_GT(builds_by_prepare.load(), 0);
+  EXPECT_EQ(stats.started, static_cast<uint64_t>(builds_by_prepare.load()));
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,230 @@
+#include "menu_registry.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "menu_fixtures.h"
+#include "style_fingerprint.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeFontStyle;
+using testing::MakeSnapshot;
+using testing::MakeSyntheticMenu;
+
+MenuSnapshotPtr MakeSyntheticSnapshot(int32_t item_count,
+                                      double font_size = 14) {
+  return MakeSnapshot(CompileMenu(MakeSyntheticMenu(item_count, 10)),
+                      font_size);
+}
+
+// Accounted size of a registration of an item_count menu under a one-letter
+// handle (the handle fits the small string buffer).
+size_t EntryBytes(int32_t item_count) {
+  MenuRegistry probe;
+  return probe.Register("x", MakeSyntheticSnapshot(item_count)).bytes;
+}
+
+size_t SumOfEntries(const MenuRegistry& registry,
+                    const std::vector<std::string>& handles) {
+  size_t bytes = 0;
+  for (const auto& handle : handles) {
+    if (const RegisteredMenu* entry = registry.Find(handle)) {
+      bytes += entry->bytes;
+    }
+  }
+  return bytes;
+}
+
+TEST(MenuRegistryTest, RegisterThenUse) {
+  MenuRegistry registry;
+  const MenuSnapshotPtr snapshot = MakeSyntheticSnapshot(20);
+  const RegisteredMenu& entry = registry.Register("tray", snapshot);
+
+  EXPECT_EQ(entry.handle, "tray");
+  // Shared, not copied.
+  EXPECT_EQ(entry.snapshot, snapshot);
+  EXPECT_EQ(entry.snapshot->menu.nodes().size(), 20u);
+  EXPECT_EQ(entry.snapshot->style->font_size, 14.0);
+  EXPECT_EQ(entry.snapshot->style->fingerprint,
+            FingerprintStyle(MakeFontStyle(14)));
+  EXPECT_GT(entry.bytes, 0u);
+  EXPECT_EQ(registry.used_bytes(), entry.bytes);
+  EXPECT_EQ(registry.size(), 1u);
+
+  const RegisteredMenu* used = registry.Use("tray");
+  ASSERT_NE(used, nullptr);
+  EXPECT_EQ(used, &entry);
+  EXPECT_EQ(registry.Use("other"), nullptr);
+  EXPECT_EQ(registry.stats().hits, 1u);
+  EXPECT_EQ(registry.stats().misses, 1u);
+}
+
+TEST(MenuRegistryTest, ReRegisterReplacesAndChangesVersion) {
+  MenuRegistry registry;
+  const uint64_t first =
+      registry.Register("tray", MakeSyntheticSnapshot(20)).version;
+  const RegisteredMenu& second =
+      registry.Register("tray", MakeSyntheticSnapshot(200, 16));
+
+  EXPECT_NE(second.version, first);
+  EXPECT_EQ(second.snapshot->menu.nodes().size(), 200u);
+  EXPECT_EQ(second.snapshot->style->fingerprint,
+            FingerprintStyle(MakeFontStyle(16)));
+  EXPECT_EQ(registry.size(), 1u);
+  // The replaced menu no longer counts.
+  EXPECT_EQ(registry.used_bytes(), second.bytes);
+  EXPECT_EQ(registry.stats().registrations, 2u);
+  EXPECT_EQ(registry.stats().replacements, 1u);
+}
+
+TEST(MenuRegistryTest, DisposeFreesTheBudget) {
+  MenuRegistry registry;
+  registry.Register("a", MakeSyntheticSnapshot(20));
+  const size_t b_bytes =
+      registry.Register("b", MakeSyntheticSnapshot(50)).bytes;
+
+  EXPECT_TRUE(registry.Dispose("a"));
+  EXPECT_FALSE(registry.Dispose("a"));
+  EXPECT_EQ(registry.Use("a"), nullptr);
+  EXPECT_NE(registry.Use("b"), nullptr);
+  EXPECT_EQ(registry.used_bytes(), b_bytes);
+  EXPECT_EQ(registry.stats().disposals, 1u);
+
+  EXPECT_TRUE(registry.Dispose("b"));
+  EXPECT_EQ(registry.used_bytes(), 0u);
+  EXPECT_EQ(registry.size(), 0u);
+}
+
+TEST(MenuRegistryTest, EvictsLeastRecentlyShownFirst) {
+  // Room for three menus of the same size, not four.
+  const size_t entry_bytes = EntryBytes(100);
+  MenuRegistry registry(entry_bytes * 3 + entry_bytes / 2);
+  registry.Register("a", MakeSyntheticSnapshot(100));
+  registry.Register("b", MakeSyntheticSnapshot(100));
+  registry.Register("c", MakeSyntheticSnapshot(100));
+  ASSERT_EQ(registry.size(), 3u);
+
+  // Showing a makes b the least recently shown.
+  ASSERT_NE(registry.Use("a"), nullptr);
+  registry.Register("d", MakeSyntheticSnapshot(100));
+
+  EXPECT_EQ(registry.size(), 3u);
+  EXPECT_EQ(registry.Find("b"), nullptr);
+  EXPECT_NE(registry.Find("a"), nullptr);
+  EXPECT_NE(registry.Find("c"), nullptr);
+  EXPECT_NE(registry.Find("d"), nullptr);
+  EXPECT_EQ(registry.stats().evictions, 1u);
+  EXPECT_LE(registry.used_bytes(), registry.budget_bytes());
+
+  // Find does not count as a show: c is next.
+  ASSERT_NE(registry.Find("c"), nullptr);
+  registry.Register("e", MakeSyntheticSnapshot(100));
+  EXPECT_EQ(registry.Find("c"), nullptr);
+  EXPECT_NE(registry.Find("a"), nullptr);
+}
+
+TEST(MenuRegistryTest, EvictsAsManyAsNeededForALargeMenu) {
+  const size_t small_bytes = EntryBytes(20);
+  MenuRegistry registry(EntryBytes(500) + small_bytes);
+  for (const char* handle : {"a", "b", "c", "d"}) {
+    registry.Register(handle, MakeSyntheticSnapshot(20));
+  }
+  registry.Register("big", MakeSyntheticSnapshot(500));
+
+  EXPECT_NE(registry.Find("big"), nullptr);
+  EXPECT_NE(registry.Find("d"), nullptr);
+  EXPECT_EQ(registry.Find("a"), nullptr);
+  EXPECT_EQ(registry.Find("c"), nullptr);
+  EXPECT_LE(registry.used_bytes(), registry.budget_bytes());
+}
+
+TEST(MenuRegistryTest, KeepsANewMenuLargerThanTheBudget) {
+  MenuRegistry registry(EntryBytes(20) * 2);
+  registry.Register("small", MakeSyntheticSnapshot(20));
+  const RegisteredMenu& big =
+      registry.Register("big", MakeSyntheticSnapshot(1000));
+
+  // Everything else goes, but the menu about to be shown stays.
+  EXPECT_EQ(registry.Find("small"), nullptr);
+  EXPECT_EQ(registry.Find("big"), &big);
+  EXPECT_GT(registry.used_bytes(), registry.budget_bytes());
+
+  // The next registration evicts it like any other.
+  registry.Register("small", MakeSyntheticSnapshot(20));
+  EXPECT_EQ(registry.Find("big"), nullptr);
+  EXPECT_LE(registry.used_bytes(), registry.budget_bytes());
+}
+
+TEST(MenuRegistryTest, ShrinkingTheBudgetEvicts) {
+  MenuRegistry registry;
+  for (const char* handle : {"a", "b", "c", "d"}) {
+    registry.Register(handle, MakeSyntheticSnapshot(100));
+  }
+  ASSERT_NE(registry.Use("a"), nullptr);
+
+  registry.set_budget_bytes(EntryBytes(100) * 2);
+  EXPECT_EQ(registry.size(), 2u);
+  EXPECT_NE(registry.Find("a"), nullptr);
+  EXPECT_NE(registry.Find("d"), nullptr);
+
+  registry.set_budget_bytes(0);
+  EXPECT_EQ(registry.size(), 0u);
+  EXPECT_EQ(registry.used_bytes(), 0u);
+}
+
+TEST(MenuRegistryTest, AccountedBytesGrowWithTheMenu) {
+  EXPECT_LT(EntryBytes(10), EntryBytes(100));
+  EXPECT_LT(EntryBytes(100), EntryBytes(1000));
+  // Roughly the compiled nodes plus their strings in both encodings.
+  EXPECT_GT(EntryBytes(1000), 1000 * sizeof(MenuNode));
+
+  // The resolved style counts its strings.
+  flutter::EncodableMap labelled = MakeFontStyle(14);
+  const std::string label(200, 'x');
+  labelled[flutter::EncodableValue("virtualizationMoreLabel")] =
+      flutter::EncodableValue(label);
+  EXPECT_GE(ResolveStyle(labelled).memory_bytes(),
+            ResolveStyle(MakeFontStyle(14)).memory_bytes() + label.size());
+}
+
+TEST(MenuRegistryTest, RandomOperationsKeepTheAccounting) {
+  std::mt19937 rng(20);
+  const std::vector<std::string> handles = {"a", "b", "c", "d", "e",
+                                            "f", "g", "h", "i", "j"};
+  MenuRegistry registry(EntryBytes(100) * 4);
+  for (int step = 0; step < 2000; ++step) {
+    const std::string& handle = handles[rng() % handles.size()];
+    switch (rng() % 5) {
+      case 0:
+      case 1:
+        registry.Register(
+            handle, MakeSyntheticSnapshot(10 + rng() % 200, 12 + rng() % 4));
+        // Only the new menu may exceed the budget, and only on its own.
+        if (registry.size() > 1) {
+          EXPECT_LE(registry.used_bytes(), registry.budget_bytes());
+        }
+        EXPECT_NE(registry.Find(handle), nullptr);
+        break;
+      case 2:
+      case 3:
+        registry.Use(handle);
+        break;
+      case 4:
+        registry.Dispose(handle);
+        break;
+    }
+    ASSERT_EQ(registry.used_bytes(), SumOfEntries(registry, handles));
+  }
+  const MenuRegistryStats& stats = registry.stats();
+  EXPECT_EQ(stats.registrations - stats.replacements - stats.disposals -
+                stats.evictions,
+            registry.size());
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
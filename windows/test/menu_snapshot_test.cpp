@@ -0,0 +1,224 @@
+#include "menu_snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "allocation_counter.h"
+#include "menu_fixtures.h"
+#include "recording_menu_backend.h"
+#include "show_scheduler.h"
+#include "style_fingerprint.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::AllocationScope;
+using testing::HeadlessContextMenu;
+using testing::MakeFontStyle;
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeSubmenu;
+using testing::MakeSyntheticMenu;
+
+// A font style with key_count further entries; a copy of it allocates at
+// least one node per entry.
+flutter::EncodableMap MakeStyleWithExtraKeys(int key_count) {
+  flutter::EncodableMap style = MakeFontStyle(13);
+  for (int i = 0; i < key_count; ++i) {
+    style[flutter::EncodableValue("extension" + std::to_string(i))] =
+        flutter::EncodableValue("a value longer than the small string buffer");
+  }
+  return style;
+}
+
+// Two submenus, so that one can be opened on each side of a menu change.
+CompiledMenu MakeTwoSubmenuMenu(const std::string& inner_label) {
+  return CompileMenu(MakeMenu({
+      flutter::EncodableValue(MakeItem(1, "normal", "Open")),
+      flutter::EncodableValue(MakeSubmenu(
+          2, "Recent", {flutter::EncodableValue(MakeItem(4, "normal",
+                                                         inner_label))})),
+      flutter::EncodableValue(MakeSubmenu(
+          3, "Tools", {flutter::EncodableValue(MakeItem(5, "normal",
+                                                        inner_label))})),
+  }));
+}
+
+// What ShowWinUIContextMenu queues for the XAML thread (PendingShow).
+struct QueuedShow {
+  MenuSnapshotPtr snapshot;
+  MenuShowRequest request;
+};
+
+// Runs one show the way the plugin does: the platform thread submits the
+// current snapshot, the XAML thread takes it from the scheduler and shows it
+// through the pool, then the user closes the menu.
+bool RunShow(ShowScheduler<QueuedShow>& shows, HeadlessContextMenu& headless,
+             const MenuSnapshotPtr& current) {
+  QueuedShow show;
+  show.snapshot = current;
+  show.request.x = 100;
+  show.request.y = 200;
+  show.request.placement = "top";
+  show.request.exclusion_rect = MenuRect{0, 1040, 1920, 40};
+  shows.Submit(std::move(show), [](bool) {});
+  ShowAction<QueuedShow> action = shows.Next();
+  if (action.step != ShowStep::kShow) return false;
+  const bool shown = headless.Show(std::move(action.request->snapshot),
+                                   action.request->request);
+  if (shown) shows.OnOpened(action.id);
+  headless.Close();
+  shows.OnClosed(action.id);
+  return shown;
+}
+
+// Allocations of a warm show (host, flyout and items exist) of snapshot.
+int64_t WarmShowAllocations(const MenuSnapshotPtr& snapshot) {
+  ShowScheduler<QueuedShow> shows;
+  HeadlessContextMenu headless;
+  headless.backend().set_logging(false);
+  EXPECT_TRUE(RunShow(shows, headless, snapshot));
+  AllocationScope scope;
+  EXPECT_TRUE(RunShow(shows, headless, snapshot));
+  const int64_t allocations = scope.count();
+  EXPECT_EQ(headless.pool().built(), snapshot);
+  return allocations;
+}
+
+TEST(MenuSnapshotTest, MakeMovesTheMenuInAndResolvesTheStyle) {
+  const flutter::EncodableMap style = MakeStyleWithExtraKeys(4);
+  CompiledMenu menu = CompileMenu(MakeSyntheticMenu(100, 10));
+  const MenuNode* nodes = menu.nodes().data();
+
+  MenuSnapshotPtr snapshot = MakeMenuSnapshot(std::move(menu), style);
+  // The buffers moved, not copied.
+  EXPECT_EQ(snapshot->menu.nodes().data(), nodes);
+  ASSERT_NE(snapshot->style, nullptr);
+  EXPECT_EQ(snapshot->style->font_size, 13.0);
+  EXPECT_EQ(snapshot->style->fingerprint, FingerprintStyle(style));
+}
+
+TEST(MenuSnapshotTest, MakeDoesNotCopyTheStyle) {
+  auto allocations = [](int key_count) {
+    CompiledMenu menu = CompileMenu(MakeSyntheticMenu(10, 10));
+    const flutter::EncodableMap style = MakeStyleWithExtraKeys(key_count);
+    AllocationScope scope;
+    MenuSnapshotPtr snapshot = MakeMenuSnapshot(std::move(menu), style);
+    return scope.count();
+  };
+  EXPECT_EQ(allocations(0), allocations(500));
+}
+
+TEST(MenuSnapshotTest, ShowsMakeNoCopies) {
+  // Same work for a 10-item menu with a 2-key style as for a 2000-item menu
+  // with a 500-key style: nothing on the way from the plugin's snapshot to
+  // the pool copies the menu or the style.
+  const int64_t small = WarmShowAllocations(
+      MakeMenuSnapshot(CompileMenu(MakeSyntheticMenu(10, 10)),
+                       MakeStyleWithExtraKeys(0)));
+  const int64_t large = WarmShowAllocations(MakeMenuSnapshot(
+      CompileMenu(MakeSyntheticMenu(2000, 10)), MakeStyleWithExtraKeys(500)));
+  EXPECT_EQ(small, large);
+  // Scheduler bookkeeping (the callback) only.
+  EXPECT_LE(large, 4);
+}
+
+TEST(MenuSnapshotTest, OpenFlyoutKeepsItsSnapshot) {
+  HeadlessContextMenu headless;
+  MenuSnapshotPtr current = MakeMenuSnapshot(MakeTwoSubmenuMenu("Inner"), {});
+  ASSERT_TRUE(headless.Show(current));
+  std::weak_ptr<const MenuSnapshot> shown = current;
+
+  // A setContextMenu while the menu is open replaces the plugin's snapshot.
+  current = MakeMenuSnapshot(MakeTwoSubmenuMenu("Renamed"), {});
+  ASSERT_FALSE(shown.expired());
+  // A submenu opened now is built from what the flyout shows.
+  ASSERT_TRUE(headless.backend().OpenSubmenu(1));
+  EXPECT_EQ(headless.backend().widget(3).text, "Inner");
+  ASSERT_TRUE(headless.Close());
+
+  // Same layout: the built items are updated and rebound to the new
+  // snapshot, and the old one is released.
+  ASSERT_TRUE(headless.Show(current));
+  EXPECT_EQ(headless.pool().stats().item_builds, 1u);
+  EXPECT_EQ(headless.backend().widget(3).text, "Renamed");
+  EXPECT_TRUE(shown.expired());
+  // Submenus built later read the new snapshot.
+  ASSERT_TRUE(headless.backend().OpenSubmenu(2));
+  EXPECT_EQ(headless.backend().widget(4).text, "Renamed");
+}
+
+flutter::EncodableList CheckedPatch(int32_t id, bool checked) {
+  flutter::EncodableMap patch;
+  patch[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
+  patch[flutter::EncodableValue("field")] = flutter::EncodableValue("checked");
+  patch[flutter::EncodableValue("value")] = flutter::EncodableValue(checked);
+  return flutter::EncodableList{flutter::EncodableValue(patch)};
+}
+
+TEST(MenuSnapshotTest, PatchCopiesAHeldMenuAndSharesTheStyle) {
+  CompiledMenu menu = CompileMenu(MakeMenu(
+      {flutter::EncodableValue(MakeItem(1, "checkbox", "Wrap lines"))}));
+  std::shared_ptr<MenuSnapshot> patched =
+      MakeMenuSnapshot(std::move(menu), MakeStyleWithExtraKeys(2));
+  // As a show or the pooled flyout holds it.
+  MenuSnapshotPtr base = patched;
+
+  EXPECT_TRUE(PatchMenuSnapshot(patched, CheckedPatch(1, true)).ok());
+  EXPECT_NE(patched, base);
+  EXPECT_TRUE(patched->menu.node(0).checked);
+  // A show holding base still sees the menu it was given.
+  EXPECT_FALSE(base->menu.node(0).checked);
+  EXPECT_EQ(patched->style, base->style);
+}
+
+TEST(MenuSnapshotTest, PatchesInPlaceWhenNothingElseHoldsTheMenu) {
+  std::shared_ptr<MenuSnapshot> snapshot = MakeMenuSnapshot(
+      CompileMenu(MakeSyntheticMenu(2000, 100)), MakeStyleWithExtraKeys(2));
+  const MenuSnapshot* original = snapshot.get();
+  // Id 3 is a checkbox.
+  EXPECT_TRUE(PatchMenuSnapshot(snapshot, CheckedPatch(3, true)).ok());
+  EXPECT_EQ(snapshot.get(), original);
+  snapshot->menu.ForEachNodeWithId(3, [&](uint32_t index) {
+    EXPECT_TRUE(snapshot->menu.node(index).checked);
+  });
+
+  // Once the show that held it is gone, patches are in place again.
+  { MenuSnapshotPtr shown = snapshot; }
+  EXPECT_TRUE(PatchMenuSnapshot(snapshot, CheckedPatch(3, false)).ok());
+  EXPECT_EQ(snapshot.get(), original);
+}
+
+TEST(MenuSnapshotTest, RepeatedLabelPatchesKeepTheSnapshotBounded) {
+  auto label_patch = [](int step) {
+    flutter::EncodableMap patch;
+    patch[flutter::EncodableValue("id")] = flutter::EncodableValue(2);
+    patch[flutter::EncodableValue("field")] = flutter::EncodableValue("label");
+    patch[flutter::EncodableValue("value")] = flutter::EncodableValue(
+        "Syncing: " + std::to_string(step) + " of 10000 files uploaded");
+    return flutter::EncodableList{flutter::EncodableValue(patch)};
+  };
+  std::shared_ptr<MenuSnapshot> snapshot =
+      MakeMenuSnapshot(MakeTwoSubmenuMenu("Inner"), MakeStyleWithExtraKeys(0));
+  PatchMenuSnapshot(snapshot, label_patch(0));
+  const size_t first_bytes = EstimateMenuSnapshotBytes(*snapshot);
+
+  size_t max_bytes = 0;
+  for (int step = 1; step <= 10000; ++step) {
+    PatchMenuSnapshot(snapshot, label_patch(step));
+    max_bytes = std::max(max_bytes, EstimateMenuSnapshotBytes(*snapshot));
+  }
+  EXPECT_EQ(snapshot->menu.str(snapshot->menu.node(1).label),
+            "Syncing: 10000 of 10000 files uploaded");
+  EXPECT_EQ(snapshot->menu.str(snapshot->menu.node(3).label), "Inner");
+  // Without compaction the label alone would add over 400 KB.
+  EXPECT_LT(max_bytes, first_bytes + 32 * 1024);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
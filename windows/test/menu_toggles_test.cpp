@@ -0,0 +1,204 @@
+#include "menu_toggles.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#include "menu_fixtures.h"
+#include "menu_snapshot.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeRadio;
+using testing::MakeSubmenu;
+
+flutter::EncodableMap Checkbox(int32_t id, bool checked) {
+  flutter::EncodableMap item = MakeItem(id, "checkbox", "Checkbox");
+  item[flutter::EncodableValue("checked")] = flutter::EncodableValue(checked);
+  return item;
+}
+
+// One named group of radio items, optionally with the first one checked.
+CompiledMenu MakeGroupMenu(int32_t size, bool first_checked) {
+  flutter::EncodableList items;
+  for (int32_t i = 0; i < size; ++i) {
+    items.emplace_back(MakeRadio(i + 1, "size", first_checked && i == 0));
+  }
+  return CompileMenu(MakeMenu(std::move(items)));
+}
+
+int CountChecked(const CompiledMenu& menu) {
+  int count = 0;
+  for (uint32_t i = 0; i < menu.nodes().size(); ++i) {
+    if (menu.toggles().checked(i)) ++count;
+  }
+  return count;
+}
+
+TEST(MenuTogglesTest, GroupsRadioItemsAtCompileTime) {
+  // Nodes: 0 Radio "size", 1 Sub, 2 Radio "", 3 Radio "", 4 Checkbox,
+  // then the submenu: 5 Radio "size", 6 Radio "", 7 Radio "theme".
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      MakeRadio(1, "size"),
+      MakeSubmenu(2, "More", {MakeRadio(6, "size"), MakeRadio(7, ""),
+                              MakeRadio(8, "theme")}),
+      MakeRadio(3, ""),
+      MakeRadio(4, ""),
+      Checkbox(5, false),
+  }));
+  ASSERT_EQ(menu.nodes().size(), 8u);
+
+  EXPECT_EQ(menu.radio_group_count(), 4u);
+  // Named groups span submenus.
+  EXPECT_EQ(menu.radio_group(0), menu.radio_group(5));
+  // Unnamed ones are per sibling list.
+  EXPECT_EQ(menu.radio_group(2), menu.radio_group(3));
+  EXPECT_NE(menu.radio_group(2), menu.radio_group(6));
+  EXPECT_NE(menu.radio_group(0), menu.radio_group(2));
+  EXPECT_NE(menu.radio_group(7), menu.radio_group(0));
+  EXPECT_LT(menu.radio_group(7), menu.radio_group_count());
+  EXPECT_EQ(menu.radio_group(1), CompiledMenu::kNoGroup);
+  EXPECT_EQ(menu.radio_group(4), CompiledMenu::kNoGroup);
+
+  CompiledMenu plain = CompileMenu(MakeMenu({Checkbox(1, true)}));
+  EXPECT_EQ(plain.radio_group_count(), 0u);
+  EXPECT_EQ(plain.radio_group(0), CompiledMenu::kNoGroup);
+}
+
+TEST(MenuTogglesTest, SeedsFromCheckedFields) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      Checkbox(1, true),
+      Checkbox(2, false),
+      MakeRadio(3, "size", true),
+      MakeRadio(4, "size", true),
+      MakeRadio(5, "size"),
+  }));
+  const MenuToggleState& toggles = menu.toggles();
+  EXPECT_TRUE(toggles.checked(0));
+  EXPECT_FALSE(toggles.checked(1));
+  // Two checked in one group: the last one wins.
+  EXPECT_FALSE(toggles.checked(2));
+  EXPECT_TRUE(toggles.checked(3));
+  EXPECT_EQ(toggles.group_checked(menu.radio_group(3)), 3u);
+  // The compiled fields stay as sent.
+  EXPECT_TRUE(menu.node(2).checked);
+
+  CompiledMenu none = MakeGroupMenu(3, false);
+  EXPECT_EQ(none.toggles().group_checked(0), CompiledMenu::kNoNode);
+}
+
+TEST(MenuTogglesTest, ClicksFlipCheckboxesAndSelectRadioItems) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      MakeItem(1, "normal", "Open"),
+      Checkbox(2, false),
+      MakeRadio(3, "size", true),
+      MakeRadio(4, "size"),
+  }));
+  MenuToggleState& toggles = menu.toggles();
+
+  EXPECT_FALSE(toggles.Toggle(menu, 0).toggled);
+
+  MenuToggleResult result = toggles.Toggle(menu, 1);
+  EXPECT_TRUE(result.toggled);
+  EXPECT_TRUE(result.checked);
+  EXPECT_EQ(result.unchecked, CompiledMenu::kNoNode);
+  EXPECT_FALSE(toggles.Toggle(menu, 1).checked);
+  EXPECT_FALSE(toggles.checked(1));
+
+  result = toggles.Toggle(menu, 3);
+  EXPECT_TRUE(result.checked);
+  EXPECT_EQ(result.unchecked, 2u);
+  EXPECT_TRUE(toggles.checked(3));
+  EXPECT_FALSE(toggles.checked(2));
+
+  // Clicking the checked radio item keeps it checked.
+  result = toggles.Toggle(menu, 3);
+  EXPECT_TRUE(result.checked);
+  EXPECT_EQ(result.unchecked, CompiledMenu::kNoNode);
+  EXPECT_TRUE(toggles.checked(3));
+}
+
+TEST(MenuTogglesTest, SetKeepsOneCheckedPerGroup) {
+  CompiledMenu menu = MakeGroupMenu(3, true);
+  MenuToggleState& toggles = menu.toggles();
+
+  // updateMenuItems sends both sides of a radio change, in either order.
+  toggles.Set(menu, 1, true);
+  EXPECT_FALSE(toggles.checked(0));
+  toggles.Set(menu, 0, false);
+  EXPECT_TRUE(toggles.checked(1));
+  EXPECT_EQ(toggles.group_checked(0), 1u);
+
+  toggles.Set(menu, 2, false);
+  toggles.Set(menu, 2, true);
+  EXPECT_EQ(CountChecked(menu), 1);
+
+  toggles.Set(menu, 2, false);
+  EXPECT_EQ(toggles.group_checked(0), CompiledMenu::kNoNode);
+  EXPECT_EQ(CountChecked(menu), 0);
+  EXPECT_EQ(toggles.Toggle(menu, 0).unchecked, CompiledMenu::kNoNode);
+}
+
+TEST(MenuTogglesTest, LargeGroupsKeepOneCheckedItem) {
+  CompiledMenu menu = MakeGroupMenu(1000, true);
+  MenuToggleState& toggles = menu.toggles();
+  uint32_t previous = 0;
+  for (uint32_t step = 1; step <= 2000; ++step) {
+    const uint32_t index = (step * 7919) % 1000;
+    const MenuToggleResult result = toggles.Toggle(menu, index);
+    EXPECT_EQ(result.unchecked,
+              index == previous ? CompiledMenu::kNoNode : previous);
+    previous = index;
+  }
+  EXPECT_EQ(CountChecked(menu), 1);
+  EXPECT_TRUE(toggles.checked(previous));
+}
+
+TEST(MenuTogglesTest, CopiesAndPatchedSnapshotsShareTheState) {
+  std::shared_ptr<MenuSnapshot> base = MakeMenuSnapshot(
+      CompileMenu(MakeMenu({Checkbox(1, false), MakeRadio(2, "size", true),
+                            MakeRadio(3, "size")})),
+      {});
+  CompiledMenu copy = base->menu;
+  copy.toggles().Toggle(copy, 0);
+  EXPECT_TRUE(base->menu.toggles().checked(0));
+
+  // A label patch keeps the clicked state although the node says otherwise.
+  flutter::EncodableMap label;
+  label[flutter::EncodableValue("id")] = flutter::EncodableValue(1);
+  label[flutter::EncodableValue("field")] = flutter::EncodableValue("label");
+  label[flutter::EncodableValue("value")] = flutter::EncodableValue("Pin");
+  std::shared_ptr<MenuSnapshot> patched = base;
+  PatchMenuSnapshot(patched,
+                    flutter::EncodableList{flutter::EncodableValue(label)});
+  EXPECT_FALSE(patched->menu.node(0).checked);
+  EXPECT_TRUE(patched->menu.toggles().checked(0));
+
+  // A checked patch sets the shared state.
+  flutter::EncodableMap radio;
+  radio[flutter::EncodableValue("id")] = flutter::EncodableValue(3);
+  radio[flutter::EncodableValue("field")] = flutter::EncodableValue("checked");
+  radio[flutter::EncodableValue("value")] = flutter::EncodableValue(true);
+  PatchMenuSnapshot(patched,
+                    flutter::EncodableList{flutter::EncodableValue(radio)});
+  EXPECT_TRUE(base->menu.toggles().checked(2));
+  EXPECT_FALSE(base->menu.toggles().checked(1));
+
+  // A new compile starts over.
+  CompiledMenu recompiled = CompileMenu(MakeMenu({Checkbox(1, false)}));
+  EXPECT_FALSE(recompiled.toggles().checked(0));
+}
+
+TEST(MenuTogglesTest, CountsTowardsMemory) {
+  const size_t small = MakeGroupMenu(10, false).memory_bytes();
+  const size_t large = MakeGroupMenu(1000, false).memory_bytes();
+  EXPECT_GT(large - small, 990 * (sizeof(MenuNode) + sizeof(uint32_t) +
+                                  sizeof(std::atomic<bool>)));
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,684 @@
+#include "menu_widget_backend.h"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "menu_fixtures.h"
+#include "menu_snapshot.h"
+#include "menu_toggles.h"
+#include "recording_menu_backend.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::HeadlessContextMenu;
+using testing::kMorePageItem;
+using testing::kPreviousPageItem;
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeRadio;
+using testing::MakeStyle;
+using testing::MakeSubmenu;
+using testing::RecordedOp;
+
+class EventLog : public MenuEventSink {
+ public:
+  void OnMenuItemClick(const MenuClick& click) override {
+    events.push_back("click " + std::to_string(click.id));
+    clicks.push_back(click);
+  }
+  void OnMenuOpening() override { events.push_back("opening"); }
+  void OnMenuClosing() override { events.push_back("closing"); }
+  void OnMenuClosed() override { events.push_back("closed"); }
+
+  std::vector<std::string> events;
+  std::vector<MenuClick> clicks;
+};
+
+flutter::EncodableMap With(flutter::EncodableMap item, const char* key,
+                           flutter::EncodableValue value) {
+  item[flutter::EncodableValue(key)] = std::move(value);
+  return item;
+}
+
+flutter::EncodableList NumberedItems(int32_t first_id, int32_t count) {
+  flutter::EncodableList items;
+  for (int32_t id = first_id; id < first_id + count; ++id) {
+    items.emplace_back(MakeItem(id, "normal", "Item " + std::to_string(id)));
+  }
+  return items;
+}
+
+// Pages of 10, at most 20 items per list, root lists over 30 items paged.
+flutter::EncodableMap PagingStyle() {
+  return MakeStyle({
+      {"virtualizationThreshold", flutter::EncodableValue(30)},
+      {"virtualizationPageSize", flutter::EncodableValue(10)},
+      {"virtualizationMaxItems", flutter::EncodableValue(20)},
+  });
+}
+
+std::vector<uint32_t> Range(uint32_t first, uint32_t end) {
+  std::vector<uint32_t> indices;
+  for (uint32_t i = first; i < end; ++i) indices.push_back(i);
+  return indices;
+}
+
+std::vector<uint32_t> Paged(bool previous, std::vector<uint32_t> indices,
+                            bool more) {
+  if (previous) indices.insert(indices.begin(), kPreviousPageItem);
+  if (more) indices.push_back(kMorePageItem);
+  return indices;
+}
+
+TEST(MenuWidgetBackendTest, ParsesIconGlyphs) {
+  EXPECT_EQ(ParseIconGlyph("0xE713"), 0xE713);
+  EXPECT_EQ(ParseIconGlyph("0Xe713"), 0xE713);
+  EXPECT_EQ(ParseIconGlyph("0x41zz"), 0x41);
+  EXPECT_EQ(ParseIconGlyph("0x"), 0);
+  EXPECT_EQ(ParseIconGlyph("E713"), 0);
+  EXPECT_EQ(ParseIconGlyph("0xzz"), 0);
+  EXPECT_EQ(ParseIconGlyph("0x10000"), 0);
+}
+
+TEST(MenuWidgetBackendTest, ResolvesItemStyle) {
+  MenuItemStyle empty = ResolveMenuItemStyle(ResolvedStyle());
+  EXPECT_TRUE(empty.compact);
+  EXPECT_EQ(empty.text_color, 0u);
+
+  MenuItemStyle style = ResolveMenuItemStyle(ResolveStyle(MakeStyle({
+      {"compactItemLayout", flutter::EncodableValue(false)},
+      {"fontSize", flutter::EncodableValue(13.0)},
+      {"textColor", flutter::EncodableValue(int64_t{0xFF112233})},
+      {"iconColor", flutter::EncodableValue(int32_t{0x7F445566})},
+  })));
+  EXPECT_FALSE(style.compact);
+  EXPECT_EQ(style.font_size, 13.0);
+  EXPECT_EQ(style.text_color, 0xFF112233u);
+  EXPECT_EQ(style.icon_color, 0x7F445566u);
+  EXPECT_EQ(style.separator_color, 0u);
+}
+
+TEST(MenuWidgetBackendTest, BuildsWidgetTree) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      MakeItem(1, "normal", "Open"),
+      MakeItem(2, "separator", ""),
+      MakeSubmenu(3, "More", {MakeItem(4, "checkbox", "Pin"),
+                              MakeItem(5, "radio", "Small")}),
+      MakeItem(6, "split", "Split"),
+  }));
+  HeadlessContextMenu headless;
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+
+  auto& backend = headless.backend();
+  ASSERT_TRUE(backend.OpenSubmenu(2));
+  ASSERT_EQ(backend.widget_count(), 6u);
+  EXPECT_EQ(backend.root_items(), (std::vector<uint32_t>{0, 1, 2, 3}));
+  EXPECT_EQ(backend.widget(2).children, (std::vector<uint32_t>{4, 5}));
+
+  EXPECT_EQ(backend.widget(0).kind, MenuWidgetKind::kItem);
+  EXPECT_EQ(backend.widget(0).text, "Open");
+  EXPECT_EQ(backend.widget(1).kind, MenuWidgetKind::kSeparator);
+  EXPECT_TRUE(backend.widget(1).text.empty());
+  EXPECT_EQ(backend.widget(2).kind, MenuWidgetKind::kSubItem);
+  EXPECT_FALSE(backend.widget(2).has_click);
+  EXPECT_EQ(backend.widget(4).kind, MenuWidgetKind::kToggle);
+  EXPECT_TRUE(backend.widget(4).keep_open);
+  EXPECT_EQ(backend.widget(5).kind, MenuWidgetKind::kToggle);
+  EXPECT_EQ(backend.widget(5).click_id, 5);
+  // Split entries render as sub items but keep the icon column.
+  EXPECT_EQ(backend.widget(3).kind, MenuWidgetKind::kSubItem);
+  EXPECT_FALSE(backend.widget(3).compact);
+  EXPECT_TRUE(backend.widget(0).compact);
+  EXPECT_TRUE(backend.is_open());
+}
+
+TEST(MenuWidgetBackendTest, IconsOnlyWithoutCompactLayout) {
+  auto icon_item = With(MakeItem(1, "normal", "Settings"), "icon",
+                        flutter::EncodableValue("0xE713"));
+  auto split = With(MakeItem(2, "split", "Split"), "icon",
+                    flutter::EncodableValue("0xE8A7"));
+  CompiledMenu menu = CompileMenu(MakeMenu({icon_item, split}));
+
+  HeadlessContextMenu compact;
+  ASSERT_TRUE(compact.Show(menu, flutter::EncodableMap()));
+  EXPECT_EQ(compact.backend().widget(0).icon_glyph, 0);
+  EXPECT_EQ(compact.backend().widget(1).icon_glyph, 0xE8A7);
+
+  HeadlessContextMenu full;
+  ASSERT_TRUE(full.Show(menu, MakeStyle({
+      {"compactItemLayout", flutter::EncodableValue(false)},
+      {"iconColor", flutter::EncodableValue(int64_t{0xFF00FF00})},
+  })));
+  EXPECT_EQ(full.backend().widget(0).icon_glyph, 0xE713);
+  EXPECT_EQ(full.backend().widget(0).icon_color, 0xFF00FF00u);
+  EXPECT_FALSE(full.backend().widget(0).compact);
+}
+
+TEST(MenuWidgetBackendTest, AppliesItemStyle) {
+  auto disabled = With(MakeItem(2, "normal", "Off"), "disabled",
+                       flutter::EncodableValue(true));
+  auto shortcut = With(MakeItem(4, "checkbox", "Wrap"), "acceleratorText",
+                       flutter::EncodableValue("Alt+Z"));
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      With(MakeItem(1, "normal", "On"), "acceleratorText",
+           flutter::EncodableValue("Ctrl+O")),
+      disabled,
+      MakeItem(3, "separator", ""),
+      shortcut,
+  }));
+  HeadlessContextMenu headless;
+  ASSERT_TRUE(headless.Show(menu, MakeStyle({
+      {"fontSize", flutter::EncodableValue(12.0)},
+      {"itemHeight", flutter::EncodableValue(28.0)},
+      {"textColor", flutter::EncodableValue(int64_t{0xFFFFFFFF})},
+      {"disabledTextColor", flutter::EncodableValue(int64_t{0xFF808080})},
+      {"separatorColor", flutter::EncodableValue(int64_t{0xFF333333})},
+  })));
+
+  const auto& backend = headless.backend();
+  EXPECT_EQ(backend.widget(0).font_size, 12.0);
+  EXPECT_EQ(backend.widget(0).min_height, 28.0);
+  EXPECT_EQ(backend.widget(0).foreground, 0xFFFFFFFFu);
+  EXPECT_EQ(backend.widget(0).accelerator_text, "Ctrl+O");
+  EXPECT_FALSE(backend.widget(1).enabled);
+  EXPECT_EQ(backend.widget(1).foreground, 0xFF808080u);
+  EXPECT_EQ(backend.widget(2).separator_color, 0xFF333333u);
+  EXPECT_EQ(backend.widget(2).font_size, 0.0);
+  // Checkbox items never show accelerator text.
+  EXPECT_TRUE(backend.widget(3).accelerator_text.empty());
+}
+
+TEST(MenuWidgetBackendTest, ClicksReportIdsAndClose) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      MakeItem(1, "normal", "Open"),
+      MakeItem(2, "checkbox", "Pin"),
+      With(MakeItem(3, "normal", "Off"), "disabled",
+           flutter::EncodableValue(true)),
+  }));
+  EventLog log;
+  HeadlessContextMenu headless(&log);
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+
+  EXPECT_TRUE(headless.Click(2));
+  EXPECT_TRUE(headless.backend().is_open());
+  EXPECT_FALSE(headless.Click(3));
+  EXPECT_FALSE(headless.Click(99));
+  EXPECT_TRUE(headless.Click(1));
+  EXPECT_FALSE(headless.backend().is_open());
+  EXPECT_EQ(headless.pool().state(), MenuHostState::kWarm);
+  EXPECT_EQ(log.events, (std::vector<std::string>{
+                            "opening", "click 2", "click 1", "closing",
+                            "closed"}));
+}
+
+TEST(MenuWidgetBackendTest, ClicksCarryTheShownGenerationAndPath) {
+  auto build = [](const std::string& label, uint32_t generation) {
+    CompiledMenu menu = CompileMenu(MakeMenu({
+        MakeItem(1, "normal", "Open"),
+        MakeSubmenu(2, "Recent", {MakeItem(3, "normal", "a.txt"),
+                                  MakeItem(4, "normal", label)}),
+    }));
+    menu.set_generation(generation);
+    return menu;
+  };
+  EventLog log;
+  HeadlessContextMenu headless(&log);
+  ASSERT_TRUE(headless.Show(build("b.txt", 7), flutter::EncodableMap()));
+  ASSERT_TRUE(headless.backend().OpenSubmenu(1));
+  ASSERT_TRUE(headless.Click(4));
+  ASSERT_EQ(log.clicks.size(), 1u);
+  EXPECT_EQ(log.clicks[0].generation, 7u);
+  EXPECT_EQ(log.clicks[0].id, 4);
+  ASSERT_EQ(log.clicks[0].path.length, 2u);
+  EXPECT_EQ(log.clicks[0].path.positions[0], 1u);
+  EXPECT_EQ(log.clicks[0].path.positions[1], 1u);
+  // Not a toggle.
+  EXPECT_FALSE(log.clicks[0].checked);
+
+  // Items updated in place for a newer menu report its generation.
+  ASSERT_TRUE(headless.Show(build("c.txt", 8), flutter::EncodableMap()));
+  ASSERT_EQ(headless.pool().stats().item_builds, 1u);
+  ASSERT_TRUE(headless.Click(1));
+  ASSERT_EQ(log.clicks.size(), 2u);
+  EXPECT_EQ(log.clicks[1].generation, 8u);
+  EXPECT_EQ(log.clicks[1].path.length, 1u);
+}
+
+TEST(MenuWidgetBackendTest, RadioClicksUncheckTheGroupInPlace) {
+  // Nodes: 0 Small, 1 Medium, 2 More, then 3 Large inside More.
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      MakeRadio(1, "size", false),
+      MakeRadio(2, "size", true),
+      MakeSubmenu(3, "More", {MakeRadio(4, "size", false)}),
+  }));
+  menu.set_generation(5);
+  EventLog log;
+  HeadlessContextMenu headless(&log);
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+  const auto& backend = headless.backend();
+  ASSERT_TRUE(backend.widget(1).checked);
+
+  ASSERT_TRUE(headless.Click(1));
+  EXPECT_TRUE(backend.is_open());
+  EXPECT_TRUE(backend.widget(0).checked);
+  EXPECT_FALSE(backend.widget(1).checked);
+  ASSERT_EQ(log.clicks.size(), 1u);
+  EXPECT_EQ(log.clicks[0].checked, std::optional<bool>(true));
+  EXPECT_EQ(log.clicks[0].unchecked_id, std::optional<int32_t>(2));
+  EXPECT_EQ(log.clicks[0].unchecked_path.length, 1u);
+  EXPECT_EQ(log.clicks[0].unchecked_path.positions[0], 1u);
+
+  // The control unchecks itself; the checked radio item stays checked.
+  ASSERT_TRUE(headless.Click(1));
+  EXPECT_TRUE(backend.widget(0).checked);
+  EXPECT_EQ(log.clicks[1].checked, std::optional<bool>(true));
+  EXPECT_FALSE(log.clicks[1].unchecked_id);
+
+  // Items built later show the current state, and clicking one unchecks a
+  // built item outside its list.
+  ASSERT_TRUE(headless.backend().OpenSubmenu(2));
+  EXPECT_FALSE(backend.widget(3).checked);
+  ASSERT_TRUE(headless.Click(4));
+  EXPECT_FALSE(backend.widget(0).checked);
+  EXPECT_EQ(log.clicks[2].unchecked_id, std::optional<int32_t>(1));
+  ASSERT_EQ(log.clicks[2].path.length, 2u);
+  // The pool's copy of the menu shares its state.
+  EXPECT_EQ(menu.toggles().group_checked(menu.radio_group(3)), 3u);
+}
+
+TEST(MenuWidgetBackendTest, ToggledStateOutlivesReshowsAndPatches) {
+  std::shared_ptr<MenuSnapshot> snapshot = MakeMenuSnapshot(
+      CompileMenu(MakeMenu({
+          With(MakeItem(1, "checkbox", "Pin"), "checked",
+               flutter::EncodableValue(false)),
+          MakeItem(2, "normal", "Open"),
+      })),
+      {});
+  EventLog log;
+  HeadlessContextMenu headless(&log);
+  const auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(snapshot));
+  ASSERT_TRUE(headless.Click(1));
+  EXPECT_EQ(log.clicks[0].checked, std::optional<bool>(true));
+  ASSERT_TRUE(headless.Close());
+
+  ASSERT_TRUE(headless.Show(snapshot));
+  EXPECT_TRUE(backend.widget(0).checked);
+  ASSERT_TRUE(headless.Close());
+
+  auto patch = [](int32_t id, const char* field,
+                  flutter::EncodableValue value) {
+    flutter::EncodableMap map;
+    map[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
+    map[flutter::EncodableValue("field")] = flutter::EncodableValue(field);
+    map[flutter::EncodableValue("value")] = std::move(value);
+    return flutter::EncodableList{flutter::EncodableValue(map)};
+  };
+  // Dart knows the item is checked now and sends only a label.
+  PatchMenuSnapshot(snapshot,
+                    patch(2, "label", flutter::EncodableValue("Open file")));
+  ASSERT_TRUE(headless.Show(snapshot));
+  EXPECT_TRUE(backend.widget(0).checked);
+  EXPECT_EQ(backend.widget(1).text, "Open file");
+  ASSERT_TRUE(headless.Close());
+
+  // Unchecking it from Dart reaches the item although the compiled field
+  // never said it was checked.
+  headless.backend().ClearLog();
+  PatchMenuSnapshot(snapshot,
+                    patch(1, "checked", flutter::EncodableValue(false)));
+  ASSERT_TRUE(headless.Show(snapshot));
+  EXPECT_FALSE(backend.widget(0).checked);
+  EXPECT_EQ(backend.CountOps(RecordedOp::kChecked), 1u);
+  EXPECT_EQ(headless.pool().stats().item_builds, 1u);
+}
+
+TEST(MenuWidgetBackendTest, ReshowUpdatesOnlyChangedProperties) {
+  auto build = [](const std::string& label, bool checked) {
+    return CompileMenu(MakeMenu({
+        MakeItem(1, "normal", label),
+        With(MakeItem(2, "checkbox", "Pin"), "checked",
+             flutter::EncodableValue(checked)),
+        MakeItem(3, "normal", "Quit"),
+    }));
+  };
+  HeadlessContextMenu headless;
+  ASSERT_TRUE(headless.Show(build("Open", false), flutter::EncodableMap()));
+  ASSERT_TRUE(headless.Close());
+  headless.backend().ClearLog();
+
+  ASSERT_TRUE(headless.Show(build("Open file", true), flutter::EncodableMap()));
+  const auto& backend = headless.backend();
+  EXPECT_EQ(backend.CountOps(RecordedOp::kCreateItem), 0u);
+  EXPECT_EQ(backend.CountOps(RecordedOp::kText), 1u);
+  EXPECT_EQ(backend.CountOps(RecordedOp::kChecked), 1u);
+  EXPECT_EQ(backend.CountOps(RecordedOp::kEnabled), 0u);
+  EXPECT_EQ(backend.log().size(), 3u);  // Text, checked, show.
+  EXPECT_EQ(backend.widget(0).text, "Open file");
+  EXPECT_TRUE(backend.widget(1).checked);
+}
+
+TEST(MenuWidgetBackendTest, RebuildsWhenForegroundCannotBeReverted) {
+  auto build = [](bool disabled) {
+    return CompileMenu(MakeMenu({With(MakeItem(1, "normal", "Item"),
+                                      "disabled",
+                                      flutter::EncodableValue(disabled))}));
+  };
+  const flutter::EncodableMap style = MakeStyle({
+      {"disabledTextColor", flutter::EncodableValue(int64_t{0xFF808080})},
+  });
+  HeadlessContextMenu headless;
+  ASSERT_TRUE(headless.Show(build(true), style));
+  ASSERT_TRUE(headless.Close());
+  ASSERT_TRUE(headless.Show(build(false), style));
+
+  EXPECT_EQ(headless.pool().stats().item_builds, 2u);
+  EXPECT_EQ(headless.backend().widget(0).foreground, 0u);
+  EXPECT_TRUE(headless.backend().widget(0).enabled);
+}
+
+TEST(MenuWidgetBackendTest, RecoversFromLostHostAndFailedShow) {
+  CompiledMenu menu = CompileMenu(MakeMenu({MakeItem(1, "normal", "Open")}));
+  HeadlessContextMenu headless;
+  headless.backend().FailNextShow();
+  EXPECT_FALSE(headless.Show(menu, flutter::EncodableMap()));
+  EXPECT_EQ(headless.pool().state(), MenuHostState::kCold);
+
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+  ASSERT_TRUE(headless.Close());
+  headless.backend().KillHost();
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+  EXPECT_EQ(headless.pool().stats().host_creates, 3u);
+  EXPECT_EQ(headless.backend().widget(0).text, "Open");
+}
+
+TEST(MenuWidgetBackendTest, BuildsSubmenusOnFirstOpen) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      MakeItem(1, "normal", "Open"),
+      MakeSubmenu(2, "Recent", {MakeItem(3, "normal", "a.txt"),
+                                MakeSubmenu(4, "Older", {
+                                    MakeItem(5, "normal", "b.txt")})}),
+  }));
+  EventLog log;
+  HeadlessContextMenu headless(&log);
+  auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+
+  EXPECT_EQ(backend.CountOps(RecordedOp::kCreateItem), 2u);
+  EXPECT_FALSE(backend.widget(2).created);
+  EXPECT_FALSE(headless.Click(3));
+  EXPECT_EQ(backend.submenus().pending_count(), 2u);
+
+  ASSERT_TRUE(backend.OpenSubmenu(1));
+  EXPECT_EQ(backend.CountOps(RecordedOp::kCreateItem), 4u);
+  EXPECT_EQ(backend.widget(1).children, (std::vector<uint32_t>{2, 3}));
+  // Opening again builds nothing; the nested submenu is still pending.
+  ASSERT_TRUE(backend.OpenSubmenu(1));
+  EXPECT_EQ(backend.CountOps(RecordedOp::kCreateItem), 4u);
+  EXPECT_FALSE(backend.widget(4).created);
+
+  ASSERT_TRUE(backend.OpenSubmenu(3));
+  EXPECT_TRUE(backend.widget(4).created);
+  EXPECT_TRUE(headless.Click(5));
+  EXPECT_EQ(log.events.back(), "closed");
+}
+
+TEST(MenuWidgetBackendTest, BuiltSubmenusLastForTheItemsLifetime) {
+  auto build = [](const std::string& child_label) {
+    return CompileMenu(MakeMenu({
+        MakeSubmenu(1, "First", {MakeItem(2, "normal", child_label)}),
+        MakeSubmenu(3, "Second", {MakeItem(4, "normal", child_label)}),
+    }));
+  };
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(build("old"), flutter::EncodableMap()));
+  ASSERT_TRUE(backend.OpenSubmenu(0));
+  ASSERT_TRUE(headless.Close());
+  backend.ClearLog();
+
+  // Same layout: the built submenu is updated in place and stays built; the
+  // unbuilt one needs no calls and picks up the new label when opened.
+  ASSERT_TRUE(headless.Show(build("new"), flutter::EncodableMap()));
+  EXPECT_EQ(backend.CountOps(RecordedOp::kText), 1u);
+  EXPECT_EQ(backend.widget(2).text, "new");
+  EXPECT_EQ(backend.submenus().built_count(), 1u);
+  ASSERT_TRUE(backend.OpenSubmenu(1));
+  EXPECT_EQ(backend.widget(3).text, "new");
+  ASSERT_TRUE(headless.Close());
+
+  // A new style recreates the flyout, which starts with nothing built.
+  ASSERT_TRUE(headless.Show(
+      build("new"), MakeStyle({{"fontSize", flutter::EncodableValue(14.0)}})));
+  EXPECT_EQ(backend.submenus().built_count(), 0u);
+  EXPECT_EQ(backend.submenus().pending_count(), 2u);
+}
+
+TEST(MenuWidgetBackendTest, LiveItemsUpdateTheOpenFlyout) {
+  auto icon_item = With(MakeItem(1, "normal", "Sync"), "icon",
+                        flutter::EncodableValue("0xE895"));
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      icon_item,
+      MakeItem(2, "separator", ""),
+      MakeSubmenu(3, "Jobs", {MakeItem(4, "normal", "Idle")}),
+  }));
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  LiveItemUpdate update;
+  update.id = 1;
+  update.label = "Syncing 42%";
+  EXPECT_FALSE(backend.ApplyLiveItem(update));
+
+  ASSERT_TRUE(headless.Show(menu, MakeStyle({
+      {"compactItemLayout", flutter::EncodableValue(false)},
+  })));
+  backend.ClearLog();
+  update.icon = "0xE72C";
+  update.disabled = true;
+  ASSERT_TRUE(backend.ApplyLiveItem(update));
+  EXPECT_EQ(backend.widget(0).text, "Syncing 42%");
+  EXPECT_EQ(backend.widget(0).icon_glyph, 0xE72C);
+  EXPECT_FALSE(backend.widget(0).enabled);
+  EXPECT_EQ(backend.CountOps(RecordedOp::kCreateItem), 0u);
+
+  // Separators and unknown ids take no live values.
+  update.id = 2;
+  EXPECT_FALSE(backend.ApplyLiveItem(update));
+  update.id = 99;
+  EXPECT_FALSE(backend.ApplyLiveItem(update));
+
+  // Items of an unbuilt submenu get their live values when built.
+  LiveItemUpdate child;
+  child.id = 4;
+  child.label = "Running";
+  ASSERT_TRUE(backend.ApplyLiveItem(child));
+  EXPECT_FALSE(backend.widget(3).created);
+  ASSERT_TRUE(backend.OpenSubmenu(2));
+  EXPECT_EQ(backend.widget(3).text, "Running");
+}
+
+TEST(MenuWidgetBackendTest, LiveItemsLastUntilTheMenuChanges) {
+  auto build = [](const std::string& label) {
+    return CompileMenu(MakeMenu({
+        With(MakeItem(1, "normal", label), "icon",
+             flutter::EncodableValue("0xE895")),
+        MakeItem(2, "normal", "Plain"),
+    }));
+  };
+  const flutter::EncodableMap style = MakeStyle({
+      {"compactItemLayout", flutter::EncodableValue(false)},
+  });
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  MenuSnapshotPtr snapshot = MakeMenuSnapshot(build("Sync"), style);
+  ASSERT_TRUE(headless.Show(snapshot));
+  LiveItemUpdate update;
+  update.id = 1;
+  update.label = "Syncing";
+  update.disabled = true;
+  ASSERT_TRUE(backend.ApplyLiveItem(update));
+  LiveItemUpdate icon;
+  icon.id = 2;
+  icon.icon = "0xE72C";
+  ASSERT_TRUE(backend.ApplyLiveItem(icon));
+  EXPECT_EQ(backend.widget(1).icon_glyph, 0xE72C);
+  ASSERT_TRUE(headless.Close());
+
+  // The same snapshot again keeps them.
+  ASSERT_TRUE(headless.Show(snapshot));
+  EXPECT_EQ(backend.widget(0).text, "Syncing");
+  EXPECT_FALSE(backend.widget(0).enabled);
+  ASSERT_TRUE(headless.Close());
+
+  // Another snapshot of the menu restores its own values in place.
+  ASSERT_TRUE(headless.Show(build("Synced"), style));
+  EXPECT_EQ(headless.pool().stats().item_builds, 1u);
+  EXPECT_EQ(backend.widget(0).text, "Synced");
+  EXPECT_TRUE(backend.widget(0).enabled);
+  EXPECT_EQ(backend.widget(1).icon_glyph, 0);
+}
+
+TEST(MenuWidgetBackendTest, LiveDisabledItemsUseTheStyleColors) {
+  CompiledMenu menu = CompileMenu(MakeMenu({MakeItem(1, "normal", "Item")}));
+  LiveItemUpdate update;
+  update.id = 1;
+  update.disabled = true;
+
+  HeadlessContextMenu styled;
+  ASSERT_TRUE(styled.Show(menu, MakeStyle({
+      {"textColor", flutter::EncodableValue(int64_t{0xFFFFFFFF})},
+      {"disabledTextColor", flutter::EncodableValue(int64_t{0xFF808080})},
+  })));
+  ASSERT_TRUE(styled.backend().ApplyLiveItem(update));
+  EXPECT_EQ(styled.backend().widget(0).foreground, 0xFF808080u);
+  update.disabled = false;
+  ASSERT_TRUE(styled.backend().ApplyLiveItem(update));
+  EXPECT_EQ(styled.backend().widget(0).foreground, 0xFFFFFFFFu);
+
+  // Without a text colour the foreground could not be reverted, so the
+  // control's own disabled look is left to show.
+  HeadlessContextMenu plain;
+  ASSERT_TRUE(plain.Show(menu, MakeStyle({
+      {"disabledTextColor", flutter::EncodableValue(int64_t{0xFF808080})},
+  })));
+  update.disabled = true;
+  ASSERT_TRUE(plain.backend().ApplyLiveItem(update));
+  EXPECT_FALSE(plain.backend().widget(0).enabled);
+  EXPECT_EQ(plain.backend().widget(0).foreground, 0u);
+}
+
+TEST(MenuWidgetBackendTest, EagerSubmenusBuildTheWholeTree) {
+  CompiledMenu menu = CompileMenu(
+      testing::MakeSyntheticMenu(/*item_count=*/40, /*fanout=*/10));
+  HeadlessContextMenu headless;
+  headless.backend().set_lazy_submenus(false);
+  ASSERT_TRUE(headless.Show(menu, flutter::EncodableMap()));
+  EXPECT_EQ(headless.backend().CountOps(RecordedOp::kCreateItem), 40u);
+  EXPECT_EQ(headless.backend().CountOps(RecordedOp::kSubmenuOpenHandler), 0u);
+  EXPECT_EQ(headless.backend().submenus().pending_count(), 0u);
+}
+
+TEST(MenuWidgetBackendTest, PagesLongLists) {
+  CompiledMenu menu = CompileMenu(MakeMenu(NumberedItems(1, 45)));
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(menu, PagingStyle()));
+  EXPECT_EQ(backend.root_items(), Paged(false, Range(0, 10), true));
+  EXPECT_EQ(backend.live_widget_count(), 10u);
+
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  EXPECT_EQ(backend.root_items(), Paged(false, Range(0, 20), true));
+  // Past the cap, the first page goes.
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  EXPECT_EQ(backend.root_items(), Paged(true, Range(10, 30), true));
+  EXPECT_FALSE(backend.widget(0).created);
+  EXPECT_EQ(backend.live_widget_count(), 20u);
+
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  EXPECT_EQ(backend.root_items(), Paged(true, Range(25, 45), false));
+  EXPECT_FALSE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kPrevious));
+  EXPECT_EQ(backend.root_items(), Paged(true, Range(15, 35), true));
+  EXPECT_EQ(backend.widget(15).text, "Item 16");
+  EXPECT_EQ(backend.live_widget_count(), 20u);
+}
+
+TEST(MenuWidgetBackendTest, PagesVirtualizedSubmenusBelowTheThreshold) {
+  CompiledMenu menu = CompileMenu(MakeMenu({
+      With(MakeSubmenu(1, "Recent", NumberedItems(10, 25)), "virtualized",
+           flutter::EncodableValue(true)),
+      MakeSubmenu(2, "Devices", NumberedItems(100, 25)),
+  }));
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(menu, PagingStyle()));
+  ASSERT_TRUE(backend.OpenSubmenu(0));
+  ASSERT_TRUE(backend.OpenSubmenu(1));
+  EXPECT_EQ(backend.widget(0).children, Paged(false, Range(2, 12), true));
+  EXPECT_EQ(backend.widget(1).children, Range(27, 52));
+  EXPECT_NE(backend.page_window(0), nullptr);
+  EXPECT_EQ(backend.page_window(1), nullptr);
+  EXPECT_FALSE(backend.Page(1, MenuPageDirection::kNext));
+
+  ASSERT_TRUE(backend.Page(0, MenuPageDirection::kNext));
+  ASSERT_TRUE(backend.Page(0, MenuPageDirection::kNext));
+  EXPECT_EQ(backend.widget(0).children, Paged(true, Range(7, 27), false));
+  EXPECT_TRUE(headless.Click(34));  // Node 26, the last entry.
+}
+
+TEST(MenuWidgetBackendTest, RemovedSubmenusAreBuiltAgainWhenPagedBack) {
+  flutter::EncodableList items = NumberedItems(2, 39);
+  items.insert(items.begin(), flutter::EncodableValue(MakeSubmenu(
+                                  1, "Sub", {MakeItem(100, "normal", "x")})));
+  CompiledMenu menu = CompileMenu(MakeMenu(std::move(items)));
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(menu, PagingStyle()));
+  ASSERT_TRUE(backend.OpenSubmenu(0));
+  ASSERT_TRUE(backend.widget(40).created);
+
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  EXPECT_FALSE(backend.widget(0).created);
+  EXPECT_FALSE(backend.widget(40).created);
+  EXPECT_EQ(backend.submenus().built_count(), 0u);
+
+  ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kPrevious));
+  EXPECT_TRUE(backend.widget(0).has_submenu_open_handler);
+  ASSERT_TRUE(backend.OpenSubmenu(0));
+  EXPECT_EQ(backend.widget(0).children, (std::vector<uint32_t>{40}));
+}
+
+TEST(MenuWidgetBackendTest, UpdatesOnlyItemsInThePageWindow) {
+  auto build = [](const std::string& label) {
+    flutter::EncodableList items = NumberedItems(1, 40);
+    items[5] = flutter::EncodableValue(MakeItem(6, "normal", label));
+    items[35] = flutter::EncodableValue(MakeItem(36, "normal", label));
+    return CompileMenu(MakeMenu(std::move(items)));
+  };
+  HeadlessContextMenu headless;
+  auto& backend = headless.backend();
+  ASSERT_TRUE(headless.Show(build("old"), PagingStyle()));
+  ASSERT_TRUE(headless.Close());
+  backend.ClearLog();
+
+  ASSERT_TRUE(headless.Show(build("new"), PagingStyle()));
+  EXPECT_EQ(backend.CountOps(RecordedOp::kCreateItem), 0u);
+  EXPECT_EQ(backend.CountOps(RecordedOp::kText), 1u);
+  EXPECT_EQ(backend.widget(5).text, "new");
+  // Entries outside the window are built from the current menu.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(backend.Page(kRootWidget, MenuPageDirection::kNext));
+  }
+  EXPECT_EQ(backend.widget(35).text, "new");
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,241 @@
+#include "packed_menu.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "menu_fixtures.h"
+#include "menu_host_pool.h"
+#include "packed_menu_writer.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeItem;
+using testing::MakeMenu;
+using testing::MakeSubmenu;
+using testing::PackMenu;
+using testing::PokeU32;
+
+// Nodes: 0 Open, 1 Recent, 2 Quit | 3 a.txt, 4 Older | 5 b.txt
+CompiledMenu NestedMenu() {
+  auto open = MakeItem(1, "normal", "Open");
+  open[flutter::EncodableValue("icon")] = flutter::EncodableValue("0xE8E5");
+  open[flutter::EncodableValue("acceleratorText")] =
+      flutter::EncodableValue("Ctrl+O");
+  auto recent = MakeSubmenu(
+      2, "Recent",
+      {MakeItem(3, "checkbox", "a.txt"),
+       MakeSubmenu(4, "Older", {MakeItem(5, "radio", "b.txt")})});
+  recent[flutter::EncodableValue("virtualized")] = flutter::EncodableValue(true);
+  auto quit = MakeItem(6, "normal", "Quit");
+  quit[flutter::EncodableValue("disabled")] = flutter::EncodableValue(true);
+  return CompileMenu(MakeMenu({open, recent, quit}));
+}
+
+flutter::EncodableMap FullStyle() {
+  flutter::EncodableMap padding;
+  padding[flutter::EncodableValue("left")] = flutter::EncodableValue(4.0);
+  padding[flutter::EncodableValue("top")] = flutter::EncodableValue(2.0);
+  padding[flutter::EncodableValue("right")] = flutter::EncodableValue(4.0);
+  padding[flutter::EncodableValue("bottom")] = flutter::EncodableValue(2.0);
+
+  flutter::EncodableMap style;
+  style[flutter::EncodableValue("compactItemLayout")] =
+      flutter::EncodableValue(true);
+  style[flutter::EncodableValue("fontWeight")] = flutter::EncodableValue(600);
+  style[flutter::EncodableValue("textColor")] =
+      flutter::EncodableValue(int64_t{0xFFEEEEEE});
+  style[flutter::EncodableValue("fontSize")] = flutter::EncodableValue(13.5);
+  style[flutter::EncodableValue("fontFamily")] =
+      flutter::EncodableValue("Segoe UI");
+  style[flutter::EncodableValue("padding")] = flutter::EncodableValue(padding);
+  return style;
+}
+
+void ExpectSameMenu(const CompiledMenu& a, const CompiledMenu& b) {
+  ASSERT_TRUE(MenuLayoutMatches(a, b));
+  for (uint32_t i = 0; i < a.nodes().size(); ++i) {
+    EXPECT_TRUE(MenuNodeContentEquals(a, b, i)) << "node " << i;
+  }
+}
+
+PackedMenuError Open(const std::vector<uint8_t>& buffer) {
+  PackedMenuView view;
+  return view.Open(buffer.data(), buffer.size());
+}
+
+// Offset of node index in a buffer written by PackMenu.
+size_t NodeOffset(const CompiledMenu& menu, uint32_t index) {
+  return kPackedHeaderSize + menu.string_count() * kPackedStringRefSize +
+         index * kPackedNodeSize;
+}
+
+TEST(PackedMenuTest, CompilesToTheSameMenuAsTheMap) {
+  const CompiledMenu expected = NestedMenu();
+  const std::vector<uint8_t> buffer = PackMenu(expected, {});
+  PackedMenuView view;
+  ASSERT_EQ(view.Open(buffer.data(), buffer.size()), PackedMenuError::kNone);
+  EXPECT_EQ(view.node_count(), 6u);
+  EXPECT_EQ(view.root_count(), 3u);
+
+  const CompiledMenu packed = CompileMenu(view);
+  ExpectSameMenu(expected, packed);
+  EXPECT_TRUE(packed.node(1).virtualized);
+  EXPECT_TRUE(packed.node(2).disabled);
+  EXPECT_EQ(packed.str(packed.node(0).accelerator_text), "Ctrl+O");
+  EXPECT_EQ(packed.node(4).first_child, 5u);
+}
+
+TEST(PackedMenuTest, CarriesTheGenerationAndBuildsTheIdIndex) {
+  CompiledMenu expected = NestedMenu();
+  expected.set_generation(0xC0FFEE);
+  const std::vector<uint8_t> buffer = PackMenu(expected, {});
+  PackedMenuView view;
+  ASSERT_EQ(view.Open(buffer.data(), buffer.size()), PackedMenuError::kNone);
+  EXPECT_EQ(view.generation(), 0xC0FFEEu);
+
+  const CompiledMenu packed = CompileMenu(view);
+  EXPECT_EQ(packed.generation(), 0xC0FFEEu);
+  for (uint32_t i = 0; i < packed.nodes().size(); ++i) {
+    EXPECT_EQ(packed.FindNode(packed.node(i).id), i);
+    EXPECT_EQ(packed.parent(i), expected.parent(i));
+  }
+}
+
+TEST(PackedMenuTest, CompilesLargeMenus) {
+  const CompiledMenu expected =
+      CompileMenu(testing::MakeSyntheticMenu(5000, 25));
+  const std::vector<uint8_t> buffer = PackMenu(expected, {});
+  PackedMenuView view;
+  ASSERT_EQ(view.Open(buffer.data(), buffer.size()), PackedMenuError::kNone);
+  ExpectSameMenu(expected, CompileMenu(view));
+}
+
+TEST(PackedMenuTest, DecodesStyleLikeTheMethodChannel) {
+  const flutter::EncodableMap style = FullStyle();
+  const std::vector<uint8_t> buffer = PackMenu(NestedMenu(), style);
+  PackedMenuView view;
+  ASSERT_EQ(view.Open(buffer.data(), buffer.size()), PackedMenuError::kNone);
+  EXPECT_EQ(view.style_count(), style.size());
+  EXPECT_EQ(DecodePackedStyle(view), style);
+
+  // Ints that fit are int32, as StandardMethodCodec decodes them.
+  const flutter::EncodableMap decoded = DecodePackedStyle(view);
+  EXPECT_TRUE(std::holds_alternative<int32_t>(
+      decoded.at(flutter::EncodableValue("fontWeight"))));
+  EXPECT_TRUE(std::holds_alternative<int64_t>(
+      decoded.at(flutter::EncodableValue("textColor"))));
+}
+
+TEST(PackedMenuTest, EmptyMenuAndStyle) {
+  const std::vector<uint8_t> buffer = PackMenu(CompiledMenu(), {});
+  EXPECT_EQ(buffer.size(), kPackedHeaderSize + kPackedStringRefSize);
+  PackedMenuView view;
+  ASSERT_EQ(view.Open(buffer.data(), buffer.size()), PackedMenuError::kNone);
+  EXPECT_TRUE(CompileMenu(view).nodes().empty());
+  EXPECT_TRUE(DecodePackedStyle(view).empty());
+}
+
+TEST(PackedMenuTest, RejectsForeignAndTruncatedBuffers) {
+  const std::vector<uint8_t> valid = PackMenu(NestedMenu(), FullStyle());
+  PackedMenuView view;
+  EXPECT_EQ(view.Open(nullptr, 0), PackedMenuError::kTruncated);
+  EXPECT_EQ(view.Open(valid.data(), kPackedHeaderSize - 1),
+            PackedMenuError::kTruncated);
+  EXPECT_EQ(view.Open(valid.data(), valid.size() - 1),
+            PackedMenuError::kBadSize);
+
+  std::vector<uint8_t> buffer = valid;
+  buffer[0] = '{';
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadMagic);
+
+  buffer = valid;
+  buffer[4] = 2;
+  EXPECT_EQ(Open(buffer), PackedMenuError::kUnsupportedVersion);
+
+  buffer = valid;
+  PokeU32(buffer, 20, 0xFFFFFFFF);  // node_count
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadSize);
+  EXPECT_EQ(view.node_count(), 0u);
+}
+
+TEST(PackedMenuTest, RejectsOutOfRangeStrings) {
+  const CompiledMenu menu = NestedMenu();
+  const std::vector<uint8_t> valid = PackMenu(menu, {});
+
+  std::vector<uint8_t> buffer = valid;
+  PokeU32(buffer, NodeOffset(menu, 2) + 8,
+          static_cast<uint32_t>(menu.string_count()));
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadString);
+
+  buffer = valid;
+  PokeU32(buffer, kPackedHeaderSize + kPackedStringRefSize + 4, 1 << 20);
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadString);
+
+  buffer = valid;
+  buffer[NodeOffset(menu, 0)] = 6;  // No such MenuItemType.
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadNode);
+}
+
+TEST(PackedMenuTest, RejectsLayoutsCompileMenuCannotProduce) {
+  const CompiledMenu menu = NestedMenu();
+  const std::vector<uint8_t> valid = PackMenu(menu, {});
+
+  // Children on a normal item.
+  std::vector<uint8_t> buffer = valid;
+  buffer[NodeOffset(menu, 1)] = static_cast<uint8_t>(MenuItemType::kNormal);
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadLayout);
+
+  // A submenu pointing back at the root block (a cycle).
+  buffer = valid;
+  PokeU32(buffer, NodeOffset(menu, 4) + 32, 0);
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadLayout);
+
+  // Children running past the end.
+  buffer = valid;
+  PokeU32(buffer, NodeOffset(menu, 4) + 36, 2);
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadLayout);
+
+  // Nodes no submenu owns.
+  buffer = valid;
+  PokeU32(buffer, NodeOffset(menu, 4) + 36, 0);
+  EXPECT_EQ(Open(buffer), PackedMenuError::kBadLayout);
+}
+
+// Random corruption of a valid buffer either fails Open or yields a menu
+// that every accessor can walk. Run under ASan/UBSan, or use the libFuzzer
+// target (TRAY_MANAGER_WINUI_BUILD_FUZZERS) for deeper coverage.
+TEST(PackedMenuTest, SurvivesRandomCorruption) {
+  const std::vector<uint8_t> valid = PackMenu(
+      CompileMenu(testing::MakeSyntheticMenu(60, 6)), FullStyle());
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<size_t> position(0, valid.size() - 1);
+  std::uniform_int_distribution<int> byte(0, 255);
+  int accepted = 0;
+  for (int round = 0; round < 20000; ++round) {
+    std::vector<uint8_t> buffer = valid;
+    const int flips = 1 + round % 4;
+    for (int i = 0; i < flips; ++i) {
+      buffer[position(rng)] = static_cast<uint8_t>(byte(rng));
+    }
+    PackedMenuView view;
+    if (view.Open(buffer.data(), buffer.size()) != PackedMenuError::kNone) {
+      continue;
+    }
+    ++accepted;
+    const CompiledMenu menu = CompileMenu(view);
+    size_t total = 0;
+    for (const MenuNode& node : menu.nodes()) {
+      total += menu.str(node.label).size() + menu.str(node.tool_tip).size();
+    }
+    total += DecodePackedStyle(view).size();
+    EXPECT_GT(total, 0u);
+  }
+  // Most flips land in labels and values, which stay valid.
+  EXPECT_GT(accepted, 0);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
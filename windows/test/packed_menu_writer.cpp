@@ -0,0 +1,177 @@
+#include "packed_menu_writer.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "packed_menu.h"
+
+namespace tray_manager_winui {
+namespace testing {
+
+namespace {
+
+class Writer {
+ public:
+  void U8(uint8_t value) { out_.push_back(value); }
+  void U16(uint16_t value) {
+    U8(static_cast<uint8_t>(value));
+    U8(static_cast<uint8_t>(value >> 8));
+  }
+  void U32(uint32_t value) {
+    U16(static_cast<uint16_t>(value));
+    U16(static_cast<uint16_t>(value >> 16));
+  }
+  void U64(uint64_t value) {
+    U32(static_cast<uint32_t>(value));
+    U32(static_cast<uint32_t>(value >> 32));
+  }
+  void F64(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    U64(bits);
+  }
+  void Bytes(std::string_view bytes) {
+    out_.insert(out_.end(), bytes.begin(), bytes.end());
+  }
+
+  std::vector<uint8_t>& out() { return out_; }
+
+ private:
+  std::vector<uint8_t> out_;
+};
+
+struct StyleEntry {
+  uint32_t key;
+  PackedStyleKind kind;
+  uint64_t bits;
+};
+
+double InsetValue(const flutter::EncodableMap& map, const char* key) {
+  auto it = map.find(flutter::EncodableValue(key));
+  if (it == map.end()) return 0;
+  if (const auto* d = std::get_if<double>(&it->second)) return *d;
+  if (const auto* i = std::get_if<int32_t>(&it->second)) return *i;
+  return 0;
+}
+
+uint64_t DoubleBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+}  // namespace
+
+std::vector<uint8_t> PackMenu(const CompiledMenu& menu,
+                              const flutter::EncodableMap& style) {
+  // Menu strings keep their ids; style strings are appended after them.
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < menu.string_count(); ++i) {
+    strings.emplace_back(menu.str(static_cast<StringId>(i)));
+  }
+  auto add_string = [&strings](const std::string& value) {
+    strings.push_back(value);
+    return static_cast<uint32_t>(strings.size() - 1);
+  };
+
+  std::vector<StyleEntry> entries;
+  std::vector<double> insets;
+  for (const auto& [key_val, value] : style) {
+    const auto* key = std::get_if<std::string>(&key_val);
+    if (!key) continue;
+    StyleEntry entry{0, PackedStyleKind::kBool, 0};
+    if (const auto* b = std::get_if<bool>(&value)) {
+      entry.kind = PackedStyleKind::kBool;
+      entry.bits = *b ? 1 : 0;
+    } else if (const auto* i32 = std::get_if<int32_t>(&value)) {
+      entry.kind = PackedStyleKind::kInt;
+      entry.bits = static_cast<uint64_t>(int64_t{*i32});
+    } else if (const auto* i64 = std::get_if<int64_t>(&value)) {
+      entry.kind = PackedStyleKind::kInt;
+      entry.bits = static_cast<uint64_t>(*i64);
+    } else if (const auto* d = std::get_if<double>(&value)) {
+      entry.kind = PackedStyleKind::kDouble;
+      entry.bits = DoubleBits(*d);
+    } else if (const auto* s = std::get_if<std::string>(&value)) {
+      entry.kind = PackedStyleKind::kString;
+      entry.bits = s->empty() ? kEmptyString : add_string(*s);
+    } else if (const auto* m = std::get_if<flutter::EncodableMap>(&value)) {
+      entry.kind = PackedStyleKind::kInsets;
+      entry.bits = insets.size() / 4;
+      for (const char* side : {"left", "top", "right", "bottom"}) {
+        insets.push_back(InsetValue(*m, side));
+      }
+    } else {
+      continue;
+    }
+    entry.key = add_string(*key);
+    entries.push_back(entry);
+  }
+
+  std::string string_data;
+  std::vector<std::pair<uint32_t, uint32_t>> refs;
+  for (const std::string& value : strings) {
+    refs.emplace_back(static_cast<uint32_t>(string_data.size()),
+                      static_cast<uint32_t>(value.size()));
+    string_data += value;
+  }
+
+  const auto& nodes = menu.nodes();
+  const size_t total = kPackedHeaderSize + refs.size() * kPackedStringRefSize +
+                       nodes.size() * kPackedNodeSize +
+                       entries.size() * kPackedStyleSize +
+                       insets.size() / 4 * kPackedInsetsSize +
+                       string_data.size();
+  Writer w;
+  w.out().reserve(total);
+  w.U32(kPackedMenuMagic);
+  w.U16(kPackedMenuVersion);
+  w.U16(static_cast<uint16_t>(kPackedHeaderSize));
+  w.U32(static_cast<uint32_t>(total));
+  w.U32(static_cast<uint32_t>(refs.size()));
+  w.U32(static_cast<uint32_t>(string_data.size()));
+  w.U32(static_cast<uint32_t>(nodes.size()));
+  w.U32(menu.root_count());
+  w.U32(static_cast<uint32_t>(entries.size()));
+  w.U32(static_cast<uint32_t>(insets.size() / 4));
+  w.U32(menu.generation());
+  for (const auto& [offset, length] : refs) {
+    w.U32(offset);
+    w.U32(length);
+  }
+  for (const MenuNode& node : nodes) {
+    w.U8(static_cast<uint8_t>(node.type));
+    w.U8((node.disabled ? kPackedNodeDisabled : 0) |
+         (node.checked ? kPackedNodeChecked : 0) |
+         (node.virtualized ? kPackedNodeVirtualized : 0));
+    w.U16(0);
+    w.U32(static_cast<uint32_t>(node.id));
+    for (StringId id : {node.label, node.icon, node.icon_font_family,
+                        node.accelerator_text, node.tool_tip,
+                        node.radio_group}) {
+      w.U32(id);
+    }
+    w.U32(node.first_child);
+    w.U32(node.child_count);
+  }
+  for (const StyleEntry& entry : entries) {
+    w.U32(entry.key);
+    w.U8(static_cast<uint8_t>(entry.kind));
+    w.U8(0);
+    w.U16(0);
+    w.U64(entry.bits);
+  }
+  for (double inset : insets) w.F64(inset);
+  w.Bytes(string_data);
+  return std::move(w.out());
+}
+
+void PokeU32(std::vector<uint8_t>& buffer, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    buffer[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+}  // namespace testing
+}  // namespace tray_manager_winui
@@ -0,0 +1,28 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_PACKED_MENU_WRITER_H_
+#define TRAY_MANAGER_WINUI_TEST_PACKED_MENU_WRITER_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+namespace testing {
+
+// Writes menu and style in the packed_menu.h format, as the Dart packer
+// does for the same menu JSON: nodes in CompileMenu order, strings as
+// interned by it. Style values that are not bools, ints, doubles, strings or
+// {left, top, right, bottom} maps are skipped.
+std::vector<uint8_t> PackMenu(const CompiledMenu& menu,
+                              const flutter::EncodableMap& style);
+
+// Overwrites 4 bytes at offset with a little-endian value; for corrupting
+// buffers in tests.
+void PokeU32(std::vector<uint8_t>& buffer, size_t offset, uint32_t value);
+
+}  // namespace testing
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_PACKED_MENU_WRITER_H_
@@ -0,0 +1,290 @@
+#include "recording_menu_backend.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace tray_manager_winui {
+namespace testing {
+
+bool RecordingMenuBackend::CreateHost() {
+  Record(RecordedOp::kCreateHost);
+  host_alive_ = true;
+  return true;
+}
+
+void RecordingMenuBackend::DestroyHost() {
+  Record(RecordedOp::kDestroyHost);
+  host_alive_ = false;
+  open_ = false;
+}
+
+bool RecordingMenuBackend::CreateFlyoutWidget(const ResolvedStyle&) {
+  Record(RecordedOp::kCreateFlyout);
+  has_flyout_ = true;
+  // Like the WinUI backend, which parses compact styles only when enabled.
+  compact_styles_ = item_style().compact;
+  return true;
+}
+
+void RecordingMenuBackend::DestroyFlyoutWidget() {
+  Record(RecordedOp::kDestroyFlyout);
+  has_flyout_ = false;
+  open_ = false;
+  widgets_.clear();
+  root_items_.clear();
+}
+
+bool RecordingMenuBackend::Show(const MenuShowRequest& request) {
+  Record(RecordedOp::kShow);
+  last_request_ = request;
+  if (fail_next_show_ || !has_flyout_ || !host_alive_) {
+    fail_next_show_ = false;
+    return false;
+  }
+  open_ = true;
+  if (events_) events_->OnMenuOpening();
+  return true;
+}
+
+bool RecordingMenuBackend::Click(int32_t id) {
+  if (!open_ || !menu()) return false;
+  uint32_t clicked = CompiledMenu::kNoNode;
+  menu()->ForEachNodeWithId(id, [&](uint32_t index) {
+    if (clicked == CompiledMenu::kNoNode && index < widgets_.size() &&
+        widgets_[index] && widgets_[index]->has_click) {
+      clicked = index;
+    }
+  });
+  if (clicked == CompiledMenu::kNoNode) return false;
+  RecordedWidget& widget = *widgets_[clicked];
+  if (!widget.enabled) return false;
+  // ToggleMenuFlyoutItem flips IsChecked before raising Click.
+  if (widget.kind == MenuWidgetKind::kToggle) widget.checked = !widget.checked;
+  const MenuClick click = ClickItem(clicked);
+  if (events_) events_->OnMenuItemClick(click);
+  if (!widget.keep_open) Close();
+  return true;
+}
+
+bool RecordingMenuBackend::OpenSubmenu(uint32_t index) {
+  if (!open_ || !widget(index).has_submenu_open_handler) {
+    return false;
+  }
+  MaterializeSubmenu(index);
+  return true;
+}
+
+bool RecordingMenuBackend::Page(uint32_t parent, MenuPageDirection direction) {
+  if (!open_) return false;
+  if (parent != kRootWidget && !widget(parent).created) return false;
+  const uint32_t page_item = direction == MenuPageDirection::kPrevious
+                                 ? kPreviousPageItem
+                                 : kMorePageItem;
+  const std::vector<uint32_t>& list = items(parent);
+  if (std::find(list.begin(), list.end(), page_item) == list.end()) {
+    return false;
+  }
+  return ShowPage(parent, direction);
+}
+
+bool RecordingMenuBackend::Close() {
+  if (!open_) return false;
+  if (events_) events_->OnMenuClosing();
+  open_ = false;
+  if (events_) events_->OnMenuClosed();
+  return true;
+}
+
+const RecordedWidget& RecordingMenuBackend::widget(uint32_t index) const {
+  static const RecordedWidget kNotCreated;
+  if (index >= widgets_.size() || !widgets_[index]) return kNotCreated;
+  return *widgets_[index];
+}
+
+const std::vector<uint32_t>& RecordingMenuBackend::items(
+    uint32_t parent) const {
+  return parent == kRootWidget ? root_items_ : widget(parent).children;
+}
+
+size_t RecordingMenuBackend::live_widget_count() const {
+  return static_cast<size_t>(
+      std::count_if(widgets_.begin(), widgets_.end(),
+                    [](const auto& entry) { return entry != nullptr; }));
+}
+
+size_t RecordingMenuBackend::CountOps(RecordedOp op) const {
+  return static_cast<size_t>(
+      std::count_if(log_.begin(), log_.end(),
+                    [op](const RecordedCall& call) { return call.op == op; }));
+}
+
+void RecordingMenuBackend::ClearItems(size_t node_count) {
+  Record(RecordedOp::kClearItems);
+  // Only created widgets are allocated, like controls on the WinUI side.
+  widgets_.clear();
+  widgets_.resize(node_count);
+  root_items_.clear();
+}
+
+void RecordingMenuBackend::CreateItem(uint32_t index, MenuWidgetKind kind) {
+  Record(RecordedOp::kCreateItem, index);
+  widgets_[index] = std::make_unique<RecordedWidget>();
+  widgets_[index]->created = true;
+  widgets_[index]->kind = kind;
+}
+
+void RecordingMenuBackend::AppendItem(uint32_t parent, uint32_t index) {
+  Record(RecordedOp::kAppendItem, index);
+  MutableItems(parent).push_back(index);
+}
+
+void RecordingMenuBackend::InsertItem(uint32_t parent, uint32_t position,
+                                      uint32_t index) {
+  Record(RecordedOp::kInsertItem, index);
+  std::vector<uint32_t>& list = MutableItems(parent);
+  list.insert(list.begin() + position, index);
+}
+
+void RecordingMenuBackend::RemoveItem(uint32_t parent, uint32_t position) {
+  Record(RecordedOp::kRemoveItem, parent);
+  std::vector<uint32_t>& list = MutableItems(parent);
+  list.erase(list.begin() + position);
+}
+
+void RecordingMenuBackend::ReleaseItem(uint32_t index) {
+  Record(RecordedOp::kReleaseItem, index);
+  // Page items live in the children list, so they go with the widget.
+  widgets_[index].reset();
+}
+
+void RecordingMenuBackend::InsertPageItem(uint32_t parent, uint32_t position,
+                                          MenuPageDirection direction,
+                                          std::string_view) {
+  Record(RecordedOp::kPageItem, parent);
+  std::vector<uint32_t>& list = MutableItems(parent);
+  list.insert(list.begin() + position,
+              direction == MenuPageDirection::kPrevious ? kPreviousPageItem
+                                                        : kMorePageItem);
+}
+
+void RecordingMenuBackend::SetText(uint32_t index, MenuText text) {
+  Record(RecordedOp::kText, index);
+  widgets_[index]->text.assign(text.utf8);
+  widgets_[index]->text_utf16.assign(text.utf16);
+}
+
+void RecordingMenuBackend::SetEnabled(uint32_t index, bool enabled) {
+  Record(RecordedOp::kEnabled, index);
+  widgets_[index]->enabled = enabled;
+}
+
+void RecordingMenuBackend::SetChecked(uint32_t index, bool checked) {
+  Record(RecordedOp::kChecked, index);
+  widgets_[index]->checked = checked;
+}
+
+void RecordingMenuBackend::SetIcon(uint32_t index, uint16_t glyph,
+                                   MenuText font_family,
+                                   uint32_t icon_color) {
+  Record(RecordedOp::kIcon, index);
+  RecordedWidget& widget = *widgets_[index];
+  widget.icon_glyph = glyph;
+  widget.icon_font_family.assign(font_family.utf8);
+  widget.icon_color = icon_color;
+}
+
+void RecordingMenuBackend::ClearIcon(uint32_t index) {
+  Record(RecordedOp::kIcon, index);
+  RecordedWidget& widget = *widgets_[index];
+  widget.icon_glyph = 0;
+  widget.icon_font_family.clear();
+  widget.icon_color = 0;
+}
+
+void RecordingMenuBackend::SetAcceleratorText(uint32_t index,
+                                              MenuText text) {
+  Record(RecordedOp::kAcceleratorText, index);
+  widgets_[index]->accelerator_text.assign(text.utf8);
+}
+
+void RecordingMenuBackend::SetToolTip(uint32_t index, MenuText text) {
+  Record(RecordedOp::kToolTip, index);
+  widgets_[index]->tool_tip.assign(text.utf8);
+}
+
+bool RecordingMenuBackend::SetCompactStyle(uint32_t index,
+                                           MenuWidgetKind kind) {
+  if (!compact_styles_ || kind == MenuWidgetKind::kSeparator) return false;
+  Record(RecordedOp::kCompactStyle, index);
+  widgets_[index]->compact = true;
+  return true;
+}
+
+void RecordingMenuBackend::SetFontSize(uint32_t index, double size) {
+  Record(RecordedOp::kFontSize, index);
+  widgets_[index]->font_size = size;
+}
+
+void RecordingMenuBackend::SetMinHeight(uint32_t index, double height) {
+  Record(RecordedOp::kMinHeight, index);
+  widgets_[index]->min_height = height;
+}
+
+void RecordingMenuBackend::SetForeground(uint32_t index, uint32_t argb) {
+  Record(RecordedOp::kForeground, index);
+  widgets_[index]->foreground = argb;
+}
+
+void RecordingMenuBackend::SetSeparatorColor(uint32_t index, uint32_t argb) {
+  Record(RecordedOp::kSeparatorColor, index);
+  widgets_[index]->separator_color = argb;
+}
+
+void RecordingMenuBackend::SetClickHandler(uint32_t index, int32_t id,
+                                           bool keep_open) {
+  Record(RecordedOp::kClickHandler, index);
+  RecordedWidget& widget = *widgets_[index];
+  widget.has_click = true;
+  widget.click_id = id;
+  widget.keep_open = keep_open;
+}
+
+void RecordingMenuBackend::SetSubmenuOpenHandler(uint32_t index) {
+  Record(RecordedOp::kSubmenuOpenHandler, index);
+  widgets_[index]->has_submenu_open_handler = true;
+}
+
+void RecordingMenuBackend::Record(RecordedOp op, uint32_t index) {
+  if (logging_) log_.push_back({op, index});
+}
+
+std::vector<uint32_t>& RecordingMenuBackend::MutableItems(uint32_t parent) {
+  return parent == kRootWidget ? root_items_ : widgets_[parent]->children;
+}
+
+bool HeadlessContextMenu::Show(MenuSnapshotPtr snapshot,
+                               const MenuShowRequest& request) {
+  return pool_.Show(std::move(snapshot), request);
+}
+
+bool HeadlessContextMenu::Show(const CompiledMenu& menu,
+                               const flutter::EncodableMap& style,
+                               const MenuShowRequest& request) {
+  return Show(MakeMenuSnapshot(menu, style), request);
+}
+
+bool HeadlessContextMenu::Click(int32_t id) {
+  if (!backend_.Click(id)) return false;
+  if (!backend_.is_open()) pool_.OnClosed();
+  return true;
+}
+
+bool HeadlessContextMenu::Close() {
+  if (!backend_.Close()) return false;
+  pool_.OnClosed();
+  return true;
+}
+
+}  // namespace testing
+}  // namespace tray_manager_winui
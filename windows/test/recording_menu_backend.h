@@ -0,0 +1,229 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_RECORDING_MENU_BACKEND_H_
+#define TRAY_MANAGER_WINUI_TEST_RECORDING_MENU_BACKEND_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "menu_host_pool.h"
+#include "menu_model.h"
+#include "menu_snapshot.h"
+#include "menu_widget_backend.h"
+
+namespace tray_manager_winui {
+namespace testing {
+
+/// Calls recorded by RecordingMenuBackend, in the order they were made.
+enum class RecordedOp : uint8_t {
+  kCreateHost,
+  kDestroyHost,
+  kCreateFlyout,
+  kDestroyFlyout,
+  kClearItems,
+  kCreateItem,
+  kAppendItem,
+  kInsertItem,
+  kRemoveItem,
+  kReleaseItem,
+  kPageItem,
+  kText,
+  kEnabled,
+  kChecked,
+  kIcon,
+  kAcceleratorText,
+  kToolTip,
+  kCompactStyle,
+  kFontSize,
+  kMinHeight,
+  kForeground,
+  kSeparatorColor,
+  kClickHandler,
+  kSubmenuOpenHandler,
+  kShow,
+};
+
+/// Entries of RecordedWidget::children and root_items() that stand for page
+/// items rather than node indices.
+constexpr uint32_t kPreviousPageItem = 0xFFFFFFFE;
+constexpr uint32_t kMorePageItem = 0xFFFFFFFD;
+
+/// One recorded call; index is the node index for widget calls, the parent
+/// for RemoveItem and page item calls, and kRootWidget otherwise.
+struct RecordedCall {
+  RecordedOp op;
+  uint32_t index;
+};
+
+/// In-memory stand-in for one flyout item control.
+struct RecordedWidget {
+  bool created = false;
+  MenuWidgetKind kind = MenuWidgetKind::kItem;
+  std::string text;
+  /// The UTF-16 text a XAML control would get.
+  std::u16string text_utf16;
+  bool enabled = true;
+  bool checked = false;
+  uint16_t icon_glyph = 0;
+  std::string icon_font_family;
+  uint32_t icon_color = 0;
+  std::string accelerator_text;
+  std::string tool_tip;
+  bool compact = false;
+  double font_size = 0;
+  double min_height = 0;
+  uint32_t foreground = 0;
+  uint32_t separator_color = 0;
+  bool has_click = false;
+  int32_t click_id = 0;
+  bool keep_open = false;
+  bool has_submenu_open_handler = false;
+  /// Items of this sub item in order: node indices, kPreviousPageItem and
+  /// kMorePageItem.
+  std::vector<uint32_t> children;
+};
+
+/// Headless MenuWidgetBackend: builds a widget tree in memory and logs every
+/// call, so the menu pipeline (MenuHostPool, item building, style resolution,
+/// event wiring) runs and can be measured without WinUI.
+class RecordingMenuBackend : public MenuWidgetBackend {
+ public:
+  /// events may be null.
+  explicit RecordingMenuBackend(MenuEventSink* events = nullptr)
+      : events_(events) {}
+
+  // MenuHostBackend:
+  bool CreateHost() override;
+  void DestroyHost() override;
+  bool IsHostAlive() const override { return host_alive_; }
+  bool Show(const MenuShowRequest& request) override;
+
+  /// Clicks the item with the given menu id, as the user would. Returns false
+  /// if the menu is not open or no clickable item has that id. Toggles flip
+  /// their control first, as ToggleMenuFlyoutItem does; items other than
+  /// toggles close the menu.
+  bool Click(int32_t id);
+
+  /// Hovers sub item index, which builds its children on the first open.
+  /// Returns false if the menu is not open or index has no open handler.
+  bool OpenSubmenu(uint32_t index);
+
+  /// Clicks the page item of parent's list towards direction. Returns false
+  /// if the menu is not open or parent has no such page item.
+  bool Page(uint32_t parent, MenuPageDirection direction);
+
+  /// Closes the open menu: reports onMenuClosing/onMenuClosed. The caller
+  /// tells the pool (MenuHostPool::OnClosed), as the WinUI Closed handler
+  /// does.
+  bool Close();
+
+  /// Simulates the host window being destroyed behind the pool's back.
+  void KillHost() { host_alive_ = false; }
+
+  /// Makes the next Show fail.
+  void FailNextShow() { fail_next_show_ = true; }
+
+  bool is_open() const { return open_; }
+  const std::optional<MenuShowRequest>& last_request() const {
+    return last_request_;
+  }
+
+  /// Widget of node index; a default RecordedWidget (created == false) if
+  /// it was not created.
+  const RecordedWidget& widget(uint32_t index) const;
+  /// Number of nodes of the menu the items were built from.
+  size_t widget_count() const { return widgets_.size(); }
+  /// Items of the flyout itself (see RecordedWidget::children).
+  const std::vector<uint32_t>& root_items() const { return root_items_; }
+  /// root_items() for kRootWidget, else the children of sub item parent.
+  const std::vector<uint32_t>& items(uint32_t parent) const;
+  /// Widgets that exist now (created and not released).
+  size_t live_widget_count() const;
+
+  /// Logging can be turned off to measure the pipeline alone.
+  void set_logging(bool enabled) { logging_ = enabled; }
+  const std::vector<RecordedCall>& log() const { return log_; }
+  void ClearLog() { log_.clear(); }
+  size_t CountOps(RecordedOp op) const;
+
+ protected:
+  // MenuWidgetBackend:
+  bool CreateFlyoutWidget(const ResolvedStyle& style) override;
+  void DestroyFlyoutWidget() override;
+  void ClearItems(size_t node_count) override;
+  void CreateItem(uint32_t index, MenuWidgetKind kind) override;
+  void AppendItem(uint32_t parent, uint32_t index) override;
+  void InsertItem(uint32_t parent, uint32_t position, uint32_t index) override;
+  void RemoveItem(uint32_t parent, uint32_t position) override;
+  void ReleaseItem(uint32_t index) override;
+  void InsertPageItem(uint32_t parent, uint32_t position,
+                      MenuPageDirection direction,
+                      std::string_view label) override;
+  void SetText(uint32_t index, MenuText text) override;
+  void SetEnabled(uint32_t index, bool enabled) override;
+  void SetChecked(uint32_t index, bool checked) override;
+  void SetIcon(uint32_t index, uint16_t glyph, MenuText font_family,
+               uint32_t icon_color) override;
+  void ClearIcon(uint32_t index) override;
+  void SetAcceleratorText(uint32_t index, MenuText text) override;
+  void SetToolTip(uint32_t index, MenuText text) override;
+  bool SetCompactStyle(uint32_t index, MenuWidgetKind kind) override;
+  void SetFontSize(uint32_t index, double size) override;
+  void SetMinHeight(uint32_t index, double height) override;
+  void SetForeground(uint32_t index, uint32_t argb) override;
+  void SetSeparatorColor(uint32_t index, uint32_t argb) override;
+  void SetClickHandler(uint32_t index, int32_t id, bool keep_open) override;
+  void SetSubmenuOpenHandler(uint32_t index) override;
+
+ private:
+  void Record(RecordedOp op, uint32_t index = kRootWidget);
+  std::vector<uint32_t>& MutableItems(uint32_t parent);
+
+  MenuEventSink* events_;
+  bool host_alive_ = false;
+  bool has_flyout_ = false;
+  bool compact_styles_ = false;
+  bool open_ = false;
+  bool fail_next_show_ = false;
+  std::optional<MenuShowRequest> last_request_;
+  std::vector<std::unique_ptr<RecordedWidget>> widgets_;
+  std::vector<uint32_t> root_items_;
+  bool logging_ = true;
+  std::vector<RecordedCall> log_;
+};
+
+/// The show path of ShowWinUIContextMenu with a RecordingMenuBackend in place
+/// of WinUI: one pool and backend, driven the way the XAML thread drives them.
+class HeadlessContextMenu {
+ public:
+  explicit HeadlessContextMenu(MenuEventSink* events = nullptr)
+      : backend_(events), pool_(backend_) {}
+
+  bool Show(MenuSnapshotPtr snapshot,
+            const MenuShowRequest& request = MenuShowRequest());
+  /// Shows a snapshot of copies of menu and style.
+  bool Show(const CompiledMenu& menu, const flutter::EncodableMap& style,
+            const MenuShowRequest& request = MenuShowRequest());
+
+  /// See RecordingMenuBackend::Click; a click that closes the menu returns
+  /// the host to the pool.
+  bool Click(int32_t id);
+  bool Close();
+
+  RecordingMenuBackend& backend() { return backend_; }
+  MenuHostPool& pool() { return pool_; }
+
+ private:
+  RecordingMenuBackend backend_;
+  MenuHostPool pool_;
+};
+
+}  // namespace testing
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_RECORDING_MENU_BACKEND_H_
@@ -0,0 +1,413 @@
+#include "show_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "task_thread.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::TaskThread;
+
+// The request is just the position the menu opens at.
+using Scheduler = ShowScheduler<int>;
+
+// Single-threaded stand-in for the XAML thread with a simulated clock: tasks
+// run in time order (then in the order they were posted), and RunUntil
+// advances the clock.
+class SimulatedXamlThread {
+ public:
+  void PostAfter(int delay, std::function<void()> task) {
+    tasks_.emplace(std::make_pair(now_ + delay, seq_++), std::move(task));
+  }
+
+  // Runs every task due at or before time.
+  void RunUntil(int time) {
+    while (!tasks_.empty() && tasks_.begin()->first.first <= time) {
+      auto it = tasks_.begin();
+      now_ = it->first.first;
+      std::function<void()> task = std::move(it->second);
+      tasks_.erase(it);
+      task();
+    }
+    if (time > now_) now_ = time;
+  }
+
+  void RunUntilIdle() {
+    while (!tasks_.empty()) RunUntil(tasks_.begin()->first.first);
+  }
+
+  int now() const { return now_; }
+
+ private:
+  int now_ = 0;
+  uint64_t seq_ = 0;
+  std::map<std::pair<int, uint64_t>, std::function<void()>> tasks_;
+};
+
+// Drives the scheduler the way the WinUI show path does: building and
+// opening a flyout take build_time + open_time, hiding one close_time.
+class SimulatedMenu {
+ public:
+  explicit SimulatedMenu(SimulatedXamlThread& xaml) : xaml_(xaml) {}
+
+  int build_time = 5;
+  int open_time = 20;
+  int close_time = 10;
+  // The next show fails while building.
+  bool fail_next = false;
+
+  // Platform thread.
+  void Submit(int position, Scheduler::Callback done) {
+    if (scheduler.Submit(position, std::move(done))) ScheduleNext();
+  }
+
+  // The user dismisses the open menu.
+  void Dismiss() {
+    if (!open_id_) return;
+    const uint64_t id = *open_id_;
+    xaml_.PostAfter(close_time, [this, id] { Closed(id); });
+  }
+
+  Scheduler scheduler;
+  // Where the menu is open, if it is.
+  std::optional<int> open_at;
+  std::vector<int> opened_positions;
+  int max_open = 0;
+
+ private:
+  void ScheduleNext() {
+    xaml_.PostAfter(0, [this] { RunNext(); });
+  }
+
+  void RunNext() {
+    ShowAction<int> action = scheduler.Next();
+    switch (action.step) {
+      case ShowStep::kNone:
+        break;
+      case ShowStep::kShow: {
+        const uint64_t id = action.id;
+        const int position = *action.request;
+        if (fail_next) {
+          fail_next = false;
+          xaml_.PostAfter(build_time, [this, id] { Closed(id); });
+          break;
+        }
+        xaml_.PostAfter(build_time + open_time, [this, id, position] {
+          if (hidden_.count(id)) return;  // Hidden before it opened.
+          open_at = position;
+          open_id_ = id;
+          opened_positions.push_back(position);
+          ++open_count_;
+          max_open = std::max(max_open, open_count_);
+          scheduler.OnOpened(id);
+        });
+        break;
+      }
+      case ShowStep::kClose: {
+        const uint64_t id = action.id;
+        hidden_.insert(id);
+        xaml_.PostAfter(close_time, [this, id] { Closed(id); });
+        break;
+      }
+    }
+  }
+
+  void Closed(uint64_t id) {
+    if (open_id_ == id) {
+      open_id_.reset();
+      open_at.reset();
+      --open_count_;
+    }
+    if (scheduler.OnClosed(id)) ScheduleNext();
+  }
+
+  SimulatedXamlThread& xaml_;
+  std::optional<uint64_t> open_id_;
+  std::set<uint64_t> hidden_;
+  int open_count_ = 0;
+};
+
+// Collects callback results; each callback must run exactly once.
+class Outcomes {
+ public:
+  Scheduler::Callback Expect(int id) {
+    return [this, id](bool shown) {
+      ++calls_[id];
+      results_[id] = shown;
+    };
+  }
+
+  std::optional<bool> result(int id) const {
+    auto it = results_.find(id);
+    if (it == results_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  bool AllCalledOnce(int count) const {
+    for (int id = 0; id < count; ++id) {
+      auto it = calls_.find(id);
+      if (it == calls_.end() || it->second != 1) return false;
+    }
+    return static_cast<int>(calls_.size()) == count;
+  }
+
+ private:
+  std::map<int, int> calls_;
+  std::map<int, bool> results_;
+};
+
+TEST(ShowSchedulerTest, ShowOpensAndReportsTrue) {
+  SimulatedXamlThread xaml;
+  SimulatedMenu menu(xaml);
+  Outcomes outcomes;
+  menu.Submit(100, outcomes.Expect(0));
+  xaml.RunUntil(24);
+  EXPECT_FALSE(outcomes.result(0).has_value());  // Not open yet.
+  xaml.RunUntilIdle();
+  EXPECT_EQ(outcomes.result(0), true);
+  EXPECT_EQ(menu.open_at, 100);
+  EXPECT_TRUE(menu.scheduler.busy());
+
+  menu.Dismiss();
+  xaml.RunUntilIdle();
+  EXPECT_FALSE(menu.scheduler.busy());
+  EXPECT_TRUE(outcomes.AllCalledOnce(1));
+}
+
+TEST(ShowSchedulerTest, BurstBeforeTheXamlThreadRunsMergesIntoTheLatest) {
+  SimulatedXamlThread xaml;
+  SimulatedMenu menu(xaml);
+  Outcomes outcomes;
+  for (int i = 0; i < 5; ++i) menu.Submit(100 + i, outcomes.Expect(i));
+  xaml.RunUntilIdle();
+
+  EXPECT_EQ(menu.opened_positions, std::vector<int>{104});
+  EXPECT_TRUE(outcomes.AllCalledOnce(5));
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(outcomes.result(i), true);
+  const ShowSchedulerStats stats = menu.scheduler.stats();
+  EXPECT_EQ(stats.submitted, 5u);
+  EXPECT_EQ(stats.merged, 4u);
+  EXPECT_EQ(stats.started, 1u);
+  EXPECT_EQ(stats.opened, 1u);
+}
+
+TEST(ShowSchedulerTest, RequestWhileBuildingSupersedesTheStartedShow) {
+  SimulatedXamlThread xaml;
+  SimulatedMenu menu(xaml);
+  Outcomes outcomes;
+  menu.Submit(100, outcomes.Expect(0));
+  xaml.RunUntil(10);  // Started, opens at 25.
+  menu.Submit(200, outcomes.Expect(1));
+  xaml.RunUntil(25);
+  EXPECT_FALSE(outcomes.result(0).has_value());  // Waits for the newer show.
+  xaml.RunUntilIdle();
+
+  EXPECT_EQ(menu.opened_positions, std::vector<int>{200});
+  EXPECT_EQ(menu.open_at, 200);
+  EXPECT_EQ(outcomes.result(0), true);
+  EXPECT_EQ(outcomes.result(1), true);
+  EXPECT_TRUE(outcomes.AllCalledOnce(2));
+  const ShowSchedulerStats stats = menu.scheduler.stats();
+  EXPECT_EQ(stats.superseded, 1u);
+  EXPECT_EQ(stats.started, 2u);
+  EXPECT_EQ(stats.opened, 1u);
+  EXPECT_EQ(stats.failed, 1u);  // The superseded show never opened.
+}
+
+TEST(ShowSchedulerTest, RequestWhileOpenReshowsAtTheNewPosition) {
+  SimulatedXamlThread xaml;
+  SimulatedMenu menu(xaml);
+  Outcomes outcomes;
+  menu.Submit(100, outcomes.Expect(0));
+  xaml.RunUntilIdle();
+  EXPECT_EQ(outcomes.result(0), true);
+
+  menu.Submit(200, outcomes.Expect(1));
+  xaml.RunUntilIdle();
+  EXPECT_EQ(menu.opened_positions, (std::vector<int>{100, 200}));
+  EXPECT_EQ(menu.open_at, 200);
+  EXPECT_EQ(outcomes.result(1), true);
+  EXPECT_EQ(menu.max_open, 1);
+  EXPECT_EQ(menu.scheduler.stats().reshown, 1u);
+}
+
+TEST(ShowSchedulerTest, RequestsWhileClosingWaitForTheClose) {
+  SimulatedXamlThread xaml;
+  SimulatedMenu menu(xaml);
+  Outcomes outcomes;
+  menu.Submit(100, outcomes.Expect(0));
+  xaml.RunUntilIdle();
+  menu.Submit(200, outcomes.Expect(1));
+  xaml.RunUntil(xaml.now() + 1);  // Closing the menu at 100.
+  menu.Submit(300, outcomes.Expect(2));
+  menu.Submit(400, outcomes.Expect(3));
+  xaml.RunUntilIdle();
+
+  EXPECT_EQ(menu.opened_positions, (std::vector<int>{100, 400}));
+  EXPECT_TRUE(outcomes.AllCalledOnce(4));
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(outcomes.result(i), true);
+}
+
+TEST(ShowSchedulerTest, FailedShowReportsFalseToEveryMergedCaller) {
+  SimulatedXamlThread xaml;
+  SimulatedMenu menu(xaml);
+  Outcomes outcomes;
+  menu.fail_next = true;
+  menu.Submit(100, outcomes.Expect(0));
+  menu.Submit(200, outcomes.Expect(1));
+  xaml.RunUntilIdle();
+  EXPECT_EQ(outcomes.result(0), false);
+  EXPECT_EQ(outcomes.result(1), false);
+  EXPECT_FALSE(menu.scheduler.busy());
+
+  // The next request starts over.
+  menu.Submit(300, outcomes.Expect(2));
+  xaml.RunUntilIdle();
+  EXPECT_EQ(outcomes.result(2), true);
+  EXPECT_TRUE(outcomes.AllCalledOnce(3));
+}
+
+TEST(ShowSchedulerTest, ShowClosedBeforeOpeningReportsFalse) {
+  Scheduler scheduler;
+  Outcomes outcomes;
+  ASSERT_TRUE(scheduler.Submit(100, outcomes.Expect(0)));
+  ShowAction<int> action = scheduler.Next();
+  ASSERT_EQ(action.step, ShowStep::kShow);
+  EXPECT_FALSE(scheduler.OnClosed(action.id));
+  EXPECT_EQ(outcomes.result(0), false);
+  scheduler.OnOpened(action.id);  // Outdated; ignored.
+  EXPECT_EQ(scheduler.stats().opened, 0u);
+  EXPECT_TRUE(outcomes.AllCalledOnce(1));
+}
+
+TEST(ShowSchedulerTest, FailPendingReportsFalseAndAllowsTheNextRun) {
+  Scheduler scheduler;
+  Outcomes outcomes;
+  ASSERT_TRUE(scheduler.Submit(100, outcomes.Expect(0)));
+  EXPECT_FALSE(scheduler.Submit(200, outcomes.Expect(1)));  // Merged.
+  scheduler.FailPending();  // E.g. WinUI initialization failed.
+  EXPECT_EQ(outcomes.result(0), false);
+  EXPECT_EQ(outcomes.result(1), false);
+  EXPECT_EQ(scheduler.Next().step, ShowStep::kNone);
+
+  EXPECT_TRUE(scheduler.Submit(300, outcomes.Expect(2)));
+  EXPECT_EQ(scheduler.Next().step, ShowStep::kShow);
+}
+
+TEST(ShowSchedulerTest, OnlyTheFirstSubmitOfABurstSchedulesARun) {
+  Scheduler scheduler;
+  Outcomes outcomes;
+  EXPECT_TRUE(scheduler.Submit(1, outcomes.Expect(0)));
+  EXPECT_FALSE(scheduler.Submit(2, outcomes.Expect(1)));
+  ShowAction<int> show = scheduler.Next();
+  ASSERT_EQ(show.step, ShowStep::kShow);
+  EXPECT_EQ(*show.request, 2);
+
+  // While the show runs, the next request needs one run, which closes it.
+  EXPECT_TRUE(scheduler.Submit(3, outcomes.Expect(2)));
+  EXPECT_FALSE(scheduler.Submit(4, outcomes.Expect(3)));
+  ShowAction<int> close = scheduler.Next();
+  ASSERT_EQ(close.step, ShowStep::kClose);
+  EXPECT_EQ(close.id, show.id);
+  // Until it closes, submits wait for OnClosed to schedule the run.
+  EXPECT_FALSE(scheduler.Submit(5, outcomes.Expect(4)));
+  EXPECT_TRUE(scheduler.OnClosed(show.id));
+  ShowAction<int> next = scheduler.Next();
+  ASSERT_EQ(next.step, ShowStep::kShow);
+  EXPECT_EQ(*next.request, 5);
+  scheduler.OnOpened(next.id);
+  EXPECT_TRUE(outcomes.AllCalledOnce(5));
+}
+
+// Random request times and random build, open and close durations. Every
+// caller is answered once, at most one menu is ever open, and the menu ends
+// up open at the last requested position.
+TEST(ShowSchedulerTest, RandomTimingsAlwaysEndAtTheLatestRequest) {
+  for (uint32_t seed = 1; seed <= 200; ++seed) {
+    std::mt19937 rng(seed);
+    SimulatedXamlThread xaml;
+    SimulatedMenu menu(xaml);
+    menu.build_time = static_cast<int>(rng() % 10);
+    menu.open_time = 1 + static_cast<int>(rng() % 40);
+    menu.close_time = 1 + static_cast<int>(rng() % 20);
+    Outcomes outcomes;
+    const int requests = 1 + static_cast<int>(rng() % 30);
+    int time = 0;
+    for (int i = 0; i < requests; ++i) {
+      time += static_cast<int>(rng() % 30);
+      xaml.RunUntil(time);
+      if (rng() % 8 == 0) menu.Dismiss();
+      menu.Submit(i, outcomes.Expect(i));
+    }
+    xaml.RunUntilIdle();
+
+    SCOPED_TRACE(seed);
+    EXPECT_TRUE(outcomes.AllCalledOnce(requests));
+    EXPECT_LE(menu.max_open, 1);
+    ASSERT_FALSE(menu.opened_positions.empty());
+    EXPECT_EQ(menu.opened_positions.back(), requests - 1);
+    EXPECT_EQ(outcomes.result(requests - 1), true);
+  }
+}
+
+// The platform thread submits while the XAML thread runs shows and reports
+// their outcomes. Run under -DTRAY_MANAGER_WINUI_SANITIZER=thread.
+TEST(ShowSchedulerTest, ConcurrentSubmitsAreEachAnsweredOnce) {
+  constexpr int kRequests = 5000;
+  Scheduler scheduler;
+  std::vector<std::atomic<int>> calls(kRequests);
+  std::atomic<int> last_opened{-1};
+  {
+    TaskThread xaml;
+    std::function<void()> run_next = [&] {
+      ShowAction<int> action = scheduler.Next();
+      if (action.step == ShowStep::kShow) {
+        const uint64_t id = action.id;
+        const int position = *action.request;
+        // Opens in a later task, like Loaded and Opened.
+        xaml.Post([&, id, position] {
+          last_opened = position;
+          scheduler.OnOpened(id);
+        });
+      } else if (action.step == ShowStep::kClose) {
+        const uint64_t id = action.id;
+        xaml.Post([&, id] {
+          if (scheduler.OnClosed(id)) xaml.Post(run_next);
+        });
+      }
+    };
+    for (int i = 0; i < kRequests; ++i) {
+      if (scheduler.Submit(i, [&calls, i](bool) { ++calls[i]; })) {
+        xaml.Post(run_next);
+      }
+      if (i % 64 == 0) std::this_thread::yield();
+    }
+    // The last request is answered last; wait for it before stopping the
+    // XAML thread, which drops tasks posted after that.
+    for (int spins = 0; calls[kRequests - 1].load() == 0 && spins < 100000;
+         ++spins) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+  for (int i = 0; i < kRequests; ++i) {
+    ASSERT_EQ(calls[i].load(), 1) << i;
+  }
+  EXPECT_EQ(last_opened.load(), kRequests - 1);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
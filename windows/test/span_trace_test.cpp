@@ -0,0 +1,172 @@
+#include "span_trace.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tray_manager_winui {
+namespace {
+
+TEST(SpanTraceTest, RecordsNothingWhileDisabled) {
+  SpanTrace trace;
+  trace.Record("a", 1, 2);
+  trace.Instant("b");
+  { ScopedSpan span("c", trace); }
+  EXPECT_TRUE(trace.Snapshot().empty());
+  EXPECT_EQ(trace.recorded(), 0u);
+}
+
+TEST(SpanTraceTest, SnapshotIsOrderedByStart) {
+  SpanTrace trace;
+  trace.set_enabled(true);
+  const uint32_t show = trace.BeginShow();
+  const uint64_t t = SpanTrace::Now();
+  trace.Record("late", t + 300, t + 400);
+  trace.Record("early", t + 100, t + 250);
+  trace.Record("backwards", t + 500, t + 450);
+
+  const std::vector<SpanRecord> records = trace.Snapshot();
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_STREQ(records[0].name, "early");
+  EXPECT_GT(records[0].duration_ns, 0u);
+  EXPECT_LT(records[0].start_ns, records[1].start_ns);
+  EXPECT_STREQ(records[1].name, "late");
+  EXPECT_STREQ(records[2].name, "backwards");
+  EXPECT_EQ(records[2].duration_ns, 0u);
+  for (const SpanRecord& record : records) {
+    EXPECT_EQ(record.show, show);
+    EXPECT_EQ(record.thread, SpanTrace::CurrentThread());
+    EXPECT_FALSE(record.instant);
+  }
+}
+
+TEST(SpanTraceTest, ScopedSpanCoversItsScope) {
+  SpanTrace trace;
+  trace.set_enabled(true);
+  const uint64_t before = SpanTrace::NowNs();
+  {
+    ScopedSpan span("scope", trace);
+    trace.Instant("inside");
+  }
+  const uint64_t after = SpanTrace::NowNs();
+
+  // Tick to nanosecond conversion is calibrated, so allow some slack.
+  constexpr uint64_t kSlackNs = 2000;
+  const std::vector<SpanRecord> records = trace.Snapshot();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_STREQ(records[0].name, "scope");
+  EXPECT_GE(records[0].start_ns + kSlackNs, before);
+  EXPECT_LE(records[0].start_ns + records[0].duration_ns, after + kSlackNs);
+  EXPECT_TRUE(records[1].instant);
+  EXPECT_GE(records[1].start_ns, records[0].start_ns);
+}
+
+TEST(SpanTraceTest, KeepsTheNewestSpansWhenFull) {
+  SpanTrace trace(4);
+  trace.set_enabled(true);
+  const char* names[] = {"0", "1", "2", "3", "4", "5"};
+  const uint64_t t = SpanTrace::Now();
+  for (uint64_t i = 0; i < 6; ++i) trace.Record(names[i], t + i, t + i + 1);
+
+  const std::vector<SpanRecord> records = trace.Snapshot();
+  ASSERT_EQ(records.size(), 4u);
+  EXPECT_STREQ(records.front().name, "2");
+  EXPECT_STREQ(records.back().name, "5");
+  EXPECT_EQ(trace.recorded(), 6u);
+}
+
+TEST(SpanTraceTest, ClearForgetsEarlierSpans) {
+  SpanTrace trace;
+  trace.set_enabled(true);
+  trace.Record("old", SpanTrace::Now(), SpanTrace::Now());
+  trace.Clear();
+  EXPECT_TRUE(trace.Snapshot().empty());
+  trace.Record("new", SpanTrace::Now(), SpanTrace::Now());
+  ASSERT_EQ(trace.Snapshot().size(), 1u);
+  EXPECT_STREQ(trace.Snapshot()[0].name, "new");
+}
+
+TEST(SpanTraceTest, ExportsChromeTraceEvents) {
+  std::vector<SpanRecord> records(3);
+  records[0] = {"CreateHost", 10000, 2500, 2, 1, false};
+  records[1] = {"say \"hi\"\n", 11000, 1, 2, 1, false};
+  records[2] = {"Opened", 12000, 0, 3, 1, true};
+
+  const std::string json = ExportChromeTrace(records, {{2, "platform"}});
+  EXPECT_EQ(json,
+            "{\"traceEvents\":[\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+            "\"args\":{\"name\":\"platform\"}},\n"
+            "{\"name\":\"CreateHost\",\"cat\":\"tray_manager_winui\",\"ph\":\"X\","
+            "\"ts\":0.000,\"dur\":2.500,\"pid\":1,\"tid\":2,"
+            "\"args\":{\"show\":1}},\n"
+            "{\"name\":\"say \\\"hi\\\"\\u000a\",\"cat\":\"tray_manager_winui\","
+            "\"ph\":\"X\",\"ts\":1.000,\"dur\":0.001,\"pid\":1,\"tid\":2,"
+            "\"args\":{\"show\":1}},\n"
+            "{\"name\":\"Opened\",\"cat\":\"tray_manager_winui\",\"ph\":\"i\","
+            "\"s\":\"t\",\"ts\":2.000,\"pid\":1,\"tid\":3,"
+            "\"args\":{\"show\":1}}\n"
+            "],\"displayTimeUnit\":\"ms\"}");
+}
+
+TEST(SpanTraceTest, ExportsRecordedSpansAndThreadNames) {
+  SpanTrace trace;
+  trace.set_enabled(true);
+  trace.NameThread("platform");
+  trace.BeginShow();
+  { ScopedSpan span("CreateHost", trace); }
+  trace.Instant("Opened");
+
+  const std::string json = ExportChromeTrace(trace);
+  const std::string tid = std::to_string(SpanTrace::CurrentThread());
+  EXPECT_NE(json.find("\"tid\":" + tid + ",\"args\":{\"name\":\"platform\"}"),
+            std::string::npos);
+  EXPECT_NE(json.find("{\"name\":\"CreateHost\",\"cat\":\"tray_manager_winui\","
+                      "\"ph\":\"X\",\"ts\":0.000,\"dur\":"),
+            std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"Opened\""), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"show\":1}"), std::string::npos);
+}
+
+TEST(SpanTraceTest, EmptyTraceExportsNoEvents) {
+  SpanTrace trace;
+  EXPECT_EQ(ExportChromeTrace(trace),
+            "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}");
+}
+
+// Writers on several threads while another thread exports; every span read
+// back must be complete. Run under -DTRAY_MANAGER_WINUI_SANITIZER=thread.
+TEST(SpanTraceTest, ConcurrentWritersAndReaders) {
+  constexpr int kWriters = 4;
+  constexpr int kSpansPerWriter = 20000;
+  SpanTrace trace(256);
+  trace.set_enabled(true);
+
+  std::vector<std::thread> threads;
+  for (int w = 0; w < kWriters; ++w) {
+    threads.emplace_back([&trace] {
+      for (int i = 0; i < kSpansPerWriter; ++i) {
+        ScopedSpan span("span", trace);
+      }
+    });
+  }
+  std::thread reader([&trace] {
+    for (int i = 0; i < 50; ++i) {
+      for (const SpanRecord& record : trace.Snapshot()) {
+        ASSERT_STREQ(record.name, "span");
+        ASSERT_NE(record.thread, 0u);
+      }
+      EXPECT_FALSE(ExportChromeTrace(trace).empty());
+    }
+  });
+  for (auto& thread : threads) thread.join();
+  reader.join();
+
+  EXPECT_EQ(trace.recorded(), uint64_t{kWriters} * kSpansPerWriter);
+  EXPECT_EQ(trace.Snapshot().size(), trace.capacity());
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
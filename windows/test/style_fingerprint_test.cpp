@@ -0,0 +1,118 @@
+#include "style_fingerprint.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::MakeStyle;
+
+flutter::EncodableMap MakePadding(double left, double top, double right,
+                                  double bottom) {
+  return MakeStyle({{"left", flutter::EncodableValue(left)},
+                    {"top", flutter::EncodableValue(top)},
+                    {"right", flutter::EncodableValue(right)},
+                    {"bottom", flutter::EncodableValue(bottom)}});
+}
+
+TEST(StyleFingerprintTest, IsStableAcrossBuilds) {
+  // FNV-1a 64 of the canonical empty map ('M' + u64 0); pinned so a changed
+  // encoding is noticed (cached fingerprints would silently stop matching).
+  EXPECT_EQ(FingerprintStyle(flutter::EncodableMap()), 0x7ad8d9b8091e90b8ull);
+  EXPECT_EQ(CanonicalizeStyle(flutter::EncodableMap()),
+            std::string("M\0\0\0\0\0\0\0\0", 9));
+}
+
+TEST(StyleFingerprintTest, IndependentOfKeyInsertionOrder) {
+  auto a = MakeStyle({{"textColor", flutter::EncodableValue(int64_t{0xFFFFFFFF})},
+                      {"fontSize", flutter::EncodableValue(14.0)},
+                      {"fontFamily", flutter::EncodableValue("Segoe UI")},
+                      {"padding", flutter::EncodableValue(MakePadding(1, 2, 3, 4))}});
+  flutter::EncodableMap reversed_padding;
+  reversed_padding[flutter::EncodableValue("bottom")] = flutter::EncodableValue(4.0);
+  reversed_padding[flutter::EncodableValue("right")] = flutter::EncodableValue(3.0);
+  reversed_padding[flutter::EncodableValue("top")] = flutter::EncodableValue(2.0);
+  reversed_padding[flutter::EncodableValue("left")] = flutter::EncodableValue(1.0);
+  auto b = MakeStyle({{"padding", flutter::EncodableValue(reversed_padding)},
+                      {"fontFamily", flutter::EncodableValue("Segoe UI")},
+                      {"fontSize", flutter::EncodableValue(14.0)},
+                      {"textColor", flutter::EncodableValue(int64_t{0xFFFFFFFF})}});
+
+  EXPECT_EQ(CanonicalizeStyle(a), CanonicalizeStyle(b));
+  EXPECT_EQ(FingerprintStyle(a), FingerprintStyle(b));
+}
+
+TEST(StyleFingerprintTest, Int32AndInt64ColoursMatch) {
+  // Small colours fit int32 on the wire; the same value may arrive as int64.
+  auto as_int32 = MakeStyle({{"hoverBackgroundColor",
+                              flutter::EncodableValue(int32_t{0x7F404040})}});
+  auto as_int64 = MakeStyle({{"hoverBackgroundColor",
+                              flutter::EncodableValue(int64_t{0x7F404040})}});
+  EXPECT_EQ(FingerprintStyle(as_int32), FingerprintStyle(as_int64));
+
+  // Opaque colours exceed int32 and come as int64; a sign-extended int32 of
+  // the same bits renders the same XAML colour and must match too.
+  auto opaque_int64 = MakeStyle({{"backgroundColor",
+                                  flutter::EncodableValue(int64_t{0xFF202020})}});
+  auto opaque_int32 = MakeStyle(
+      {{"backgroundColor",
+        flutter::EncodableValue(static_cast<int32_t>(0xFF202020u))}});
+  EXPECT_EQ(FingerprintStyle(opaque_int64), FingerprintStyle(opaque_int32));
+}
+
+TEST(StyleFingerprintTest, NonColourIntsKeepFullWidth) {
+  auto weight = MakeStyle({{"fontWeight", flutter::EncodableValue(int32_t{-1})}});
+  auto wide = MakeStyle(
+      {{"fontWeight", flutter::EncodableValue(int64_t{0xFFFFFFFF})}});
+  EXPECT_NE(FingerprintStyle(weight), FingerprintStyle(wide));
+
+  auto int32_weight =
+      MakeStyle({{"fontWeight", flutter::EncodableValue(int32_t{700})}});
+  auto int64_weight =
+      MakeStyle({{"fontWeight", flutter::EncodableValue(int64_t{700})}});
+  EXPECT_EQ(FingerprintStyle(int32_weight), FingerprintStyle(int64_weight));
+}
+
+TEST(StyleFingerprintTest, DifferentValuesDiffer) {
+  auto base = MakeStyle({{"fontSize", flutter::EncodableValue(14.0)}});
+  auto other = MakeStyle({{"fontSize", flutter::EncodableValue(15.0)}});
+  auto renamed = MakeStyle({{"minWidth", flutter::EncodableValue(14.0)}});
+  auto padded = MakeStyle(
+      {{"padding", flutter::EncodableValue(MakePadding(1, 2, 3, 4))}});
+  auto padded_other = MakeStyle(
+      {{"padding", flutter::EncodableValue(MakePadding(1, 2, 4, 3))}});
+  EXPECT_NE(FingerprintStyle(base), FingerprintStyle(other));
+  EXPECT_NE(FingerprintStyle(base), FingerprintStyle(renamed));
+  EXPECT_NE(FingerprintStyle(padded), FingerprintStyle(padded_other));
+}
+
+TEST(StyleFingerprintTest, DistinguishesValueTypes) {
+  auto as_bool = MakeStyle({{"compactItemLayout", flutter::EncodableValue(true)}});
+  auto as_int = MakeStyle({{"compactItemLayout", flutter::EncodableValue(1)}});
+  auto as_string =
+      MakeStyle({{"compactItemLayout", flutter::EncodableValue("true")}});
+  EXPECT_NE(FingerprintStyle(as_bool), FingerprintStyle(as_int));
+  EXPECT_NE(FingerprintStyle(as_bool), FingerprintStyle(as_string));
+}
+
+TEST(StyleFingerprintTest, FoldsNegativeZero) {
+  auto positive = MakeStyle({{"cornerRadius", flutter::EncodableValue(0.0)}});
+  auto negative = MakeStyle({{"cornerRadius", flutter::EncodableValue(-0.0)}});
+  EXPECT_EQ(FingerprintStyle(positive), FingerprintStyle(negative));
+}
+
+TEST(StyleFingerprintTest, StringBoundariesAreUnambiguous) {
+  auto a = MakeStyle({{"fontFamily", flutter::EncodableValue("ab")},
+                      {"themeMode", flutter::EncodableValue("c")}});
+  auto b = MakeStyle({{"fontFamily", flutter::EncodableValue("a")},
+                      {"themeMode", flutter::EncodableValue("bc")}});
+  EXPECT_NE(FingerprintStyle(a), FingerprintStyle(b));
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
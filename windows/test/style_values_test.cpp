@@ -0,0 +1,230 @@
+#include "style_values.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "menu_fixtures.h"
+#include "style_fingerprint.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using Entry = testing::StyleEntry;
+using testing::MakeStyle;
+
+// Every key WinUIContextMenuStyle.toJson() can send
+// (lib/src/winui_context_menu_style.dart), with a value of its type.
+std::vector<Entry> DocumentedStyle() {
+  flutter::EncodableMap padding = MakeStyle({
+      {"left", flutter::EncodableValue(1.0)},
+      {"top", flutter::EncodableValue(2.0)},
+      {"right", flutter::EncodableValue(3.0)},
+      {"bottom", flutter::EncodableValue(4.0)},
+  });
+  return {
+      {"backgroundColor", flutter::EncodableValue(int64_t{0xFF000001})},
+      {"textColor", flutter::EncodableValue(int64_t{0xFF000002})},
+      {"fontSize", flutter::EncodableValue(13.5)},
+      {"fontFamily", flutter::EncodableValue("Segoe UI Variable Display")},
+      {"fontWeight", flutter::EncodableValue(600)},
+      {"cornerRadius", flutter::EncodableValue(8.0)},
+      {"padding", flutter::EncodableValue(padding)},
+      {"minWidth", flutter::EncodableValue(200.0)},
+      {"themeMode", flutter::EncodableValue("dark")},
+      {"separatorColor", flutter::EncodableValue(int64_t{0xFF000003})},
+      {"disabledTextColor", flutter::EncodableValue(int64_t{0xFF000004})},
+      {"hoverBackgroundColor", flutter::EncodableValue(int64_t{0xFF000005})},
+      {"subMenuOpenedBackgroundColor",
+       flutter::EncodableValue(int64_t{0xFF000006})},
+      {"subMenuOpenedTextColor", flutter::EncodableValue(int64_t{0xFF000007})},
+      {"borderColor", flutter::EncodableValue(int64_t{0xFF000008})},
+      {"borderThickness", flutter::EncodableValue(1.5)},
+      {"fontStyle", flutter::EncodableValue("italic")},
+      {"itemHeight", flutter::EncodableValue(28.0)},
+      {"shadowElevation", flutter::EncodableValue(16.0)},
+      {"checkedIndicatorColor", flutter::EncodableValue(int64_t{0xFF000009})},
+      {"checkedForegroundColor", flutter::EncodableValue(int64_t{0xFF00000A})},
+      {"checkedBackgroundColor", flutter::EncodableValue(int64_t{0xFF00000B})},
+      {"iconColor", flutter::EncodableValue(int64_t{0xFF00000C})},
+      {"keyboardAcceleratorColor",
+       flutter::EncodableValue(int64_t{0xFF00000D})},
+      {"compactItemLayout", flutter::EncodableValue(false)},
+      {"maxHeight", flutter::EncodableValue(400.0)},
+      {"virtualizationThreshold", flutter::EncodableValue(100)},
+      {"virtualizationPageSize", flutter::EncodableValue(20)},
+      {"virtualizationMaxItems", flutter::EncodableValue(60)},
+      {"virtualizationMoreLabel", flutter::EncodableValue("More")},
+      {"virtualizationPreviousLabel", flutter::EncodableValue("Back")},
+      {"enableOpenCloseAnimations", flutter::EncodableValue(false)},
+      {"dismissOnPointerMoveAway", flutter::EncodableValue(true)},
+      {"backdropType", flutter::EncodableValue("mica")},
+  };
+}
+
+TEST(StyleValuesTest, FindsEveryDocumentedKey) {
+  const std::vector<Entry> documented = DocumentedStyle();
+  ASSERT_EQ(documented.size(), kStyleKeyCount);
+  std::set<StyleKey> found;
+  for (const auto& [name, value] : documented) {
+    const std::optional<StyleKey> key = FindStyleKey(name);
+    ASSERT_TRUE(key.has_value()) << name;
+    EXPECT_EQ(StyleKeyName(*key), name);
+    found.insert(*key);
+  }
+  EXPECT_EQ(found.size(), kStyleKeyCount);
+}
+
+TEST(StyleValuesTest, RejectsOtherNames) {
+  EXPECT_FALSE(FindStyleKey("").has_value());
+  EXPECT_FALSE(FindStyleKey("font").has_value());
+  EXPECT_FALSE(FindStyleKey("fontsize").has_value());
+  EXPECT_FALSE(FindStyleKey("FontSize").has_value());
+  EXPECT_FALSE(FindStyleKey(std::string_view("fontSize\0", 9)).has_value());
+  EXPECT_FALSE(FindStyleKey("radioGroup").has_value());
+
+  // Every one-character change, truncation and extension of every key.
+  for (size_t i = 0; i < kStyleKeyCount; ++i) {
+    const std::string name(StyleKeyName(static_cast<StyleKey>(i)));
+    EXPECT_FALSE(FindStyleKey(name.substr(0, name.size() - 1)).has_value());
+    EXPECT_FALSE(FindStyleKey(name + "s").has_value());
+    for (size_t at = 0; at < name.size(); ++at) {
+      std::string changed = name;
+      changed[at] = static_cast<char>(changed[at] ^ 0x20);
+      EXPECT_FALSE(FindStyleKey(changed).has_value()) << changed;
+    }
+  }
+}
+
+TEST(StyleValuesTest, ResolvesEveryDocumentedKey) {
+  const flutter::EncodableMap map = MakeStyle(DocumentedStyle());
+  const ResolvedStyle style = ResolveStyle(map);
+
+  EXPECT_EQ(style.present, (uint64_t{1} << kStyleKeyCount) - 1);
+  EXPECT_EQ(style.fingerprint, FingerprintStyle(map));
+  EXPECT_EQ(style.background_color, 0xFF000001u);
+  EXPECT_EQ(style.text_color, 0xFF000002u);
+  EXPECT_EQ(style.separator_color, 0xFF000003u);
+  EXPECT_EQ(style.disabled_text_color, 0xFF000004u);
+  EXPECT_EQ(style.hover_background_color, 0xFF000005u);
+  EXPECT_EQ(style.sub_menu_opened_background_color, 0xFF000006u);
+  EXPECT_EQ(style.sub_menu_opened_text_color, 0xFF000007u);
+  EXPECT_EQ(style.border_color, 0xFF000008u);
+  EXPECT_EQ(style.checked_indicator_color, 0xFF000009u);
+  EXPECT_EQ(style.checked_foreground_color, 0xFF00000Au);
+  EXPECT_EQ(style.checked_background_color, 0xFF00000Bu);
+  EXPECT_EQ(style.icon_color, 0xFF00000Cu);
+  EXPECT_EQ(style.keyboard_accelerator_color, 0xFF00000Du);
+  EXPECT_EQ(style.font_size, 13.5);
+  EXPECT_EQ(style.corner_radius, 8.0);
+  EXPECT_EQ(style.min_width, 200.0);
+  EXPECT_EQ(style.border_thickness, 1.5);
+  EXPECT_EQ(style.item_height, 28.0);
+  EXPECT_EQ(style.shadow_elevation, 16.0);
+  EXPECT_EQ(style.max_height, 400.0);
+  EXPECT_EQ(style.padding.left, 1.0);
+  EXPECT_EQ(style.padding.top, 2.0);
+  EXPECT_EQ(style.padding.right, 3.0);
+  EXPECT_EQ(style.padding.bottom, 4.0);
+  EXPECT_EQ(style.font_weight, 600);
+  EXPECT_EQ(style.virtualization_threshold, 100);
+  EXPECT_EQ(style.virtualization_page_size, 20);
+  EXPECT_EQ(style.virtualization_max_items, 60);
+  EXPECT_EQ(style.font_family, "Segoe UI Variable Display");
+  EXPECT_EQ(style.font_style, "italic");
+  EXPECT_EQ(style.theme_mode, "dark");
+  EXPECT_EQ(style.backdrop_type, "mica");
+  EXPECT_EQ(style.virtualization_more_label, "More");
+  EXPECT_EQ(style.virtualization_previous_label, "Back");
+  EXPECT_FALSE(style.compact_item_layout);
+  EXPECT_FALSE(style.enable_open_close_animations);
+  EXPECT_TRUE(style.dismiss_on_pointer_move_away);
+}
+
+TEST(StyleValuesTest, MissingKeysKeepDefaults) {
+  const ResolvedStyle style = ResolveStyle(flutter::EncodableMap());
+  EXPECT_TRUE(style.empty());
+  EXPECT_EQ(style.fingerprint, FingerprintStyle(flutter::EncodableMap()));
+  EXPECT_EQ(style.text_color, 0u);
+  EXPECT_EQ(style.font_size, 0.0);
+  EXPECT_TRUE(style.font_family.empty());
+  EXPECT_TRUE(style.compact_item_layout);
+  EXPECT_TRUE(style.enable_open_close_animations);
+  EXPECT_FALSE(style.dismiss_on_pointer_move_away);
+
+  // The Dart default style sends only compactItemLayout.
+  const ResolvedStyle dart_default = ResolveStyle(
+      MakeStyle({{"compactItemLayout", flutter::EncodableValue(true)}}));
+  EXPECT_FALSE(dart_default.empty());
+  EXPECT_TRUE(dart_default.has(StyleKey::kCompactItemLayout));
+  EXPECT_FALSE(dart_default.has(StyleKey::kFontSize));
+}
+
+TEST(StyleValuesTest, WrongTypesCountAsMissing) {
+  const ResolvedStyle style = ResolveStyle(MakeStyle({
+      {"fontSize", flutter::EncodableValue("large")},
+      {"textColor", flutter::EncodableValue(1.5)},
+      {"padding", flutter::EncodableValue("not a map")},
+      {"fontFamily", flutter::EncodableValue(12)},
+      {"compactItemLayout", flutter::EncodableValue(0)},
+      {"enableOpenCloseAnimations", flutter::EncodableValue()},
+  }));
+  EXPECT_TRUE(style.empty());
+  EXPECT_EQ(style.font_size, 0.0);
+  EXPECT_EQ(style.text_color, 0u);
+  EXPECT_TRUE(style.font_family.empty());
+  EXPECT_TRUE(style.compact_item_layout);
+  EXPECT_TRUE(style.enable_open_close_animations);
+}
+
+TEST(StyleValuesTest, ReadsEitherIntWidthAndWholeNumbers) {
+  const ResolvedStyle style = ResolveStyle(MakeStyle({
+      {"textColor", flutter::EncodableValue(int32_t{0x7F112233})},
+      // Dart sends colours above 0x7FFFFFFF as int64; only 32 bits count.
+      {"iconColor", flutter::EncodableValue(int64_t{0x1FF445566})},
+      {"fontSize", flutter::EncodableValue(14)},
+      {"maxHeight", flutter::EncodableValue(int64_t{300})},
+      {"virtualizationMaxItems", flutter::EncodableValue(int64_t{1} << 40)},
+      {"padding", flutter::EncodableValue(MakeStyle({
+                      {"left", flutter::EncodableValue(4)},
+                      {"bottom", flutter::EncodableValue(0.5)},
+                  }))},
+  }));
+  EXPECT_EQ(style.text_color, 0x7F112233u);
+  EXPECT_EQ(style.icon_color, 0xFF445566u);
+  EXPECT_EQ(style.font_size, 14.0);
+  EXPECT_EQ(style.max_height, 300.0);
+  EXPECT_EQ(style.virtualization_max_items, int64_t{1} << 40);
+  EXPECT_EQ(style.padding.left, 4.0);
+  EXPECT_EQ(style.padding.top, 0.0);
+  EXPECT_EQ(style.padding.bottom, 0.5);
+}
+
+TEST(StyleValuesTest, IgnoresUnknownKeys) {
+  flutter::EncodableMap map = MakeStyle({
+      {"fontSize", flutter::EncodableValue(12.0)},
+      {"futureKey", flutter::EncodableValue(1)},
+  });
+  map[flutter::EncodableValue(7)] = flutter::EncodableValue(1.0);
+  const ResolvedStyle style = ResolveStyle(map);
+  EXPECT_EQ(style.present, uint64_t{1}
+                               << static_cast<unsigned>(StyleKey::kFontSize));
+  EXPECT_EQ(style.font_size, 12.0);
+  // They still take part in the fingerprint.
+  EXPECT_EQ(style.fingerprint, FingerprintStyle(map));
+}
+
+TEST(StyleValuesTest, CountsStringsTowardsMemory) {
+  const std::string label(1000, 'x');
+  const ResolvedStyle small = ResolveStyle(flutter::EncodableMap());
+  const ResolvedStyle labelled = ResolveStyle(
+      MakeStyle({{"virtualizationMoreLabel", flutter::EncodableValue(label)}}));
+  EXPECT_EQ(small.memory_bytes(), sizeof(ResolvedStyle));
+  EXPECT_GE(labelled.memory_bytes(), sizeof(ResolvedStyle) + label.size());
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,144 @@
+#include "synthetic_menu.h"
+
+#include <random>
+#include <utility>
+
+#include "menu_fixtures.h"
+
+namespace tray_manager_winui {
+namespace testing {
+
+namespace {
+
+void AppendUtf8(std::string& out, char32_t code_point) {
+  if (code_point < 0x80) {
+    out += static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    out += static_cast<char>(0xC0 | (code_point >> 6));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    out += static_cast<char>(0xE0 | (code_point >> 12));
+    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (code_point >> 18));
+    out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+}
+
+class Generator {
+ public:
+  explicit Generator(const SyntheticMenuSpec& spec)
+      : spec_(spec), rng_(spec.seed) {}
+
+  flutter::EncodableMap Generate() {
+    remaining_ = spec_.item_count;
+    return MakeMenu(FillList(0));
+  }
+
+ private:
+  // The root keeps adding items until the budget is spent; submenus stop at
+  // spec_.width.
+  flutter::EncodableList FillList(int32_t level) {
+    flutter::EncodableList items;
+    const int32_t width = spec_.width > 0 ? spec_.width : 1;
+    for (int32_t i = 0; remaining_ > 0 && (level == 0 || i < width); ++i) {
+      const int32_t id = next_id_++;
+      --remaining_;
+      // Every third item opens a submenu while levels are left.
+      if (level < spec_.depth && i % 3 == 0 && remaining_ > 0) {
+        const std::string label = Label(id);
+        items.emplace_back(MakeSubmenu(id, label, FillList(level + 1)));
+        continue;
+      }
+      items.emplace_back(MakeLeaf(id, i));
+    }
+    return items;
+  }
+
+  flutter::EncodableMap MakeLeaf(int32_t id, int32_t position) {
+    if (position % 11 == 10) return MakeItem(id, "separator", "");
+    const char* type = position % 7 == 3   ? "checkbox"
+                       : position % 7 == 5 ? "radio"
+                                           : "normal";
+    flutter::EncodableMap item = MakeItem(id, type, Label(id));
+    if (position % 7 == 5) {
+      item[flutter::EncodableValue("radioGroup")] =
+          flutter::EncodableValue("group" + std::to_string(id / 20));
+    }
+    if (position % 4 == 0) {
+      item[flutter::EncodableValue("toolTip")] =
+          flutter::EncodableValue(Label(id + 1));
+    }
+    if (position % 5 == 1) {
+      item[flutter::EncodableValue("acceleratorText")] =
+          flutter::EncodableValue("Ctrl+" + std::to_string(position % 10));
+    }
+    if (position % 6 == 2) {
+      item[flutter::EncodableValue("icon")] = flutter::EncodableValue("0xE8E5");
+    }
+    return item;
+  }
+
+  // "<id> " followed by script characters up to spec_.label_length code
+  // points, so labels are distinct.
+  std::string Label(int32_t id) {
+    std::string label = std::to_string(id);
+    label += ' ';
+    for (size_t n = label.size(); n < spec_.label_length; ++n) {
+      AppendUtf8(label, NextCodePoint());
+    }
+    return label;
+  }
+
+  char32_t NextCodePoint() {
+    static constexpr char32_t kLatin[] = {0xE4, 0xE9, 0xF6, 0xFC, 0xDF, 0xE7};
+    std::uniform_int_distribution<uint32_t> pick(0, 0xFFFF);
+    const uint32_t r = pick(rng_);
+    auto ascii = [r] { return static_cast<char32_t>('a' + r % 26); };
+    switch (spec_.script) {
+      case LabelScript::kAscii:
+        return ascii();
+      case LabelScript::kLatin:
+        return r % 4 == 0 ? kLatin[(r >> 2) % 6] : ascii();
+      case LabelScript::kCjk:
+        return 0x4E00 + r % 0x5000;
+      case LabelScript::kMixed:
+        switch (r % 8) {
+          case 0:
+            return kLatin[(r >> 3) % 6];
+          case 1:
+          case 2:
+            return 0x4E00 + (r >> 3) % 0x5000;
+          case 3:
+            return 0x1F600 + (r >> 3) % 0x40;
+          default:
+            return ascii();
+        }
+    }
+    return ascii();
+  }
+
+  const SyntheticMenuSpec& spec_;
+  std::mt19937 rng_;
+  int32_t remaining_ = 0;
+  int32_t next_id_ = 1;
+};
+
+}  // namespace
+
+flutter::EncodableMap GenerateSyntheticMenu(const SyntheticMenuSpec& spec) {
+  return Generator(spec).Generate();
+}
+
+std::string DescribeSyntheticMenu(const SyntheticMenuSpec& spec) {
+  static constexpr const char* kScripts[] = {"ascii", "latin", "cjk", "mixed"};
+  return "d" + std::to_string(spec.depth) + "w" + std::to_string(spec.width) +
+         "/l" + std::to_string(spec.label_length) + "/" +
+         kScripts[static_cast<size_t>(spec.script)];
+}
+
+}  // namespace testing
+}  // namespace tray_manager_winui
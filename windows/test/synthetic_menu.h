@@ -0,0 +1,51 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_SYNTHETIC_MENU_H_
+#define TRAY_MANAGER_WINUI_TEST_SYNTHETIC_MENU_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tray_manager_winui {
+namespace testing {
+
+// Characters labels are drawn from.
+enum class LabelScript : uint8_t {
+  kAscii,
+  // ASCII with Latin-1 accents (2-byte UTF-8).
+  kLatin,
+  // CJK ideographs (3-byte UTF-8).
+  kCjk,
+  // ASCII, accents, CJK and emoji (4-byte UTF-8, surrogate pairs in UTF-16).
+  kMixed,
+};
+
+// Shape of a generated menu.
+struct SyntheticMenuSpec {
+  // Items in total, submenus and separators included.
+  int32_t item_count = 100;
+  // Submenu levels below the root; 0 gives a flat menu.
+  int32_t depth = 1;
+  // Items per submenu. The root takes whatever is left.
+  int32_t width = 25;
+  // Label length in code points.
+  size_t label_length = 16;
+  LabelScript script = LabelScript::kAscii;
+  // Seeds the label characters and item kinds.
+  uint32_t seed = 1;
+};
+
+// Generates a menu in the MenuItem.toJson() format: normal items with
+// occasional separators, checkboxes, radio groups, tooltips, accelerator
+// text and icons, with submenus nested to spec.depth. Ids run from 1 in
+// depth-first order; the same spec always yields the same menu.
+flutter::EncodableMap GenerateSyntheticMenu(const SyntheticMenuSpec& spec);
+
+// Short description of spec for benchmark names, e.g. "d2w10/l16/cjk".
+std::string DescribeSyntheticMenu(const SyntheticMenuSpec& spec);
+
+}  // namespace testing
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_SYNTHETIC_MENU_H_
@@ -0,0 +1,71 @@
+#include "synthetic_menu.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+
+#include "menu_model.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using testing::GenerateSyntheticMenu;
+using testing::LabelScript;
+using testing::SyntheticMenuSpec;
+
+int32_t Depth(const CompiledMenu& menu, uint32_t first, uint32_t count) {
+  int32_t depth = 0;
+  for (uint32_t i = first; i < first + count; ++i) {
+    const MenuNode& node = menu.node(i);
+    if (node.child_count > 0) {
+      depth = std::max(depth,
+                       1 + Depth(menu, node.first_child, node.child_count));
+    }
+  }
+  return depth;
+}
+
+TEST(SyntheticMenuTest, HasTheRequestedSizeAndDepth) {
+  for (int32_t depth : {0, 1, 3}) {
+    SyntheticMenuSpec spec;
+    spec.item_count = 500;
+    spec.depth = depth;
+    spec.width = 6;
+    const CompiledMenu menu = CompileMenu(GenerateSyntheticMenu(spec));
+    EXPECT_EQ(menu.nodes().size(), 500u) << depth;
+    EXPECT_EQ(Depth(menu, 0, menu.root_count()), depth);
+  }
+}
+
+TEST(SyntheticMenuTest, LabelsHaveTheRequestedLengthInCodePoints) {
+  for (LabelScript script : {LabelScript::kAscii, LabelScript::kLatin,
+                             LabelScript::kCjk, LabelScript::kMixed}) {
+    SyntheticMenuSpec spec;
+    spec.item_count = 50;
+    spec.label_length = 20;
+    spec.script = script;
+    const CompiledMenu menu = CompileMenu(GenerateSyntheticMenu(spec));
+    for (uint32_t i = 0; i < menu.nodes().size(); ++i) {
+      const MenuNode& node = menu.node(i);
+      if (node.type == MenuItemType::kSeparator) continue;
+      size_t code_points = 0;
+      for (unsigned char c : menu.str(node.label)) {
+        if ((c & 0xC0) != 0x80) ++code_points;
+      }
+      EXPECT_EQ(code_points, 20u) << menu.str(node.label);
+    }
+  }
+}
+
+TEST(SyntheticMenuTest, IsDeterministic) {
+  SyntheticMenuSpec spec;
+  spec.item_count = 200;
+  spec.script = LabelScript::kMixed;
+  EXPECT_EQ(GenerateSyntheticMenu(spec), GenerateSyntheticMenu(spec));
+  SyntheticMenuSpec reseeded = spec;
+  reseeded.seed = 2;
+  EXPECT_NE(GenerateSyntheticMenu(spec), GenerateSyntheticMenu(reseeded));
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
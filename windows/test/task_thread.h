@@ -0,0 +1,57 @@
+#ifndef TRAY_MANAGER_WINUI_TEST_TASK_THREAD_H_
+#define TRAY_MANAGER_WINUI_TEST_TASK_THREAD_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace tray_manager_winui {
+namespace testing {
+
+/// A stand-in for the XAML thread's DispatcherQueue: tasks run in order on
+/// one thread. The destructor runs what is queued, then joins.
+class TaskThread {
+ public:
+  TaskThread() : thread_([this] { Run(); }) {}
+  ~TaskThread() {
+    Post(nullptr);
+    thread_.join();
+  }
+
+  TaskThread(const TaskThread&) = delete;
+  TaskThread& operator=(const TaskThread&) = delete;
+
+  void Post(std::function<void()> task) {
+    std::lock_guard lock(mutex_);
+    tasks_.push_back(std::move(task));
+    cv_.notify_one();
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [this] { return !tasks_.empty(); });
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      if (!task) return;
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::thread thread_;
+};
+
+}  // namespace testing
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_TEST_TASK_THREAD_H_
@@ -0,0 +1,196 @@
+#include "utf16.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tray_manager_winui {
+namespace {
+
+// Reference converter written from the definitions rather than the
+// implementation: a sequence is well-formed if it decodes to a scalar value
+// in its shortest form; each maximal prefix of a well-formed sequence that
+// cannot be completed becomes one U+FFFD.
+bool DecodeWellFormed(const std::string& bytes, uint32_t* code_point) {
+  const auto lead = static_cast<uint8_t>(bytes[0]);
+  size_t length;
+  uint32_t value;
+  if (lead < 0x80) {
+    length = 1;
+    value = lead;
+  } else if ((lead & 0xE0) == 0xC0) {
+    length = 2;
+    value = lead & 0x1F;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+    value = lead & 0x0F;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 4;
+    value = lead & 0x07;
+  } else {
+    return false;
+  }
+  if (bytes.size() != length) return false;
+  for (size_t i = 1; i < length; ++i) {
+    const auto byte = static_cast<uint8_t>(bytes[i]);
+    if ((byte & 0xC0) != 0x80) return false;
+    value = (value << 6) | (byte & 0x3F);
+  }
+  static constexpr uint32_t kMinimum[] = {0, 0, 0x80, 0x800, 0x10000};
+  if (value < kMinimum[length] || value > 0x10FFFF ||
+      (value >= 0xD800 && value <= 0xDFFF)) {
+    return false;
+  }
+  *code_point = value;
+  return true;
+}
+
+bool IsPrefixOfWellFormed(const std::string& prefix) {
+  uint32_t ignored;
+  if (DecodeWellFormed(prefix, &ignored)) return true;
+  if (prefix.size() >= 4) return false;
+  for (int byte = 0x80; byte <= 0xBF; ++byte) {
+    if (IsPrefixOfWellFormed(prefix + static_cast<char>(byte))) return true;
+  }
+  return false;
+}
+
+std::u16string ReferenceUtf8ToUtf16(const std::string& utf8) {
+  std::u16string out;
+  size_t i = 0;
+  while (i < utf8.size()) {
+    bool decoded = false;
+    for (size_t length = 1; length <= 4 && i + length <= utf8.size();
+         ++length) {
+      uint32_t value;
+      if (DecodeWellFormed(utf8.substr(i, length), &value)) {
+        if (value >= 0x10000) {
+          out.push_back(static_cast<char16_t>(0xD800 + ((value - 0x10000) >> 10)));
+          out.push_back(static_cast<char16_t>(0xDC00 + (value & 0x3FF)));
+        } else {
+          out.push_back(static_cast<char16_t>(value));
+        }
+        i += length;
+        decoded = true;
+        break;
+      }
+    }
+    if (decoded) continue;
+    size_t subpart = 1;
+    while (subpart < 3 && i + subpart < utf8.size() &&
+           IsPrefixOfWellFormed(utf8.substr(i, subpart + 1))) {
+      ++subpart;
+    }
+    out.push_back(kReplacementCharacter);
+    i += subpart;
+  }
+  return out;
+}
+
+std::u16string Scalar(const std::string& utf8) {
+  std::u16string out(utf8.size(), 0);
+  out.resize(Utf8ToUtf16Scalar(utf8, out.data()));
+  return out;
+}
+
+void ExpectMatchesReference(const std::string& utf8) {
+  const std::u16string expected = ReferenceUtf8ToUtf16(utf8);
+  EXPECT_EQ(Utf8ToUtf16(utf8), expected) << ::testing::PrintToString(utf8);
+  EXPECT_EQ(Scalar(utf8), expected) << ::testing::PrintToString(utf8);
+}
+
+TEST(Utf16Test, ConvertsWellFormedText) {
+  EXPECT_EQ(Utf8ToUtf16(""), u"");
+  EXPECT_EQ(Utf8ToUtf16("Open"), u"Open");
+  EXPECT_EQ(Utf8ToUtf16("Caf\xC3\xA9"), u"Caf\u00E9");
+  EXPECT_EQ(Utf8ToUtf16("\xE6\x89\x93\xE5\xBC\x80"), u"\u6253\u5F00");
+  EXPECT_EQ(Utf8ToUtf16("\xF0\x9F\x8D\xB5"), u"\U0001F375");
+  EXPECT_EQ(Utf8ToUtf16("\xF4\x8F\xBF\xBF"), u"\U0010FFFF");
+  EXPECT_EQ(Utf8ToUtf16(std::string("a\0b", 3)), std::u16string(u"a\0b", 3));
+}
+
+TEST(Utf16Test, ReplacesMaximalIllFormedSubparts) {
+  // Examples from "U+FFFD Substitution of Maximal Subparts" in the Unicode
+  // standard, chapter 3.
+  EXPECT_EQ(Utf8ToUtf16("a\x80" "b"), u"a\uFFFDb");
+  EXPECT_EQ(Utf8ToUtf16("\xC0\xAF"), u"\uFFFD\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16("\xE0\x80\xAF"), u"\uFFFD\uFFFD\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16("\xED\xA0\x80"), u"\uFFFD\uFFFD\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16("\xF4\x90\x80\x80"), u"\uFFFD\uFFFD\uFFFD\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16("\xE1\x80" "a"), u"\uFFFDa");
+  EXPECT_EQ(Utf8ToUtf16("\xF1\x80\x80"), u"\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16("\xF5\xFF"), u"\uFFFD\uFFFD");
+  EXPECT_EQ(Utf8ToUtf16("\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64"),
+            u"a\uFFFD\uFFFD\uFFFDb\uFFFDc\uFFFD\uFFFDd");
+}
+
+TEST(Utf16Test, MatchesReferenceOnAllShortSequences) {
+  for (int a = 0; a < 256; ++a) {
+    ExpectMatchesReference(std::string(1, static_cast<char>(a)));
+    for (int b = 0; b < 256; ++b) {
+      ExpectMatchesReference(
+          {static_cast<char>(a), static_cast<char>(b)});
+    }
+  }
+  // Three-byte sequences with a lead byte of interest and every second byte.
+  for (int lead : {0xC2, 0xDF, 0xE0, 0xE1, 0xED, 0xEE, 0xF0, 0xF1, 0xF4,
+                   0xF5}) {
+    for (int b = 0x70; b < 0xD0; ++b) {
+      for (int c : {0x41, 0x7F, 0x80, 0x9F, 0xA0, 0xBF, 0xC0}) {
+        ExpectMatchesReference({static_cast<char>(lead), static_cast<char>(b),
+                                static_cast<char>(c)});
+        ExpectMatchesReference({static_cast<char>(lead), static_cast<char>(b),
+                                static_cast<char>(c), static_cast<char>(0x80)});
+      }
+    }
+  }
+}
+
+// Random text that mixes long ASCII runs (the vector path) with multi-byte
+// and broken sequences at every offset of a 16-byte block.
+TEST(Utf16Test, MatchesReferenceOnRandomText) {
+  const std::vector<std::string> pieces = {
+      "Recent file ", "a", "0123456789abcdef", "Caf\xC3\xA9", "\xE6\x89\x93",
+      "\xF0\x9F\x8D\xB5", "\x80", "\xC3", "\xE6\x89", "\xF0\x9F\x8D",
+      "\xED\xA0\x80", "\xFF", "\xC0\x80"};
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<size_t> pick(0, pieces.size() - 1);
+  std::uniform_int_distribution<int> count(0, 12);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (int round = 0; round < 3000; ++round) {
+    std::string text;
+    for (int i = count(rng); i > 0; --i) text += pieces[pick(rng)];
+    if (round % 3 == 0) {
+      for (int i = count(rng); i > 0; --i) {
+        text += static_cast<char>(byte(rng));
+      }
+    }
+    ExpectMatchesReference(text);
+  }
+}
+
+TEST(Utf16Test, VectorPathHandlesEveryAlignment) {
+  for (size_t prefix = 0; prefix < 40; ++prefix) {
+    std::string text(prefix, 'x');
+    text += "\xC3\xA9";
+    text += std::string(33, 'y');
+    ExpectMatchesReference(text);
+    // The output buffer is exactly utf8.size() units, as callers size it.
+    std::u16string out(text.size(), u'#');
+    EXPECT_EQ(Utf8ToUtf16(text, out.data()), text.size() - 1);
+  }
+}
+
+TEST(Utf16Test, AppendsToExistingText) {
+  std::u16string out = u"A";
+  AppendUtf8AsUtf16("\xC3\xA9", out);
+  AppendUtf8AsUtf16("", out);
+  AppendUtf8AsUtf16("\xF0\x9F\x8D\xB5", out);
+  EXPECT_EQ(out, u"A\u00E9\U0001F375");
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,303 @@
+#include "xaml_thread_gate.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "task_thread.h"
+
+namespace tray_manager_winui {
+namespace {
+
+using namespace std::chrono_literals;
+using testing::TaskThread;
+
+constexpr auto kTimeout = 10s;
+
+// Fake bootstrap plus fake DispatcherQueue. Initialize blocks until the test
+// releases it, like a slow Windows App SDK bootstrap.
+class FakePlatform : public XamlThreadPlatform {
+ public:
+  bool Initialize() override {
+    std::unique_lock lock(mutex_);
+    ++initializations_;
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return result_.has_value(); });
+    const bool ok = *result_;
+    if (!sticky_) result_.reset();
+    if (ok) xaml_ = std::make_unique<TaskThread>();
+    return ok;
+  }
+
+  bool Post(std::function<void()> task) override {
+    std::lock_guard lock(mutex_);
+    if (refuse_posts_ || !xaml_) return false;
+    xaml_->Post(std::move(task));
+    return true;
+  }
+
+  // Lets a pending (or the next) Initialize return ok. With sticky, every
+  // later one too.
+  void Release(bool ok, bool sticky = false) {
+    std::lock_guard lock(mutex_);
+    result_ = ok;
+    sticky_ = sticky;
+    cv_.notify_all();
+  }
+
+  bool WaitForInitializations(int count) {
+    std::unique_lock lock(mutex_);
+    return cv_.wait_for(lock, kTimeout,
+                        [&] { return initializations_ >= count; });
+  }
+
+  void RefusePosts() {
+    std::lock_guard lock(mutex_);
+    refuse_posts_ = true;
+  }
+
+  // Runs everything posted so far and stops the fake XAML thread. Only after
+  // the gate's initialization has finished (WaitForInit), which may still be
+  // posting.
+  void Shutdown() {
+    std::unique_ptr<TaskThread> xaml;
+    {
+      std::lock_guard lock(mutex_);
+      xaml = std::move(xaml_);
+    }
+  }
+
+  int initializations() {
+    std::lock_guard lock(mutex_);
+    return initializations_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::optional<bool> result_;
+  bool sticky_ = false;
+  bool refuse_posts_ = false;
+  int initializations_ = 0;
+  std::unique_ptr<TaskThread> xaml_;
+};
+
+// Records what ran (positive) and what failed (negative), in order.
+class Log {
+ public:
+  std::function<void()> Ran(int id) {
+    return [this, id] { Add(id); };
+  }
+  std::function<void()> Failed(int id) {
+    return [this, id] { Add(-id); };
+  }
+
+  bool WaitForSize(size_t size) {
+    std::unique_lock lock(mutex_);
+    return cv_.wait_for(lock, kTimeout,
+                        [&] { return entries_.size() >= size; });
+  }
+
+  std::vector<int> entries() {
+    std::lock_guard lock(mutex_);
+    return entries_;
+  }
+
+ private:
+  void Add(int entry) {
+    std::lock_guard lock(mutex_);
+    entries_.push_back(entry);
+    cv_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<int> entries_;
+};
+
+TEST(XamlThreadGateTest, IntentsQueuedDuringInitRunInOrderOnceReady) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  Log log;
+  EXPECT_EQ(gate.state(), XamlThreadState::kNotStarted);
+
+  for (int id = 1; id <= 3; ++id) gate.Run(log.Ran(id), log.Failed(id));
+  ASSERT_TRUE(platform.WaitForInitializations(1));
+  EXPECT_EQ(gate.state(), XamlThreadState::kInitializing);
+  EXPECT_TRUE(log.entries().empty());
+
+  platform.Release(true);
+  ASSERT_TRUE(gate.WaitForInit(kTimeout));
+  gate.Run(log.Ran(4), log.Failed(4));
+  ASSERT_TRUE(log.WaitForSize(4));
+  EXPECT_EQ(log.entries(), (std::vector<int>{1, 2, 3, 4}));
+  EXPECT_EQ(platform.initializations(), 1);
+  platform.Shutdown();
+}
+
+TEST(XamlThreadGateTest, IntentQueuedWhileInitializingRunsExactlyOnce) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  Log log;
+  gate.Start();
+  ASSERT_TRUE(platform.WaitForInitializations(1));
+  // Not the Run that starts initialization: it only queues, and must not
+  // also try to post the intent it handed to the queue.
+  gate.Run(log.Ran(1), log.Failed(1));
+  EXPECT_TRUE(log.entries().empty());
+
+  platform.Release(true);
+  ASSERT_TRUE(gate.WaitForInit(kTimeout));
+  ASSERT_TRUE(log.WaitForSize(1));
+  platform.Shutdown();
+  EXPECT_EQ(log.entries(), std::vector<int>{1});
+}
+
+TEST(XamlThreadGateTest, RunNeverWaitsForAStuckInitialization) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  Log log;
+  const auto start = std::chrono::steady_clock::now();
+  for (int id = 1; id <= 100; ++id) gate.Run(log.Ran(id), log.Failed(id));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_TRUE(platform.WaitForInitializations(1));
+  // Initialize is parked until Release; every Run above returned anyway.
+  EXPECT_LT(elapsed, 5s);
+  EXPECT_FALSE(gate.WaitForInit(10ms));
+  EXPECT_EQ(gate.state(), XamlThreadState::kInitializing);
+
+  platform.Release(true);
+  ASSERT_TRUE(log.WaitForSize(100));
+  EXPECT_TRUE(gate.WaitForInit(kTimeout));
+  platform.Shutdown();
+}
+
+TEST(XamlThreadGateTest, FailedInitFailsQueuedAndLaterIntents) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  Log log;
+  gate.Run(log.Ran(1), log.Failed(1));
+  gate.Run(log.Ran(2), log.Failed(2));
+  platform.Release(false);
+  EXPECT_FALSE(gate.WaitForInit(kTimeout));
+  EXPECT_EQ(gate.state(), XamlThreadState::kFailed);
+
+  // Fails on the calling thread, without retrying initialization.
+  gate.Run(log.Ran(3), log.Failed(3));
+  EXPECT_EQ(log.entries(), (std::vector<int>{-1, -2, -3}));
+  EXPECT_EQ(platform.initializations(), 1);
+}
+
+TEST(XamlThreadGateTest, RefusedPostFailsTheIntent) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  Log log;
+  gate.Start();
+  platform.Release(true);
+  ASSERT_TRUE(gate.WaitForInit(kTimeout));
+
+  platform.RefusePosts();
+  gate.Run(log.Ran(1), log.Failed(1));
+  EXPECT_EQ(log.entries(), (std::vector<int>{-1}));
+  EXPECT_EQ(gate.state(), XamlThreadState::kReady);
+  platform.Shutdown();
+}
+
+TEST(XamlThreadGateTest, StartInitializesOnceWithoutAnIntent) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  gate.Start();
+  gate.Start();
+  ASSERT_TRUE(platform.WaitForInitializations(1));
+  Log log;
+  gate.Run(log.Ran(1), log.Failed(1));  // Joins the running initialization.
+  platform.Release(true);
+  ASSERT_TRUE(log.WaitForSize(1));
+  EXPECT_EQ(log.entries(), (std::vector<int>{1}));
+  EXPECT_EQ(platform.initializations(), 1);
+  EXPECT_TRUE(gate.WaitForInit(kTimeout));
+  platform.Shutdown();
+}
+
+TEST(XamlThreadGateTest, ResetInitializesAgainOnTheNextRun) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  platform.Release(false);
+  gate.Start();
+  EXPECT_FALSE(gate.WaitForInit(kTimeout));
+
+  gate.Reset();
+  EXPECT_EQ(gate.state(), XamlThreadState::kNotStarted);
+  Log log;
+  platform.Release(true);
+  gate.Run(log.Ran(1), log.Failed(1));
+  ASSERT_TRUE(log.WaitForSize(1));
+  EXPECT_EQ(log.entries(), (std::vector<int>{1}));
+  EXPECT_EQ(platform.initializations(), 2);
+  EXPECT_TRUE(gate.WaitForInit(kTimeout));
+  platform.Shutdown();
+}
+
+TEST(XamlThreadGateTest, ResetIsIgnoredWhileInitializing) {
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  gate.Start();
+  ASSERT_TRUE(platform.WaitForInitializations(1));
+  gate.Reset();
+  EXPECT_EQ(gate.state(), XamlThreadState::kInitializing);
+  platform.Release(true);
+  EXPECT_TRUE(gate.WaitForInit(kTimeout));
+  platform.Shutdown();
+}
+
+// Producers keep running intents while initialization finishes and drains
+// the queue. Each producer's intents must run in the order it ran them,
+// across the switch from queuing to posting directly. Run under
+// -DTRAY_MANAGER_WINUI_SANITIZER=thread.
+TEST(XamlThreadGateTest, PerProducerOrderSurvivesTheSwitchToReady) {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 2000;
+  FakePlatform platform;
+  XamlThreadGate gate(platform);
+  std::vector<int> last(kProducers, -1);  // XAML thread only.
+  std::atomic<int> out_of_order{0};
+  std::atomic<int> ran{0};
+  std::atomic<int> failed{0};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        gate.Run(
+            [&, p, i] {
+              if (last[p] + 1 != i) ++out_of_order;
+              last[p] = i;
+              ++ran;
+            },
+            [&] { ++failed; });
+        if (i % 128 == 0) std::this_thread::yield();
+      }
+    });
+  }
+  ASSERT_TRUE(platform.WaitForInitializations(1));
+  platform.Release(true);
+  for (std::thread& producer : producers) producer.join();
+  // The initialization thread may still be posting what was queued.
+  ASSERT_TRUE(gate.WaitForInit(kTimeout));
+  platform.Shutdown();  // Runs everything posted.
+
+  EXPECT_EQ(failed.load(), 0);
+  EXPECT_EQ(ran.load(), kProducers * kPerProducer);
+  EXPECT_EQ(out_of_order.load(), 0);
+  EXPECT_EQ(platform.initializations(), 1);
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
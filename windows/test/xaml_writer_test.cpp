@@ -0,0 +1,742 @@
+#include "xaml_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <cwchar>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "menu_fixtures.h"
+#include "style_values.h"
+
+namespace tray_manager_winui {
+namespace {
+
+// The stream-based generator as it was before the single-pass writer, kept
+// verbatim (minus XamlReader) so the new output can be compared byte for byte.
+namespace legacy {
+
+int64_t GetStyleInt(const flutter::EncodableMap& style, const char* key) {
+  auto it = style.find(flutter::EncodableValue(key));
+  if (it == style.end()) return 0;
+  const auto* i32 = std::get_if<int32_t>(&it->second);
+  const auto* i64 = std::get_if<int64_t>(&it->second);
+  if (i32) return *i32;
+  if (i64) return *i64;
+  return 0;
+}
+
+double GetStyleDouble(const flutter::EncodableMap& style, const char* key) {
+  auto it = style.find(flutter::EncodableValue(key));
+  if (it == style.end()) return 0;
+  const auto* d = std::get_if<double>(&it->second);
+  return d ? *d : 0;
+}
+
+std::string GetStyleString(const flutter::EncodableMap& style, const char* key) {
+  auto it = style.find(flutter::EncodableValue(key));
+  if (it == style.end()) return "";
+  const auto* s = std::get_if<std::string>(&it->second);
+  return s ? *s : "";
+}
+
+std::wstring ToXamlColor(int64_t value) {
+  wchar_t buf[16];
+  std::swprintf(buf, 16, L"#%02X%02X%02X%02X",
+                static_cast<unsigned>((value >> 24) & 0xFF),
+                static_cast<unsigned>((value >> 16) & 0xFF),
+                static_cast<unsigned>((value >> 8) & 0xFF),
+                static_cast<unsigned>(value & 0xFF));
+  return buf;
+}
+
+std::wstring EscapeAttribute(const std::wstring& input) {
+  std::wstring result;
+  for (wchar_t c : input) {
+    switch (c) {
+      case L'&': result += L"&amp;"; break;
+      case L'<': result += L"&lt;"; break;
+      case L'>': result += L"&gt;"; break;
+      case L'"': result += L"&quot;"; break;
+      case L'\'': result += L"&apos;"; break;
+      default: result += c; break;
+    }
+  }
+  return result;
+}
+
+// Test inputs are ASCII.
+std::wstring Utf8ToWide(std::string_view utf8) {
+  return std::wstring(utf8.begin(), utf8.end());
+}
+
+std::wstring PresenterStyle(const flutter::EncodableMap& style) {
+  if (style.empty()) return std::wstring();
+
+  std::wstringstream xaml;
+  xaml << L"<Style TargetType='MenuFlyoutPresenter' "
+       << L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation'>";
+
+  int64_t hoverBg = GetStyleInt(style, "hoverBackgroundColor");
+  int64_t sepColor = GetStyleInt(style, "separatorColor");
+  int64_t disabledFg = GetStyleInt(style, "disabledTextColor");
+  int64_t subMenuOpenedBg = GetStyleInt(style, "subMenuOpenedBackgroundColor");
+  int64_t subMenuOpenedFg = GetStyleInt(style, "subMenuOpenedTextColor");
+  int64_t checkedFg = GetStyleInt(style, "checkedForegroundColor");
+  int64_t checkedBg = GetStyleInt(style, "checkedBackgroundColor");
+  int64_t accelColor = GetStyleInt(style, "keyboardAcceleratorColor");
+  bool needSubMenuOpenedFix = (subMenuOpenedBg == 0 && subMenuOpenedFg == 0);
+  if (hoverBg != 0 || sepColor != 0 || disabledFg != 0 ||
+      subMenuOpenedBg != 0 || subMenuOpenedFg != 0 || needSubMenuOpenedFix ||
+      checkedFg != 0 || checkedBg != 0 || accelColor != 0) {
+    std::wstringstream themeContent;
+    if (hoverBg != 0) {
+      std::wstring hoverStr = ToXamlColor(hoverBg);
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutItemBackgroundPointerOver' Color='"
+                   << hoverStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundPointerOver' Color='"
+                   << hoverStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundPointerOver' Color='"
+                   << hoverStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutItemRevealBackgroundPointerOver' Color='"
+                   << hoverStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemRevealBackgroundPointerOver' Color='"
+                   << hoverStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundPointerOver' Color='"
+                   << hoverStr << L"'/>";
+    }
+    if (sepColor != 0) {
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSeparatorBackground' Color='"
+                   << ToXamlColor(sepColor) << L"'/>";
+    }
+    if (disabledFg != 0) {
+      std::wstring disabledStr = ToXamlColor(disabledFg);
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutItemForegroundDisabled' Color='"
+                   << disabledStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemForegroundDisabled' Color='"
+                   << disabledStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemChevronDisabled' Color='"
+                   << disabledStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundDisabled' Color='"
+                   << disabledStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemCheckGlyphForegroundDisabled' Color='"
+                   << disabledStr << L"'/>";
+    }
+    if (subMenuOpenedBg != 0) {
+      std::wstring subMenuBgStr = ToXamlColor(subMenuOpenedBg);
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='"
+                   << subMenuBgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='"
+                   << subMenuBgStr << L"'/>";
+    }
+    if (subMenuOpenedFg != 0) {
+      std::wstring subMenuFgStr = ToXamlColor(subMenuOpenedFg);
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSubItemForegroundSubMenuOpened' Color='"
+                   << subMenuFgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemChevronSubMenuOpened' Color='"
+                   << subMenuFgStr << L"'/>";
+    }
+    if (checkedBg != 0) {
+      std::wstring checkedBgStr = ToXamlColor(checkedBg);
+      themeContent << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundChecked' Color='"
+                   << checkedBgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundCheckedPointerOver' Color='"
+                   << checkedBgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundCheckedPressed' Color='"
+                   << checkedBgStr << L"'/>";
+    }
+    if (checkedFg != 0) {
+      std::wstring checkedFgStr = ToXamlColor(checkedFg);
+      themeContent << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundChecked' Color='"
+                   << checkedFgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundCheckedPointerOver' Color='"
+                   << checkedFgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundCheckedPressed' Color='"
+                   << checkedFgStr << L"'/>"
+                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemCheckGlyphForegroundChecked' Color='"
+                   << checkedFgStr << L"'/>";
+    }
+    if (accelColor != 0) {
+      std::wstring accelStr = ToXamlColor(accelColor);
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutItemKeyboardAcceleratorTextForeground' Color='"
+                   << accelStr << L"'/>";
+    }
+    if (needSubMenuOpenedFix) {
+      std::wstring subMenuBgVal =
+          (hoverBg != 0) ? ToXamlColor(hoverBg) : std::wstring(L"#FF404040");
+      int64_t textColor = GetStyleInt(style, "textColor");
+      std::wstring subMenuFgVal =
+          (textColor != 0) ? ToXamlColor(textColor) : std::wstring(L"#FFFFFFFF");
+      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='"
+                   << subMenuBgVal << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='"
+                   << subMenuBgVal << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemForegroundSubMenuOpened' Color='"
+                   << subMenuFgVal << L"'/>"
+                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemChevronSubMenuOpened' Color='"
+                   << subMenuFgVal << L"'/>";
+    }
+    std::wstring content = themeContent.str();
+    std::wstringstream resDict;
+    resDict << L"<ResourceDictionary "
+            << L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+            << L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+            << L"<ResourceDictionary.ThemeDictionaries>"
+            << L"<ResourceDictionary x:Key='Default'>" << content << L"</ResourceDictionary>"
+            << L"<ResourceDictionary x:Key='Light'>" << content << L"</ResourceDictionary>"
+            << L"<ResourceDictionary x:Key='Dark'>" << content << L"</ResourceDictionary>"
+            << L"</ResourceDictionary.ThemeDictionaries>"
+            << L"</ResourceDictionary>";
+    xaml << L"<Setter Property='Resources'><Setter.Value>" << resDict.str()
+         << L"</Setter.Value></Setter>";
+  }
+
+  int64_t bg = GetStyleInt(style, "backgroundColor");
+  if (bg != 0) {
+    xaml << L"<Setter Property='Background' "
+         << L"Value='" << ToXamlColor(bg) << L"'/>";
+  }
+
+  int64_t fg = GetStyleInt(style, "textColor");
+  if (fg != 0) {
+    xaml << L"<Setter Property='Foreground' "
+         << L"Value='" << ToXamlColor(fg) << L"'/>";
+  }
+
+  double fontSize = GetStyleDouble(style, "fontSize");
+  if (fontSize > 0) {
+    xaml << L"<Setter Property='FontSize' Value='" << fontSize << L"'/>";
+  }
+
+  std::string fontFamily = GetStyleString(style, "fontFamily");
+  if (!fontFamily.empty()) {
+    std::wstring wfont = EscapeAttribute(Utf8ToWide(fontFamily));
+    xaml << L"<Setter Property='FontFamily' Value='" << wfont << L"'/>";
+  }
+
+  int64_t fontWeight = GetStyleInt(style, "fontWeight");
+  if (fontWeight > 0) {
+    xaml << L"<Setter Property='FontWeight' Value='" << fontWeight << L"'/>";
+  }
+
+  auto cr_it = style.find(flutter::EncodableValue("cornerRadius"));
+  if (cr_it != style.end()) {
+    double cornerRadius = GetStyleDouble(style, "cornerRadius");
+    xaml << L"<Setter Property='CornerRadius' Value='" << cornerRadius << L"'/>";
+  }
+
+  auto pad_it = style.find(flutter::EncodableValue("padding"));
+  if (pad_it != style.end()) {
+    const auto* pad_map = std::get_if<flutter::EncodableMap>(&pad_it->second);
+    if (pad_map) {
+      auto get_d = [&](const char* k) {
+        auto vit = pad_map->find(flutter::EncodableValue(k));
+        if (vit == pad_map->end()) return 0.0;
+        const auto* vd = std::get_if<double>(&vit->second);
+        if (vd) return *vd;
+        const auto* vi = std::get_if<int32_t>(&vit->second);
+        if (vi) return static_cast<double>(*vi);
+        return 0.0;
+      };
+      double left = get_d("left"), top = get_d("top"),
+             right = get_d("right"), bottom = get_d("bottom");
+      xaml << L"<Setter Property='Padding' Value='"
+           << left << L"," << top << L"," << right << L"," << bottom << L"'/>";
+    }
+  }
+
+  double minWidth = GetStyleDouble(style, "minWidth");
+  if (minWidth > 0) {
+    xaml << L"<Setter Property='MinWidth' Value='" << minWidth << L"'/>";
+  }
+
+  std::string themeMode = GetStyleString(style, "themeMode");
+  if (themeMode == "light") {
+    xaml << L"<Setter Property='RequestedTheme' Value='Light'/>";
+  } else if (themeMode == "dark") {
+    xaml << L"<Setter Property='RequestedTheme' Value='Dark'/>";
+  }
+
+  int64_t borderColor = GetStyleInt(style, "borderColor");
+  if (borderColor != 0) {
+    xaml << L"<Setter Property='BorderBrush' Value='"
+         << ToXamlColor(borderColor) << L"'/>";
+  }
+
+  double borderThickness = GetStyleDouble(style, "borderThickness");
+  if (borderThickness > 0) {
+    xaml << L"<Setter Property='BorderThickness' Value='"
+         << borderThickness << L"'/>";
+  }
+
+  std::string fontStyle = GetStyleString(style, "fontStyle");
+  if (fontStyle == "italic") {
+    xaml << L"<Setter Property='FontStyle' Value='Italic'/>";
+  } else if (fontStyle == "normal") {
+    xaml << L"<Setter Property='FontStyle' Value='Normal'/>";
+  }
+
+  auto shadowIt = style.find(flutter::EncodableValue("shadowElevation"));
+  if (shadowIt != style.end()) {
+    double shadowElevation = GetStyleDouble(style, "shadowElevation");
+    if (shadowElevation <= 0) {
+      xaml << L"<Setter Property='IsDefaultShadowEnabled' Value='False'/>";
+    }
+  }
+
+  double maxHeight = GetStyleDouble(style, "maxHeight");
+  if (maxHeight > 0) {
+    xaml << L"<Setter Property='MaxHeight' Value='" << maxHeight << L"'/>";
+  }
+
+  xaml << L"</Style>";
+  return xaml.str();
+}
+
+CompactItemStylesXaml CompactItemStyles(const flutter::EncodableMap* style_map) {
+  CompactItemStylesXaml result;
+  {
+    // MenuFlyoutItem: Match WinUI template structure. Root: Grid LayoutRoot with
+    // TemplateBinding Background. Inline-Hex for hoverBackgroundColor when set.
+    std::wstring mfiHoverValue =
+        L"{ThemeResource MenuFlyoutItemBackgroundPointerOver}";
+    if (style_map) {
+      int64_t h = GetStyleInt(*style_map, "hoverBackgroundColor");
+      if (h != 0) mfiHoverValue = ToXamlColor(h);
+    }
+    std::wstring mfiXaml = L"<Style TargetType='MenuFlyoutItem' "
+        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+        L"<Setter Property='Background' Value='Transparent'/>"
+        L"<Setter Property='Template'><Setter.Value>"
+        L"<ControlTemplate TargetType='MenuFlyoutItem'>"
+        L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
+        L"<TextBlock x:Name='Text' Text='{TemplateBinding Text}' "
+        L"VerticalAlignment='Center' Margin='10,0,10,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<VisualStateManager.VisualStateGroups>"
+        L"<VisualStateGroup x:Name='CommonStates'>"
+        L"<VisualState x:Name='Normal'/>"
+        L"<VisualState x:Name='PointerOver'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='";
+    mfiXaml += mfiHoverValue;
+    mfiXaml += L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Pressed'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='";
+    mfiXaml += mfiHoverValue;
+    mfiXaml += L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Disabled'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='Text.Foreground' Value='{ThemeResource MenuFlyoutItemForegroundDisabled}'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
+    result.menu_flyout_item = mfiXaml;
+
+    // ToggleMenuFlyoutItem: Two variants. If checkedIndicatorColor set: thin
+    // colored stripe left (4px). Else: checkmark on far right like SubItem Chevron.
+    int64_t stripeColor =
+        style_map ? GetStyleInt(*style_map, "checkedIndicatorColor") : 0;
+    bool useStripe = (stripeColor != 0);
+    std::wstring tmiHoverValue =
+        L"{ThemeResource ToggleMenuFlyoutItemBackgroundPointerOver}";
+    if (style_map) {
+      int64_t h = GetStyleInt(*style_map, "hoverBackgroundColor");
+      if (h != 0) tmiHoverValue = ToXamlColor(h);
+    }
+    std::wstring tmiXaml;
+    if (useStripe) {
+      std::wstring stripeColorStr = ToXamlColor(stripeColor);
+      tmiXaml = L"<Style TargetType='ToggleMenuFlyoutItem' "
+          L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+          L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+          L"<Setter Property='Background' Value='Transparent'/>"
+          L"<Setter Property='Padding' Value='0,0,0,0'/>"
+          L"<Setter Property='Template'><Setter.Value>"
+          L"<ControlTemplate TargetType='ToggleMenuFlyoutItem'>"
+          L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
+          L"<TextBlock x:Name='TextBlock' Text='{TemplateBinding Text}' "
+          L"VerticalAlignment='Center' Margin='10,0,10,0' "
+          L"Foreground='{TemplateBinding Foreground}'/>"
+          L"<Border x:Name='CheckStripe' Width='4' HorizontalAlignment='Left' "
+          L"VerticalAlignment='Stretch' Opacity='0' Background='";
+      tmiXaml += stripeColorStr;
+      tmiXaml += L"'/>"
+          L"<VisualStateManager.VisualStateGroups>"
+          L"<VisualStateGroup x:Name='CommonStates'>"
+          L"<VisualState x:Name='Normal'/>"
+          L"<VisualState x:Name='PointerOver'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='LayoutRoot.Background' Value='";
+      tmiXaml += tmiHoverValue;
+      tmiXaml += L"'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"<VisualState x:Name='Pressed'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='LayoutRoot.Background' Value='";
+      tmiXaml += tmiHoverValue;
+      tmiXaml += L"'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"<VisualState x:Name='Disabled'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemForegroundDisabled}'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"</VisualStateGroup>"
+          L"<VisualStateGroup x:Name='CheckStates'>"
+          L"<VisualState x:Name='Unchecked'/>"
+          L"<VisualState x:Name='Checked'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='CheckStripe.Opacity' Value='1'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+          L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
+    } else {
+      tmiXaml = L"<Style TargetType='ToggleMenuFlyoutItem' "
+          L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+          L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+          L"<Setter Property='Background' Value='Transparent'/>"
+          L"<Setter Property='Template'><Setter.Value>"
+          L"<ControlTemplate TargetType='ToggleMenuFlyoutItem'>"
+          L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
+          L"<Grid.ColumnDefinitions>"
+          L"<ColumnDefinition Width='*'/><ColumnDefinition Width='Auto'/>"
+          L"</Grid.ColumnDefinitions>"
+          L"<TextBlock x:Name='TextBlock' Grid.Column='0' Text='{TemplateBinding Text}' "
+          L"VerticalAlignment='Center' Margin='10,0,4,0' "
+          L"Foreground='{TemplateBinding Foreground}'/>"
+          L"<FontIcon x:Name='CheckGlyph' Grid.Column='1' Glyph='&#xE73E;' Opacity='0' "
+          L"FontSize='10' VerticalAlignment='Center' Margin='0,0,4,0' "
+          L"Foreground='{TemplateBinding Foreground}'/>"
+          L"<VisualStateManager.VisualStateGroups>"
+          L"<VisualStateGroup x:Name='CommonStates'>"
+          L"<VisualState x:Name='Normal'/>"
+          L"<VisualState x:Name='PointerOver'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='LayoutRoot.Background' Value='";
+      tmiXaml += tmiHoverValue;
+      tmiXaml += L"'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"<VisualState x:Name='Pressed'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='LayoutRoot.Background' Value='";
+      tmiXaml += tmiHoverValue;
+      tmiXaml += L"'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"<VisualState x:Name='Disabled'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemForegroundDisabled}'/>"
+          L"<Setter Target='CheckGlyph.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemCheckGlyphForegroundDisabled}'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"</VisualStateGroup>"
+          L"<VisualStateGroup x:Name='CheckStates'>"
+          L"<VisualState x:Name='Unchecked'/>"
+          L"<VisualState x:Name='Checked'>"
+          L"<VisualState.Setters>"
+          L"<Setter Target='CheckGlyph.Opacity' Value='1'/>"
+          L"</VisualState.Setters></VisualState>"
+          L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+          L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
+    }
+    result.toggle_menu_flyout_item = tmiXaml;
+
+    // NOTE: RadioMenuFlyoutItem compact style removed. Radio items are now
+    // rendered as ToggleMenuFlyoutItem (reusing toggleMenuFlyoutItemStyle)
+    // because RadioMenuFlyoutItem crashes in DesktopWindowXamlSource contexts.
+
+    // MenuFlyoutSubItem: Match WinUI default template structure for VisualState
+    // compatibility. Root: Grid LayoutRoot with TemplateBinding Background.
+    // SubMenuOpened must be in CommonStates (not SubMenuOpenedStates).
+    // Element names: TextBlock, SubItemChevron. Chevron glyph E974.
+    std::wstring hoverValue = L"{ThemeResource MenuFlyoutSubItemBackgroundPointerOver}";
+    std::wstring subMenuBgValue =
+        L"{ThemeResource MenuFlyoutSubItemBackgroundSubMenuOpened}";
+    std::wstring subMenuFgValue;
+    bool useSubMenuFg = false;
+    if (style_map) {
+      int64_t h = GetStyleInt(*style_map, "hoverBackgroundColor");
+      if (h != 0) hoverValue = ToXamlColor(h);
+      int64_t sb = GetStyleInt(*style_map, "subMenuOpenedBackgroundColor");
+      if (sb != 0) subMenuBgValue = ToXamlColor(sb);
+      int64_t sf = GetStyleInt(*style_map, "subMenuOpenedTextColor");
+      if (sf != 0) {
+        subMenuFgValue = ToXamlColor(sf);
+        useSubMenuFg = true;
+      }
+    }
+    std::wstring msiXaml = L"<Style TargetType='MenuFlyoutSubItem' "
+        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+        L"<Setter Property='Background' Value='Transparent'/>"
+        L"<Setter Property='Template'><Setter.Value>"
+        L"<ControlTemplate TargetType='MenuFlyoutSubItem'>"
+        L"<Grid x:Name='LayoutRoot' Padding='0,0,0,0' "
+        L"Background='{TemplateBinding Background}'>"
+        L"<Grid.ColumnDefinitions>"
+        L"<ColumnDefinition Width='*'/><ColumnDefinition Width='Auto'/>"
+        L"</Grid.ColumnDefinitions>"
+        L"<TextBlock x:Name='TextBlock' Grid.Column='0' Text='{TemplateBinding Text}' "
+        L"VerticalAlignment='Center' Margin='10,0,4,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<FontIcon x:Name='SubItemChevron' Grid.Column='1' Glyph='&#xE974;' FontSize='12' "
+        L"VerticalAlignment='Center' Margin='0,0,4,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<VisualStateManager.VisualStateGroups>"
+        L"<VisualStateGroup x:Name='CommonStates'>"
+        L"<VisualState x:Name='Normal'/>"
+        L"<VisualState x:Name='PointerOver'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='";
+    msiXaml += hoverValue;
+    msiXaml += L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Pressed'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='";
+    msiXaml += hoverValue;
+    msiXaml += L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='SubMenuOpened'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='";
+    msiXaml += subMenuBgValue;
+    msiXaml += L"'/>";
+    if (useSubMenuFg) {
+      msiXaml += L"<Setter Target='TextBlock.Foreground' Value='";
+      msiXaml += subMenuFgValue;
+      msiXaml += L"'/>"
+          L"<Setter Target='SubItemChevron.Foreground' Value='";
+      msiXaml += subMenuFgValue;
+      msiXaml += L"'/>";
+    }
+    msiXaml += L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Disabled'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource MenuFlyoutSubItemForegroundDisabled}'/>"
+        L"<Setter Target='SubItemChevron.Foreground' Value='{ThemeResource MenuFlyoutSubItemChevronDisabled}'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
+    result.menu_flyout_sub_item = msiXaml;
+  }
+  return result;
+}
+
+}  // namespace legacy
+
+using testing::MakeStyle;
+
+std::wstring AsciiToWide(std::string_view utf8) {
+  return std::wstring(utf8.begin(), utf8.end());
+}
+
+flutter::EncodableMap MakePadding() {
+  return MakeStyle({{"left", flutter::EncodableValue(4.5)},
+                    {"top", flutter::EncodableValue(int32_t{2})},
+                    {"right", flutter::EncodableValue(0.1)},
+                    {"bottom", flutter::EncodableValue(1e7)}});
+}
+
+// Styles covering every branch of the presenter and compact generators.
+std::vector<flutter::EncodableMap> StyleMatrix() {
+  std::vector<flutter::EncodableMap> styles;
+  styles.push_back(MakeStyle({{"textColor", flutter::EncodableValue(1)}}));
+  styles.push_back(MakeStyle(
+      {{"backgroundColor", flutter::EncodableValue(int64_t{0xFF202020})},
+       {"textColor", flutter::EncodableValue(int64_t{0xFFF0F0F0})},
+       {"hoverBackgroundColor", flutter::EncodableValue(int64_t{0xFF404040})},
+       {"separatorColor", flutter::EncodableValue(int64_t{0x33FFFFFF})},
+       {"disabledTextColor", flutter::EncodableValue(int32_t{0x7F808080})},
+       {"checkedForegroundColor", flutter::EncodableValue(int64_t{0xFF00FF00})},
+       {"checkedBackgroundColor", flutter::EncodableValue(int64_t{0xFF003300})},
+       {"keyboardAcceleratorColor", flutter::EncodableValue(int64_t{0xFFAAAAAA})},
+       {"checkedIndicatorColor", flutter::EncodableValue(int64_t{0xFF0078D4})},
+       {"fontSize", flutter::EncodableValue(13.5)},
+       {"fontFamily", flutter::EncodableValue("Segoe <UI> & 'Co'")},
+       {"fontWeight", flutter::EncodableValue(int32_t{600})},
+       {"cornerRadius", flutter::EncodableValue(0.0)},
+       {"padding", flutter::EncodableValue(MakePadding())},
+       {"minWidth", flutter::EncodableValue(200.0)},
+       {"themeMode", flutter::EncodableValue("dark")},
+       {"borderColor", flutter::EncodableValue(int64_t{0xFF101010})},
+       {"borderThickness", flutter::EncodableValue(1.25)},
+       {"fontStyle", flutter::EncodableValue("italic")},
+       {"shadowElevation", flutter::EncodableValue(0.0)},
+       {"maxHeight", flutter::EncodableValue(123456789.0)}}));
+  styles.push_back(MakeStyle(
+      {{"subMenuOpenedBackgroundColor",
+        flutter::EncodableValue(int64_t{0xFF112233})},
+       {"subMenuOpenedTextColor", flutter::EncodableValue(int64_t{0xFF445566})},
+       {"themeMode", flutter::EncodableValue("light")},
+       {"fontStyle", flutter::EncodableValue("normal")},
+       {"shadowElevation", flutter::EncodableValue(8.0)},
+       {"cornerRadius", flutter::EncodableValue(4.0)},
+       {"fontSize", flutter::EncodableValue(1.0 / 3.0)}}));
+  styles.push_back(MakeStyle(
+      {{"subMenuOpenedTextColor", flutter::EncodableValue(int64_t{0xFFABCDEF})},
+       {"hoverBackgroundColor", flutter::EncodableValue(int64_t{0x1FFFFFFFF})},
+       {"padding", flutter::EncodableValue("not a map")},
+       {"fontWeight", flutter::EncodableValue(int64_t{-1})},
+       {"minWidth", flutter::EncodableValue(-5.0)}}));
+  return styles;
+}
+
+TEST(XamlWriterTest, ColorFormatting) {
+  EXPECT_EQ(ColorToXamlString(int64_t{0xFF0078D4}), L"#FF0078D4");
+  EXPECT_EQ(ColorToXamlString(0), L"#00000000");
+  EXPECT_EQ(ColorToXamlString(static_cast<int32_t>(0x80ABCDEFu)), L"#80ABCDEF");
+  EXPECT_EQ(ColorToXamlString(int64_t{0x1FF102030}), L"#FF102030");
+}
+
+TEST(XamlWriterTest, EscapesAttributes) {
+  EXPECT_EQ(XamlEscapeAttribute(L"a&b<c>d\"e'f"),
+            L"a&amp;b&lt;c&gt;d&quot;e&apos;f");
+  EXPECT_EQ(XamlEscapeAttribute(L"Segoe UI"), L"Segoe UI");
+}
+
+TEST(XamlWriterTest, EscapeReturnsInputWhenNothingToEscape) {
+  const std::wstring input = L"Segoe UI Variable Display, 'fallback'"
+                             L"\x0126\x263C\x3E3E";
+  std::wstring buffer;
+  const std::wstring_view clean(input.data(), input.find(L','));
+  EXPECT_EQ(XamlEscapeAttribute(clean, buffer).data(), clean.data());
+  EXPECT_TRUE(buffer.empty());
+
+  const std::wstring_view escaped = XamlEscapeAttribute(input, buffer);
+  EXPECT_EQ(escaped.data(), buffer.data());
+  EXPECT_EQ(escaped, legacy::EscapeAttribute(input));
+  EXPECT_EQ(escaped.size(), buffer.size());
+}
+
+// Differential test against the original one-character-at-a-time escaper,
+// with every length around the vector width, varying densities of
+// characters to escape, and code units that only match in their low byte.
+TEST(XamlWriterTest, EscapeMatchesLegacyOnRandomText) {
+  const wchar_t alphabet[] = {
+      L'a', L'Z', L' ', L'&', L'<', L'>', L'"', L'\'', L'=', L';',
+      static_cast<wchar_t>(0x0126), static_cast<wchar_t>(0x2622),
+      static_cast<wchar_t>(0x3C00), static_cast<wchar_t>(0xFF1E),
+      static_cast<wchar_t>(0xE9)};
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> letter(0, std::size(alphabet) - 1);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::wstring buffer;
+  for (int round = 0; round < 5000; ++round) {
+    const size_t length = round % 70;
+    const int special_percent = round % 5 == 0 ? 0 : (round % 7) * 15;
+    std::wstring text;
+    for (size_t i = 0; i < length; ++i) {
+      wchar_t c = alphabet[letter(rng)];
+      if (c >= L'"' && c <= L'>' && c != L'=' && c != L';' &&
+          percent(rng) >= special_percent) {
+        c = L'x';
+      }
+      text += c;
+    }
+    const std::wstring expected = legacy::EscapeAttribute(text);
+    EXPECT_EQ(XamlEscapeAttribute(text, buffer), expected);
+    EXPECT_EQ(XamlEscapeAttribute(text), expected);
+  }
+}
+
+TEST(XamlWriterTest, EmptyStyleProducesNothing) {
+  EXPECT_TRUE(BuildPresenterStyleXaml(ResolvedStyle(), AsciiToWide).empty());
+  // Unknown keys alone leave WinUI's look.
+  EXPECT_TRUE(BuildPresenterStyleXaml(
+                  ResolveStyle(MakeStyle({{"unknown", flutter::EncodableValue(1)}})),
+                  AsciiToWide)
+                  .empty());
+}
+
+TEST(XamlWriterTest, SmallStyleGolden) {
+  auto style = MakeStyle(
+      {{"subMenuOpenedBackgroundColor", flutter::EncodableValue(int64_t{0xFF112233})},
+       {"fontSize", flutter::EncodableValue(14.0)},
+       {"padding", flutter::EncodableValue(MakePadding())}});
+  EXPECT_EQ(
+      BuildPresenterStyleXaml(ResolveStyle(style), AsciiToWide),
+      L"<Style TargetType='MenuFlyoutPresenter' "
+      L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation'>"
+      L"<Setter Property='Resources'><Setter.Value><ResourceDictionary "
+      L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+      L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+      L"<ResourceDictionary.ThemeDictionaries>"
+      L"<ResourceDictionary x:Key='Default'>"
+      L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='#FF112233'/>"
+      L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='#FF112233'/>"
+      L"</ResourceDictionary><ResourceDictionary x:Key='Light'>"
+      L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='#FF112233'/>"
+      L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='#FF112233'/>"
+      L"</ResourceDictionary><ResourceDictionary x:Key='Dark'>"
+      L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='#FF112233'/>"
+      L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='#FF112233'/>"
+      L"</ResourceDictionary></ResourceDictionary.ThemeDictionaries>"
+      L"</ResourceDictionary></Setter.Value></Setter>"
+      L"<Setter Property='FontSize' Value='14'/>"
+      L"<Setter Property='Padding' Value='4.5,2,0.1,1e+07'/>"
+      L"</Style>");
+}
+
+TEST(XamlWriterTest, PresenterMatchesLegacyGenerator) {
+  for (const auto& style : StyleMatrix()) {
+    EXPECT_EQ(BuildPresenterStyleXaml(ResolveStyle(style), AsciiToWide),
+              legacy::PresenterStyle(style));
+  }
+}
+
+TEST(XamlWriterTest, CompactStylesMatchLegacyGenerator) {
+  auto check = [](const flutter::EncodableMap* style) {
+    CompactItemStylesXaml actual = BuildCompactItemStylesXaml(
+        style ? ResolveStyle(*style) : ResolvedStyle());
+    CompactItemStylesXaml expected = legacy::CompactItemStyles(style);
+    EXPECT_EQ(actual.menu_flyout_item, expected.menu_flyout_item);
+    EXPECT_EQ(actual.toggle_menu_flyout_item, expected.toggle_menu_flyout_item);
+    EXPECT_EQ(actual.menu_flyout_sub_item, expected.menu_flyout_sub_item);
+  };
+  check(nullptr);
+  for (const auto& style : StyleMatrix()) check(&style);
+}
+
+// Every combination of the four colours the compact templates fill in, alone
+// and next to unrelated keys.
+TEST(XamlWriterTest, CompactStylesMatchLegacyForEverySlotCombination) {
+  const char* const keys[] = {"hoverBackgroundColor", "checkedIndicatorColor",
+                              "subMenuOpenedBackgroundColor",
+                              "subMenuOpenedTextColor"};
+  for (int mask = 0; mask < 16; ++mask) {
+    for (bool unrelated : {false, true}) {
+      flutter::EncodableMap style;
+      for (int i = 0; i < 4; ++i) {
+        if (mask & (1 << i)) {
+          style[flutter::EncodableValue(keys[i])] =
+              flutter::EncodableValue(int64_t{0xFF102030} + i);
+        }
+      }
+      if (unrelated) {
+        style[flutter::EncodableValue("textColor")] =
+            flutter::EncodableValue(int64_t{0xFFEEEEEE});
+        style[flutter::EncodableValue("fontSize")] =
+            flutter::EncodableValue(13.0);
+      }
+      const CompactItemStylesXaml actual =
+          BuildCompactItemStylesXaml(ResolveStyle(style));
+      const CompactItemStylesXaml expected = legacy::CompactItemStyles(&style);
+      EXPECT_EQ(actual.menu_flyout_item, expected.menu_flyout_item) << mask;
+      EXPECT_EQ(actual.toggle_menu_flyout_item,
+                expected.toggle_menu_flyout_item)
+          << mask;
+      EXPECT_EQ(actual.menu_flyout_sub_item, expected.menu_flyout_sub_item)
+          << mask;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tray_manager_winui
@@ -0,0 +1,43 @@
+# Platform-neutral core of the plugin: menu compilation and the packed format,
+# style values and XAML text generation, placement parsing, event
+# marshalling, live item coalescing, menu snapshots, the widget backend, host
+# pool, prepare state logic, the XAML thread gate, show scheduling and the
+# named menu registry. No Windows or WinUI dependencies; builds with MSVC, GCC
+# and Clang.
+#
+# Included by the plugin build (windows/CMakeLists.txt) and the standalone
+# test and benchmark project (windows/test/CMakeLists.txt). Defines
+# TRAY_MANAGER_WINUI_CORE_SOURCES and the static tray_manager_winui_core
+# target; the includer adds the directory with flutter/encodable_value.h.
+
+set(TRAY_MANAGER_WINUI_CORE_DIR "${CMAKE_CURRENT_LIST_DIR}")
+set(TRAY_MANAGER_WINUI_CORE_SOURCES
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/lazy_submenus.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/live_items.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_event_queue.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_host_pool.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_model.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_paging.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_patch.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_placement.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_prepare.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_registry.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_snapshot.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_toggles.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/menu_widget_backend.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/packed_menu.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/span_trace.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/style_fingerprint.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/style_values.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/utf16.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/xaml_thread_gate.cpp"
+  "${TRAY_MANAGER_WINUI_CORE_DIR}/xaml_writer.cpp"
+)
+
+find_package(Threads REQUIRED)
+
+add_library(tray_manager_winui_core STATIC ${TRAY_MANAGER_WINUI_CORE_SOURCES})
+target_compile_features(tray_manager_winui_core PUBLIC cxx_std_17)
+target_include_directories(tray_manager_winui_core PUBLIC
+  "${TRAY_MANAGER_WINUI_CORE_DIR}")
+target_link_libraries(tray_manager_winui_core PUBLIC Threads::Threads)
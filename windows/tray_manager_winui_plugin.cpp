@@ -1,6 +1,13 @@
 #include "include/tray_manager_winui/tray_manager_winui_plugin.h"
+#include "menu_patch.h"
+#include "menu_placement.h"
+#include "menu_registry.h"
+#include "menu_snapshot.h"
+#include "packed_menu.h"
+#include "span_trace.h"
 #include "winui_context_menu.h"
 
+#include <flutter/binary_messenger.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
@@ -8,6 +15,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 
 namespace tray_manager_winui {
 
@@ -15,6 +23,49 @@ namespace {
 
 std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> g_channel;
 
+// The "handle" argument of showContextMenu and prepareContextMenu; nullopt
+// (the menu from setContextMenu) when absent.
+std::optional<std::string> GetHandle(const flutter::EncodableValue* arguments) {
+  const auto* args =
+      arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) return std::nullopt;
+  auto it = args->find(flutter::EncodableValue("handle"));
+  if (it == args->end()) return std::nullopt;
+  const auto* handle = std::get_if<std::string>(&it->second);
+  return handle ? std::optional<std::string>(*handle) : std::nullopt;
+}
+
+// Compiles the "menu" of setContextMenu or registerMenu arguments, stamped
+// with their "generation" (0 if absent), which clicks echo back to Dart.
+CompiledMenu CompileMenuArgument(const flutter::EncodableMap& args) {
+  CompiledMenu menu = CompileMenu(std::get<flutter::EncodableMap>(
+      args.at(flutter::EncodableValue("menu"))));
+  auto it = args.find(flutter::EncodableValue("generation"));
+  if (it != args.end()) {
+    if (const auto* i = std::get_if<int32_t>(&it->second)) {
+      menu.set_generation(static_cast<uint32_t>(*i));
+    } else if (const auto* l = std::get_if<int64_t>(&it->second)) {
+      menu.set_generation(static_cast<uint32_t>(*l));
+    }
+  }
+  return menu;
+}
+
+// The "style" map of setContextMenu or registerMenu arguments, or an empty
+// map. It is read in place; the snapshot resolves it (ResolveStyle) and keeps
+// none of the map, so nothing copies it.
+const flutter::EncodableMap& StyleArgument(const flutter::EncodableMap& args) {
+  static const flutter::EncodableMap kNoStyle;
+  auto it = args.find(flutter::EncodableValue("style"));
+  if (it == args.end()) return kNoStyle;
+  const auto* style = std::get_if<flutter::EncodableMap>(&it->second);
+  return style ? *style : kNoStyle;
+}
+
+// setContextMenu in the packed_menu.h format. Replies with one byte: 1 when
+// the menu was set, 0 when the buffer was rejected.
+constexpr char kPackedMenuChannel[] = "tray_manager_winui/packed_menu";
+
 }  // namespace
 
 class TrayManagerWinuiPlugin : public flutter::Plugin {
@@ -33,10 +84,26 @@ class TrayManagerWinuiPlugin : public flutter::Plugin {
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue>& method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void HandlePackedMenu(const uint8_t* message, size_t message_size,
+                        const flutter::BinaryReply& reply);
+  void SetContextMenu(std::shared_ptr<MenuSnapshot> snapshot);
+  // Looks up the menu to show or prepare: a registered one for a handle, the
+  // setContextMenu one otherwise. Replies with an error (unknown or evicted
+  // handle) or false (no menu set) and returns null if there is none.
+  MenuSnapshotPtr SelectMenu(
+      const std::optional<std::string>& handle,
+      flutter::MethodResult<flutter::EncodableValue>& result);
 
   flutter::PluginRegistrarWindows* registrar_;
-  flutter::EncodableMap cached_menu_;
-  flutter::EncodableMap cached_style_;
+  // The setContextMenu menu. updateMenuItems patches it in place while no
+  // show or flyout holds it, and replaces it with a patched copy otherwise.
+  std::shared_ptr<MenuSnapshot> cached_;
+  // Menus registered with registerMenu; the setContextMenu menu is not
+  // counted against its budget.
+  MenuRegistry registry_;
+  // The menu of the last show or prepare: a registered handle, or nullopt for
+  // the setContextMenu menu. A prepared flyout is for this menu only.
+  std::optional<std::string> active_handle_;
 };
 
 void TrayManagerWinuiPlugin::RegisterWithRegistrar(
@@ -51,6 +118,13 @@ void TrayManagerWinuiPlugin::RegisterWithRegistrar(
       [plugin_pointer = plugin.get()](const auto& call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
+  registrar->messenger()->SetMessageHandler(
+      kPackedMenuChannel,
+      [plugin_pointer = plugin.get()](const uint8_t* message,
+                                      size_t message_size,
+                                      flutter::BinaryReply reply) {
+        plugin_pointer->HandlePackedMenu(message, message_size, reply);
+      });
 
   registrar->AddPlugin(std::move(plugin));
 }
@@ -62,36 +136,172 @@ TrayManagerWinuiPlugin::TrayManagerWinuiPlugin(
 }
 
 TrayManagerWinuiPlugin::~TrayManagerWinuiPlugin() {
+  registrar_->messenger()->SetMessageHandler(kPackedMenuChannel, nullptr);
   DestroyPlatformCallback();
   ShutdownWinUI();
 }
 
+void TrayManagerWinuiPlugin::SetContextMenu(
+    std::shared_ptr<MenuSnapshot> snapshot) {
+  cached_ = std::move(snapshot);
+  active_handle_.reset();
+  OnWinUIMenuChanged();
+  PrecompileWinUIStyle(cached_->style);
+  TriggerWinUIPreInitialization();
+}
+
+MenuSnapshotPtr TrayManagerWinuiPlugin::SelectMenu(
+    const std::optional<std::string>& handle,
+    flutter::MethodResult<flutter::EncodableValue>& result) {
+  MenuSnapshotPtr snapshot;
+  if (handle) {
+    const RegisteredMenu* entry = registry_.Use(*handle);
+    if (!entry) {
+      // Dart registers the menu again and retries.
+      result.Error("menu_not_registered",
+                   "No menu is registered as '" + *handle + "'");
+      return nullptr;
+    }
+    snapshot = entry->snapshot;
+  } else {
+    if (!cached_) {
+      result.Success(flutter::EncodableValue(false));
+      return nullptr;
+    }
+    snapshot = cached_;
+  }
+  if (handle != active_handle_) {
+    active_handle_ = handle;
+    OnWinUIMenuChanged();
+  }
+  return snapshot;
+}
+
+void TrayManagerWinuiPlugin::HandlePackedMenu(
+    const uint8_t* message, size_t message_size,
+    const flutter::BinaryReply& reply) {
+  // A rejected buffer leaves the current menu alone; Dart then falls back to
+  // the method channel.
+  ScopedSpan span("setContextMenu (packed)");
+  PackedMenuView view;
+  const bool ok = view.Open(message, message_size) == PackedMenuError::kNone;
+  if (ok) {
+    SetContextMenu(
+        MakeMenuSnapshot(CompileMenu(view), DecodePackedStyle(view)));
+  }
+  if (reply) {
+    const uint8_t status = ok ? 1 : 0;
+    reply(&status, 1);
+  }
+}
+
 void TrayManagerWinuiPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
   if (method_call.method_name() == "setContextMenu") {
+    ScopedSpan span("setContextMenu");
     const auto& args =
         std::get<flutter::EncodableMap>(*method_call.arguments());
-    cached_menu_ =
-        std::get<flutter::EncodableMap>(args.at(flutter::EncodableValue("menu")));
-    auto style_it = args.find(flutter::EncodableValue("style"));
-    if (style_it != args.end()) {
-      const auto* style_map = std::get_if<flutter::EncodableMap>(&style_it->second);
-      cached_style_ = style_map ? *style_map : flutter::EncodableMap();
-    } else {
-      cached_style_.clear();
+    SetContextMenu(
+        MakeMenuSnapshot(CompileMenuArgument(args), StyleArgument(args)));
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name() == "updateMenuItems") {
+    // Returns false when the patches could not all be applied (no menu set,
+    // unknown ids); Dart then falls back to a full setContextMenu.
+    const auto* args =
+        std::get_if<flutter::EncodableMap>(method_call.arguments());
+    const flutter::EncodableList* patches = nullptr;
+    if (args) {
+      auto it = args->find(flutter::EncodableValue("patches"));
+      if (it != args->end()) {
+        patches = std::get_if<flutter::EncodableList>(&it->second);
+      }
     }
+    if (!cached_ || !patches) {
+      result->Success(flutter::EncodableValue(false));
+      return;
+    }
+    // Copy-on-write if a show or prepared flyout holds the menu: it keeps
+    // the menu it was given.
+    const MenuPatchResult patched = PatchMenuSnapshot(cached_, *patches);
+    if (!active_handle_) OnWinUIMenuChanged();
+    result->Success(flutter::EncodableValue(patched.ok()));
+  } else if (method_call.method_name() == "updateLiveItems") {
+    // {"items": [{"id", "label", "icon", "disabled"}]}: new values for items
+    // of the flyout, applied on the XAML thread at frame rate without
+    // touching the menu. Returns false if an entry was rejected.
+    const auto* args =
+        std::get_if<flutter::EncodableMap>(method_call.arguments());
+    const flutter::EncodableList* items = nullptr;
+    if (args) {
+      auto it = args->find(flutter::EncodableValue("items"));
+      if (it != args->end()) {
+        items = std::get_if<flutter::EncodableList>(&it->second);
+      }
+    }
+    result->Success(
+        flutter::EncodableValue(items && UpdateWinUILiveItems(*items)));
+  } else if (method_call.method_name() == "registerMenu") {
+    // {"handle", "menu", "style", "generation"}: compiles the menu once for
+    // any number of showContextMenu(handle) calls. Registering a handle again
+    // replaces it.
+    ScopedSpan span("registerMenu");
+    const auto& args =
+        std::get<flutter::EncodableMap>(*method_call.arguments());
+    const auto& handle =
+        std::get<std::string>(args.at(flutter::EncodableValue("handle")));
+    const RegisteredMenu& entry = registry_.Register(
+        handle,
+        MakeMenuSnapshot(CompileMenuArgument(args), StyleArgument(args)));
+    if (active_handle_ == handle) OnWinUIMenuChanged();
+    PrecompileWinUIStyle(entry.snapshot->style);
     TriggerWinUIPreInitialization();
     result->Success(flutter::EncodableValue(true));
-  } else if (method_call.method_name() == "showContextMenu") {
-    if (cached_menu_.empty()) {
+  } else if (method_call.method_name() == "disposeMenu") {
+    // Returns false if the handle was not registered (or already evicted).
+    const auto handle = GetHandle(method_call.arguments());
+    bool disposed = handle && registry_.Dispose(*handle);
+    if (disposed && active_handle_ == handle) {
+      active_handle_.reset();
+      OnWinUIMenuChanged();
+    }
+    result->Success(flutter::EncodableValue(disposed));
+  } else if (method_call.method_name() == "setMenuMemoryBudget") {
+    // {"bytes": int}: bound for registered menus, evicting the least recently
+    // shown ones to meet it. Returns false for a missing or negative value.
+    const auto* args =
+        std::get_if<flutter::EncodableMap>(method_call.arguments());
+    std::optional<int64_t> bytes;
+    if (args) {
+      auto it = args->find(flutter::EncodableValue("bytes"));
+      if (it != args->end()) {
+        if (const auto* i = std::get_if<int32_t>(&it->second)) bytes = *i;
+        if (const auto* l = std::get_if<int64_t>(&it->second)) bytes = *l;
+      }
+    }
+    if (!bytes || *bytes < 0) {
       result->Success(flutter::EncodableValue(false));
       return;
     }
-    std::optional<double> pos_x;
-    std::optional<double> pos_y;
-    std::optional<std::string> placement;
-    std::optional<flutter::EncodableMap> exclusion_rect;
+    registry_.set_budget_bytes(static_cast<size_t>(*bytes));
+    if (active_handle_ && !registry_.Find(*active_handle_)) {
+      active_handle_.reset();
+      OnWinUIMenuChanged();
+    }
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name() == "prepareContextMenu") {
+    // Builds the hidden flyout for the menu ahead of the show.
+    MenuSnapshotPtr snapshot =
+        SelectMenu(GetHandle(method_call.arguments()), *result);
+    if (!snapshot) return;
+    bool prepared =
+        PrepareWinUIContextMenu(std::move(snapshot), g_channel.get());
+    result->Success(flutter::EncodableValue(prepared));
+  } else if (method_call.method_name() == "showContextMenu") {
+    MenuSnapshotPtr snapshot =
+        SelectMenu(GetHandle(method_call.arguments()), *result);
+    if (!snapshot) return;
+    MenuShowRequest request;
 
     const auto* encodable_args = method_call.arguments();
     const auto* args =
@@ -113,20 +323,58 @@ void TrayManagerWinuiPlugin::HandleMethodCall(
         const auto* s = std::get_if<std::string>(&it->second);
         return s ? std::optional<std::string>(*s) : std::nullopt;
       };
-      pos_x = get_double("x");
-      pos_y = get_double("y");
-      placement = get_string("placement");
+      request.x = get_double("x");
+      request.y = get_double("y");
+      request.placement = get_string("placement");
       auto er_it = args->find(flutter::EncodableValue("exclusionRect"));
       if (er_it != args->end()) {
         const auto* er_map = std::get_if<flutter::EncodableMap>(&er_it->second);
-        if (er_map) exclusion_rect = *er_map;
+        if (er_map) request.exclusion_rect = ParseMenuRect(*er_map);
       }
     }
 
-    bool shown = ShowWinUIContextMenu(cached_menu_, cached_style_,
-                                      g_channel.get(), pos_x, pos_y,
-                                      placement, exclusion_rect);
-    result->Success(flutter::EncodableValue(shown));
+    // Replies once the flyout is open (or the show failed); the platform
+    // thread never waits for WinUI initialization.
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> pending =
+        std::move(result);
+    ShowWinUIContextMenu(
+        std::move(snapshot), g_channel.get(),
+        [pending](bool shown) {
+          pending->Success(flutter::EncodableValue(shown));
+        },
+        std::move(request));
+  } else if (method_call.method_name() == "setTracingEnabled") {
+    const auto* args =
+        std::get_if<flutter::EncodableMap>(method_call.arguments());
+    bool enabled = false;
+    if (args) {
+      auto it = args->find(flutter::EncodableValue("enabled"));
+      if (it != args->end()) {
+        const auto* b = std::get_if<bool>(&it->second);
+        enabled = b && *b;
+      }
+    }
+    GetSpanTrace().set_enabled(enabled);
+    result->Success(flutter::EncodableValue(true));
+  } else if (method_call.method_name() == "getTrace") {
+    // Chrome trace_event JSON of the recorded spans; {"clear": true} starts a
+    // new trace afterwards.
+    const auto* encodable_args = method_call.arguments();
+    const auto* args =
+        encodable_args ? std::get_if<flutter::EncodableMap>(encodable_args)
+                       : nullptr;
+    bool clear = false;
+    if (args) {
+      auto it = args->find(flutter::EncodableValue("clear"));
+      if (it != args->end()) {
+        const auto* b = std::get_if<bool>(&it->second);
+        clear = b && *b;
+      }
+    }
+    SpanTrace& trace = GetSpanTrace();
+    std::string json = ExportChromeTrace(trace);
+    if (clear) trace.Clear();
+    result->Success(flutter::EncodableValue(std::move(json)));
   } else {
     result->NotImplemented();
   }
@@ -0,0 +1,138 @@
+#include "utf16.h"
+
+#include <cstdint>
+
+#include "simd.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+bool IsContinuation(uint8_t byte) { return (byte & 0xC0) == 0x80; }
+
+// Decodes the non-ASCII sequence at in[0] (in < end), writes one or two
+// units and returns the number of bytes consumed. Second-byte ranges follow
+// Table 3-7 of the Unicode standard; anything outside them ends the
+// sequence with one U+FFFD.
+size_t DecodeSequence(const uint8_t* in, const uint8_t* end, char16_t*& out) {
+  const uint8_t lead = in[0];
+  size_t length;
+  uint32_t code_point;
+  uint8_t second_min = 0x80;
+  uint8_t second_max = 0xBF;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+    code_point = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    code_point = lead & 0x0F;
+    if (lead == 0xE0) second_min = 0xA0;  // Overlong.
+    if (lead == 0xED) second_max = 0x9F;  // Surrogates.
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    code_point = lead & 0x07;
+    if (lead == 0xF0) second_min = 0x90;  // Overlong.
+    if (lead == 0xF4) second_max = 0x8F;  // Above U+10FFFF.
+  } else {
+    *out++ = kReplacementCharacter;
+    return 1;
+  }
+
+  size_t consumed = 1;
+  for (; consumed < length; ++consumed) {
+    if (in + consumed == end) break;
+    const uint8_t byte = in[consumed];
+    if (consumed == 1 ? (byte < second_min || byte > second_max)
+                      : !IsContinuation(byte)) {
+      break;
+    }
+    code_point = (code_point << 6) | (byte & 0x3F);
+  }
+  if (consumed != length) {
+    *out++ = kReplacementCharacter;
+    return consumed;
+  }
+  if (code_point >= 0x10000) {
+    code_point -= 0x10000;
+    *out++ = static_cast<char16_t>(0xD800 + (code_point >> 10));
+    *out++ = static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+  } else {
+    *out++ = static_cast<char16_t>(code_point);
+  }
+  return length;
+}
+
+}  // namespace
+
+size_t Utf8ToUtf16Scalar(std::string_view utf8, char16_t* out) {
+  const auto* in = reinterpret_cast<const uint8_t*>(utf8.data());
+  const uint8_t* end = in + utf8.size();
+  char16_t* const begin = out;
+  while (in < end) {
+    if (*in < 0x80) {
+      *out++ = *in++;
+    } else {
+      in += DecodeSequence(in, end, out);
+    }
+  }
+  return static_cast<size_t>(out - begin);
+}
+
+size_t Utf8ToUtf16(std::string_view utf8, char16_t* out) {
+  const auto* in = reinterpret_cast<const uint8_t*>(utf8.data());
+  const uint8_t* end = in + utf8.size();
+  char16_t* const begin = out;
+  while (in < end) {
+    if (*in >= 0x80) {
+      // Non-ASCII runs (CJK, say) stay on the scalar path; vector loads are
+      // only tried at the start of an ASCII run.
+      do {
+        in += DecodeSequence(in, end, out);
+      } while (in < end && *in >= 0x80);
+      continue;
+    }
+#if defined(TRAY_MANAGER_WINUI_SSE2)
+    // out never runs ahead of in, so 16 units fit whenever 16 bytes remain.
+    while (end - in >= 16) {
+      const __m128i bytes =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+      if (_mm_movemask_epi8(bytes) != 0) break;
+      const __m128i zero = _mm_setzero_si128();
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                       _mm_unpacklo_epi8(bytes, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8),
+                       _mm_unpackhi_epi8(bytes, zero));
+      in += 16;
+      out += 16;
+    }
+#elif defined(TRAY_MANAGER_WINUI_NEON)
+    while (end - in >= 16) {
+      const uint8x16_t bytes = vld1q_u8(in);
+      if (vmaxvq_u8(bytes) >= 0x80) break;
+      vst1q_u16(reinterpret_cast<uint16_t*>(out),
+                vmovl_u8(vget_low_u8(bytes)));
+      vst1q_u16(reinterpret_cast<uint16_t*>(out + 8),
+                vmovl_u8(vget_high_u8(bytes)));
+      in += 16;
+      out += 16;
+    }
+#endif
+    // The tail of the run: short runs and the ASCII head of a mixed block.
+    while (in < end && *in < 0x80) *out++ = *in++;
+  }
+  return static_cast<size_t>(out - begin);
+}
+
+std::u16string Utf8ToUtf16(std::string_view utf8) {
+  std::u16string result;
+  AppendUtf8AsUtf16(utf8, result);
+  return result;
+}
+
+void AppendUtf8AsUtf16(std::string_view utf8, std::u16string& out) {
+  const size_t start = out.size();
+  out.resize(start + utf8.size());
+  out.resize(start + Utf8ToUtf16(utf8, out.data() + start));
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,32 @@
+#ifndef TRAY_MANAGER_WINUI_UTF16_H_
+#define TRAY_MANAGER_WINUI_UTF16_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace tray_manager_winui {
+
+/// Substituted for each maximal ill-formed subsequence of the input, as
+/// MultiByteToWideChar(CP_UTF8, 0, ...) does: a lead byte followed by as many
+/// valid continuation bytes as a well-formed sequence could have becomes one
+/// U+FFFD; stray continuation bytes, C0/C1, F5-FF, overlong forms, encoded
+/// surrogates and code points above U+10FFFF are all ill-formed.
+constexpr char16_t kReplacementCharacter = 0xFFFD;
+
+/// Converts UTF-8 to UTF-16 in one pass. out must have room for utf8.size()
+/// units, the most the output can need; returns the number written. Runs of
+/// ASCII are widened 16 bytes at a time with SSE2 or NEON where available.
+size_t Utf8ToUtf16(std::string_view utf8, char16_t* out);
+
+/// The portable fallback of Utf8ToUtf16; same output, one byte at a time.
+size_t Utf8ToUtf16Scalar(std::string_view utf8, char16_t* out);
+
+std::u16string Utf8ToUtf16(std::string_view utf8);
+
+/// Appends the UTF-16 form of utf8 to out.
+void AppendUtf8AsUtf16(std::string_view utf8, std::u16string& out);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_UTF16_H_
@@ -1,17 +1,35 @@
 #include "winui_context_menu.h"
 
+#include "argb_cache.h"
+#include "live_items.h"
+#include "menu_event_queue.h"
+#include "menu_host_pool.h"
+#include "menu_placement.h"
+#include "menu_prepare.h"
+#include "menu_widget_backend.h"
+#include "show_scheduler.h"
+#include "span_trace.h"
+#include "style_values.h"
+#include "utf16.h"
+#include "xaml_thread_gate.h"
+#include "xaml_writer.h"
+
 #include <flutter/encodable_value.h>
 #include <flutter/method_channel.h>
 
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <functional>
 #include <future>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #if defined(TRAY_MANAGER_WINUI_USE_WINUI) && TRAY_MANAGER_WINUI_USE_WINUI
 
@@ -32,7 +50,6 @@
 #include <winrt/Microsoft.UI.Composition.SystemBackdrops.h>
 
 #include <MddBootstrap.h>
-#include <sstream>
 
 using namespace winrt;
 using namespace winrt::Microsoft::UI::Xaml;
@@ -47,29 +64,23 @@ namespace tray_manager_winui {
 
 namespace {
 
-std::wstring Utf8ToWide(const std::string& utf8) {
-  if (utf8.empty()) return std::wstring();
-  int size = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, nullptr, 0);
-  if (size <= 0) return std::wstring();
-  std::wstring result(size - 1, 0);
-  MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, result.data(), size);
+static_assert(sizeof(wchar_t) == sizeof(char16_t),
+              "UTF-16 buffers are passed to WinRT as wchar_t");
+
+// One pass, sized by the UTF-8 length; see utf16.h.
+std::wstring Utf8ToWide(std::string_view utf8) {
+  std::wstring result(utf8.size(), 0);
+  result.resize(Utf8ToUtf16(
+      utf8, reinterpret_cast<char16_t*>(result.data())));
   return result;
 }
 
-std::wstring XamlEscapeAttribute(const std::wstring& input) {
-  std::wstring result;
-  result.reserve(input.size() + input.size() / 4);
-  for (wchar_t c : input) {
-    switch (c) {
-      case L'&': result += L"&amp;"; break;
-      case L'<': result += L"&lt;"; break;
-      case L'>': result += L"&gt;"; break;
-      case L'"': result += L"&quot;"; break;
-      case L'\'': result += L"&apos;"; break;
-      default: result += c; break;
-    }
-  }
-  return result;
+// Menu strings are converted once per setContextMenu (CompiledMenu::text);
+// this only copies them into the HSTRING.
+winrt::hstring ToHString(MenuText text) {
+  return winrt::hstring(std::wstring_view(
+      reinterpret_cast<const wchar_t*>(text.utf16.data()),
+      text.utf16.size()));
 }
 
 void DebugLog(const wchar_t* msg) {
@@ -85,54 +96,124 @@ void DebugLog(const wchar_t* context, HRESULT hr) {
 
 // Platform-thread callback window for thread-safe InvokeMethod calls.
 // Flutter requires method channel messages on the platform thread.
-// WinUI event handlers run on the DispatcherQueue thread, so we
-// PostMessage back to this message-only window on the platform thread.
+// WinUI event handlers run on the DispatcherQueue thread; they queue events
+// in g_menuEvents and the first event of a burst posts one message to this
+// message-only window, which drains the whole queue on the platform thread.
 HWND g_platformCallbackHwnd = nullptr;
 constexpr UINT WM_FLUTTER_INVOKE = WM_APP + 100;
+// Runs g_platformTasks: method results that complete asynchronously.
+constexpr UINT WM_FLUTTER_COMPLETE = WM_APP + 101;
 
-struct PendingInvoke {
-  std::string method;
-  flutter::EncodableValue args;
-  flutter::MethodChannel<flutter::EncodableValue>* channel;
-};
+MenuEventQueue g_menuEvents;
+// updateLiveItems: merged on the platform thread, flushed to the flyout items
+// on the XAML thread at most once per display frame.
+LiveItemCoalescer g_liveItems;
+// The channel is created once at registration and outlives every event.
+std::atomic<flutter::MethodChannel<flutter::EncodableValue>*> g_eventChannel{
+    nullptr};
+uint64_t g_reportedOverflow = 0;  // Platform thread only.
+
+std::mutex g_platformTasksMutex;
+std::vector<std::function<void()>> g_platformTasks;
 
 LRESULT CALLBACK PlatformCallbackProc(HWND hwnd, UINT msg,
                                        WPARAM wParam, LPARAM lParam) {
   if (msg == WM_FLUTTER_INVOKE) {
-    auto* pending = reinterpret_cast<PendingInvoke*>(lParam);
-    if (pending && pending->channel) {
-      pending->channel->InvokeMethod(
-          pending->method,
-          std::make_unique<flutter::EncodableValue>(std::move(pending->args)));
+    auto* channel = g_eventChannel.load(std::memory_order_acquire);
+    g_menuEvents.Drain([channel](const MenuEvent& event) {
+      if (channel) {
+        channel->InvokeMethod(MenuEventMethod(event.type),
+                              MenuEventArguments(event));
+      }
+    });
+    const uint64_t overflow = g_menuEvents.overflow_count();
+    if (overflow != g_reportedOverflow) {
+      wchar_t buf[96];
+      swprintf_s(buf, L"TrayWinUI: %llu menu events dropped (queue full)\n",
+                 static_cast<unsigned long long>(overflow - g_reportedOverflow));
+      OutputDebugStringW(buf);
+      g_reportedOverflow = overflow;
     }
-    delete pending;
+    return 0;
+  }
+  if (msg == WM_FLUTTER_COMPLETE) {
+    std::vector<std::function<void()>> tasks;
+    {
+      std::lock_guard lock(g_platformTasksMutex);
+      tasks.swap(g_platformTasks);
+    }
+    for (auto& task : tasks) task();
     return 0;
   }
   return DefWindowProcW(hwnd, msg, wParam, lParam);
 }
 
-void InvokeOnPlatformThread(
-    flutter::MethodChannel<flutter::EncodableValue>* channel,
-    const std::string& method,
-    flutter::EncodableValue args = flutter::EncodableValue()) {
+// Runs task on the platform thread, from any thread. Dropped (with its
+// method result) once the callback window is gone.
+void PostToPlatformThread(std::function<void()> task) {
+  {
+    std::lock_guard lock(g_platformTasksMutex);
+    g_platformTasks.push_back(std::move(task));
+  }
+  if (!g_platformCallbackHwnd) return;
+  if (!PostMessageW(g_platformCallbackHwnd, WM_FLUTTER_COMPLETE, 0, 0)) {
+    // Still queued; the next completion wakes the thread again.
+    DebugLog(L"Posting show completion failed",
+             HRESULT_FROM_WIN32(GetLastError()));
+  }
+}
+
+// Completes a show on the platform thread; see ShowWinUIContextMenu.
+ShowWinUICallback OnPlatformThread(ShowWinUICallback on_done) {
+  return [on_done = std::move(on_done)](bool shown) {
+    PostToPlatformThread([on_done, shown] { on_done(shown); });
+  };
+}
+
+void QueueMenuEvent(flutter::MethodChannel<flutter::EncodableValue>* channel,
+                    const MenuEvent& event) {
   if (!g_platformCallbackHwnd || !channel) return;
-  auto* pending = new PendingInvoke{method, std::move(args), channel};
-  if (!PostMessageW(g_platformCallbackHwnd, WM_FLUTTER_INVOKE, 0,
-                    reinterpret_cast<LPARAM>(pending))) {
-    delete pending;
+  g_eventChannel.store(channel, std::memory_order_release);
+  if (g_menuEvents.Push(event) != MenuEventPush::kQueuedWake) return;
+  if (!PostMessageW(g_platformCallbackHwnd, WM_FLUTTER_INVOKE, 0, 0)) {
+    // The events stay queued; the next one tries to wake the thread again.
+    g_menuEvents.CancelWake();
+    DebugLog(L"Posting menu events failed",
+             HRESULT_FROM_WIN32(GetLastError()));
   }
 }
 
+// A showContextMenu, run on the XAML thread by ShowScheduler.
+struct PendingShow {
+  MenuSnapshotPtr snapshot;
+  flutter::MethodChannel<flutter::EncodableValue>* channel = nullptr;
+  MenuShowRequest request;
+  uint64_t version = 0;
+  // SpanTrace::Now() at ShowWinUIContextMenu.
+  uint64_t requested = 0;
+};
+
+// A prepareContextMenu for one menu version, run on the XAML thread.
+struct PendingPrepare {
+  MenuSnapshotPtr snapshot;
+  flutter::MethodChannel<flutter::EncodableValue>* channel = nullptr;
+  uint64_t ticket = 0;
+  uint64_t version = 0;
+};
+
+// Set once by WinUIXamlThread::Initialize, before the gate posts any task;
+// cleared by ShutdownWinUI.
 struct WinUIState {
-  bool initialized = false;
-  bool init_in_progress = false;
-  bool init_failed = false;
-  std::condition_variable cv;
   DispatcherQueueController controller{nullptr};
   DispatcherQueue queue{nullptr};
   winrt::Microsoft::UI::Xaml::Hosting::WindowsXamlManager xamlManager{nullptr};
   std::mutex mutex;
-  std::atomic<bool> menu_showing{false};
+  // Latest-wins queue of shows; one runs at a time.
+  ShowScheduler<PendingShow> shows;
+  // Latest style to precompile; a newer setContextMenu replaces it.
+  std::shared_ptr<const ResolvedStyle> pending_style;
+  // Prepared flyout versus the plugin's current menu.
+  MenuPrepareTracker prepare;
 };
 
 WinUIState& GetWinUIState() {
@@ -140,18 +221,10 @@ WinUIState& GetWinUIState() {
   return state;
 }
 
-// Holder for WinUI objects; must outlive the flyout until Closed.
-struct MenuHolder {
-  DesktopWindowXamlSource xamlSource;
-  Canvas canvas;
-  MenuFlyout flyout;
-};
-
-// Data for the host window subclass to handle click-outside close.
-struct MenuHostData {
-  WNDPROC oldProc;
-  std::shared_ptr<MenuHolder> holder;
-};
+// The queue of the calling thread; XAML-thread code posts and creates timers
+// on it rather than on WinUIState::queue, which ShutdownWinUI clears from
+// the platform thread.
+DispatcherQueue XamlQueue() { return DispatcherQueue::GetForCurrentThread(); }
 
 // Thread-local hook that forces the arrow cursor on every window owned by the
 // WinUI DispatcherQueue thread.  WinUI creates its own top-level popup windows
@@ -185,236 +258,124 @@ void RemoveCursorHook() {
   }
 }
 
-LRESULT CALLBACK MenuHostWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-  auto* data = reinterpret_cast<MenuHostData*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+// Bootstraps the Windows App SDK and runs the DispatcherQueue (XAML) thread
+// for XamlThreadGate, which calls Initialize on its own background thread.
+class WinUIXamlThread : public XamlThreadPlatform {
+ public:
+  bool Initialize() override {
+    GetSpanTrace().NameThread("winui-init");
+    auto& state = GetWinUIState();
+
+    // Windows App SDK Runtime 2.2 - keep in sync with the NuGet package versions.
+    constexpr UINT32 c_majorMinor = 0x00020002;
+    constexpr PCWSTR c_versionTag = L"";
+    PACKAGE_VERSION minVersion{};
+    HRESULT hr;
+    {
+      ScopedSpan span("MddBootstrapInitialize2");
+      hr = MddBootstrapInitialize2(
+          c_majorMinor, c_versionTag, minVersion,
+          MddBootstrapInitializeOptions_OnNoMatch_ShowUI);
+    }
+    if (FAILED(hr)) {
+      DebugLog(L"MddBootstrapInitialize2 failed", hr);
+      return false;
+    }
 
-  // Use WM_ACTIVATEAPP instead of WM_ACTIVATE to avoid killing the flyout
-  // when WinUI opens a submenu popup (which steals focus from host window
-  // but stays within the same process). WM_ACTIVATEAPP only fires when
-  // focus moves to a different application.
-  if (msg == WM_ACTIVATEAPP && wParam == FALSE && data && data->holder) {
+    // Do NOT call init_apartment: CreateOnDedicatedThread manages its own
+    // apartment on the XAML thread.
+    DispatcherQueueController controller{nullptr};
+    DispatcherQueue queue{nullptr};
     try {
-      data->holder->flyout.Hide();
+      ScopedSpan span("DispatcherQueueController::CreateOnDedicatedThread");
+      controller = DispatcherQueueController::CreateOnDedicatedThread();
+      queue = controller.DispatcherQueue();
     } catch (const winrt::hresult_error& e) {
-      DebugLog(L"MenuHostWndProc: flyout.Hide() failed", e.code());
+      DebugLog(L"DispatcherQueue creation failed", e.code());
+      return false;
     }
-  }
-
-  if (msg == WM_DESTROY && data) {
-    WNDPROC oldProc = data->oldProc;
-    SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
-    data->holder.reset();
-    delete data;
-    GetWinUIState().menu_showing.store(false);
-    return CallWindowProc(oldProc, hwnd, msg, wParam, lParam);
-  }
 
-  return data ? CallWindowProc(data->oldProc, hwnd, msg, wParam, lParam)
-              : DefWindowProc(hwnd, msg, wParam, lParam);
-}
-
-bool EnsureWinUIInitialized() {
-  auto& state = GetWinUIState();
-
-  {
-    std::unique_lock lock(state.mutex);
-    if (state.initialized) return true;
-    if (state.init_failed) return false;
-    if (state.init_in_progress) {
-      state.cv.wait_for(lock, std::chrono::seconds(30), [&state] {
-        return state.initialized || state.init_failed;
-      });
-      return state.initialized;
+    // Initialize WinUI XAML infrastructure on the dedicated thread.
+    // Must be done before creating any XAML objects.
+    using XamlManager = winrt::Microsoft::UI::Xaml::Hosting::WindowsXamlManager;
+    std::promise<XamlManager> xamlInitPromise;
+    auto xamlInitFuture = xamlInitPromise.get_future();
+    queue.TryEnqueue(DispatcherQueuePriority::High,
+                     [&xamlInitPromise]() {
+                       GetSpanTrace().NameThread("xaml");
+                       ScopedSpan span("WindowsXamlManager::InitializeForCurrentThread");
+                       try {
+                         auto manager = XamlManager::InitializeForCurrentThread();
+                         xamlInitPromise.set_value(std::move(manager));
+                       } catch (const winrt::hresult_error&) {
+                         xamlInitPromise.set_value(XamlManager{nullptr});
+                       }
+                     });
+
+    XamlManager xamlManager{nullptr};
+    try {
+      xamlManager = xamlInitFuture.get();
+    } catch (const std::exception&) {
+      DebugLog(L"XamlManager init failed (future exception)\n");
+      return false;
+    }
+    if (!xamlManager) {
+      DebugLog(L"XamlManager init returned null\n");
+      return false;
     }
-    state.init_in_progress = true;
-  }
-
-  auto fail = [&state]() {
-    std::lock_guard lock(state.mutex);
-    state.init_in_progress = false;
-    state.init_failed = true;
-    state.cv.notify_all();
-  };
-
-  // Windows App SDK Runtime 2.2 - keep in sync with the NuGet package versions.
-  constexpr UINT32 c_majorMinor = 0x00020002;
-  constexpr PCWSTR c_versionTag = L"";
-  PACKAGE_VERSION minVersion{};
-  HRESULT hr = MddBootstrapInitialize2(
-      c_majorMinor, c_versionTag, minVersion,
-      MddBootstrapInitializeOptions_OnNoMatch_ShowUI);
-  if (FAILED(hr)) {
-    DebugLog(L"MddBootstrapInitialize2 failed", hr);
-    fail();
-    return false;
-  }
-
-  // Do NOT call init_apartment: Flutter's platform thread is already STA.
-  // CreateOnDedicatedThread manages its own apartment on the XAML thread.
-  try {
-    state.controller = DispatcherQueueController::CreateOnDedicatedThread();
-    state.queue = state.controller.DispatcherQueue();
-  } catch (const winrt::hresult_error& e) {
-    DebugLog(L"DispatcherQueue creation failed", e.code());
-    fail();
-    return false;
-  }
-
-  // Initialize WinUI XAML infrastructure on the dedicated thread.
-  // Must be done before creating any XAML objects.
-  using XamlManager = winrt::Microsoft::UI::Xaml::Hosting::WindowsXamlManager;
-  std::promise<XamlManager> xamlInitPromise;
-  auto xamlInitFuture = xamlInitPromise.get_future();
-  state.queue.TryEnqueue(DispatcherQueuePriority::High,
-                         [&xamlInitPromise]() {
-                           try {
-                             auto manager = XamlManager::InitializeForCurrentThread();
-                             xamlInitPromise.set_value(std::move(manager));
-                           } catch (const winrt::hresult_error&) {
-                             xamlInitPromise.set_value(XamlManager{nullptr});
-                           }
-                         });
-
-  try {
-    state.xamlManager = xamlInitFuture.get();
-  } catch (const std::exception&) {
-    DebugLog(L"XamlManager init failed (future exception)\n");
-    fail();
-    return false;
-  }
-  if (!state.xamlManager) {
-    DebugLog(L"XamlManager init returned null\n");
-    fail();
-    return false;
-  }
 
-  {
     std::lock_guard lock(state.mutex);
-    state.initialized = true;
-    state.init_in_progress = false;
-    state.cv.notify_all();
-  }
-  return true;
-}
-
-// Gets optional int64 from EncodableMap (Dart int may be int32 or int64).
-int64_t GetStyleInt(const flutter::EncodableMap& style, const char* key) {
-  auto it = style.find(flutter::EncodableValue(key));
-  if (it == style.end()) return 0;
-  const auto* i32 = std::get_if<int32_t>(&it->second);
-  const auto* i64 = std::get_if<int64_t>(&it->second);
-  if (i32) return *i32;
-  if (i64) return *i64;
-  return 0;
-}
-
-// Gets optional double from EncodableMap.
-double GetStyleDouble(const flutter::EncodableMap& style, const char* key) {
-  auto it = style.find(flutter::EncodableValue(key));
-  if (it == style.end()) return 0;
-  const auto* d = std::get_if<double>(&it->second);
-  return d ? *d : 0;
-}
-
-// Gets optional string from EncodableMap.
-std::string GetStyleString(const flutter::EncodableMap& style, const char* key) {
-  auto it = style.find(flutter::EncodableValue(key));
-  if (it == style.end()) return "";
-  const auto* s = std::get_if<std::string>(&it->second);
-  return s ? *s : "";
-}
-
-// Gets optional bool from EncodableMap. Returns default_val when key is missing.
-bool GetStyleBool(const flutter::EncodableMap& style, const char* key,
-                  bool default_val = true) {
-  auto it = style.find(flutter::EncodableValue(key));
-  if (it == style.end()) return default_val;
-  const auto* b = std::get_if<bool>(&it->second);
-  return b ? *b : default_val;
-}
-
-// Maps Dart placement string to FlyoutPlacementMode. Returns true if mapped.
-bool TryParsePlacement(const std::string& s,
-                       FlyoutPlacementMode& out_mode) {
-  if (s == "top") {
-    out_mode = FlyoutPlacementMode::Top;
-    return true;
-  }
-  if (s == "bottom") {
-    out_mode = FlyoutPlacementMode::Bottom;
-    return true;
-  }
-  if (s == "left") {
-    out_mode = FlyoutPlacementMode::Left;
-    return true;
-  }
-  if (s == "right") {
-    out_mode = FlyoutPlacementMode::Right;
-    return true;
-  }
-  if (s == "full") {
-    out_mode = FlyoutPlacementMode::Full;
-    return true;
-  }
-  if (s == "auto") {
-    out_mode = FlyoutPlacementMode::Auto;
-    return true;
-  }
-  if (s == "topEdgeAlignedLeft") {
-    out_mode = FlyoutPlacementMode::TopEdgeAlignedLeft;
-    return true;
-  }
-  if (s == "topEdgeAlignedRight") {
-    out_mode = FlyoutPlacementMode::TopEdgeAlignedRight;
-    return true;
-  }
-  if (s == "bottomEdgeAlignedLeft") {
-    out_mode = FlyoutPlacementMode::BottomEdgeAlignedLeft;
-    return true;
-  }
-  if (s == "bottomEdgeAlignedRight") {
-    out_mode = FlyoutPlacementMode::BottomEdgeAlignedRight;
-    return true;
-  }
-  if (s == "leftEdgeAlignedTop") {
-    out_mode = FlyoutPlacementMode::LeftEdgeAlignedTop;
-    return true;
-  }
-  if (s == "leftEdgeAlignedBottom") {
-    out_mode = FlyoutPlacementMode::LeftEdgeAlignedBottom;
-    return true;
-  }
-  if (s == "rightEdgeAlignedTop") {
-    out_mode = FlyoutPlacementMode::RightEdgeAlignedTop;
+    state.controller = std::move(controller);
+    state.queue = std::move(queue);
+    state.xamlManager = std::move(xamlManager);
     return true;
   }
-  if (s == "rightEdgeAlignedBottom") {
-    out_mode = FlyoutPlacementMode::RightEdgeAlignedBottom;
-    return true;
+
+  bool Post(std::function<void()> task) override {
+    auto& state = GetWinUIState();
+    DispatcherQueue queue{nullptr};
+    {
+      std::lock_guard lock(state.mutex);
+      queue = state.queue;
+    }
+    if (!queue) return false;
+    try {
+      return queue.TryEnqueue(DispatcherQueuePriority::Normal,
+                              [task = std::move(task)]() { task(); });
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Posting to the XAML thread failed", e.code());
+      return false;
+    }
   }
-  return false;
-}
+};
 
-// Formats 0xAARRGGBB as "#AARRGGBB" for XAML.
-std::wstring ColorToXamlString(int64_t value) {
-  wchar_t buf[16];
-  swprintf_s(buf, L"#%02X%02X%02X%02X",
-             static_cast<unsigned>((value >> 24) & 0xFF),
-             static_cast<unsigned>((value >> 16) & 0xFF),
-             static_cast<unsigned>((value >> 8) & 0xFF),
-             static_cast<unsigned>(value & 0xFF));
-  return buf;
+// Every request for the XAML thread goes through the gate, so that no
+// platform-thread call waits for WinUI initialization.
+XamlThreadGate& GetXamlThreadGate() {
+  static WinUIXamlThread platform;
+  static XamlThreadGate gate(platform);
+  return gate;
 }
 
-// Creates SolidColorBrush from ARGB int64 (0xAARRGGBB) via XAML.
-// Returns null brush if value is 0. Uses XamlReader to avoid linker issues.
-Brush CreateBrushFromStyleInt(const flutter::EncodableMap& style,
-                              const char* key) {
-  int64_t value = GetStyleInt(style, key);
-  if (value == 0) return nullptr;
+static_assert(static_cast<int32_t>(MenuPlacement::kTop) ==
+              static_cast<int32_t>(FlyoutPlacementMode::Top),
+              "MenuPlacement mirrors FlyoutPlacementMode");
+static_assert(static_cast<int32_t>(MenuPlacement::kFull) ==
+              static_cast<int32_t>(FlyoutPlacementMode::Full),
+              "MenuPlacement mirrors FlyoutPlacementMode");
+static_assert(static_cast<int32_t>(MenuPlacement::kRightEdgeAlignedBottom) ==
+              static_cast<int32_t>(FlyoutPlacementMode::RightEdgeAlignedBottom),
+              "MenuPlacement mirrors FlyoutPlacementMode");
+static_assert(static_cast<int32_t>(MenuPlacement::kAuto) ==
+              static_cast<int32_t>(FlyoutPlacementMode::Auto),
+              "MenuPlacement mirrors FlyoutPlacementMode");
+
+// Creates SolidColorBrush from ARGB (0xAARRGGBB) via XAML.
+// Uses XamlReader to avoid linker issues.
+Brush CreateSolidColorBrush(uint32_t argb) {
   std::wstring xaml =
       std::wstring(L"<SolidColorBrush xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' Color='")
-      + ColorToXamlString(value) + L"'/>";
+      + ColorToXamlString(argb) + L"'/>";
   try {
     return winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(xaml).as<Brush>();
   } catch (...) {
@@ -422,31 +383,32 @@ Brush CreateBrushFromStyleInt(const flutter::EncodableMap& style,
   }
 }
 
-// Parses hex icon string ("0xHHHH") and creates a FontIcon.
-// Returns null IconElement on invalid input.
-IconElement CreateIconFromString(const std::string& iconStr,
-                                const std::string& fontFamily,
-                                Brush iconColorBrush = nullptr) {
-  if (iconStr.size() < 3 || iconStr[0] != '0' ||
-      (iconStr[1] != 'x' && iconStr[1] != 'X')) {
-    return nullptr;
-  }
-  unsigned long codepoint = 0;
-  try {
-    codepoint = std::stoul(iconStr.substr(2), nullptr, 16);
-  } catch (...) {
-    return nullptr;
-  }
-  if (codepoint == 0 || codepoint > 0xFFFF) return nullptr;
+// Brushes are thread-affine XAML objects, so the cache is per thread; only
+// the DispatcherQueue (XAML) thread ever creates brushes.
+ArgbCache<Brush>& GetBrushCache() {
+  thread_local ArgbCache<Brush> cache;
+  return cache;
+}
 
+// Returns the shared SolidColorBrush for an ARGB colour, creating it on its
+// first use. Returns null brush for 0 (colour not set).
+Brush GetBrush(uint32_t argb) {
+  if (argb == 0) return nullptr;
+  return GetBrushCache().GetOrCreate(argb, CreateSolidColorBrush);
+}
+
+// Creates a FontIcon for a glyph parsed by ParseIconGlyph.
+IconElement CreateFontIcon(uint16_t glyph,
+                           MenuText fontFamily,
+                           Brush iconColorBrush = nullptr) {
   FontIcon fontIcon;
-  wchar_t glyph[2] = {static_cast<wchar_t>(codepoint), L'\0'};
-  fontIcon.Glyph(winrt::hstring(glyph));
+  wchar_t text[2] = {static_cast<wchar_t>(glyph), L'\0'};
+  fontIcon.Glyph(winrt::hstring(text));
   fontIcon.FontSize(16);
 
   if (!fontFamily.empty()) {
     fontIcon.FontFamily(
-        Media::FontFamily(winrt::hstring(Utf8ToWide(fontFamily))));
+        Media::FontFamily(ToHString(fontFamily)));
   }
   if (iconColorBrush) {
     fontIcon.Foreground(iconColorBrush);
@@ -454,236 +416,22 @@ IconElement CreateIconFromString(const std::string& iconStr,
   return fontIcon;
 }
 
-void ApplyStyleToFlyout(MenuFlyout& flyout, const flutter::EncodableMap& style) {
-  if (style.empty()) return;
-
-  std::wstringstream xaml;
-  xaml << L"<Style TargetType='MenuFlyoutPresenter' "
-       << L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation'>";
-
-  int64_t hoverBg = GetStyleInt(style, "hoverBackgroundColor");
-  int64_t sepColor = GetStyleInt(style, "separatorColor");
-  int64_t disabledFg = GetStyleInt(style, "disabledTextColor");
-  int64_t subMenuOpenedBg = GetStyleInt(style, "subMenuOpenedBackgroundColor");
-  int64_t subMenuOpenedFg = GetStyleInt(style, "subMenuOpenedTextColor");
-  int64_t checkedFg = GetStyleInt(style, "checkedForegroundColor");
-  int64_t checkedBg = GetStyleInt(style, "checkedBackgroundColor");
-  int64_t accelColor = GetStyleInt(style, "keyboardAcceleratorColor");
-  bool needSubMenuOpenedFix = (subMenuOpenedBg == 0 && subMenuOpenedFg == 0);
-  if (hoverBg != 0 || sepColor != 0 || disabledFg != 0 ||
-      subMenuOpenedBg != 0 || subMenuOpenedFg != 0 || needSubMenuOpenedFix ||
-      checkedFg != 0 || checkedBg != 0 || accelColor != 0) {
-    std::wstringstream themeContent;
-    if (hoverBg != 0) {
-      std::wstring hoverStr = ColorToXamlString(hoverBg);
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutItemBackgroundPointerOver' Color='"
-                   << hoverStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundPointerOver' Color='"
-                   << hoverStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundPointerOver' Color='"
-                   << hoverStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutItemRevealBackgroundPointerOver' Color='"
-                   << hoverStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemRevealBackgroundPointerOver' Color='"
-                   << hoverStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundPointerOver' Color='"
-                   << hoverStr << L"'/>";
-    }
-    if (sepColor != 0) {
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSeparatorBackground' Color='"
-                   << ColorToXamlString(sepColor) << L"'/>";
-    }
-    if (disabledFg != 0) {
-      std::wstring disabledStr = ColorToXamlString(disabledFg);
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutItemForegroundDisabled' Color='"
-                   << disabledStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemForegroundDisabled' Color='"
-                   << disabledStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemChevronDisabled' Color='"
-                   << disabledStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundDisabled' Color='"
-                   << disabledStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemCheckGlyphForegroundDisabled' Color='"
-                   << disabledStr << L"'/>";
-    }
-    if (subMenuOpenedBg != 0) {
-      std::wstring subMenuBgStr = ColorToXamlString(subMenuOpenedBg);
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='"
-                   << subMenuBgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='"
-                   << subMenuBgStr << L"'/>";
-    }
-    if (subMenuOpenedFg != 0) {
-      std::wstring subMenuFgStr = ColorToXamlString(subMenuOpenedFg);
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSubItemForegroundSubMenuOpened' Color='"
-                   << subMenuFgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemChevronSubMenuOpened' Color='"
-                   << subMenuFgStr << L"'/>";
-    }
-    if (checkedBg != 0) {
-      std::wstring checkedBgStr = ColorToXamlString(checkedBg);
-      themeContent << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundChecked' Color='"
-                   << checkedBgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundCheckedPointerOver' Color='"
-                   << checkedBgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemBackgroundCheckedPressed' Color='"
-                   << checkedBgStr << L"'/>";
-    }
-    if (checkedFg != 0) {
-      std::wstring checkedFgStr = ColorToXamlString(checkedFg);
-      themeContent << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundChecked' Color='"
-                   << checkedFgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundCheckedPointerOver' Color='"
-                   << checkedFgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemForegroundCheckedPressed' Color='"
-                   << checkedFgStr << L"'/>"
-                   << L"<SolidColorBrush x:Key='ToggleMenuFlyoutItemCheckGlyphForegroundChecked' Color='"
-                   << checkedFgStr << L"'/>";
-    }
-    if (accelColor != 0) {
-      std::wstring accelStr = ColorToXamlString(accelColor);
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutItemKeyboardAcceleratorTextForeground' Color='"
-                   << accelStr << L"'/>";
-    }
-    if (needSubMenuOpenedFix) {
-      std::wstring subMenuBgVal =
-          (hoverBg != 0) ? ColorToXamlString(hoverBg) : std::wstring(L"#FF404040");
-      int64_t textColor = GetStyleInt(style, "textColor");
-      std::wstring subMenuFgVal =
-          (textColor != 0) ? ColorToXamlString(textColor) : std::wstring(L"#FFFFFFFF");
-      themeContent << L"<SolidColorBrush x:Key='MenuFlyoutSubItemBackgroundSubMenuOpened' Color='"
-                   << subMenuBgVal << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemRevealBackgroundSubMenuOpened' Color='"
-                   << subMenuBgVal << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemForegroundSubMenuOpened' Color='"
-                   << subMenuFgVal << L"'/>"
-                   << L"<SolidColorBrush x:Key='MenuFlyoutSubItemChevronSubMenuOpened' Color='"
-                   << subMenuFgVal << L"'/>";
-    }
-    std::wstring content = themeContent.str();
-    std::wstringstream resDict;
-    resDict << L"<ResourceDictionary "
-            << L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
-            << L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
-            << L"<ResourceDictionary.ThemeDictionaries>"
-            << L"<ResourceDictionary x:Key='Default'>" << content << L"</ResourceDictionary>"
-            << L"<ResourceDictionary x:Key='Light'>" << content << L"</ResourceDictionary>"
-            << L"<ResourceDictionary x:Key='Dark'>" << content << L"</ResourceDictionary>"
-            << L"</ResourceDictionary.ThemeDictionaries>"
-            << L"</ResourceDictionary>";
-    xaml << L"<Setter Property='Resources'><Setter.Value>" << resDict.str()
-         << L"</Setter.Value></Setter>";
-  }
-
-  int64_t bg = GetStyleInt(style, "backgroundColor");
-  if (bg != 0) {
-    xaml << L"<Setter Property='Background' "
-         << L"Value='" << ColorToXamlString(bg) << L"'/>";
-  }
-
-  int64_t fg = GetStyleInt(style, "textColor");
-  if (fg != 0) {
-    xaml << L"<Setter Property='Foreground' "
-         << L"Value='" << ColorToXamlString(fg) << L"'/>";
-  }
-
-  double fontSize = GetStyleDouble(style, "fontSize");
-  if (fontSize > 0) {
-    xaml << L"<Setter Property='FontSize' Value='" << fontSize << L"'/>";
-  }
-
-  std::string fontFamily = GetStyleString(style, "fontFamily");
-  if (!fontFamily.empty()) {
-    std::wstring wfont = XamlEscapeAttribute(Utf8ToWide(fontFamily));
-    xaml << L"<Setter Property='FontFamily' Value='" << wfont << L"'/>";
-  }
-
-  int64_t fontWeight = GetStyleInt(style, "fontWeight");
-  if (fontWeight > 0) {
-    xaml << L"<Setter Property='FontWeight' Value='" << fontWeight << L"'/>";
-  }
-
-  auto cr_it = style.find(flutter::EncodableValue("cornerRadius"));
-  if (cr_it != style.end()) {
-    double cornerRadius = GetStyleDouble(style, "cornerRadius");
-    xaml << L"<Setter Property='CornerRadius' Value='" << cornerRadius << L"'/>";
-  }
-
-  auto pad_it = style.find(flutter::EncodableValue("padding"));
-  if (pad_it != style.end()) {
-    const auto* pad_map = std::get_if<flutter::EncodableMap>(&pad_it->second);
-    if (pad_map) {
-      auto get_d = [&](const char* k) {
-        auto vit = pad_map->find(flutter::EncodableValue(k));
-        if (vit == pad_map->end()) return 0.0;
-        const auto* vd = std::get_if<double>(&vit->second);
-        if (vd) return *vd;
-        const auto* vi = std::get_if<int32_t>(&vit->second);
-        if (vi) return static_cast<double>(*vi);
-        return 0.0;
-      };
-      double left = get_d("left"), top = get_d("top"),
-             right = get_d("right"), bottom = get_d("bottom");
-      xaml << L"<Setter Property='Padding' Value='"
-           << left << L"," << top << L"," << right << L"," << bottom << L"'/>";
-    }
-  }
-
-  double minWidth = GetStyleDouble(style, "minWidth");
-  if (minWidth > 0) {
-    xaml << L"<Setter Property='MinWidth' Value='" << minWidth << L"'/>";
-  }
-
-  std::string themeMode = GetStyleString(style, "themeMode");
-  if (themeMode == "light") {
-    xaml << L"<Setter Property='RequestedTheme' Value='Light'/>";
-  } else if (themeMode == "dark") {
-    xaml << L"<Setter Property='RequestedTheme' Value='Dark'/>";
-  }
-
-  int64_t borderColor = GetStyleInt(style, "borderColor");
-  if (borderColor != 0) {
-    xaml << L"<Setter Property='BorderBrush' Value='"
-         << ColorToXamlString(borderColor) << L"'/>";
-  }
-
-  double borderThickness = GetStyleDouble(style, "borderThickness");
-  if (borderThickness > 0) {
-    xaml << L"<Setter Property='BorderThickness' Value='"
-         << borderThickness << L"'/>";
-  }
-
-  std::string fontStyle = GetStyleString(style, "fontStyle");
-  if (fontStyle == "italic") {
-    xaml << L"<Setter Property='FontStyle' Value='Italic'/>";
-  } else if (fontStyle == "normal") {
-    xaml << L"<Setter Property='FontStyle' Value='Normal'/>";
-  }
-
-  auto shadowIt = style.find(flutter::EncodableValue("shadowElevation"));
-  if (shadowIt != style.end()) {
-    double shadowElevation = GetStyleDouble(style, "shadowElevation");
-    if (shadowElevation <= 0) {
-      xaml << L"<Setter Property='IsDefaultShadowEnabled' Value='False'/>";
-    }
-  }
-
-  double maxHeight = GetStyleDouble(style, "maxHeight");
-  if (maxHeight > 0) {
-    xaml << L"<Setter Property='MaxHeight' Value='" << maxHeight << L"'/>";
-  }
-
-  xaml << L"</Style>";
+// Parses the MenuFlyoutPresenter style. Returns null style if the style is
+// empty or the XAML fails to load.
+Style CreatePresenterStyle(const ResolvedStyle& style) {
+  ScopedSpan span("CreatePresenterStyle");
+  std::wstring xaml = BuildPresenterStyleXaml(style, Utf8ToWide);
+  if (xaml.empty()) return nullptr;
 
   try {
-    auto styleObj = winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(
-        xaml.str()).as<Style>();
-    flyout.MenuFlyoutPresenterStyle(styleObj);
+    return winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(xaml)
+        .as<Style>();
   } catch (const winrt::hresult_error& e) {
-    DebugLog(L"Failed to apply MenuFlyoutPresenterStyle", e.code());
+    DebugLog(L"Failed to create MenuFlyoutPresenterStyle", e.code());
   } catch (const std::exception&) {
-    DebugLog(L"Failed to apply MenuFlyoutPresenterStyle (std::exception)\n");
+    DebugLog(L"Failed to create MenuFlyoutPresenterStyle (std::exception)\n");
   }
+  return nullptr;
 }
 
 // Creates compact item styles (no icon column). Returns null style on failure.
@@ -693,237 +441,23 @@ struct CompactItemStyles {
   Style menuFlyoutSubItemStyle{nullptr};
 };
 
-CompactItemStyles CreateCompactItemStyles(const flutter::EncodableMap* style_map) {
+CompactItemStyles CreateCompactItemStyles(const ResolvedStyle& style) {
+  ScopedSpan span("CreateCompactItemStyles");
   CompactItemStyles result;
   try {
-    // MenuFlyoutItem: Match WinUI template structure. Root: Grid LayoutRoot with
-    // TemplateBinding Background. Inline-Hex for hoverBackgroundColor when set.
-    std::wstring mfiHoverValue =
-        L"{ThemeResource MenuFlyoutItemBackgroundPointerOver}";
-    if (style_map) {
-      int64_t h = GetStyleInt(*style_map, "hoverBackgroundColor");
-      if (h != 0) mfiHoverValue = ColorToXamlString(h);
-    }
-    std::wstring mfiXaml = L"<Style TargetType='MenuFlyoutItem' "
-        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
-        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
-        L"<Setter Property='Background' Value='Transparent'/>"
-        L"<Setter Property='Template'><Setter.Value>"
-        L"<ControlTemplate TargetType='MenuFlyoutItem'>"
-        L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
-        L"<TextBlock x:Name='Text' Text='{TemplateBinding Text}' "
-        L"VerticalAlignment='Center' Margin='10,0,10,0' "
-        L"Foreground='{TemplateBinding Foreground}'/>"
-        L"<VisualStateManager.VisualStateGroups>"
-        L"<VisualStateGroup x:Name='CommonStates'>"
-        L"<VisualState x:Name='Normal'/>"
-        L"<VisualState x:Name='PointerOver'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='LayoutRoot.Background' Value='";
-    mfiXaml += mfiHoverValue;
-    mfiXaml += L"'/>"
-        L"</VisualState.Setters></VisualState>"
-        L"<VisualState x:Name='Pressed'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='LayoutRoot.Background' Value='";
-    mfiXaml += mfiHoverValue;
-    mfiXaml += L"'/>"
-        L"</VisualState.Setters></VisualState>"
-        L"<VisualState x:Name='Disabled'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='Text.Foreground' Value='{ThemeResource MenuFlyoutItemForegroundDisabled}'/>"
-        L"</VisualState.Setters></VisualState>"
-        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
-        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
-    result.menuFlyoutItemStyle =
-        winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(mfiXaml).as<Style>();
-
-    // ToggleMenuFlyoutItem: Two variants. If checkedIndicatorColor set: thin
-    // colored stripe left (4px). Else: checkmark on far right like SubItem Chevron.
-    int64_t stripeColor =
-        style_map ? GetStyleInt(*style_map, "checkedIndicatorColor") : 0;
-    bool useStripe = (stripeColor != 0);
-    std::wstring tmiHoverValue =
-        L"{ThemeResource ToggleMenuFlyoutItemBackgroundPointerOver}";
-    if (style_map) {
-      int64_t h = GetStyleInt(*style_map, "hoverBackgroundColor");
-      if (h != 0) tmiHoverValue = ColorToXamlString(h);
-    }
-    std::wstring tmiXaml;
-    if (useStripe) {
-      std::wstring stripeColorStr = ColorToXamlString(stripeColor);
-      tmiXaml = L"<Style TargetType='ToggleMenuFlyoutItem' "
-          L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
-          L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
-          L"<Setter Property='Background' Value='Transparent'/>"
-          L"<Setter Property='Padding' Value='0,0,0,0'/>"
-          L"<Setter Property='Template'><Setter.Value>"
-          L"<ControlTemplate TargetType='ToggleMenuFlyoutItem'>"
-          L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
-          L"<TextBlock x:Name='TextBlock' Text='{TemplateBinding Text}' "
-          L"VerticalAlignment='Center' Margin='10,0,10,0' "
-          L"Foreground='{TemplateBinding Foreground}'/>"
-          L"<Border x:Name='CheckStripe' Width='4' HorizontalAlignment='Left' "
-          L"VerticalAlignment='Stretch' Opacity='0' Background='";
-      tmiXaml += stripeColorStr;
-      tmiXaml += L"'/>"
-          L"<VisualStateManager.VisualStateGroups>"
-          L"<VisualStateGroup x:Name='CommonStates'>"
-          L"<VisualState x:Name='Normal'/>"
-          L"<VisualState x:Name='PointerOver'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='LayoutRoot.Background' Value='";
-      tmiXaml += tmiHoverValue;
-      tmiXaml += L"'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"<VisualState x:Name='Pressed'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='LayoutRoot.Background' Value='";
-      tmiXaml += tmiHoverValue;
-      tmiXaml += L"'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"<VisualState x:Name='Disabled'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemForegroundDisabled}'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"</VisualStateGroup>"
-          L"<VisualStateGroup x:Name='CheckStates'>"
-          L"<VisualState x:Name='Unchecked'/>"
-          L"<VisualState x:Name='Checked'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='CheckStripe.Opacity' Value='1'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
-          L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
-    } else {
-      tmiXaml = L"<Style TargetType='ToggleMenuFlyoutItem' "
-          L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
-          L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
-          L"<Setter Property='Background' Value='Transparent'/>"
-          L"<Setter Property='Template'><Setter.Value>"
-          L"<ControlTemplate TargetType='ToggleMenuFlyoutItem'>"
-          L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
-          L"<Grid.ColumnDefinitions>"
-          L"<ColumnDefinition Width='*'/><ColumnDefinition Width='Auto'/>"
-          L"</Grid.ColumnDefinitions>"
-          L"<TextBlock x:Name='TextBlock' Grid.Column='0' Text='{TemplateBinding Text}' "
-          L"VerticalAlignment='Center' Margin='10,0,4,0' "
-          L"Foreground='{TemplateBinding Foreground}'/>"
-          L"<FontIcon x:Name='CheckGlyph' Grid.Column='1' Glyph='&#xE73E;' Opacity='0' "
-          L"FontSize='10' VerticalAlignment='Center' Margin='0,0,4,0' "
-          L"Foreground='{TemplateBinding Foreground}'/>"
-          L"<VisualStateManager.VisualStateGroups>"
-          L"<VisualStateGroup x:Name='CommonStates'>"
-          L"<VisualState x:Name='Normal'/>"
-          L"<VisualState x:Name='PointerOver'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='LayoutRoot.Background' Value='";
-      tmiXaml += tmiHoverValue;
-      tmiXaml += L"'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"<VisualState x:Name='Pressed'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='LayoutRoot.Background' Value='";
-      tmiXaml += tmiHoverValue;
-      tmiXaml += L"'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"<VisualState x:Name='Disabled'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemForegroundDisabled}'/>"
-          L"<Setter Target='CheckGlyph.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemCheckGlyphForegroundDisabled}'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"</VisualStateGroup>"
-          L"<VisualStateGroup x:Name='CheckStates'>"
-          L"<VisualState x:Name='Unchecked'/>"
-          L"<VisualState x:Name='Checked'>"
-          L"<VisualState.Setters>"
-          L"<Setter Target='CheckGlyph.Opacity' Value='1'/>"
-          L"</VisualState.Setters></VisualState>"
-          L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
-          L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
-    }
-    result.toggleMenuFlyoutItemStyle =
-        winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(tmiXaml).as<Style>();
-
     // NOTE: RadioMenuFlyoutItem compact style removed. Radio items are now
     // rendered as ToggleMenuFlyoutItem (reusing toggleMenuFlyoutItemStyle)
     // because RadioMenuFlyoutItem crashes in DesktopWindowXamlSource contexts.
-
-    // MenuFlyoutSubItem: Match WinUI default template structure for VisualState
-    // compatibility. Root: Grid LayoutRoot with TemplateBinding Background.
-    // SubMenuOpened must be in CommonStates (not SubMenuOpenedStates).
-    // Element names: TextBlock, SubItemChevron. Chevron glyph E974.
-    std::wstring hoverValue = L"{ThemeResource MenuFlyoutSubItemBackgroundPointerOver}";
-    std::wstring subMenuBgValue =
-        L"{ThemeResource MenuFlyoutSubItemBackgroundSubMenuOpened}";
-    std::wstring subMenuFgValue;
-    bool useSubMenuFg = false;
-    if (style_map) {
-      int64_t h = GetStyleInt(*style_map, "hoverBackgroundColor");
-      if (h != 0) hoverValue = ColorToXamlString(h);
-      int64_t sb = GetStyleInt(*style_map, "subMenuOpenedBackgroundColor");
-      if (sb != 0) subMenuBgValue = ColorToXamlString(sb);
-      int64_t sf = GetStyleInt(*style_map, "subMenuOpenedTextColor");
-      if (sf != 0) {
-        subMenuFgValue = ColorToXamlString(sf);
-        useSubMenuFg = true;
-      }
-    }
-    std::wstring msiXaml = L"<Style TargetType='MenuFlyoutSubItem' "
-        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
-        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
-        L"<Setter Property='Background' Value='Transparent'/>"
-        L"<Setter Property='Template'><Setter.Value>"
-        L"<ControlTemplate TargetType='MenuFlyoutSubItem'>"
-        L"<Grid x:Name='LayoutRoot' Padding='0,0,0,0' "
-        L"Background='{TemplateBinding Background}'>"
-        L"<Grid.ColumnDefinitions>"
-        L"<ColumnDefinition Width='*'/><ColumnDefinition Width='Auto'/>"
-        L"</Grid.ColumnDefinitions>"
-        L"<TextBlock x:Name='TextBlock' Grid.Column='0' Text='{TemplateBinding Text}' "
-        L"VerticalAlignment='Center' Margin='10,0,4,0' "
-        L"Foreground='{TemplateBinding Foreground}'/>"
-        L"<FontIcon x:Name='SubItemChevron' Grid.Column='1' Glyph='&#xE974;' FontSize='12' "
-        L"VerticalAlignment='Center' Margin='0,0,4,0' "
-        L"Foreground='{TemplateBinding Foreground}'/>"
-        L"<VisualStateManager.VisualStateGroups>"
-        L"<VisualStateGroup x:Name='CommonStates'>"
-        L"<VisualState x:Name='Normal'/>"
-        L"<VisualState x:Name='PointerOver'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='LayoutRoot.Background' Value='";
-    msiXaml += hoverValue;
-    msiXaml += L"'/>"
-        L"</VisualState.Setters></VisualState>"
-        L"<VisualState x:Name='Pressed'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='LayoutRoot.Background' Value='";
-    msiXaml += hoverValue;
-    msiXaml += L"'/>"
-        L"</VisualState.Setters></VisualState>"
-        L"<VisualState x:Name='SubMenuOpened'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='LayoutRoot.Background' Value='";
-    msiXaml += subMenuBgValue;
-    msiXaml += L"'/>";
-    if (useSubMenuFg) {
-      msiXaml += L"<Setter Target='TextBlock.Foreground' Value='";
-      msiXaml += subMenuFgValue;
-      msiXaml += L"'/>"
-          L"<Setter Target='SubItemChevron.Foreground' Value='";
-      msiXaml += subMenuFgValue;
-      msiXaml += L"'/>";
-    }
-    msiXaml += L"</VisualState.Setters></VisualState>"
-        L"<VisualState x:Name='Disabled'>"
-        L"<VisualState.Setters>"
-        L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource MenuFlyoutSubItemForegroundDisabled}'/>"
-        L"<Setter Target='SubItemChevron.Foreground' Value='{ThemeResource MenuFlyoutSubItemChevronDisabled}'/>"
-        L"</VisualState.Setters></VisualState>"
-        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
-        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
+    CompactItemStylesXaml xaml = BuildCompactItemStylesXaml(style);
+    result.menuFlyoutItemStyle =
+        winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(
+            xaml.menu_flyout_item).as<Style>();
+    result.toggleMenuFlyoutItemStyle =
+        winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(
+            xaml.toggle_menu_flyout_item).as<Style>();
     result.menuFlyoutSubItemStyle =
-        winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(msiXaml).as<Style>();
+        winrt::Microsoft::UI::Xaml::Markup::XamlReader::Load(
+            xaml.menu_flyout_sub_item).as<Style>();
   } catch (const winrt::hresult_error& e) {
     DebugLog(L"Failed to create compact item styles", e.code());
   } catch (const std::exception&) {
@@ -932,276 +466,119 @@ CompactItemStyles CreateCompactItemStyles(const flutter::EncodableMap* style_map
   return result;
 }
 
-// Applies common per-item styling (fontSize, itemHeight, foreground).
-void ApplyItemStyling(MenuFlyoutItemBase const& itemBase,
-                      const flutter::EncodableMap& style_map,
-                      bool disabled) {
-  double fs = GetStyleDouble(style_map, "fontSize");
-  double itemH = GetStyleDouble(style_map, "itemHeight");
-  Brush fg = disabled && GetStyleInt(style_map, "disabledTextColor") != 0
-                 ? CreateBrushFromStyleInt(style_map, "disabledTextColor")
-                 : CreateBrushFromStyleInt(style_map, "textColor");
-
-  if (auto mfi = itemBase.try_as<MenuFlyoutItem>()) {
-    if (fs > 0) mfi.FontSize(fs);
-    if (itemH > 0) mfi.MinHeight(itemH);
-    if (fg) mfi.Foreground(fg);
-  } else if (auto sub = itemBase.try_as<MenuFlyoutSubItem>()) {
-    if (fs > 0) sub.FontSize(fs);
-    if (itemH > 0) sub.MinHeight(itemH);
-    if (fg) sub.Foreground(fg);
+// Parsed XAML styles for one style, shared by every show whose style has
+// the same fingerprint. Style objects are sealed on first use and may be
+// applied to any number of flyouts and items.
+struct CompiledStyles {
+  Style presenterStyle{nullptr};
+  CompactItemStyles compactStyles;
+};
+
+// Enough for the styles of every registered menu an app switches between
+// (see menu_registry.h); the least recently shown is dropped first.
+constexpr size_t kMaxCompiledStyles = 32;
+
+struct CompiledStyleCache {
+  using Entry = std::pair<uint64_t, std::shared_ptr<const CompiledStyles>>;
+  // Most recently used first.
+  std::list<Entry> order;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
+
+// XAML objects are thread-affine; only the DispatcherQueue (XAML) thread
+// compiles and reads styles.
+CompiledStyleCache& GetCompiledStyleCache() {
+  thread_local CompiledStyleCache cache;
+  return cache;
+}
+
+// Returns the parsed styles for style, running the XamlReader parses only
+// the first time a fingerprint is seen.
+std::shared_ptr<const CompiledStyles> GetOrCompileStyles(
+    const ResolvedStyle& style) {
+  auto& cache = GetCompiledStyleCache();
+  const uint64_t fingerprint = style.fingerprint;
+  auto it = cache.index.find(fingerprint);
+  if (it != cache.index.end()) {
+    cache.order.splice(cache.order.begin(), cache.order, it->second);
+    return it->second->second;
+  }
+
+  auto compiled = std::make_shared<CompiledStyles>();
+  compiled->presenterStyle = CreatePresenterStyle(style);
+  if (style.compact_item_layout) {
+    compiled->compactStyles = CreateCompactItemStyles(style);
   }
+  if (cache.index.size() >= kMaxCompiledStyles) {
+    cache.index.erase(cache.order.back().first);
+    cache.order.pop_back();
+  }
+  cache.order.emplace_front(fingerprint, compiled);
+  cache.index.emplace(fingerprint, cache.order.begin());
+  return compiled;
 }
 
-void AddMenuItemsToCollection(
-    const winrt::Windows::Foundation::Collections::IVector<
-        winrt::Microsoft::UI::Xaml::Controls::MenuFlyoutItemBase>& collection,
-    const flutter::EncodableList& items,
-    flutter::MethodChannel<flutter::EncodableValue>* channel,
-    const flutter::EncodableMap* style_map,
-    const CompactItemStyles* compact_styles,
-    std::shared_ptr<bool> cancelCloseForToggleClick = nullptr) {
-  for (const auto& item_val : items) {
-    const auto* item_map = std::get_if<flutter::EncodableMap>(&item_val);
-    if (!item_map) continue;
-
-    auto get_str = [&](const char* key) -> std::string {
-      auto it = item_map->find(flutter::EncodableValue(key));
-      if (it == item_map->end()) return "";
-      const auto* s = std::get_if<std::string>(&it->second);
-      return s ? *s : "";
-    };
-    auto get_int = [&](const char* key) -> int {
-      auto it = item_map->find(flutter::EncodableValue(key));
-      if (it == item_map->end()) return 0;
-      const auto* i = std::get_if<int>(&it->second);
-      return i ? *i : 0;
-    };
-    auto get_bool = [&](const char* key) -> bool {
-      auto it = item_map->find(flutter::EncodableValue(key));
-      if (it == item_map->end()) return false;
-      const auto* b = std::get_if<bool>(&it->second);
-      return b ? *b : false;
-    };
+LRESULT CALLBACK MenuHostWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-    std::string type = get_str("type");
-    int id = get_int("id");
-    std::string label = get_str("label");
-    bool disabled = get_bool("disabled");
-    std::string iconStr = get_str("icon");
-    std::string iconFontFamily = get_str("iconFontFamily");
-    std::string acceleratorText = get_str("acceleratorText");
-    std::string toolTipStr = get_str("toolTip");
-    Brush iconColorBrush = style_map
-        ? CreateBrushFromStyleInt(*style_map, "iconColor") : nullptr;
-
-    if (type == "separator") {
-      MenuFlyoutSeparator sep;
-      if (style_map) {
-        Brush sepBrush = CreateBrushFromStyleInt(*style_map, "separatorColor");
-        if (sepBrush) sep.Background(sepBrush);
-      }
-      collection.Append(sep);
-    } else if (type == "submenu") {
-      MenuFlyoutSubItem sub;
-      sub.Text(winrt::hstring(Utf8ToWide(label)));
-      sub.IsEnabled(!disabled);
-      auto sub_it = item_map->find(flutter::EncodableValue("submenu"));
-      if (sub_it != item_map->end()) {
-        const auto* sub_map = std::get_if<flutter::EncodableMap>(&sub_it->second);
-        if (sub_map) {
-          auto sub_items_it = sub_map->find(flutter::EncodableValue("items"));
-          if (sub_items_it != sub_map->end()) {
-            const auto* sub_items = std::get_if<flutter::EncodableList>(&sub_items_it->second);
-            if (sub_items) {
-              AddMenuItemsToCollection(sub.Items(), *sub_items, channel, style_map,
-                                      compact_styles, cancelCloseForToggleClick);
-            }
-          }
-        }
-      }
-      if (compact_styles && compact_styles->menuFlyoutSubItemStyle) {
-        sub.Style(compact_styles->menuFlyoutSubItemStyle);
-      } else if (!iconStr.empty()) {
-        auto iconElem = CreateIconFromString(iconStr, iconFontFamily, iconColorBrush);
-        if (iconElem) sub.Icon(iconElem);
-      }
-      if (!toolTipStr.empty()) {
-        ToolTipService::SetToolTip(sub,
-            winrt::box_value(winrt::hstring(Utf8ToWide(toolTipStr))));
-      }
-      if (style_map) ApplyItemStyling(sub, *style_map, disabled);
-      collection.Append(sub);
-
-    } else if (type == "checkbox") {
-      ToggleMenuFlyoutItem toggle;
-      toggle.Text(winrt::hstring(Utf8ToWide(label)));
-      toggle.IsEnabled(!disabled);
-      auto checked_it = item_map->find(flutter::EncodableValue("checked"));
-      if (checked_it != item_map->end()) {
-        const auto* b = std::get_if<bool>(&checked_it->second);
-        toggle.IsChecked(b && *b);
-      }
-      toggle.Click([channel, id, cancelCloseForToggleClick](auto&&, auto&&) {
-        if (cancelCloseForToggleClick) *cancelCloseForToggleClick = true;
-        flutter::EncodableMap args;
-        args[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
-        InvokeOnPlatformThread(channel, "onMenuItemClick",
-                               flutter::EncodableValue(std::move(args)));
-      });
-      if (compact_styles && compact_styles->toggleMenuFlyoutItemStyle) {
-        toggle.Style(compact_styles->toggleMenuFlyoutItemStyle);
-      } else if (!iconStr.empty()) {
-        auto iconElem = CreateIconFromString(iconStr, iconFontFamily, iconColorBrush);
-        if (iconElem) toggle.Icon(iconElem);
-      }
-      if (!toolTipStr.empty()) {
-        ToolTipService::SetToolTip(toggle,
-            winrt::box_value(winrt::hstring(Utf8ToWide(toolTipStr))));
-      }
-      if (style_map) ApplyItemStyling(toggle, *style_map, disabled);
-      collection.Append(toggle);
-
-    } else if (type == "split") {
-      // WinUI 3 does not expose SplitMenuFlyoutItem in the current Windows App
-      // SDK. Render split entries as submenus so the menu remains usable.
-      MenuFlyoutSubItem split;
-      split.Text(winrt::hstring(Utf8ToWide(label)));
-      split.IsEnabled(!disabled);
-      auto sub_it = item_map->find(flutter::EncodableValue("submenu"));
-      if (sub_it != item_map->end()) {
-        const auto* sub_map = std::get_if<flutter::EncodableMap>(&sub_it->second);
-        if (sub_map) {
-          auto sub_items_it = sub_map->find(flutter::EncodableValue("items"));
-          if (sub_items_it != sub_map->end()) {
-            const auto* sub_items = std::get_if<flutter::EncodableList>(&sub_items_it->second);
-            if (sub_items) {
-              AddMenuItemsToCollection(split.Items(), *sub_items, channel, style_map,
-                                      compact_styles, cancelCloseForToggleClick);
-            }
-          }
-        }
-      }
-      if (!iconStr.empty()) {
-        auto iconElem = CreateIconFromString(iconStr, iconFontFamily, iconColorBrush);
-        if (iconElem) split.Icon(iconElem);
-      }
-      if (!toolTipStr.empty()) {
-        ToolTipService::SetToolTip(split,
-            winrt::box_value(winrt::hstring(Utf8ToWide(toolTipStr))));
-      }
-      if (style_map) ApplyItemStyling(split, *style_map, disabled);
-      collection.Append(split);
-
-    } else if (type == "radio") {
-      // RadioMenuFlyoutItem crashes when rendered inside a SubMenu hosted in a
-      // DesktopWindowXamlSource (Xaml Islands) context – the crash happens at
-      // SubMenu-open time, not at item creation, so try/catch doesn't help.
-      // Use ToggleMenuFlyoutItem as a reliable substitute.
-      std::string groupName = get_str("radioGroup");
-      bool isChecked = false;
-      auto checked_it = item_map->find(flutter::EncodableValue("checked"));
-      if (checked_it != item_map->end()) {
-        const auto* b = std::get_if<bool>(&checked_it->second);
-        isChecked = (b && *b);
-      }
-      {
-        ToggleMenuFlyoutItem radio;
-        radio.Text(winrt::hstring(Utf8ToWide(label)));
-        radio.IsEnabled(!disabled);
-        radio.IsChecked(isChecked);
-        radio.Click([channel, id, cancelCloseForToggleClick](auto&&, auto&&) {
-          if (cancelCloseForToggleClick) *cancelCloseForToggleClick = true;
-          flutter::EncodableMap args;
-          args[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
-          InvokeOnPlatformThread(channel, "onMenuItemClick",
-                                 flutter::EncodableValue(std::move(args)));
-        });
-        if (compact_styles && compact_styles->toggleMenuFlyoutItemStyle) {
-          radio.Style(compact_styles->toggleMenuFlyoutItemStyle);
-        } else if (!iconStr.empty()) {
-          auto iconElem = CreateIconFromString(iconStr, iconFontFamily, iconColorBrush);
-          if (iconElem) radio.Icon(iconElem);
-        }
-        if (!acceleratorText.empty()) {
-          radio.KeyboardAcceleratorTextOverride(
-              winrt::hstring(Utf8ToWide(acceleratorText)));
-        }
-        if (!toolTipStr.empty()) {
-          ToolTipService::SetToolTip(radio,
-              winrt::box_value(winrt::hstring(Utf8ToWide(toolTipStr))));
-        }
-        if (style_map) ApplyItemStyling(radio, *style_map, disabled);
-        collection.Append(radio);
-      }
+// Forwards menu events to Dart over the method channel.
+class ChannelMenuEventSink : public MenuEventSink {
+ public:
+  flutter::MethodChannel<flutter::EncodableValue>* channel() const {
+    return channel_;
+  }
+  void set_channel(flutter::MethodChannel<flutter::EncodableValue>* channel) {
+    channel_ = channel;
+  }
 
-    } else {
-      MenuFlyoutItem item;
-      item.Text(winrt::hstring(Utf8ToWide(label)));
-      item.IsEnabled(!disabled);
-      item.Click([channel, id](auto&&, auto&&) {
-        flutter::EncodableMap args;
-        args[flutter::EncodableValue("id")] = flutter::EncodableValue(id);
-        InvokeOnPlatformThread(channel, "onMenuItemClick",
-                               flutter::EncodableValue(std::move(args)));
-      });
-      if (compact_styles && compact_styles->menuFlyoutItemStyle) {
-        item.Style(compact_styles->menuFlyoutItemStyle);
-      } else if (!iconStr.empty()) {
-        auto iconElem = CreateIconFromString(iconStr, iconFontFamily, iconColorBrush);
-        if (iconElem) item.Icon(iconElem);
-      }
-      if (!acceleratorText.empty()) {
-        item.KeyboardAcceleratorTextOverride(
-            winrt::hstring(Utf8ToWide(acceleratorText)));
-      }
-      if (!toolTipStr.empty()) {
-        ToolTipService::SetToolTip(item,
-            winrt::box_value(winrt::hstring(Utf8ToWide(toolTipStr))));
-      }
-      if (style_map) ApplyItemStyling(item, *style_map, disabled);
-      collection.Append(item);
-    }
+  void OnMenuItemClick(const MenuClick& click) override {
+    QueueMenuEvent(channel_, MakeClickEvent(click));
+  }
+  void OnMenuOpening() override {
+    QueueMenuEvent(channel_, {MenuEventType::kOpening});
+  }
+  void OnMenuClosing() override {
+    QueueMenuEvent(channel_, {MenuEventType::kClosing});
+  }
+  void OnMenuClosed() override {
+    QueueMenuEvent(channel_, {MenuEventType::kClosed});
   }
-}
 
-void ShowMenuOnWinUIThread(
-    const flutter::EncodableMap& menu_json,
-    const flutter::EncodableMap& style_json,
-    flutter::MethodChannel<flutter::EncodableValue>* channel,
-    std::optional<double> pos_x,
-    std::optional<double> pos_y,
-    std::optional<std::string> placement,
-    std::optional<flutter::EncodableMap> exclusion_rect) {
-  auto& state = GetWinUIState();
-  if (!state.queue) return;
+ private:
+  flutter::MethodChannel<flutter::EncodableValue>* channel_ = nullptr;
+};
 
-  bool expected = false;
-  if (!state.menu_showing.compare_exchange_strong(expected, true)) {
-    return;
+// Pooled host: one hidden tool window with a XAML island and a MenuFlyout,
+// kept alive between shows and driven by MenuHostPool. Lives on the XAML
+// thread; event handlers capture `this`, which outlives every XAML object it
+// owns. Which items to create and which properties to set is decided by
+// MenuWidgetBackend; the Set* overrides map that onto XAML controls.
+class WinUIMenuHostBackend : public MenuWidgetBackend {
+ public:
+  flutter::MethodChannel<flutter::EncodableValue>* channel() const {
+    return events_.channel();
+  }
+  void set_channel(flutter::MethodChannel<flutter::EncodableValue>* channel) {
+    events_.set_channel(channel);
   }
+  void set_show_requested(uint64_t ticks) { show_requested_ = ticks; }
+  // ShowScheduler id of the show this host runs; its outcome is reported
+  // with OnOpened and OnClosed.
+  void set_show_id(uint64_t id) { show_id_ = id; }
 
-  flutter::EncodableMap menu_copy = menu_json;
-  flutter::EncodableMap style_copy = style_json;
-  state.queue.TryEnqueue(DispatcherQueuePriority::Normal,
-                         [menu_copy, style_copy, channel, pos_x, pos_y,
-                          placement, exclusion_rect]() {
-    auto prevDpiContext = SetThreadDpiAwarenessContext(
-        DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+  // The show failed, closed, or its host went away. Harmless if already
+  // reported.
+  void ReportShowClosed();
 
-    POINT pt;
-    if (pos_x.has_value() && pos_y.has_value()) {
-      pt.x = static_cast<LONG>(*pos_x);
-      pt.y = static_cast<LONG>(*pos_y);
-    } else {
-      GetCursorPos(&pt);
-    }
+  // Closes the show for a newer request: hides the flyout (Closed reports
+  // it) or, if it is still waiting for Loaded, drops it right away.
+  void CloseShow(uint64_t id);
 
+  bool CreateHost() override {
     static const wchar_t* kMenuHostClass = L"TrayWinUIMenuHost";
     static bool class_registered = false;
     if (!class_registered) {
       WNDCLASSW wc = {};
-      wc.lpfnWndProc = DefWindowProcW;
+      wc.lpfnWndProc = MenuHostWndProc;
       wc.hInstance = GetModuleHandle(nullptr);
       wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
       wc.lpszClassName = kMenuHostClass;
@@ -1209,108 +586,182 @@ void ShowMenuOnWinUIThread(
       class_registered = true;
     }
 
-    HWND hwnd = CreateWindowExW(
-        WS_EX_TOOLWINDOW | WS_EX_TOPMOST, kMenuHostClass, L"",
-        WS_POPUP, pt.x, pt.y, 1, 1,
-        nullptr, nullptr, GetModuleHandle(nullptr), nullptr);
-
+    auto prevDpiContext = SetThreadDpiAwarenessContext(
+        DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+    {
+      ScopedSpan span("CreateWindowExW");
+      hwnd_ = CreateWindowExW(
+          WS_EX_TOOLWINDOW | WS_EX_TOPMOST, kMenuHostClass, L"",
+          WS_POPUP, 0, 0, 1, 1,
+          nullptr, nullptr, GetModuleHandle(nullptr), nullptr);
+    }
     if (prevDpiContext) {
       SetThreadDpiAwarenessContext(prevDpiContext);
     }
+    if (!hwnd_) return false;
+    SetWindowLongPtr(hwnd_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
 
-    if (!hwnd) {
-      GetWinUIState().menu_showing.store(false);
-      return;
-    }
-
-    InstallCursorHook();
+    try {
+      // Use Initialize(WindowId) instead of deprecated IDesktopWindowXamlSourceNative::AttachToWindow
+      // (E_NOINTERFACE in unpackaged Win32 apps - WindowsAppSDK #3978)
+      {
+        ScopedSpan span("DesktopWindowXamlSource::Initialize");
+        xaml_source_ = DesktopWindowXamlSource();
+        xaml_source_.Initialize(
+            winrt::Microsoft::UI::GetWindowIdFromWindow(hwnd_));
+      }
 
-    ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+      canvas_ = Canvas();
+      canvas_.Width(1);
+      canvas_.Height(1);
+      // ShowAt only after Loaded: ensures XAML visual tree is ready
+      // (microsoft-ui-xaml#7989). The canvas stays loaded while the host is
+      // hidden, so later shows open the flyout right away.
+      canvas_.Loaded([this](auto&&, auto&&) {
+        canvas_loaded_ = true;
+        GetSpanTrace().Record("Show to canvas.Loaded", show_called_,
+                              SpanTrace::Now());
+        if (show_pending_ && !ShowAtAnchor()) AbandonHost();
+      });
+      xaml_source_.Content(canvas_);
 
-    DebugLog(L"TrayWinUI: host window created\n");
+      // Allow MenuFlyout to overlay taskbar; default true constrains to work area
+      xaml_source_.ShouldConstrainPopupsToWorkArea(false);
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"XAML island setup failed", e.code());
+      return false;
+    }
+    DebugLog(L"TrayWinUI: host window and XAML island created\n");
+    return true;
+  }
 
+  void DestroyHost() override {
+    // Still waiting for Loaded. A host recovered by MenuHostPool::Show before
+    // it calls Show has nothing pending.
+    if (show_pending_) ReportShowClosed();
+    show_pending_ = false;
+    canvas_loaded_ = false;
     try {
-      // Use shared_ptr to keep XAML objects alive until flyout is closed.
-      // ShowAt() returns immediately; destroying canvas/flyout while menu is open causes abort().
-      auto holder = std::make_shared<MenuHolder>();
+      if (xaml_source_) xaml_source_.Close();
+    } catch (...) {}
+    xaml_source_ = nullptr;
+    canvas_ = nullptr;
+    if (hwnd_) {
+      HWND hwnd = hwnd_;
+      hwnd_ = nullptr;
+      SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+      DestroyWindow(hwnd);
+    }
+  }
 
-      // Use Initialize(WindowId) instead of deprecated IDesktopWindowXamlSourceNative::AttachToWindow
-      // (E_NOINTERFACE in unpackaged Win32 apps - WindowsAppSDK #3978)
-      auto parentId = winrt::Microsoft::UI::GetWindowIdFromWindow(hwnd);
-      holder->xamlSource.Initialize(parentId);
+  bool IsHostAlive() const override { return hwnd_ != nullptr; }
 
-      DebugLog(L"TrayWinUI: XAML island initialized\n");
+  bool BuildItems(const CompiledMenu& menu) override {
+    ScopedSpan span("BuildItems");
+    try {
+      MenuWidgetBackend::BuildItems(menu);
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Building menu items failed", e.code());
+      return false;
+    }
+    return true;
+  }
 
-      holder->canvas.Width(1);
-      holder->canvas.Height(1);
-      holder->xamlSource.Content(holder->canvas);
+  bool UpdateItem(const CompiledMenu& previous, const CompiledMenu& menu,
+                  uint32_t index) override {
+    if (index >= items_.size()) return false;
+    try {
+      return MenuWidgetBackend::UpdateItem(previous, menu, index);
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Updating menu item failed", e.code());
+      return false;
+    }
+  }
 
-      // Allow MenuFlyout to overlay taskbar; default true constrains to work area
-      holder->xamlSource.ShouldConstrainPopupsToWorkArea(false);
-
-      bool use_compact = GetStyleBool(style_copy, "compactItemLayout", true);
-      const flutter::EncodableMap* style_ptr =
-          style_copy.empty() ? nullptr : &style_copy;
-      CompactItemStyles compact_styles;
-      if (use_compact) {
-        compact_styles = CreateCompactItemStyles(style_ptr);
-      }
-      auto cancelCloseForToggle = std::make_shared<bool>(false);
-      auto items_it = menu_copy.find(flutter::EncodableValue("items"));
-      if (items_it != menu_copy.end()) {
-        const auto* items = std::get_if<flutter::EncodableList>(&items_it->second);
-        if (items) {
-          AddMenuItemsToCollection(
-              holder->flyout.Items(), *items, channel, style_ptr,
-              use_compact ? &compact_styles : nullptr, cancelCloseForToggle);
+  bool Show(const MenuShowRequest& request) override {
+    POINT pt;
+    if (request.x.has_value() && request.y.has_value()) {
+      pt.x = static_cast<LONG>(*request.x);
+      pt.y = static_cast<LONG>(*request.y);
+    } else {
+      GetCursorPos(&pt);
+    }
+    exclusion_rect_ = request.exclusion_rect;
+
+    try {
+      FlyoutPlacementMode mode = default_placement_;
+      if (request.placement.has_value()) {
+        if (auto placement = ParseMenuPlacement(*request.placement)) {
+          mode = static_cast<FlyoutPlacementMode>(*placement);
         }
       }
+      flyout_.Placement(mode);
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Setting placement failed", e.code());
+      return false;
+    }
 
-      if (!style_copy.empty()) {
-        ApplyStyleToFlyout(holder->flyout, style_copy);
+    InstallCursorHook();
+    *cancel_close_for_toggle_ = false;
 
-        auto animIt = style_copy.find(flutter::EncodableValue("enableOpenCloseAnimations"));
-        if (animIt != style_copy.end()) {
-          const auto* b = std::get_if<bool>(&animIt->second);
-          if (b && !*b) {
-            holder->flyout.AreOpenCloseAnimationsEnabled(false);
-          }
-        }
-      }
+    auto prevDpiContext = SetThreadDpiAwarenessContext(
+        DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+    SetWindowPos(hwnd_, HWND_TOPMOST, pt.x, pt.y, 1, 1,
+                 SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    if (prevDpiContext) {
+      SetThreadDpiAwarenessContext(prevDpiContext);
+    }
+
+    show_pending_ = true;
+    show_called_ = SpanTrace::Now();
+    if (!canvas_loaded_) return true;  // Loaded opens the flyout.
+    return ShowAtAnchor();
+  }
+
+ protected:
+  bool CreateFlyoutWidget(const ResolvedStyle& style) override {
+    ScopedSpan span("CreateFlyoutWidget");
+    try {
+      compiled_styles_ = GetOrCompileStyles(style);
+      dismiss_on_move_ = style.dismiss_on_pointer_move_away;
+
+      flyout_ = MenuFlyout();
+      default_placement_ = flyout_.Placement();
 
-      if (placement.has_value()) {
-        FlyoutPlacementMode mode;
-        if (TryParsePlacement(*placement, mode)) {
-          holder->flyout.Placement(mode);
+      if (!style.empty()) {
+        if (compiled_styles_->presenterStyle) {
+          flyout_.MenuFlyoutPresenterStyle(compiled_styles_->presenterStyle);
+        }
+        if (!style.enable_open_close_animations) {
+          flyout_.AreOpenCloseAnimationsEnabled(false);
         }
       }
 
-      double shadowElevation = GetStyleDouble(style_copy, "shadowElevation");
-      std::string backdropType = GetStyleString(style_copy, "backdropType");
-
       // Apply SystemBackdrop on the FlyoutBase itself (not the presenter).
       // WinUI 3 supports FlyoutBase.SystemBackdrop since WinAppSDK 1.3+.
+      const std::string& backdropType = style.backdrop_type;
       if (!backdropType.empty()) {
         try {
           if (backdropType == "acrylic") {
-            holder->flyout.SystemBackdrop(
+            flyout_.SystemBackdrop(
                 winrt::Microsoft::UI::Xaml::Media::DesktopAcrylicBackdrop());
           } else if (backdropType == "mica") {
-            holder->flyout.SystemBackdrop(
+            flyout_.SystemBackdrop(
                 winrt::Microsoft::UI::Xaml::Media::MicaBackdrop());
           } else if (backdropType == "micaAlt") {
             auto mica = winrt::Microsoft::UI::Xaml::Media::MicaBackdrop();
             mica.Kind(winrt::Microsoft::UI::Composition::
                 SystemBackdrops::MicaKind::BaseAlt);
-            holder->flyout.SystemBackdrop(mica);
+            flyout_.SystemBackdrop(mica);
           }
         } catch (...) {}
       }
 
+      const double shadowElevation = style.shadow_elevation;
       if (shadowElevation > 0) {
-        holder->flyout.Opened([holder, shadowElevation](auto&&, auto&&) {
+        flyout_.Opened([this, shadowElevation](auto&&, auto&&) {
           try {
-            auto xamlRoot = holder->canvas.XamlRoot();
+            auto xamlRoot = canvas_.XamlRoot();
             if (!xamlRoot) return;
             winrt::Windows::Foundation::Collections::IVectorView<Popup> popups =
                 VisualTreeHelper::GetOpenPopupsForXamlRoot(xamlRoot);
@@ -1324,132 +775,595 @@ void ShowMenuOnWinUIThread(
         });
       }
 
-      bool useDismissOnMove = GetStyleBool(style_copy,
-          "dismissOnPointerMoveAway", false);
-      auto dismissTimer = std::make_shared<
-          winrt::Microsoft::UI::Dispatching::DispatcherQueueTimer>(nullptr);
-
-      if (useDismissOnMove) {
-        holder->flyout.Opened([holder, hwnd, dismissTimer](auto&&, auto&&) {
+      if (dismiss_on_move_) {
+        flyout_.Opened([this](auto&&, auto&&) {
           try {
-            auto& state = GetWinUIState();
-            *dismissTimer = state.queue.CreateTimer();
-            (*dismissTimer).Interval(std::chrono::milliseconds(150));
-            (*dismissTimer).Tick([holder, hwnd](auto&&, auto&&) {
+            dismiss_timer_ = XamlQueue().CreateTimer();
+            dismiss_timer_.Interval(std::chrono::milliseconds(150));
+            dismiss_timer_.Tick([this](auto&&, auto&&) {
               try {
+                if (!hwnd_ || !flyout_) return;
                 POINT cursorPt;
                 GetCursorPos(&cursorPt);
                 HWND underCursor = WindowFromPoint(cursorPt);
                 if (!underCursor) {
-                  holder->flyout.Hide();
+                  flyout_.Hide();
                   return;
                 }
                 // Accept if cursor is over host window or any of its children
                 // (popup windows are owned by the host hwnd's thread).
-                if (underCursor == hwnd || IsChild(hwnd, underCursor)) return;
-                DWORD hostTid = GetWindowThreadProcessId(hwnd, nullptr);
+                if (underCursor == hwnd_ || IsChild(hwnd_, underCursor)) return;
+                DWORD hostTid = GetWindowThreadProcessId(hwnd_, nullptr);
                 DWORD cursorTid = GetWindowThreadProcessId(underCursor, nullptr);
                 if (hostTid == cursorTid) return;
-                holder->flyout.Hide();
+                flyout_.Hide();
               } catch (...) {}
             });
-            (*dismissTimer).Start();
+            dismiss_timer_.Start();
           } catch (...) {}
         });
       }
 
-      holder->flyout.Opening([channel](auto&&, auto&&) {
-        InvokeOnPlatformThread(channel, "onMenuOpening");
+      flyout_.Opened([this](auto&&, auto&&) {
+        SpanTrace& trace = GetSpanTrace();
+        const uint64_t now = SpanTrace::Now();
+        trace.Record("ShowAt to Opened", show_at_called_, now);
+        trace.Record("Request to Opened", show_requested_, now);
+        GetWinUIState().shows.OnOpened(show_id_);
       });
-      holder->flyout.Closing([cancelCloseForToggle, channel](auto&&, auto&& args) {
-        if (*cancelCloseForToggle) {
+      flyout_.Opening([this](auto&&, auto&&) { events_.OnMenuOpening(); });
+      flyout_.Closing([this](auto&&, auto&& args) {
+        if (*cancel_close_for_toggle_) {
           args.Cancel(true);
-          *cancelCloseForToggle = false;
+          *cancel_close_for_toggle_ = false;
           return;
         }
-        InvokeOnPlatformThread(channel, "onMenuClosing");
-      });
-      holder->flyout.Closed([holder, hwnd, channel, dismissTimer](auto&&, auto&&) {
-        if (*dismissTimer) {
-          (*dismissTimer).Stop();
-          *dismissTimer = nullptr;
-        }
-        RemoveCursorHook();
-        InvokeOnPlatformThread(channel, "onMenuClosed");
-        PostMessage(hwnd, WM_CLOSE, 0, 0);
+        events_.OnMenuClosing();
       });
+      flyout_.Closed([this](auto&&, auto&&) { OnFlyoutClosed(); });
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Flyout setup failed", e.code());
+      return false;
+    }
+    return true;
+  }
 
-      // Subclass host window to close flyout when another app gets focus (WM_ACTIVATEAPP).
-      WNDPROC oldProc =
-          reinterpret_cast<WNDPROC>(GetWindowLongPtr(hwnd, GWLP_WNDPROC));
-      auto* hostData = new MenuHostData{oldProc, holder};
-      SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(hostData));
-      SetWindowLongPtr(hwnd, GWLP_WNDPROC,
-                      reinterpret_cast<LONG_PTR>(&MenuHostWndProc));
+  void DestroyFlyoutWidget() override {
+    StopDismissTimer();
+    items_.clear();
+    try {
+      if (flyout_) flyout_.Items().Clear();
+    } catch (...) {}
+    flyout_ = nullptr;
+    compiled_styles_.reset();
+  }
 
-      // ShowAt in Loaded: ensures XAML visual tree is ready (microsoft-ui-xaml#7989).
-      // SetForegroundWindow + PostMessage(WM_NULL) before ShowAt: workaround for tray menus (MS KB135788).
-      holder->canvas.Loaded([holder, hwnd, style_copy, exclusion_rect](auto&&, auto&&) {
-        try {
-          SetForegroundWindow(hwnd);
-          PostMessage(hwnd, WM_NULL, 0, 0);
-
-          auto opts =
-              winrt::Microsoft::UI::Xaml::Controls::Primitives::FlyoutShowOptions();
-          bool useDismissOnMove = GetStyleBool(style_copy,
-              "dismissOnPointerMoveAway", false);
-          opts.ShowMode(useDismissOnMove
-              ? FlyoutShowMode::TransientWithDismissOnPointerMoveAway
-              : FlyoutShowMode::Transient);
-          winrt::Windows::Foundation::Point pos(0.0f, 0.0f);
-          opts.Position(pos);
-          if (exclusion_rect.has_value()) {
-            const auto& er = *exclusion_rect;
-            auto get_d = [&](const char* k) -> double {
-              auto it = er.find(flutter::EncodableValue(k));
-              if (it == er.end()) return 0.0;
-              const auto* d = std::get_if<double>(&it->second);
-              if (d) return *d;
-              const auto* i = std::get_if<int32_t>(&it->second);
-              if (i) return static_cast<double>(*i);
-              return 0.0;
-            };
-            winrt::Windows::Foundation::Rect rect{
-                static_cast<float>(get_d("x")),
-                static_cast<float>(get_d("y")),
-                static_cast<float>(get_d("width")),
-                static_cast<float>(get_d("height"))};
-            opts.ExclusionRect(rect);
-          }
+  void ClearItems(size_t node_count) override {
+    flyout_.Items().Clear();
+    items_.assign(node_count, MenuFlyoutItemBase{nullptr});
+  }
+
+  void CreateItem(uint32_t index, MenuWidgetKind kind) override {
+    switch (kind) {
+      case MenuWidgetKind::kItem:
+        items_[index] = MenuFlyoutItem();
+        break;
+      case MenuWidgetKind::kToggle:
+        items_[index] = ToggleMenuFlyoutItem();
+        break;
+      case MenuWidgetKind::kSubItem:
+        items_[index] = MenuFlyoutSubItem();
+        break;
+      case MenuWidgetKind::kSeparator:
+        items_[index] = MenuFlyoutSeparator();
+        break;
+    }
+  }
 
-          DebugLog(L"TrayWinUI: calling ShowAt\n");
+  void AppendItem(uint32_t parent, uint32_t index) override {
+    ItemsOf(parent).Append(items_[index]);
+  }
+
+  void InsertItem(uint32_t parent, uint32_t position,
+                  uint32_t index) override {
+    ItemsOf(parent).InsertAt(position, items_[index]);
+  }
+
+  void RemoveItem(uint32_t parent, uint32_t position) override {
+    ItemsOf(parent).RemoveAt(position);
+  }
+
+  void ReleaseItem(uint32_t index) override {
+    // Page items are only referenced by their sub item's Items().
+    items_[index] = nullptr;
+  }
 
-          holder->flyout.ShowAt(holder->canvas, opts);
+  // MenuFlyoutPresenter does not expose its ScrollViewer per item, so pointer
+  // hover and keyboard focus on a page item stand in for scrolling onto it.
+  // Paging changes the collection that holds the page item, so it runs after
+  // the handler returns.
+  void InsertPageItem(uint32_t parent, uint32_t position,
+                      MenuPageDirection direction,
+                      std::string_view label) override {
+    MenuFlyoutItem item;
+    item.Text(winrt::hstring(Utf8ToWide(label)));
+    const MenuItemStyle& style = item_style();
+    if (style.compact && compiled_styles_ &&
+        compiled_styles_->compactStyles.menuFlyoutItemStyle) {
+      item.Style(compiled_styles_->compactStyles.menuFlyoutItemStyle);
+    }
+    if (style.font_size > 0) item.FontSize(style.font_size);
+    if (style.item_height > 0) item.MinHeight(style.item_height);
+    Brush brush = GetBrush(style.text_color);
+    if (brush) item.Foreground(brush);
+
+    auto page = [this, parent, direction] {
+      XamlQueue().TryEnqueue([this, parent, direction] {
+        try {
+          ShowPage(parent, direction);
         } catch (const winrt::hresult_error& e) {
-          DebugLog(L"ShowAt failed", e.code());
-          RemoveCursorHook();
-          DestroyWindow(hwnd);
-        } catch (...) {
-          DebugLog(L"TrayWinUI: ShowAt failed (unknown exception)\n");
-          RemoveCursorHook();
-          DestroyWindow(hwnd);
+          DebugLog(L"Paging menu items failed", e.code());
         }
       });
+    };
+    item.Click([this, page](auto&&, auto&&) {
+      *cancel_close_for_toggle_ = true;
+      page();
+    });
+    item.PointerEntered([page](auto&&, auto&&) { page(); });
+    item.GotFocus([page](auto&&, auto&&) { page(); });
+    ItemsOf(parent).InsertAt(position, item);
+  }
+
+  void SetText(uint32_t index, MenuText text) override {
+    winrt::hstring value = ToHString(text);
+    if (auto item = items_[index].try_as<MenuFlyoutItem>()) {
+      item.Text(value);
+    } else if (auto sub = items_[index].try_as<MenuFlyoutSubItem>()) {
+      sub.Text(value);
+    }
+  }
+
+  void SetEnabled(uint32_t index, bool enabled) override {
+    items_[index].IsEnabled(enabled);
+  }
+
+  void SetChecked(uint32_t index, bool checked) override {
+    items_[index].as<ToggleMenuFlyoutItem>().IsChecked(checked);
+  }
+
+  void SetIcon(uint32_t index, uint16_t glyph, MenuText font_family,
+               uint32_t icon_color) override {
+    IconElement icon = CreateFontIcon(glyph, font_family, GetBrush(icon_color));
+    if (auto item = items_[index].try_as<MenuFlyoutItem>()) {
+      item.Icon(icon);
+    } else if (auto sub = items_[index].try_as<MenuFlyoutSubItem>()) {
+      sub.Icon(icon);
+    }
+  }
+
+  void ClearIcon(uint32_t index) override {
+    if (auto item = items_[index].try_as<MenuFlyoutItem>()) {
+      item.Icon(nullptr);
+    } else if (auto sub = items_[index].try_as<MenuFlyoutSubItem>()) {
+      sub.Icon(nullptr);
+    }
+  }
+
+  void SetAcceleratorText(uint32_t index, MenuText text) override {
+    items_[index].as<MenuFlyoutItem>().KeyboardAcceleratorTextOverride(
+        ToHString(text));
+  }
+
+  void SetToolTip(uint32_t index, MenuText text) override {
+    if (text.empty()) {
+      ToolTipService::SetToolTip(items_[index], nullptr);
+      return;
+    }
+    ToolTipService::SetToolTip(items_[index],
+        winrt::box_value(ToHString(text)));
+  }
+
+  bool SetCompactStyle(uint32_t index, MenuWidgetKind kind) override {
+    if (!compiled_styles_) return false;
+    // Radio items reuse the toggle style (they are ToggleMenuFlyoutItems).
+    const CompactItemStyles& compact = compiled_styles_->compactStyles;
+    Style style{nullptr};
+    switch (kind) {
+      case MenuWidgetKind::kItem:
+        style = compact.menuFlyoutItemStyle;
+        break;
+      case MenuWidgetKind::kToggle:
+        style = compact.toggleMenuFlyoutItemStyle;
+        break;
+      case MenuWidgetKind::kSubItem:
+        style = compact.menuFlyoutSubItemStyle;
+        break;
+      case MenuWidgetKind::kSeparator:
+        break;
+    }
+    if (!style) return false;
+    items_[index].Style(style);
+    return true;
+  }
+
+  void SetFontSize(uint32_t index, double size) override {
+    items_[index].FontSize(size);
+  }
+
+  void SetMinHeight(uint32_t index, double height) override {
+    items_[index].MinHeight(height);
+  }
+
+  void SetForeground(uint32_t index, uint32_t argb) override {
+    Brush brush = GetBrush(argb);
+    if (brush) items_[index].Foreground(brush);
+  }
+
+  void SetSeparatorColor(uint32_t index, uint32_t argb) override {
+    Brush brush = GetBrush(argb);
+    if (brush) items_[index].Background(brush);
+  }
+
+  void SetClickHandler(uint32_t index, int32_t, bool keep_open) override {
+    items_[index].as<MenuFlyoutItem>().Click(
+        [this, index, keep_open](auto&&, auto&&) {
+          if (keep_open) *cancel_close_for_toggle_ = true;
+          events_.OnMenuItemClick(ClickItem(index));
+        });
+  }
+
+  // MenuFlyoutSubItem has no opening event. Pointer hover and keyboard focus
+  // both reach the sub item before its submenu opens (hover opens it after a
+  // delay), so build the children on whichever comes first.
+  void SetSubmenuOpenHandler(uint32_t index) override {
+    auto sub = items_[index].as<MenuFlyoutSubItem>();
+    sub.PointerEntered([this, index](auto&&, auto&&) { BuildSubmenu(index); });
+    sub.GotFocus([this, index](auto&&, auto&&) { BuildSubmenu(index); });
+  }
+
+ private:
+  friend LRESULT CALLBACK MenuHostWndProc(HWND, UINT, WPARAM, LPARAM);
+
+  bool ShowAtAnchor() {
+    show_pending_ = false;
+    try {
+      // SetForegroundWindow + PostMessage(WM_NULL) before ShowAt: workaround for tray menus (MS KB135788).
+      SetForegroundWindow(hwnd_);
+      PostMessage(hwnd_, WM_NULL, 0, 0);
+
+      auto opts =
+          winrt::Microsoft::UI::Xaml::Controls::Primitives::FlyoutShowOptions();
+      opts.ShowMode(dismiss_on_move_
+          ? FlyoutShowMode::TransientWithDismissOnPointerMoveAway
+          : FlyoutShowMode::Transient);
+      winrt::Windows::Foundation::Point pos(0.0f, 0.0f);
+      opts.Position(pos);
+      if (exclusion_rect_.has_value()) {
+        const MenuRect& er = *exclusion_rect_;
+        winrt::Windows::Foundation::Rect rect{
+            static_cast<float>(er.x), static_cast<float>(er.y),
+            static_cast<float>(er.width), static_cast<float>(er.height)};
+        opts.ExclusionRect(rect);
+      }
+
+      DebugLog(L"TrayWinUI: calling ShowAt\n");
 
+      ScopedSpan span("ShowAt");
+      show_at_called_ = SpanTrace::Now();
+      flyout_.ShowAt(canvas_, opts);
+      return true;
     } catch (const winrt::hresult_error& e) {
-      DebugLog(L"XAML setup failed", e.code());
-      RemoveCursorHook();
-      GetWinUIState().menu_showing.store(false);
-      DestroyWindow(hwnd);
+      DebugLog(L"ShowAt failed", e.code());
     } catch (...) {
-      DebugLog(L"TrayWinUI: XAML setup failed (unknown exception)\n");
-      RemoveCursorHook();
-      GetWinUIState().menu_showing.store(false);
-      DestroyWindow(hwnd);
+      DebugLog(L"TrayWinUI: ShowAt failed (unknown exception)\n");
+    }
+    return false;
+  }
+
+  // A deferred ShowAt failed outside MenuHostPool::Show. Destroying the window
+  // makes IsHostAlive() false, so the next show rebuilds from scratch.
+  void AbandonHost() {
+    ReportShowClosed();
+    RemoveCursorHook();
+    if (hwnd_) DestroyWindow(hwnd_);
+  }
+
+  winrt::Windows::Foundation::Collections::IVector<MenuFlyoutItemBase> ItemsOf(
+      uint32_t parent) const {
+    if (parent == kRootWidget) return flyout_.Items();
+    return items_[parent].as<MenuFlyoutSubItem>().Items();
+  }
+
+  void BuildSubmenu(uint32_t index) {
+    try {
+      ScopedSpan span("BuildSubmenu");
+      MaterializeSubmenu(index);
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Building submenu items failed", e.code());
+    }
+  }
+
+  void StopDismissTimer() {
+    if (dismiss_timer_) {
+      dismiss_timer_.Stop();
+      dismiss_timer_ = nullptr;
+    }
+  }
+
+  void OnFlyoutClosed();
+
+  ChannelMenuEventSink events_;
+
+  // Host.
+  HWND hwnd_ = nullptr;
+  DesktopWindowXamlSource xaml_source_{nullptr};
+  Canvas canvas_{nullptr};
+  bool canvas_loaded_ = false;
+  bool show_pending_ = false;
+
+  // Flyout, rebuilt when the style changes.
+  MenuFlyout flyout_{nullptr};
+  std::shared_ptr<const CompiledStyles> compiled_styles_;
+  bool dismiss_on_move_ = false;
+  FlyoutPlacementMode default_placement_ = FlyoutPlacementMode::Auto;
+  winrt::Microsoft::UI::Dispatching::DispatcherQueueTimer dismiss_timer_{nullptr};
+  std::shared_ptr<bool> cancel_close_for_toggle_ = std::make_shared<bool>(false);
+
+  // Items by CompiledMenu node index.
+  std::vector<MenuFlyoutItemBase> items_;
+
+  // Current show.
+  std::optional<MenuRect> exclusion_rect_;
+  // SpanTrace::Now() at ShowWinUIContextMenu, Show and ShowAt, for spans that
+  // end in the Loaded and Opened callbacks.
+  uint64_t show_requested_ = 0;
+  uint64_t show_called_ = 0;
+  uint64_t show_at_called_ = 0;
+  uint64_t show_id_ = 0;
+};
+
+// The pool and its backend hold XAML objects, which are thread-affine; only
+// the DispatcherQueue (XAML) thread touches them.
+WinUIMenuHostBackend& GetMenuHostBackend() {
+  thread_local WinUIMenuHostBackend backend;
+  return backend;
+}
+
+MenuHostPool& GetMenuHostPool() {
+  thread_local MenuHostPool pool(GetMenuHostBackend());
+  return pool;
+}
+
+void RunNextShow();
+
+void WinUIMenuHostBackend::ReportShowClosed() {
+  if (GetWinUIState().shows.OnClosed(show_id_)) {
+    // Not from inside a XAML event handler.
+    XamlQueue().TryEnqueue(DispatcherQueuePriority::Normal,
+                           []() { RunNextShow(); });
+  }
+}
+
+void WinUIMenuHostBackend::CloseShow(uint64_t id) {
+  if (id != show_id_) {
+    GetWinUIState().shows.OnClosed(id);
+    return;
+  }
+  if (show_pending_) {
+    show_pending_ = false;
+    if (hwnd_) ShowWindow(hwnd_, SW_HIDE);
+    RemoveCursorHook();
+    GetMenuHostPool().OnClosed();
+    ReportShowClosed();
+    return;
+  }
+  try {
+    if (flyout_) {
+      flyout_.Hide();
+      return;
+    }
+  } catch (const winrt::hresult_error& e) {
+    DebugLog(L"Hiding the flyout failed", e.code());
+  }
+  ReportShowClosed();
+}
+
+void WinUIMenuHostBackend::OnFlyoutClosed() {
+  StopDismissTimer();
+  RemoveCursorHook();
+  events_.OnMenuClosed();
+  if (hwnd_) ShowWindow(hwnd_, SW_HIDE);
+  GetMenuHostPool().OnClosed();
+  ReportShowClosed();
+}
+
+LRESULT CALLBACK MenuHostWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+  auto* host = reinterpret_cast<WinUIMenuHostBackend*>(
+      GetWindowLongPtr(hwnd, GWLP_USERDATA));
+
+  // Use WM_ACTIVATEAPP instead of WM_ACTIVATE to avoid killing the flyout
+  // when WinUI opens a submenu popup (which steals focus from host window
+  // but stays within the same process). WM_ACTIVATEAPP only fires when
+  // focus moves to a different application.
+  if (msg == WM_ACTIVATEAPP && wParam == FALSE && host && host->flyout_) {
+    try {
+      host->flyout_.Hide();
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"MenuHostWndProc: flyout.Hide() failed", e.code());
+    }
+  }
+
+  // Destroyed behind the pool's back (DestroyHost clears USERDATA first).
+  if (msg == WM_DESTROY && host) {
+    SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+    host->hwnd_ = nullptr;
+    host->ReportShowClosed();
+  }
+
+  return DefWindowProc(hwnd, msg, wParam, lParam);
+}
+
+// Opens the flyout for show id; the backend reports the outcome.
+void ShowOnWinUIThread(uint64_t id, const PendingShow& show) {
+  GetSpanTrace().Record("Request to XAML thread", show.requested,
+                        SpanTrace::Now());
+  ScopedSpan span("MenuHostPool::Show");
+  auto& backend = GetMenuHostBackend();
+  auto& pool = GetMenuHostPool();
+  auto& prepare = GetWinUIState().prepare;
+  bool shown = false;
+  try {
+    backend.set_show_requested(show.requested);
+    // Built items capture the channel in their Click handlers.
+    if (backend.channel() != show.channel) {
+      pool.Reset();
+      prepare.Invalidate();
+      backend.set_channel(show.channel);
+    }
+    backend.set_show_id(id);
+    if (prepare.BeginShow(show.version) == MenuPrepareShow::kUsePrepared) {
+      shown = pool.ShowPrepared(show.request);
+    }
+    if (!shown) shown = pool.Show(show.snapshot, show.request);
+  } catch (...) {
+    DebugLog(L"TrayWinUI: show failed (unknown exception)\n");
+    pool.Reset();
+  }
+  if (!shown) {
+    prepare.Invalidate();
+    DebugLog(L"TrayWinUI: show failed, host discarded\n");
+    RemoveCursorHook();
+    backend.ReportShowClosed();
+  }
+}
+
+// Runs what the show scheduler asks for: the latest request, or closing the
+// current show to make way for it.
+void RunNextShow() {
+  ShowAction<PendingShow> action = GetWinUIState().shows.Next();
+  switch (action.step) {
+    case ShowStep::kNone:
+      break;
+    case ShowStep::kShow:
+      ShowOnWinUIThread(action.id, *action.request);
+      break;
+    case ShowStep::kClose:
+      GetMenuHostBackend().CloseShow(action.id);
+      break;
+  }
+}
+
+// Builds the hidden flyout for a prepareContextMenu unless a show, a newer
+// prepare or a menu change made it moot. Runs at normal priority, in order
+// with shows: a show requested after the prepare opens what it built.
+void PrepareOnWinUIThread(std::shared_ptr<const PendingPrepare> pending) {
+  auto& prepare = GetWinUIState().prepare;
+  if (!prepare.StartPrepare(pending->ticket, pending->version)) return;
+  ScopedSpan span("MenuHostPool::Prepare");
+  auto& backend = GetMenuHostBackend();
+  auto& pool = GetMenuHostPool();
+  bool ok = false;
+  try {
+    if (backend.channel() != pending->channel) {
+      pool.Reset();
+      backend.set_channel(pending->channel);
+    }
+    ok = pool.Prepare(pending->snapshot);
+  } catch (...) {
+    DebugLog(L"TrayWinUI: prepare failed (unknown exception)\n");
+    pool.Reset();
+  }
+  prepare.FinishPrepare(pending->ticket, ok);
+  if (!ok) DebugLog(L"TrayWinUI: prepare failed or menu showing\n");
+}
+
+// Parses the latest pending style (if any) at low priority so that the
+// XamlReader parses happen before the user opens the menu. Runs on the XAML
+// thread.
+void PrecompileOnWinUIThread() {
+  XamlQueue().TryEnqueue(DispatcherQueuePriority::Low, []() {
+    auto& state = GetWinUIState();
+    std::shared_ptr<const ResolvedStyle> style;
+    {
+      std::lock_guard lock(state.mutex);
+      style = std::move(state.pending_style);
+    }
+    if (!style) return;  // An earlier task took it.
+    try {
+      GetOrCompileStyles(*style);
+    } catch (const winrt::hresult_error& e) {
+      DebugLog(L"Style precompile failed", e.code());
+    } catch (...) {
+      DebugLog(L"TrayWinUI: style precompile failed (unknown exception)\n");
     }
   });
 }
 
+// Pacing of live item flushes; XAML thread only.
+struct LiveItemFlush {
+  bool initialized = false;
+  LiveItemFlushPacer pacer;
+  DispatcherQueueTimer timer{nullptr};
+};
+
+LiveItemFlush& GetLiveItemFlush() {
+  thread_local LiveItemFlush flush;
+  return flush;
+}
+
+// Refresh rate of the primary display in Hz, 0 if unknown.
+uint32_t DisplayRefreshRate() {
+  DEVMODEW mode = {};
+  mode.dmSize = sizeof(mode);
+  if (!EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &mode)) return 0;
+  // 0 and 1 stand for the hardware's default rate.
+  return mode.dmDisplayFrequency > 1 ? mode.dmDisplayFrequency : 0;
+}
+
+// Applies every pending live item update to the pooled flyout's items, open
+// or hidden; updates for a menu without the id are dropped.
+void FlushLiveItems() {
+  GetLiveItemFlush().pacer.OnFlushed(LiveItemFlushPacer::Clock::now());
+  ScopedSpan span("FlushLiveItems");
+  auto& backend = GetMenuHostBackend();
+  try {
+    g_liveItems.Drain([&backend](const LiveItemUpdate& update) {
+      backend.ApplyLiveItem(update);
+    });
+  } catch (const winrt::hresult_error& e) {
+    DebugLog(L"Applying live menu items failed", e.code());
+  }
+}
+
+// Runs on the XAML thread for the first update since the last flush: flushes
+// now if the last flush was a frame or more ago, else when that frame ends.
+void ScheduleLiveItemFlush() {
+  auto& flush = GetLiveItemFlush();
+  if (!flush.initialized) {
+    flush.initialized = true;
+    flush.pacer.set_refresh_rate(DisplayRefreshRate());
+  }
+  const std::chrono::microseconds delay =
+      flush.pacer.Delay(LiveItemFlushPacer::Clock::now());
+  if (delay.count() == 0) {
+    FlushLiveItems();
+    return;
+  }
+  try {
+    if (!flush.timer) {
+      flush.timer = XamlQueue().CreateTimer();
+      flush.timer.IsRepeating(false);
+      flush.timer.Tick([](auto&&, auto&&) { FlushLiveItems(); });
+    }
+    flush.timer.Interval(delay);
+    flush.timer.Start();
+  } catch (const winrt::hresult_error& e) {
+    DebugLog(L"Live item flush timer failed", e.code());
+    FlushLiveItems();
+  }
+}
+
 }  // namespace
 
 void InitPlatformCallback() {
@@ -1465,6 +1379,7 @@ void InitPlatformCallback() {
   g_platformCallbackHwnd = CreateWindowExW(
       0, L"TrayWinUICallbackWnd", L"", 0,
       0, 0, 0, 0, HWND_MESSAGE, nullptr, GetModuleHandle(nullptr), nullptr);
+  GetSpanTrace().NameThread("platform");
 }
 
 void DestroyPlatformCallback() {
@@ -1472,60 +1387,125 @@ void DestroyPlatformCallback() {
     DestroyWindow(g_platformCallbackHwnd);
     g_platformCallbackHwnd = nullptr;
   }
+  std::lock_guard lock(g_platformTasksMutex);
+  g_platformTasks.clear();
+}
+
+void TriggerWinUIPreInitialization() { GetXamlThreadGate().Start(); }
+
+void PrecompileWinUIStyle(std::shared_ptr<const ResolvedStyle> style) {
+  auto& state = GetWinUIState();
+  {
+    std::lock_guard lock(state.mutex);
+    state.pending_style = std::move(style);
+  }
+  GetXamlThreadGate().Run(PrecompileOnWinUIThread, [] {});
+}
+
+void OnWinUIMenuChanged() { GetWinUIState().prepare.OnMenuChanged(); }
+
+bool UpdateWinUILiveItems(const flutter::EncodableList& updates) {
+  return SubmitLiveItems(updates, g_liveItems, GetXamlThreadGate(),
+                         ScheduleLiveItemFlush);
 }
 
-void TriggerWinUIPreInitialization() {
+bool PrepareWinUIContextMenu(
+    MenuSnapshotPtr snapshot,
+    flutter::MethodChannel<flutter::EncodableValue>* channel) {
+  if (!channel || !snapshot) return false;
+  XamlThreadGate& gate = GetXamlThreadGate();
+  if (gate.state() == XamlThreadState::kFailed) return false;
   auto& state = GetWinUIState();
-  std::lock_guard lock(state.mutex);
-  if (state.initialized || state.init_in_progress || state.init_failed) return;
-  std::thread([]() {
-    EnsureWinUIInitialized();
-  }).detach();
+  // Only this (platform) thread changes the version.
+  const uint64_t version = state.prepare.version();
+  const uint64_t ticket = state.prepare.RequestPrepare();
+  if (ticket == 0) return true;  // Already prepared or preparing.
+  auto pending = std::make_shared<PendingPrepare>();
+  pending->snapshot = std::move(snapshot);
+  pending->channel = channel;
+  pending->ticket = ticket;
+  pending->version = version;
+  // A newer prepare supersedes this one by ticket if both are queued.
+  gate.Run([pending]() { PrepareOnWinUIThread(pending); },
+           [ticket]() { GetWinUIState().prepare.FinishPrepare(ticket, false); });
+  return true;
 }
 
 void ShutdownWinUI() {
   auto& state = GetWinUIState();
-  std::lock_guard lock(state.mutex);
-  if (!state.initialized) return;
-  try {
-    if (state.xamlManager) {
-      state.xamlManager.Close();
-      state.xamlManager = nullptr;
-    }
-    if (state.controller) {
-      state.controller.ShutdownQueueAsync();
-      state.controller = nullptr;
+  XamlThreadGate& gate = GetXamlThreadGate();
+  // Initialization still running owns the state; leave it to the process.
+  if (gate.state() != XamlThreadState::kReady) return;
+  DispatcherQueue queue{nullptr};
+  {
+    std::lock_guard lock(state.mutex);
+    queue = state.queue;
+  }
+  // The pooled host window and XAML island belong to the XAML thread; release
+  // them there before the island infrastructure goes away. Waited for without
+  // state.mutex, which XAML-thread tasks take.
+  if (queue) {
+    auto released = std::make_shared<std::promise<void>>();
+    auto done = released->get_future();
+    if (queue.TryEnqueue(DispatcherQueuePriority::High, [released]() {
+          try {
+            GetMenuHostPool().Reset();
+          } catch (...) {}
+          GetWinUIState().prepare.Invalidate();
+          released->set_value();
+        })) {
+      done.wait_for(std::chrono::seconds(2));
     }
+  }
+  winrt::Microsoft::UI::Xaml::Hosting::WindowsXamlManager xamlManager{nullptr};
+  DispatcherQueueController controller{nullptr};
+  {
+    std::lock_guard lock(state.mutex);
+    xamlManager = std::exchange(state.xamlManager, nullptr);
+    controller = std::exchange(state.controller, nullptr);
     state.queue = nullptr;
+  }
+  try {
+    if (xamlManager) xamlManager.Close();
+    if (controller) controller.ShutdownQueueAsync();
   } catch (const winrt::hresult_error& e) {
     DebugLog(L"ShutdownWinUI error", e.code());
   }
-  state.initialized = false;
   try {
     MddBootstrapShutdown();
   } catch (...) {}
+  gate.Reset();
 }
 
-bool ShowWinUIContextMenu(
-    const flutter::EncodableMap& menu_json,
-    const flutter::EncodableMap& style_json,
+void ShowWinUIContextMenu(
+    MenuSnapshotPtr snapshot,
     flutter::MethodChannel<flutter::EncodableValue>* channel,
-    std::optional<double> pos_x,
-    std::optional<double> pos_y,
-    std::optional<std::string> placement,
-    std::optional<flutter::EncodableMap> exclusion_rect) {
-  if (!channel) return false;
-  try {
-    if (!EnsureWinUIInitialized()) return false;
-    ShowMenuOnWinUIThread(menu_json, style_json, channel, pos_x, pos_y,
-                          placement, exclusion_rect);
-    return true;
-  } catch (const winrt::hresult_error& e) {
-    DebugLog(L"ShowWinUIContextMenu error", e.code());
-    return false;
-  } catch (...) {
-    DebugLog(L"ShowWinUIContextMenu: unknown exception\n");
-    return false;
+    ShowWinUICallback on_done,
+    MenuShowRequest request) {
+  ShowWinUICallback done = OnPlatformThread(std::move(on_done));
+  if (!channel || !snapshot) {
+    done(false);
+    return;
+  }
+  SpanTrace& trace = GetSpanTrace();
+  const uint64_t requested = SpanTrace::Now();
+  if (trace.enabled()) trace.BeginShow();
+  ScopedSpan span("ShowWinUIContextMenu");
+  auto& state = GetWinUIState();
+  PendingShow show;
+  // Shares the plugin's snapshot: no copy of the menu or style per show.
+  show.snapshot = std::move(snapshot);
+  show.channel = channel;
+  show.request = std::move(request);
+  show.version = state.prepare.version();
+  show.requested = requested;
+  // A request still waiting absorbs this one; otherwise run the scheduler
+  // on the XAML thread (queued while WinUI initializes).
+  if (state.shows.Submit(std::move(show), std::move(done))) {
+    GetXamlThreadGate().Run(RunNextShow, []() {
+      DebugLog(L"TrayWinUI: WinUI unavailable, menu not shown\n");
+      GetWinUIState().shows.FailPending();
+    });
   }
 }
 
@@ -1538,18 +1518,24 @@ namespace tray_manager_winui {
 void InitPlatformCallback() {}
 void DestroyPlatformCallback() {}
 void TriggerWinUIPreInitialization() {}
+void PrecompileWinUIStyle(std::shared_ptr<const ResolvedStyle>) {}
+void OnWinUIMenuChanged() {}
+bool UpdateWinUILiveItems(const flutter::EncodableList&) { return false; }
+
+bool PrepareWinUIContextMenu(
+    MenuSnapshotPtr,
+    flutter::MethodChannel<flutter::EncodableValue>*) {
+  return false;
+}
 
 void ShutdownWinUI() {}
 
-bool ShowWinUIContextMenu(
-    const flutter::EncodableMap&,
-    const flutter::EncodableMap&,
+void ShowWinUIContextMenu(
+    MenuSnapshotPtr,
     flutter::MethodChannel<flutter::EncodableValue>*,
-    std::optional<double>,
-    std::optional<double>,
-    std::optional<std::string>,
-    std::optional<flutter::EncodableMap>) {
-  return false;
+    ShowWinUICallback on_done,
+    MenuShowRequest) {
+  on_done(false);
 }
 
 }  // namespace tray_manager_winui
@@ -4,46 +4,83 @@
 #include <flutter/encodable_value.h>
 #include <flutter/method_channel.h>
 
+#include "menu_host_pool.h"
+#include "menu_snapshot.h"
+
+#include <functional>
 #include <memory>
-#include <optional>
-#include <string>
 
 namespace tray_manager_winui {
 
+/// Receives whether a ShowWinUIContextMenu opened the flyout.
+using ShowWinUICallback = std::function<void(bool shown)>;
+
 /// Shows a WinUI 3 MenuFlyout.
 ///
-/// Without pos_x/pos_y, uses current cursor position. With both, uses the
-/// specified screen coordinates (physical pixels).
+/// Without request.x/request.y, uses current cursor position. With both, uses
+/// the specified screen coordinates (physical pixels).
 ///
-/// \param menu_json Menu structure (same format as tray_manager: {"items": [...]})
-/// \param style_json Optional style map (backgroundColor, textColor, fontSize, etc.)
+/// Returns without waiting for WinUI: the first call starts initialization
+/// (unless TriggerWinUIPreInitialization did), and the show is queued until
+/// it finishes. Shows are latest-wins (ShowScheduler): a call made while an
+/// earlier one is waiting or still opening replaces it, and a call made while
+/// the menu is open reopens it at the new position.
+///
+/// \param snapshot Menu and style to show; shared with the XAML thread, which
+///     keeps it while the flyout built from it is open or prepared
 /// \param channel Method channel to invoke "onMenuItemClick" with {"id": itemId}
-/// \param pos_x Optional screen X coordinate
-/// \param pos_y Optional screen Y coordinate
-/// \param placement Optional placement mode (top, bottom, left, right, etc.)
-/// \param exclusion_rect Optional rect the flyout should avoid ({x,y,width,height})
-/// \return true on success, false if WinUI unavailable
-bool ShowWinUIContextMenu(
-    const flutter::EncodableMap& menu_json,
-    const flutter::EncodableMap& style_json,
+/// \param on_done Called once on the platform thread: true when the flyout
+///     has opened for this call or a later one that replaced it, false if
+///     WinUI is unavailable or that show failed
+/// \param request Optional screen position (physical pixels), placement mode
+///     and rect the flyout should avoid
+void ShowWinUIContextMenu(
+    MenuSnapshotPtr snapshot,
     flutter::MethodChannel<flutter::EncodableValue>* channel,
-    std::optional<double> pos_x = std::nullopt,
-    std::optional<double> pos_y = std::nullopt,
-    std::optional<std::string> placement = std::nullopt,
-    std::optional<flutter::EncodableMap> exclusion_rect = std::nullopt);
+    ShowWinUICallback on_done,
+    MenuShowRequest request = {});
 
 /// Creates a message-only window on the platform thread for safe
 /// InvokeMethod callbacks from the WinUI DispatcherQueue thread.
 /// Must be called during plugin registration (platform thread).
 void InitPlatformCallback();
 
-/// Destroys the callback window. Call from plugin destructor.
+/// Destroys the callback window. Call from plugin destructor. Pending
+/// ShowWinUIContextMenu callbacks are dropped.
 void DestroyPlatformCallback();
 
 /// Starts WinUI initialization in a background thread. Call from setContextMenu
-/// to avoid blocking on first showContextMenu.
+/// so that the first showContextMenu does not wait for it.
 void TriggerWinUIPreInitialization();
 
+/// Parses the XAML styles for style on the WinUI thread in the background
+/// (after initialization, if it is still running), so the first show with this
+/// style reuses them. Call from setContextMenu with the snapshot's style.
+void PrecompileWinUIStyle(std::shared_ptr<const ResolvedStyle> style);
+
+/// Marks a prepared flyout stale. Call whenever the menu or style that
+/// ShowWinUIContextMenu and PrepareWinUIContextMenu receive changes
+/// (setContextMenu, updateMenuItems).
+void OnWinUIMenuChanged();
+
+/// Queues updateLiveItems entries (see ParseLiveItemUpdate) for the items of
+/// the flyout, open or hidden, and returns without waiting for the XAML
+/// thread. Updates to the same item are merged, latest value wins per field,
+/// and applied at most once per display frame (LiveItemCoalescer). Before
+/// WinUI is initialized there is no flyout and they are dropped. Returns
+/// false if they were dropped, or an entry was invalid or could not be
+/// queued (see SubmitLiveItems).
+bool UpdateWinUILiveItems(const flutter::EncodableList& updates);
+
+/// Builds the hidden host window, XAML island, styles and every item for
+/// snapshot on the WinUI thread in the background (starting initialization if
+/// needed), so that the next ShowWinUIContextMenu of the same menu only
+/// positions the host and calls ShowAt. Does nothing if the current menu is
+/// already prepared or being prepared. Returns false if WinUI is unavailable.
+bool PrepareWinUIContextMenu(
+    MenuSnapshotPtr snapshot,
+    flutter::MethodChannel<flutter::EncodableValue>* channel);
+
 /// Shuts down WinUI infrastructure. Call from plugin destructor for clean
 /// release of DispatcherQueueController and WindowsXamlManager.
 void ShutdownWinUI();
@@ -0,0 +1,111 @@
+#include "xaml_thread_gate.h"
+
+#include <thread>
+#include <utility>
+
+namespace tray_manager_winui {
+
+XamlThreadGate::XamlThreadGate(XamlThreadPlatform& platform)
+    : shared_(std::make_shared<Shared>(platform)) {}
+
+XamlThreadGate::~XamlThreadGate() = default;
+
+void XamlThreadGate::Start() {
+  {
+    std::lock_guard lock(shared_->mutex);
+    if (shared_->state != XamlThreadState::kNotStarted) return;
+    BeginInit(*shared_);
+  }
+  LaunchInit(shared_);
+}
+
+void XamlThreadGate::Run(std::function<void()> task,
+                         std::function<void()> on_failed) {
+  Intent intent{std::move(task), std::move(on_failed)};
+  bool launch = false;
+  bool dispatch_now = false;
+  {
+    std::unique_lock lock(shared_->mutex);
+    switch (shared_->state) {
+      case XamlThreadState::kReady:
+        dispatch_now = true;
+        break;
+      case XamlThreadState::kFailed:
+        lock.unlock();
+        intent.on_failed();
+        return;
+      case XamlThreadState::kNotStarted:
+        BeginInit(*shared_);
+        launch = true;
+        [[fallthrough]];
+      case XamlThreadState::kInitializing:
+        shared_->pending.push_back(std::move(intent));
+        break;
+    }
+  }
+  if (launch) {
+    LaunchInit(shared_);
+  } else if (dispatch_now) {
+    // Ready: the initialization thread has posted everything queued before,
+    // so posting now keeps the order.
+    Dispatch(*shared_, std::move(intent));
+  }
+}
+
+void XamlThreadGate::Reset() {
+  std::lock_guard lock(shared_->mutex);
+  if (shared_->state == XamlThreadState::kInitializing) return;
+  shared_->state = XamlThreadState::kNotStarted;
+}
+
+bool XamlThreadGate::WaitForInit(std::chrono::milliseconds timeout) {
+  std::unique_lock lock(shared_->mutex);
+  shared_->settled.wait_for(lock, timeout, [this] {
+    return shared_->state == XamlThreadState::kReady ||
+           shared_->state == XamlThreadState::kFailed;
+  });
+  return shared_->state == XamlThreadState::kReady;
+}
+
+XamlThreadState XamlThreadGate::state() const {
+  std::lock_guard lock(shared_->mutex);
+  return shared_->state;
+}
+
+void XamlThreadGate::BeginInit(Shared& shared) {
+  shared.state = XamlThreadState::kInitializing;
+}
+
+void XamlThreadGate::LaunchInit(std::shared_ptr<Shared> shared) {
+  std::thread([shared = std::move(shared)] {
+    const bool ok = shared->platform.Initialize();
+    // Intents queued while posting the previous batch are picked up by the
+    // next round; the state turns kReady only once the queue is empty, so a
+    // concurrent Run cannot overtake them.
+    while (true) {
+      std::vector<Intent> batch;
+      {
+        std::lock_guard lock(shared->mutex);
+        if (shared->pending.empty()) {
+          shared->state = ok ? XamlThreadState::kReady : XamlThreadState::kFailed;
+          shared->settled.notify_all();
+          return;
+        }
+        batch.swap(shared->pending);
+      }
+      for (Intent& intent : batch) {
+        if (ok) {
+          Dispatch(*shared, std::move(intent));
+        } else {
+          intent.on_failed();
+        }
+      }
+    }
+  }).detach();
+}
+
+void XamlThreadGate::Dispatch(Shared& shared, Intent intent) {
+  if (!shared.platform.Post(std::move(intent.task))) intent.on_failed();
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,102 @@
+#ifndef TRAY_MANAGER_WINUI_XAML_THREAD_GATE_H_
+#define TRAY_MANAGER_WINUI_XAML_THREAD_GATE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tray_manager_winui {
+
+/// Platform side of XamlThreadGate: WinUI bootstrap and the XAML thread's
+/// DispatcherQueue on Windows, fakes in tests.
+class XamlThreadPlatform {
+ public:
+  virtual ~XamlThreadPlatform() = default;
+
+  /// Runs once, on a background thread the gate starts: bootstraps the
+  /// runtime and creates the XAML thread. May block for a long time. Returns
+  /// false on failure.
+  virtual bool Initialize() = 0;
+
+  /// Queues task on the XAML thread. Called from any thread after Initialize
+  /// succeeded. Returns false if the queue refused it.
+  virtual bool Post(std::function<void()> task) = 0;
+};
+
+/// Initialization as seen by XamlThreadGate::Run.
+enum class XamlThreadState : uint8_t {
+  kNotStarted,
+  /// Initialize is running; Run queues intents.
+  kInitializing,
+  /// Run posts straight to the XAML thread.
+  kReady,
+  /// Initialize failed; Run fails every intent right away.
+  kFailed,
+};
+
+/// Runs work on the XAML thread without ever blocking the caller on WinUI
+/// initialization. The first Run (or Start) initializes on a background
+/// thread; intents arriving meanwhile are queued and posted, in the order
+/// they were run, once initialization succeeds, or failed if it does not.
+/// Thread-safe.
+class XamlThreadGate {
+ public:
+  /// platform must outlive every initialization the gate starts.
+  explicit XamlThreadGate(XamlThreadPlatform& platform);
+  ~XamlThreadGate();
+
+  XamlThreadGate(const XamlThreadGate&) = delete;
+  XamlThreadGate& operator=(const XamlThreadGate&) = delete;
+
+  /// Starts initialization in the background if it has not started.
+  void Start();
+
+  /// Runs task on the XAML thread once initialized, starting initialization
+  /// if needed. If initialization fails or the post is refused, calls
+  /// on_failed instead, on this thread or the initialization thread. Exactly
+  /// one of the two is called. Never blocks on initialization.
+  void Run(std::function<void()> task, std::function<void()> on_failed);
+
+  /// Forgets a finished initialization (after the platform was shut down) so
+  /// that the next Run initializes again. No effect while initializing.
+  void Reset();
+
+  /// Waits up to timeout for initialization to finish; true if it
+  /// succeeded. For shutdown and tests; never call it on a show path.
+  bool WaitForInit(std::chrono::milliseconds timeout);
+
+  XamlThreadState state() const;
+
+ private:
+  struct Intent {
+    std::function<void()> task;
+    std::function<void()> on_failed;
+  };
+
+  // Shared with the detached initialization thread, which may outlive the
+  // gate.
+  struct Shared {
+    explicit Shared(XamlThreadPlatform& platform) : platform(platform) {}
+    XamlThreadPlatform& platform;
+    mutable std::mutex mutex;
+    std::condition_variable settled;
+    XamlThreadState state = XamlThreadState::kNotStarted;
+    std::vector<Intent> pending;
+  };
+
+  // Requires the lock; moves to kInitializing. The caller launches the
+  // thread after unlocking.
+  static void BeginInit(Shared& shared);
+  static void LaunchInit(std::shared_ptr<Shared> shared);
+  static void Dispatch(Shared& shared, Intent intent);
+
+  std::shared_ptr<Shared> shared_;
+};
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_XAML_THREAD_GATE_H_
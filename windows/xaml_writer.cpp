@@ -0,0 +1,860 @@
+#include "xaml_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cwchar>
+#include <string_view>
+
+#include "simd.h"
+
+namespace tray_manager_winui {
+
+namespace {
+
+constexpr wchar_t kHexDigits[] = L"0123456789ABCDEF";
+
+bool NeedsXamlEscape(wchar_t c) {
+  return c == L'&' || c == L'<' || c == L'>' || c == L'"' || c == L'\'';
+}
+
+std::wstring_view XamlEntity(wchar_t c) {
+  switch (c) {
+    case L'&': return L"&amp;";
+    case L'<': return L"&lt;";
+    case L'>': return L"&gt;";
+    case L'"': return L"&quot;";
+    default: return L"&apos;";
+  }
+}
+
+// Index of the first character that needs escaping, or size. Compares a
+// vector of code units (8 with 16-bit wchar_t on Windows, 4 with 32-bit
+// wchar_t elsewhere) against all five at once.
+size_t FindXamlEscape(const wchar_t* text, size_t size) {
+  // Escapes often come in runs ("<<", "&&"); check the next unit before
+  // setting up the vector loop.
+  if (size == 0 || NeedsXamlEscape(text[0])) return 0;
+  size_t i = 1;
+#if defined(TRAY_MANAGER_WINUI_SSE2)
+  constexpr size_t kLanes = 16 / sizeof(wchar_t);
+  if constexpr (sizeof(wchar_t) == 2) {
+    const __m128i amp = _mm_set1_epi16('&');
+    const __m128i lt = _mm_set1_epi16('<');
+    const __m128i gt = _mm_set1_epi16('>');
+    const __m128i quot = _mm_set1_epi16('"');
+    const __m128i apos = _mm_set1_epi16('\'');
+    for (; i + kLanes <= size; i += kLanes) {
+      const __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+      const __m128i hit = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi16(v, amp), _mm_cmpeq_epi16(v, lt)),
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, gt),
+                                    _mm_cmpeq_epi16(v, quot)),
+                       _mm_cmpeq_epi16(v, apos)));
+      const int mask = _mm_movemask_epi8(hit);
+      if (mask != 0) return i + LowestSetBit(static_cast<uint32_t>(mask)) / 2;
+    }
+  } else {
+    const __m128i amp = _mm_set1_epi32('&');
+    const __m128i lt = _mm_set1_epi32('<');
+    const __m128i gt = _mm_set1_epi32('>');
+    const __m128i quot = _mm_set1_epi32('"');
+    const __m128i apos = _mm_set1_epi32('\'');
+    for (; i + kLanes <= size; i += kLanes) {
+      const __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+      const __m128i hit = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi32(v, amp), _mm_cmpeq_epi32(v, lt)),
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(v, gt),
+                                    _mm_cmpeq_epi32(v, quot)),
+                       _mm_cmpeq_epi32(v, apos)));
+      const int mask = _mm_movemask_epi8(hit);
+      if (mask != 0) return i + LowestSetBit(static_cast<uint32_t>(mask)) / 4;
+    }
+  }
+#elif defined(TRAY_MANAGER_WINUI_NEON)
+  // No movemask; a block with a hit is located by the scalar loop below.
+  if constexpr (sizeof(wchar_t) == 2) {
+    const auto* units = reinterpret_cast<const uint16_t*>(text);
+    for (; i + 8 <= size; i += 8) {
+      const uint16x8_t v = vld1q_u16(units + i);
+      const uint16x8_t hit = vorrq_u16(
+          vorrq_u16(vceqq_u16(v, vdupq_n_u16('&')),
+                    vceqq_u16(v, vdupq_n_u16('<'))),
+          vorrq_u16(vorrq_u16(vceqq_u16(v, vdupq_n_u16('>')),
+                              vceqq_u16(v, vdupq_n_u16('"'))),
+                    vceqq_u16(v, vdupq_n_u16('\''))));
+      if (vmaxvq_u16(hit) != 0) break;
+    }
+  } else {
+    const auto* units = reinterpret_cast<const uint32_t*>(text);
+    for (; i + 4 <= size; i += 4) {
+      const uint32x4_t v = vld1q_u32(units + i);
+      const uint32x4_t hit = vorrq_u32(
+          vorrq_u32(vceqq_u32(v, vdupq_n_u32('&')),
+                    vceqq_u32(v, vdupq_n_u32('<'))),
+          vorrq_u32(vorrq_u32(vceqq_u32(v, vdupq_n_u32('>')),
+                              vceqq_u32(v, vdupq_n_u32('"'))),
+                    vceqq_u32(v, vdupq_n_u32('\''))));
+      if (vmaxvq_u32(hit) != 0) break;
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (NeedsXamlEscape(text[i])) return i;
+  }
+  return size;
+}
+
+// "#AARRGGBB", formatted through the hex table without allocating.
+struct ColorText {
+  wchar_t chars[9];
+};
+
+ColorText FormatColor(int64_t value) {
+  ColorText text;
+  const auto argb = static_cast<uint32_t>(value & 0xFFFFFFFF);
+  text.chars[0] = L'#';
+  for (int i = 0; i < 8; ++i) {
+    text.chars[1 + i] = kHexDigits[(argb >> (28 - 4 * i)) & 0xF];
+  }
+  return text;
+}
+
+// ASCII number as std::wostream would print it with default flags
+// (%g, precision 6, classic locale for doubles).
+struct NumberText {
+  char chars[32];
+  size_t size = 0;
+};
+
+NumberText FormatDouble(double value) {
+  NumberText text;
+  auto result = std::to_chars(text.chars, text.chars + sizeof(text.chars),
+                              value, std::chars_format::general, 6);
+  text.size = static_cast<size_t>(result.ptr - text.chars);
+  return text;
+}
+
+NumberText FormatInt(int64_t value) {
+  NumberText text;
+  auto result =
+      std::to_chars(text.chars, text.chars + sizeof(text.chars), value);
+  text.size = static_cast<size_t>(result.ptr - text.chars);
+  return text;
+}
+
+// Either a "#AARRGGBB" colour or a literal such as a {ThemeResource ...}.
+struct SlotText {
+  const wchar_t* data;
+  size_t size;
+};
+
+SlotText Slot(const ColorText& color) { return {color.chars, 9}; }
+
+template <size_t N>
+SlotText Slot(const wchar_t (&literal)[N]) {
+  return {literal, N - 1};
+}
+
+// First pass: only measures.
+class CountingSink {
+ public:
+  void Put(const wchar_t*, size_t size) { size_ += size; }
+  void PutAscii(const char*, size_t size) { size_ += size; }
+  size_t Mark() const { return size_; }
+  void Repeat(size_t begin, size_t end) { size_ += end - begin; }
+  size_t size() const { return size_; }
+
+ private:
+  size_t size_ = 0;
+};
+
+// Second pass: writes into a buffer sized by CountingSink.
+class BufferSink {
+ public:
+  explicit BufferSink(wchar_t* data) : data_(data) {}
+  void Put(const wchar_t* text, size_t size) {
+    std::wmemcpy(data_ + size_, text, size);
+    size_ += size;
+  }
+  void PutAscii(const char* text, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      data_[size_ + i] = static_cast<wchar_t>(text[i]);
+    }
+    size_ += size;
+  }
+  size_t Mark() const { return size_; }
+  // Copies an already written range [begin, end) to the end.
+  void Repeat(size_t begin, size_t end) {
+    std::wmemcpy(data_ + size_, data_ + begin, end - begin);
+    size_ += end - begin;
+  }
+
+ private:
+  wchar_t* data_;
+  size_t size_ = 0;
+};
+
+template <typename Sink, size_t N>
+void Put(Sink& sink, const wchar_t (&literal)[N]) {
+  sink.Put(literal, N - 1);
+}
+
+template <typename Sink>
+void Put(Sink& sink, const ColorText& color) {
+  sink.Put(color.chars, 9);
+}
+
+template <typename Sink>
+void Put(Sink& sink, const NumberText& number) {
+  sink.PutAscii(number.chars, number.size);
+}
+
+template <typename Sink>
+void Put(Sink& sink, const std::wstring& text) {
+  sink.Put(text.data(), text.size());
+}
+
+// Runs emit twice: once to size the output, once to fill it.
+template <typename Emit>
+std::wstring Render(const Emit& emit) {
+  CountingSink counter;
+  emit(counter);
+  std::wstring out(counter.size(), L'\0');
+  BufferSink writer(out.data());
+  emit(writer);
+  return out;
+}
+
+template <typename Sink, size_t N>
+void PutBrush(Sink& sink, const wchar_t (&key)[N], const ColorText& color) {
+  Put(sink, L"<SolidColorBrush x:Key='");
+  Put(sink, key);
+  Put(sink, L"' Color='");
+  Put(sink, color);
+  Put(sink, L"'/>");
+}
+
+template <typename Sink, size_t N>
+void PutSetter(Sink& sink, const wchar_t (&property)[N],
+               const NumberText& value) {
+  Put(sink, L"<Setter Property='");
+  Put(sink, property);
+  Put(sink, L"' Value='");
+  Put(sink, value);
+  Put(sink, L"'/>");
+}
+
+template <typename Sink, size_t N>
+void PutSetter(Sink& sink, const wchar_t (&property)[N],
+               const ColorText& value) {
+  Put(sink, L"<Setter Property='");
+  Put(sink, property);
+  Put(sink, L"' Value='");
+  Put(sink, value);
+  Put(sink, L"'/>");
+}
+
+// Every style value the presenter XAML needs, resolved and formatted once
+// before the two writer passes.
+struct PresenterValues {
+  int64_t hover_bg = 0;
+  int64_t separator = 0;
+  int64_t disabled_fg = 0;
+  int64_t sub_menu_opened_bg = 0;
+  int64_t sub_menu_opened_fg = 0;
+  int64_t checked_fg = 0;
+  int64_t checked_bg = 0;
+  int64_t accelerator = 0;
+  int64_t text = 0;
+  int64_t background = 0;
+  int64_t border = 0;
+  bool need_sub_menu_opened_fix = false;
+  bool has_theme_content = false;
+
+  double font_size = 0;
+  NumberText font_size_text;
+  bool has_font_family = false;
+  std::wstring font_family;
+  int64_t font_weight = 0;
+  NumberText font_weight_text;
+  bool has_corner_radius = false;
+  NumberText corner_radius_text;
+  bool has_padding = false;
+  NumberText padding_text[4];
+  double min_width = 0;
+  NumberText min_width_text;
+  std::string theme_mode;
+  double border_thickness = 0;
+  NumberText border_thickness_text;
+  std::string font_style;
+  bool disable_shadow = false;
+  double max_height = 0;
+  NumberText max_height_text;
+};
+
+PresenterValues ResolvePresenterValues(const ResolvedStyle& style,
+                                       Utf8ToWideFn utf8_to_wide) {
+  PresenterValues v;
+  v.hover_bg = style.hover_background_color;
+  v.separator = style.separator_color;
+  v.disabled_fg = style.disabled_text_color;
+  v.sub_menu_opened_bg = style.sub_menu_opened_background_color;
+  v.sub_menu_opened_fg = style.sub_menu_opened_text_color;
+  v.checked_fg = style.checked_foreground_color;
+  v.checked_bg = style.checked_background_color;
+  v.accelerator = style.keyboard_accelerator_color;
+  v.text = style.text_color;
+  v.background = style.background_color;
+  v.border = style.border_color;
+  v.need_sub_menu_opened_fix =
+      (v.sub_menu_opened_bg == 0 && v.sub_menu_opened_fg == 0);
+  v.has_theme_content =
+      v.hover_bg != 0 || v.separator != 0 || v.disabled_fg != 0 ||
+      v.sub_menu_opened_bg != 0 || v.sub_menu_opened_fg != 0 ||
+      v.need_sub_menu_opened_fix || v.checked_fg != 0 || v.checked_bg != 0 ||
+      v.accelerator != 0;
+
+  v.font_size = style.font_size;
+  v.font_size_text = FormatDouble(v.font_size);
+
+  v.has_font_family = !style.font_family.empty();
+  if (v.has_font_family) {
+    v.font_family = XamlEscapeAttribute(utf8_to_wide(style.font_family));
+  }
+
+  v.font_weight = style.font_weight;
+  v.font_weight_text = FormatInt(v.font_weight);
+
+  v.has_corner_radius = style.has(StyleKey::kCornerRadius);
+  v.corner_radius_text = FormatDouble(style.corner_radius);
+
+  v.has_padding = style.has(StyleKey::kPadding);
+  if (v.has_padding) {
+    v.padding_text[0] = FormatDouble(style.padding.left);
+    v.padding_text[1] = FormatDouble(style.padding.top);
+    v.padding_text[2] = FormatDouble(style.padding.right);
+    v.padding_text[3] = FormatDouble(style.padding.bottom);
+  }
+
+  v.min_width = style.min_width;
+  v.min_width_text = FormatDouble(v.min_width);
+  v.theme_mode = style.theme_mode;
+  v.border_thickness = style.border_thickness;
+  v.border_thickness_text = FormatDouble(v.border_thickness);
+  v.font_style = style.font_style;
+  v.disable_shadow =
+      style.has(StyleKey::kShadowElevation) && style.shadow_elevation <= 0;
+  v.max_height = style.max_height;
+  v.max_height_text = FormatDouble(v.max_height);
+  return v;
+}
+
+// Brushes of one theme dictionary; emitted once and copied for the others.
+template <typename Sink>
+void PutThemeBody(Sink& sink, const PresenterValues& v) {
+  if (v.hover_bg != 0) {
+    const ColorText hover = FormatColor(v.hover_bg);
+    PutBrush(sink, L"MenuFlyoutItemBackgroundPointerOver", hover);
+    PutBrush(sink, L"ToggleMenuFlyoutItemBackgroundPointerOver", hover);
+    PutBrush(sink, L"MenuFlyoutSubItemBackgroundPointerOver", hover);
+    PutBrush(sink, L"MenuFlyoutItemRevealBackgroundPointerOver", hover);
+    PutBrush(sink, L"ToggleMenuFlyoutItemRevealBackgroundPointerOver", hover);
+    PutBrush(sink, L"MenuFlyoutSubItemRevealBackgroundPointerOver", hover);
+  }
+  if (v.separator != 0) {
+    PutBrush(sink, L"MenuFlyoutSeparatorBackground", FormatColor(v.separator));
+  }
+  if (v.disabled_fg != 0) {
+    const ColorText disabled = FormatColor(v.disabled_fg);
+    PutBrush(sink, L"MenuFlyoutItemForegroundDisabled", disabled);
+    PutBrush(sink, L"MenuFlyoutSubItemForegroundDisabled", disabled);
+    PutBrush(sink, L"MenuFlyoutSubItemChevronDisabled", disabled);
+    PutBrush(sink, L"ToggleMenuFlyoutItemForegroundDisabled", disabled);
+    PutBrush(sink, L"ToggleMenuFlyoutItemCheckGlyphForegroundDisabled", disabled);
+  }
+  if (v.sub_menu_opened_bg != 0) {
+    const ColorText bg = FormatColor(v.sub_menu_opened_bg);
+    PutBrush(sink, L"MenuFlyoutSubItemBackgroundSubMenuOpened", bg);
+    PutBrush(sink, L"MenuFlyoutSubItemRevealBackgroundSubMenuOpened", bg);
+  }
+  if (v.sub_menu_opened_fg != 0) {
+    const ColorText fg = FormatColor(v.sub_menu_opened_fg);
+    PutBrush(sink, L"MenuFlyoutSubItemForegroundSubMenuOpened", fg);
+    PutBrush(sink, L"MenuFlyoutSubItemChevronSubMenuOpened", fg);
+  }
+  if (v.checked_bg != 0) {
+    const ColorText bg = FormatColor(v.checked_bg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemBackgroundChecked", bg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemBackgroundCheckedPointerOver", bg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemBackgroundCheckedPressed", bg);
+  }
+  if (v.checked_fg != 0) {
+    const ColorText fg = FormatColor(v.checked_fg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemForegroundChecked", fg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemForegroundCheckedPointerOver", fg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemForegroundCheckedPressed", fg);
+    PutBrush(sink, L"ToggleMenuFlyoutItemCheckGlyphForegroundChecked", fg);
+  }
+  if (v.accelerator != 0) {
+    PutBrush(sink, L"MenuFlyoutItemKeyboardAcceleratorTextForeground",
+             FormatColor(v.accelerator));
+  }
+  if (v.need_sub_menu_opened_fix) {
+    // Without explicit values WinUI keeps the light theme's SubMenuOpened
+    // colours even in dark menus.
+    const ColorText bg =
+        FormatColor(v.hover_bg != 0 ? v.hover_bg : int64_t{0xFF404040});
+    const ColorText fg =
+        FormatColor(v.text != 0 ? v.text : int64_t{0xFFFFFFFF});
+    PutBrush(sink, L"MenuFlyoutSubItemBackgroundSubMenuOpened", bg);
+    PutBrush(sink, L"MenuFlyoutSubItemRevealBackgroundSubMenuOpened", bg);
+    PutBrush(sink, L"MenuFlyoutSubItemForegroundSubMenuOpened", fg);
+    PutBrush(sink, L"MenuFlyoutSubItemChevronSubMenuOpened", fg);
+  }
+}
+
+template <typename Sink>
+void PutPresenterStyle(Sink& sink, const PresenterValues& v) {
+  Put(sink, L"<Style TargetType='MenuFlyoutPresenter' "
+            L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation'>");
+
+  if (v.has_theme_content) {
+    Put(sink, L"<Setter Property='Resources'><Setter.Value>"
+              L"<ResourceDictionary "
+              L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+              L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+              L"<ResourceDictionary.ThemeDictionaries>"
+              L"<ResourceDictionary x:Key='Default'>");
+    const size_t body_begin = sink.Mark();
+    PutThemeBody(sink, v);
+    const size_t body_end = sink.Mark();
+    Put(sink, L"</ResourceDictionary><ResourceDictionary x:Key='Light'>");
+    sink.Repeat(body_begin, body_end);
+    Put(sink, L"</ResourceDictionary><ResourceDictionary x:Key='Dark'>");
+    sink.Repeat(body_begin, body_end);
+    Put(sink, L"</ResourceDictionary>"
+              L"</ResourceDictionary.ThemeDictionaries>"
+              L"</ResourceDictionary>"
+              L"</Setter.Value></Setter>");
+  }
+
+  if (v.background != 0) {
+    PutSetter(sink, L"Background", FormatColor(v.background));
+  }
+  if (v.text != 0) {
+    PutSetter(sink, L"Foreground", FormatColor(v.text));
+  }
+  if (v.font_size > 0) {
+    PutSetter(sink, L"FontSize", v.font_size_text);
+  }
+  if (v.has_font_family) {
+    Put(sink, L"<Setter Property='FontFamily' Value='");
+    Put(sink, v.font_family);
+    Put(sink, L"'/>");
+  }
+  if (v.font_weight > 0) {
+    PutSetter(sink, L"FontWeight", v.font_weight_text);
+  }
+  if (v.has_corner_radius) {
+    PutSetter(sink, L"CornerRadius", v.corner_radius_text);
+  }
+  if (v.has_padding) {
+    Put(sink, L"<Setter Property='Padding' Value='");
+    Put(sink, v.padding_text[0]);
+    Put(sink, L",");
+    Put(sink, v.padding_text[1]);
+    Put(sink, L",");
+    Put(sink, v.padding_text[2]);
+    Put(sink, L",");
+    Put(sink, v.padding_text[3]);
+    Put(sink, L"'/>");
+  }
+  if (v.min_width > 0) {
+    PutSetter(sink, L"MinWidth", v.min_width_text);
+  }
+  if (v.theme_mode == "light") {
+    Put(sink, L"<Setter Property='RequestedTheme' Value='Light'/>");
+  } else if (v.theme_mode == "dark") {
+    Put(sink, L"<Setter Property='RequestedTheme' Value='Dark'/>");
+  }
+  if (v.border != 0) {
+    PutSetter(sink, L"BorderBrush", FormatColor(v.border));
+  }
+  if (v.border_thickness > 0) {
+    PutSetter(sink, L"BorderThickness", v.border_thickness_text);
+  }
+  if (v.font_style == "italic") {
+    Put(sink, L"<Setter Property='FontStyle' Value='Italic'/>");
+  } else if (v.font_style == "normal") {
+    Put(sink, L"<Setter Property='FontStyle' Value='Normal'/>");
+  }
+  if (v.disable_shadow) {
+    Put(sink, L"<Setter Property='IsDefaultShadowEnabled' Value='False'/>");
+  }
+  if (v.max_height > 0) {
+    PutSetter(sink, L"MaxHeight", v.max_height_text);
+  }
+  Put(sink, L"</Style>");
+}
+
+// Compact item styles are constant XAML around a few colour slots. Each
+// template is stored as constexpr text pieces with a typed slot between
+// consecutive pieces; where every piece and slot starts, and the length of
+// the constant text, are computed at compile time, so filling one only
+// measures the slot values, allocates once and copies.
+
+// What a slot holds. Hover slots fall back to a different theme resource per
+// item type, so each item type has its own.
+enum class ItemSlot : uint8_t {
+  kItemHover,
+  kToggleHover,
+  kSubItemHover,
+  kCheckStripe,
+  kSubMenuOpenedBackground,
+  kSubMenuOpenedForeground,
+  kCount,
+};
+
+constexpr size_t kItemSlotCount = static_cast<size_t>(ItemSlot::kCount);
+
+// text[0] slot[0] text[1] ... slot[N-1] text[N].
+template <size_t N>
+class ItemTemplate {
+ public:
+  constexpr ItemTemplate(const std::wstring_view (&text)[N + 1],
+                         const ItemSlot (&slots)[N]) {
+    size_t offset = 0;
+    for (size_t i = 0; i < N; ++i) {
+      text_[i] = text[i];
+      slots_[i] = slots[i];
+      text_offset_[i] = offset;
+      offset += text[i].size();
+      slot_offset_[i] = offset;
+    }
+    text_[N] = text[N];
+    text_offset_[N] = offset;
+    constant_size_ = offset + text[N].size();
+  }
+
+  // Total length of the text pieces, without slot values.
+  constexpr size_t constant_size() const { return constant_size_; }
+  constexpr size_t slot_count() const { return N; }
+
+  // Offsets within the output, given the length of the slot values before
+  // the piece or slot.
+  constexpr size_t text_offset(size_t i) const { return text_offset_[i]; }
+  constexpr size_t slot_offset(size_t i) const { return slot_offset_[i]; }
+
+  std::wstring Fill(const SlotText (&values)[kItemSlotCount]) const {
+    size_t size = constant_size_;
+    for (ItemSlot slot : slots_) size += values[static_cast<size_t>(slot)].size;
+    std::wstring out(size, L'\0');
+    wchar_t* data = out.data();
+    size_t shift = 0;  // Slot text before the current piece.
+    for (size_t i = 0; i < N; ++i) {
+      std::wmemcpy(data + text_offset_[i] + shift, text_[i].data(),
+                   text_[i].size());
+      const SlotText& value = values[static_cast<size_t>(slots_[i])];
+      std::wmemcpy(data + slot_offset_[i] + shift, value.data, value.size);
+      shift += value.size;
+    }
+    std::wmemcpy(data + text_offset_[N] + shift, text_[N].data(),
+                 text_[N].size());
+    return out;
+  }
+
+ private:
+  std::wstring_view text_[N + 1] = {};
+  ItemSlot slots_[N] = {};
+  size_t text_offset_[N + 1] = {};
+  size_t slot_offset_[N] = {};
+  size_t constant_size_ = 0;
+};
+
+// Shared by every template: the end of the PointerOver setter up to the
+// Pressed background value.
+constexpr std::wstring_view kPointerOverToPressed =
+    L"'/>"
+    L"</VisualState.Setters></VisualState>"
+    L"<VisualState x:Name='Pressed'>"
+    L"<VisualState.Setters>"
+    L"<Setter Target='LayoutRoot.Background' Value='";
+
+// MenuFlyoutItem: Match WinUI template structure. Root: Grid LayoutRoot with
+// TemplateBinding Background. Inline-Hex for hoverBackgroundColor when set.
+constexpr ItemTemplate<2> kMenuFlyoutItemTemplate(
+    {
+        L"<Style TargetType='MenuFlyoutItem' "
+        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+        L"<Setter Property='Background' Value='Transparent'/>"
+        L"<Setter Property='Template'><Setter.Value>"
+        L"<ControlTemplate TargetType='MenuFlyoutItem'>"
+        L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
+        L"<TextBlock x:Name='Text' Text='{TemplateBinding Text}' "
+        L"VerticalAlignment='Center' Margin='10,0,10,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<VisualStateManager.VisualStateGroups>"
+        L"<VisualStateGroup x:Name='CommonStates'>"
+        L"<VisualState x:Name='Normal'/>"
+        L"<VisualState x:Name='PointerOver'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='",
+        kPointerOverToPressed,
+        L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Disabled'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='Text.Foreground' Value='{ThemeResource MenuFlyoutItemForegroundDisabled}'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>",
+    },
+    {ItemSlot::kItemHover, ItemSlot::kItemHover});
+
+// ToggleMenuFlyoutItem with a thin coloured stripe on the left (4px) that
+// becomes visible when checked.
+constexpr ItemTemplate<3> kToggleStripeTemplate(
+    {
+        L"<Style TargetType='ToggleMenuFlyoutItem' "
+        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+        L"<Setter Property='Background' Value='Transparent'/>"
+        L"<Setter Property='Padding' Value='0,0,0,0'/>"
+        L"<Setter Property='Template'><Setter.Value>"
+        L"<ControlTemplate TargetType='ToggleMenuFlyoutItem'>"
+        L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
+        L"<TextBlock x:Name='TextBlock' Text='{TemplateBinding Text}' "
+        L"VerticalAlignment='Center' Margin='10,0,10,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<Border x:Name='CheckStripe' Width='4' HorizontalAlignment='Left' "
+        L"VerticalAlignment='Stretch' Opacity='0' Background='",
+        L"'/>"
+        L"<VisualStateManager.VisualStateGroups>"
+        L"<VisualStateGroup x:Name='CommonStates'>"
+        L"<VisualState x:Name='Normal'/>"
+        L"<VisualState x:Name='PointerOver'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='",
+        kPointerOverToPressed,
+        L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Disabled'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemForegroundDisabled}'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup>"
+        L"<VisualStateGroup x:Name='CheckStates'>"
+        L"<VisualState x:Name='Unchecked'/>"
+        L"<VisualState x:Name='Checked'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='CheckStripe.Opacity' Value='1'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>",
+    },
+    {ItemSlot::kCheckStripe, ItemSlot::kToggleHover, ItemSlot::kToggleHover});
+
+// ToggleMenuFlyoutItem with a checkmark on the far right like the SubItem
+// chevron.
+constexpr ItemTemplate<2> kToggleCheckmarkTemplate(
+    {
+        L"<Style TargetType='ToggleMenuFlyoutItem' "
+        L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+        L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+        L"<Setter Property='Background' Value='Transparent'/>"
+        L"<Setter Property='Template'><Setter.Value>"
+        L"<ControlTemplate TargetType='ToggleMenuFlyoutItem'>"
+        L"<Grid x:Name='LayoutRoot' Background='{TemplateBinding Background}'>"
+        L"<Grid.ColumnDefinitions>"
+        L"<ColumnDefinition Width='*'/><ColumnDefinition Width='Auto'/>"
+        L"</Grid.ColumnDefinitions>"
+        L"<TextBlock x:Name='TextBlock' Grid.Column='0' Text='{TemplateBinding Text}' "
+        L"VerticalAlignment='Center' Margin='10,0,4,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<FontIcon x:Name='CheckGlyph' Grid.Column='1' Glyph='&#xE73E;' Opacity='0' "
+        L"FontSize='10' VerticalAlignment='Center' Margin='0,0,4,0' "
+        L"Foreground='{TemplateBinding Foreground}'/>"
+        L"<VisualStateManager.VisualStateGroups>"
+        L"<VisualStateGroup x:Name='CommonStates'>"
+        L"<VisualState x:Name='Normal'/>"
+        L"<VisualState x:Name='PointerOver'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='LayoutRoot.Background' Value='",
+        kPointerOverToPressed,
+        L"'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"<VisualState x:Name='Disabled'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemForegroundDisabled}'/>"
+        L"<Setter Target='CheckGlyph.Foreground' Value='{ThemeResource ToggleMenuFlyoutItemCheckGlyphForegroundDisabled}'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup>"
+        L"<VisualStateGroup x:Name='CheckStates'>"
+        L"<VisualState x:Name='Unchecked'/>"
+        L"<VisualState x:Name='Checked'>"
+        L"<VisualState.Setters>"
+        L"<Setter Target='CheckGlyph.Opacity' Value='1'/>"
+        L"</VisualState.Setters></VisualState>"
+        L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+        L"</Grid></ControlTemplate></Setter.Value></Setter></Style>",
+    },
+    {ItemSlot::kToggleHover, ItemSlot::kToggleHover});
+
+// MenuFlyoutSubItem: Match WinUI default template structure for VisualState
+// compatibility. Root: Grid LayoutRoot with TemplateBinding Background.
+// SubMenuOpened must be in CommonStates (not SubMenuOpenedStates).
+// Element names: TextBlock, SubItemChevron. Chevron glyph E974.
+constexpr std::wstring_view kSubItemHead =
+    L"<Style TargetType='MenuFlyoutSubItem' "
+    L"xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation' "
+    L"xmlns:x='http://schemas.microsoft.com/winfx/2006/xaml'>"
+    L"<Setter Property='Background' Value='Transparent'/>"
+    L"<Setter Property='Template'><Setter.Value>"
+    L"<ControlTemplate TargetType='MenuFlyoutSubItem'>"
+    L"<Grid x:Name='LayoutRoot' Padding='0,0,0,0' "
+    L"Background='{TemplateBinding Background}'>"
+    L"<Grid.ColumnDefinitions>"
+    L"<ColumnDefinition Width='*'/><ColumnDefinition Width='Auto'/>"
+    L"</Grid.ColumnDefinitions>"
+    L"<TextBlock x:Name='TextBlock' Grid.Column='0' Text='{TemplateBinding Text}' "
+    L"VerticalAlignment='Center' Margin='10,0,4,0' "
+    L"Foreground='{TemplateBinding Foreground}'/>"
+    L"<FontIcon x:Name='SubItemChevron' Grid.Column='1' Glyph='&#xE974;' FontSize='12' "
+    L"VerticalAlignment='Center' Margin='0,0,4,0' "
+    L"Foreground='{TemplateBinding Foreground}'/>"
+    L"<VisualStateManager.VisualStateGroups>"
+    L"<VisualStateGroup x:Name='CommonStates'>"
+    L"<VisualState x:Name='Normal'/>"
+    L"<VisualState x:Name='PointerOver'>"
+    L"<VisualState.Setters>"
+    L"<Setter Target='LayoutRoot.Background' Value='";
+
+constexpr std::wstring_view kSubItemPressedToSubMenuOpened =
+    L"'/>"
+    L"</VisualState.Setters></VisualState>"
+    L"<VisualState x:Name='SubMenuOpened'>"
+    L"<VisualState.Setters>"
+    L"<Setter Target='LayoutRoot.Background' Value='";
+
+constexpr std::wstring_view kSubItemTail =
+    L"'/>"
+    L"</VisualState.Setters></VisualState>"
+    L"<VisualState x:Name='Disabled'>"
+    L"<VisualState.Setters>"
+    L"<Setter Target='TextBlock.Foreground' Value='{ThemeResource MenuFlyoutSubItemForegroundDisabled}'/>"
+    L"<Setter Target='SubItemChevron.Foreground' Value='{ThemeResource MenuFlyoutSubItemChevronDisabled}'/>"
+    L"</VisualState.Setters></VisualState>"
+    L"</VisualStateGroup></VisualStateManager.VisualStateGroups>"
+    L"</Grid></ControlTemplate></Setter.Value></Setter></Style>";
+
+constexpr ItemTemplate<3> kSubItemTemplate(
+    {kSubItemHead, kPointerOverToPressed, kSubItemPressedToSubMenuOpened,
+     kSubItemTail},
+    {ItemSlot::kSubItemHover, ItemSlot::kSubItemHover,
+     ItemSlot::kSubMenuOpenedBackground});
+
+// The same with subMenuOpenedTextColor applied to the text and chevron.
+constexpr ItemTemplate<5> kSubItemWithForegroundTemplate(
+    {kSubItemHead, kPointerOverToPressed, kSubItemPressedToSubMenuOpened,
+     L"'/><Setter Target='TextBlock.Foreground' Value='",
+     L"'/><Setter Target='SubItemChevron.Foreground' Value='", kSubItemTail},
+    {ItemSlot::kSubItemHover, ItemSlot::kSubItemHover,
+     ItemSlot::kSubMenuOpenedBackground, ItemSlot::kSubMenuOpenedForeground,
+     ItemSlot::kSubMenuOpenedForeground});
+
+}  // namespace
+
+std::wstring ColorToXamlString(int64_t value) {
+  const ColorText text = FormatColor(value);
+  return std::wstring(text.chars, 9);
+}
+
+std::wstring_view XamlEscapeAttribute(std::wstring_view input,
+                                     std::wstring& buffer) {
+  const wchar_t* data = input.data();
+  const size_t size = input.size();
+  size_t next = FindXamlEscape(data, size);
+  if (next == size) return input;
+
+  // Sizes the output exactly, then copies the runs between entities.
+  size_t escaped_size = size;
+  for (size_t i = next; i < size;) {
+    escaped_size += XamlEntity(data[i]).size() - 1;
+    ++i;
+    i += FindXamlEscape(data + i, size - i);
+  }
+  buffer.resize(escaped_size);
+  wchar_t* out = buffer.data();
+  size_t run = 0;
+  while (next < size) {
+    out = std::copy(data + run, data + next, out);
+    const std::wstring_view entity = XamlEntity(data[next]);
+    out = std::copy(entity.begin(), entity.end(), out);
+    run = next + 1;
+    next = run + FindXamlEscape(data + run, size - run);
+  }
+  std::copy(data + run, data + size, out);
+  return buffer;
+}
+
+std::wstring XamlEscapeAttribute(std::wstring input) {
+  std::wstring buffer;
+  if (XamlEscapeAttribute(input, buffer).data() == input.data()) return input;
+  return buffer;
+}
+
+std::wstring BuildPresenterStyleXaml(const ResolvedStyle& style,
+                                     Utf8ToWideFn utf8_to_wide) {
+  if (style.empty()) return std::wstring();
+  const PresenterValues values = ResolvePresenterValues(style, utf8_to_wide);
+  return Render([&values](auto& sink) { PutPresenterStyle(sink, values); });
+}
+
+CompactItemStylesXaml BuildCompactItemStylesXaml(const ResolvedStyle& style) {
+  const uint32_t hover = style.hover_background_color;
+  const uint32_t stripe = style.checked_indicator_color;
+  const uint32_t sub_menu_bg = style.sub_menu_opened_background_color;
+  const uint32_t sub_menu_fg = style.sub_menu_opened_text_color;
+
+  const ColorText hover_color = FormatColor(hover);
+  const ColorText stripe_color = FormatColor(stripe);
+  const ColorText sub_menu_bg_color = FormatColor(sub_menu_bg);
+  const ColorText sub_menu_fg_color = FormatColor(sub_menu_fg);
+
+  SlotText slots[kItemSlotCount] = {};
+  auto set = [&slots](ItemSlot slot, SlotText text) {
+    slots[static_cast<size_t>(slot)] = text;
+  };
+  set(ItemSlot::kItemHover,
+      hover != 0 ? Slot(hover_color)
+                 : Slot(L"{ThemeResource MenuFlyoutItemBackgroundPointerOver}"));
+  set(ItemSlot::kToggleHover,
+      hover != 0
+          ? Slot(hover_color)
+          : Slot(L"{ThemeResource ToggleMenuFlyoutItemBackgroundPointerOver}"));
+  set(ItemSlot::kSubItemHover,
+      hover != 0
+          ? Slot(hover_color)
+          : Slot(L"{ThemeResource MenuFlyoutSubItemBackgroundPointerOver}"));
+  set(ItemSlot::kCheckStripe, Slot(stripe_color));
+  set(ItemSlot::kSubMenuOpenedBackground,
+      sub_menu_bg != 0
+          ? Slot(sub_menu_bg_color)
+          : Slot(L"{ThemeResource MenuFlyoutSubItemBackgroundSubMenuOpened}"));
+  set(ItemSlot::kSubMenuOpenedForeground, Slot(sub_menu_fg_color));
+
+  CompactItemStylesXaml result;
+  result.menu_flyout_item = kMenuFlyoutItemTemplate.Fill(slots);
+  result.toggle_menu_flyout_item = stripe != 0
+                                       ? kToggleStripeTemplate.Fill(slots)
+                                       : kToggleCheckmarkTemplate.Fill(slots);
+  result.menu_flyout_sub_item =
+      sub_menu_fg != 0 ? kSubItemWithForegroundTemplate.Fill(slots)
+                       : kSubItemTemplate.Fill(slots);
+  return result;
+}
+
+}  // namespace tray_manager_winui
@@ -0,0 +1,49 @@
+#ifndef TRAY_MANAGER_WINUI_XAML_WRITER_H_
+#define TRAY_MANAGER_WINUI_XAML_WRITER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "style_values.h"
+
+namespace tray_manager_winui {
+
+/// Converts UTF-8 style strings (fontFamily) to UTF-16 for XAML.
+using Utf8ToWideFn = std::wstring (*)(std::string_view utf8);
+
+/// Formats 0xAARRGGBB as "#AARRGGBB" for XAML.
+std::wstring ColorToXamlString(int64_t value);
+
+/// Escapes & < > " ' for use inside a single-quoted XAML attribute.
+/// Returns input itself when nothing needs escaping (the common case for
+/// font families and labels); otherwise writes the escaped text into buffer,
+/// sized exactly, and returns a view of it.
+std::wstring_view XamlEscapeAttribute(std::wstring_view input,
+                                     std::wstring& buffer);
+
+/// As above, returning input moved through when nothing needs escaping.
+std::wstring XamlEscapeAttribute(std::wstring input);
+
+/// Builds the MenuFlyoutPresenter <Style> for a WinUIContextMenuStyle.
+/// Returns an empty string for an empty style.
+///
+/// The output length is computed in a first pass and the XAML is then written
+/// into a single buffer; the theme resources are formatted once and copied
+/// into the Default, Light and Dark dictionaries.
+std::wstring BuildPresenterStyleXaml(const ResolvedStyle& style,
+                                     Utf8ToWideFn utf8_to_wide);
+
+/// XAML of the compact (no icon column) item styles.
+struct CompactItemStylesXaml {
+  std::wstring menu_flyout_item;
+  std::wstring toggle_menu_flyout_item;
+  std::wstring menu_flyout_sub_item;
+};
+
+/// Builds the compact item styles; an empty style gives WinUI's defaults.
+CompactItemStylesXaml BuildCompactItemStylesXaml(const ResolvedStyle& style);
+
+}  // namespace tray_manager_winui
+
+#endif  // TRAY_MANAGER_WINUI_XAML_WRITER_H_